@@ -1,11 +1,14 @@
 #include <cuda_runtime.h>
 #include <iostream>
 #include "cublas_v2.h"
+#include "cuda_bf16.h"
 #include "cuda_fp16.h"
 #include "magma_lapack.h"
 #include "magma_v2.h"
 
 
+#include "../../host/blas/blas_kernels.hpp"
+#include "../../host/precision.hpp"
 #include "../memory/detail.hpp"
 #include "../memory/memory.hpp"
 
@@ -17,12 +20,18 @@ namespace blas {
 double norm2(magma_int_t num_rows, double* v_vector, magma_int_t inc,
              magma_queue_t queue)
 {
+    if (detail::use_host_backend()) {
+        return host::norm2(num_rows, v_vector, inc);
+    }
     return magma_dnrm2(num_rows, v_vector, inc, queue);
 }
 
 float norm2(magma_int_t num_rows, float* v_vector, magma_int_t inc,
             magma_queue_t queue)
 {
+    if (detail::use_host_backend()) {
+        return host::norm2(num_rows, v_vector, inc);
+    }
     return magma_snrm2(num_rows, v_vector, inc, queue);
 }
 
@@ -30,12 +39,20 @@ float norm2(magma_int_t num_rows, float* v_vector, magma_int_t inc,
 void copy(magma_int_t num_rows, double* source_vector, magma_int_t inc_u,
           double* dest_vector, magma_int_t inc_v, magma_queue_t queue)
 {
+    if (detail::use_host_backend()) {
+        host::copy(num_rows, source_vector, inc_u, dest_vector, inc_v);
+        return;
+    }
     magma_dcopy(num_rows, source_vector, inc_u, dest_vector, inc_v, queue);
 }
 
 void copy(magma_int_t num_rows, float* source_vector, magma_int_t inc_u,
           float* dest_vector, magma_int_t inc_v, magma_queue_t queue)
 {
+    if (detail::use_host_backend()) {
+        host::copy(num_rows, source_vector, inc_u, dest_vector, inc_v);
+        return;
+    }
     magma_scopy(num_rows, source_vector, inc_u, dest_vector, inc_v, queue);
 }
 
@@ -43,12 +60,20 @@ void copy(magma_int_t num_rows, float* source_vector, magma_int_t inc_u,
 void scale(magma_int_t num_rows, double alpha, double* v_vector,
            magma_int_t inc, magma_queue_t queue)
 {
+    if (detail::use_host_backend()) {
+        host::scale(num_rows, alpha, v_vector, inc);
+        return;
+    }
     magma_dscal(num_rows, alpha, v_vector, inc, queue);
 }
 
 void scale(magma_int_t num_rows, float alpha, float* v_vector, magma_int_t inc,
            magma_queue_t queue)
 {
+    if (detail::use_host_backend()) {
+        host::scale(num_rows, alpha, v_vector, inc);
+        return;
+    }
     magma_sscal(num_rows, alpha, v_vector, inc, queue);
 }
 
@@ -57,12 +82,20 @@ void axpy(magma_int_t num_rows, double alpha, double* u_vector,
           magma_int_t inc_u, double* v_vector, magma_int_t inc_v,
           magma_queue_t queue)
 {
+    if (detail::use_host_backend()) {
+        host::axpy(num_rows, alpha, u_vector, inc_u, v_vector, inc_v);
+        return;
+    }
     magma_daxpy(num_rows, alpha, u_vector, inc_u, v_vector, inc_v, queue);
 }
 
 void axpy(magma_int_t num_rows, float alpha, float* u_vector, magma_int_t inc_u,
           float* v_vector, magma_int_t inc_v, magma_queue_t queue)
 {
+    if (detail::use_host_backend()) {
+        host::axpy(num_rows, alpha, u_vector, inc_u, v_vector, inc_v);
+        return;
+    }
     magma_saxpy(num_rows, alpha, u_vector, inc_u, v_vector, inc_v, queue);
 }
 
@@ -72,6 +105,11 @@ void gemv(magma_trans_t trans, magma_int_t num_rows, magma_int_t num_cols,
           magma_int_t inc_u, double beta, double* v_vector, magma_int_t inc_v,
           magma_queue_t queue)
 {
+    if (detail::use_host_backend()) {
+        host::gemv(trans, num_rows, num_cols, alpha, mtx, ld, u_vector, inc_u,
+                   beta, v_vector, inc_v);
+        return;
+    }
     magma_dgemv(trans, num_rows, num_cols, alpha, mtx, num_rows, u_vector,
                 inc_u, beta, v_vector, inc_v, queue);
 }
@@ -81,6 +119,11 @@ void gemv(magma_trans_t trans, magma_int_t num_rows, magma_int_t num_cols,
           magma_int_t inc_u, float beta, float* v_vector, magma_int_t inc_v,
           magma_queue_t queue)
 {
+    if (detail::use_host_backend()) {
+        host::gemv(trans, num_rows, num_cols, alpha, mtx, ld, u_vector, inc_u,
+                   beta, v_vector, inc_v);
+        return;
+    }
     magmablas_sgemv(trans, num_rows, num_cols, alpha, mtx, ld, u_vector, inc_u,
                     beta, v_vector, inc_v, queue);
 }
@@ -90,6 +133,13 @@ void gemv(magma_trans_t trans, magma_int_t num_rows, magma_int_t num_cols,
           magmaHalf_ptr u_vector, magma_int_t inc_u, magmaHalf beta,
           magmaHalf_ptr v_vector, magma_int_t inc_v, magma_queue_t queue)
 {
+    if (detail::use_host_backend()) {
+        host::gemv(trans, num_rows, num_cols,
+                   host::arithmetic<__half>::load(alpha), mtx, ld, u_vector,
+                   inc_u, host::arithmetic<__half>::load(beta), v_vector,
+                   inc_v);
+        return;
+    }
     if (trans == MagmaNoTrans) {
         magma_hgemm(MagmaNoTrans, MagmaNoTrans, num_rows, 1, num_cols, alpha,
                     mtx, ld, u_vector, ld, beta, v_vector, ld, queue);
@@ -99,11 +149,36 @@ void gemv(magma_trans_t trans, magma_int_t num_rows, magma_int_t num_cols,
     }
 }
 
+void gemv(magma_trans_t trans, magma_int_t num_rows, magma_int_t num_cols,
+          float alpha, __nv_bfloat16* mtx, magma_int_t ld,
+          __nv_bfloat16* u_vector, magma_int_t inc_u, float beta,
+          __nv_bfloat16* v_vector, magma_int_t inc_v, magma_queue_t queue)
+{
+    if (detail::use_host_backend()) {
+        host::gemv(trans, num_rows, num_cols, alpha, mtx, ld, u_vector, inc_u,
+                   beta, v_vector, inc_v);
+        return;
+    }
+    // MAGMA has no bfloat16 routines; cuBLAS computes in fp32 on the tensor
+    // cores.
+    magma_int_t rows_out = (trans == MagmaNoTrans) ? num_rows : num_cols;
+    magma_int_t len = (trans == MagmaNoTrans) ? num_cols : num_rows;
+    cublasGemmEx(magma_queue_get_cublas_handle(queue),
+                 cublas_trans_const(trans), CUBLAS_OP_N, rows_out, 1, len,
+                 &alpha, mtx, CUDA_R_16BF, ld, u_vector, CUDA_R_16BF, len,
+                 &beta, v_vector, CUDA_R_16BF, rows_out, CUBLAS_COMPUTE_32F,
+                 CUBLAS_GEMM_DEFAULT);
+}
+
 
 void trsv(magma_uplo_t uplo, magma_trans_t trans, magma_diag_t diag,
           magma_int_t n, magmaDouble_const_ptr dA, magma_int_t ldda,
           magmaDouble_ptr dx, magma_int_t incx, magma_queue_t queue)
 {
+    if (detail::use_host_backend()) {
+        host::trsv(uplo, trans, diag, n, dA, ldda, dx, incx);
+        return;
+    }
     magma_dtrsv(uplo, trans, diag, n, dA, ldda, dx, incx, queue);
 }
 
@@ -111,6 +186,10 @@ void trsv(magma_uplo_t uplo, magma_trans_t trans, magma_diag_t diag,
           magma_int_t n, magmaFloat_const_ptr dA, magma_int_t ldda,
           magmaFloat_ptr dx, magma_int_t incx, magma_queue_t queue)
 {
+    if (detail::use_host_backend()) {
+        host::trsv(uplo, trans, diag, n, dA, ldda, dx, incx);
+        return;
+    }
     magma_strsv(uplo, trans, diag, n, dA, ldda, dx, incx, queue);
 }
 
@@ -119,6 +198,10 @@ void trmv(magma_uplo_t uplo, magma_trans_t trans, magma_diag_t diag,
           magma_int_t n, magmaDouble_const_ptr dA, magma_int_t ldda,
           magmaDouble_ptr dx, magma_int_t incx, magma_queue_t queue)
 {
+    if (detail::use_host_backend()) {
+        host::trmv(uplo, trans, diag, n, dA, ldda, dx, incx);
+        return;
+    }
     magma_dtrmv(uplo, trans, diag, n, dA, ldda, dx, incx, queue);
 }
 
@@ -126,6 +209,10 @@ void trmv(magma_uplo_t uplo, magma_trans_t trans, magma_diag_t diag,
           magma_int_t n, magmaFloat_const_ptr dA, magma_int_t ldda,
           magmaFloat_ptr dx, magma_int_t incx, magma_queue_t queue)
 {
+    if (detail::use_host_backend()) {
+        host::trmv(uplo, trans, diag, n, dA, ldda, dx, incx);
+        return;
+    }
     magma_strmv(uplo, trans, diag, n, dA, ldda, dx, incx, queue);
 }
 
@@ -136,6 +223,11 @@ void gemm(magma_trans_t transA, magma_trans_t transB, magma_int_t m,
           double beta, magmaDouble_ptr dC, magma_int_t lddc,
           detail::magma_info& info)
 {
+    if (detail::use_host_backend()) {
+        host::gemm(transA, transB, m, n, k, alpha, dA, ldda, dB, lddb, beta,
+                   dC, lddc);
+        return;
+    }
     magma_dgemm(transA, transB, m, n, k, alpha, dA, ldda, dB, lddb, beta, dC,
                 lddc, info.queue);
 }
@@ -146,6 +238,11 @@ void gemm(magma_trans_t transA, magma_trans_t transB, magma_int_t m,
           float beta, magmaFloat_ptr dC, magma_int_t lddc,
           detail::magma_info& info)
 {
+    if (detail::use_host_backend()) {
+        host::gemm(transA, transB, m, n, k, alpha, dA, ldda, dB, lddb, beta,
+                   dC, lddc);
+        return;
+    }
     magma_sgemm(transA, transB, m, n, k, alpha, dA, ldda, dB, lddb, beta, dC,
                 lddc, info.queue);
 }
@@ -156,19 +253,142 @@ void gemm(magma_trans_t transA, magma_trans_t transB, magma_int_t m,
           magmaHalf beta, magmaHalf_ptr dC, magma_int_t lddc,
           detail::magma_info& info)
 {
+    if (detail::use_host_backend()) {
+        host::gemm(transA, transB, m, n, k,
+                   host::arithmetic<__half>::load(alpha), dA, ldda, dB, lddb,
+                   host::arithmetic<__half>::load(beta), dC, lddc);
+        return;
+    }
     magma_hgemm(transA, transB, m, n, k, alpha, dA, ldda, dB, lddb, beta, dC,
                 lddc, info.queue);
 }
 
+void gemm(magma_trans_t transA, magma_trans_t transB, magma_int_t m,
+          magma_int_t n, magma_int_t k, float alpha, const __nv_bfloat16* dA,
+          magma_int_t ldda, const __nv_bfloat16* dB, magma_int_t lddb,
+          float beta, __nv_bfloat16* dC, magma_int_t lddc,
+          detail::magma_info& info)
+{
+    if (detail::use_host_backend()) {
+        host::gemm(transA, transB, m, n, k, alpha, dA, ldda, dB, lddb, beta,
+                   dC, lddc);
+        return;
+    }
+    cublasGemmEx(info.cublas_handle, cublas_trans_const(transA),
+                 cublas_trans_const(transB), m, n, k, &alpha, dA, CUDA_R_16BF,
+                 ldda, dB, CUDA_R_16BF, lddb, &beta, dC, CUDA_R_16BF, lddc,
+                 CUBLAS_COMPUTE_32F, CUBLAS_GEMM_DEFAULT);
+}
+
+void syrk(magma_uplo_t uplo, magma_trans_t trans, magma_int_t n,
+          magma_int_t k, double alpha, magmaDouble_const_ptr dA,
+          magma_int_t ldda, double beta, magmaDouble_ptr dC, magma_int_t lddc,
+          magma_queue_t queue)
+{
+    if (detail::use_host_backend()) {
+        host::syrk(uplo, trans, n, k, alpha, dA, ldda, beta, dC, lddc);
+        return;
+    }
+    magma_dsyrk(uplo, trans, n, k, alpha, dA, ldda, beta, dC, lddc, queue);
+}
+
+void syrk(magma_uplo_t uplo, magma_trans_t trans, magma_int_t n,
+          magma_int_t k, float alpha, magmaFloat_const_ptr dA,
+          magma_int_t ldda, float beta, magmaFloat_ptr dC, magma_int_t lddc,
+          magma_queue_t queue)
+{
+    if (detail::use_host_backend()) {
+        host::syrk(uplo, trans, n, k, alpha, dA, ldda, beta, dC, lddc);
+        return;
+    }
+    magma_ssyrk(uplo, trans, n, k, alpha, dA, ldda, beta, dC, lddc, queue);
+}
+
+void trsm(magma_side_t side, magma_uplo_t uplo, magma_trans_t trans,
+          magma_diag_t diag, magma_int_t m, magma_int_t n, double alpha,
+          magmaDouble_const_ptr dA, magma_int_t ldda, magmaDouble_ptr dB,
+          magma_int_t lddb, magma_queue_t queue)
+{
+    if (detail::use_host_backend()) {
+        host::trsm(side, uplo, trans, diag, m, n, alpha, dA, ldda, dB, lddb);
+        return;
+    }
+    magma_dtrsm(side, uplo, trans, diag, m, n, alpha, dA, ldda, dB, lddb,
+                queue);
+}
+
+void trsm(magma_side_t side, magma_uplo_t uplo, magma_trans_t trans,
+          magma_diag_t diag, magma_int_t m, magma_int_t n, float alpha,
+          magmaFloat_const_ptr dA, magma_int_t ldda, magmaFloat_ptr dB,
+          magma_int_t lddb, magma_queue_t queue)
+{
+    if (detail::use_host_backend()) {
+        host::trsm(side, uplo, trans, diag, m, n, alpha, dA, ldda, dB, lddb);
+        return;
+    }
+    magma_strsm(side, uplo, trans, diag, m, n, alpha, dA, ldda, dB, lddb,
+                queue);
+}
+
+void trmm(magma_side_t side, magma_uplo_t uplo, magma_trans_t trans,
+          magma_diag_t diag, magma_int_t m, magma_int_t n, double alpha,
+          magmaDouble_const_ptr dA, magma_int_t ldda, magmaDouble_ptr dB,
+          magma_int_t lddb, magma_queue_t queue)
+{
+    if (detail::use_host_backend()) {
+        host::trmm(side, uplo, trans, diag, m, n, alpha, dA, ldda, dB, lddb);
+        return;
+    }
+    magma_dtrmm(side, uplo, trans, diag, m, n, alpha, dA, ldda, dB, lddb,
+                queue);
+}
+
+void trmm(magma_side_t side, magma_uplo_t uplo, magma_trans_t trans,
+          magma_diag_t diag, magma_int_t m, magma_int_t n, float alpha,
+          magmaFloat_const_ptr dA, magma_int_t ldda, magmaFloat_ptr dB,
+          magma_int_t lddb, magma_queue_t queue)
+{
+    if (detail::use_host_backend()) {
+        host::trmm(side, uplo, trans, diag, m, n, alpha, dA, ldda, dB, lddb);
+        return;
+    }
+    magma_strmm(side, uplo, trans, diag, m, n, alpha, dA, ldda, dB, lddb,
+                queue);
+}
+
+magma_int_t potrf_gpu(magma_uplo_t uplo, magma_int_t n, magmaDouble_ptr dA,
+                      magma_int_t ldda, magma_int_t* info)
+{
+    if (detail::use_host_backend()) {
+        return host::potrf(uplo, n, dA, ldda, info);
+    }
+    return magma_dpotrf_gpu(uplo, n, dA, ldda, info);
+}
+
+magma_int_t potrf_gpu(magma_uplo_t uplo, magma_int_t n, magmaFloat_ptr dA,
+                      magma_int_t ldda, magma_int_t* info)
+{
+    if (detail::use_host_backend()) {
+        return host::potrf(uplo, n, dA, ldda, info);
+    }
+    return magma_spotrf_gpu(uplo, n, dA, ldda, info);
+}
+
 magma_int_t geqrf2_gpu(magma_int_t m, magma_int_t n, magmaDouble_ptr dA,
                        magma_int_t ldda, double* tau, magma_int_t* info)
 {
+    if (detail::use_host_backend()) {
+        return host::geqrf(m, n, dA, ldda, tau, info);
+    }
     return magma_dgeqrf2_gpu(m, n, dA, ldda, tau, info);
 }
 
 magma_int_t geqrf2_gpu(magma_int_t m, magma_int_t n, magmaFloat_ptr dA,
                        magma_int_t ldda, float* tau, magma_int_t* info)
 {
+    if (detail::use_host_backend()) {
+        return host::geqrf(m, n, dA, ldda, tau, info);
+    }
     return magma_sgeqrf2_gpu(m, n, dA, ldda, tau, info);
 }
 
@@ -2,6 +2,7 @@
 #define BLENDNPIK_BLAS_HPP
 
 
+#include "cuda_bf16.h"
 #include "magma_v2.h"
 
 
@@ -12,6 +13,10 @@ namespace rls {
 namespace blas {
 
 
+// Every wrapper dispatches on detail::get_backend(): MAGMA on the device for
+// backend::cuda, OpenMP/CPU BLAS kernels (host/blas) for backend::host. The
+// pointers must live in the memory space of the active backend.
+
 double norm2(magma_int_t num_rows, double* v_vector, magma_int_t inc,
              magma_queue_t queue);
 
@@ -52,6 +57,12 @@ void gemv(magma_trans_t trans, magma_int_t num_rows, magma_int_t num_cols,
           magmaHalf_ptr u_vector, magma_int_t inc_u, magmaHalf beta,
           magmaHalf_ptr v_vector, magma_int_t inc_v, magma_queue_t queue);
 
+// bfloat16 storage with fp32 scalars and accumulation.
+void gemv(magma_trans_t trans, magma_int_t num_rows, magma_int_t num_cols,
+          float alpha, __nv_bfloat16* mtx, magma_int_t ld,
+          __nv_bfloat16* u_vector, magma_int_t inc_u, float beta,
+          __nv_bfloat16* v_vector, magma_int_t inc_v, magma_queue_t queue);
+
 void trsv(magma_uplo_t uplo, magma_trans_t trans, magma_diag_t diag,
           magma_int_t n, magmaDouble_const_ptr dA, magma_int_t ldda,
           magmaDouble_ptr dx, magma_int_t incx, magma_queue_t queue);
@@ -86,6 +97,48 @@ void gemm(magma_trans_t transA, magma_trans_t transB, magma_int_t m,
           magmaHalf beta, magmaHalf_ptr dC, magma_int_t lddc,
           detail::magma_info& info);
 
+void gemm(magma_trans_t transA, magma_trans_t transB, magma_int_t m,
+          magma_int_t n, magma_int_t k, float alpha, const __nv_bfloat16* dA,
+          magma_int_t ldda, const __nv_bfloat16* dB, magma_int_t lddb,
+          float beta, __nv_bfloat16* dC, magma_int_t lddc,
+          detail::magma_info& info);
+
+void syrk(magma_uplo_t uplo, magma_trans_t trans, magma_int_t n,
+          magma_int_t k, double alpha, magmaDouble_const_ptr dA,
+          magma_int_t ldda, double beta, magmaDouble_ptr dC, magma_int_t lddc,
+          magma_queue_t queue);
+
+void syrk(magma_uplo_t uplo, magma_trans_t trans, magma_int_t n,
+          magma_int_t k, float alpha, magmaFloat_const_ptr dA,
+          magma_int_t ldda, float beta, magmaFloat_ptr dC, magma_int_t lddc,
+          magma_queue_t queue);
+
+void trsm(magma_side_t side, magma_uplo_t uplo, magma_trans_t trans,
+          magma_diag_t diag, magma_int_t m, magma_int_t n, double alpha,
+          magmaDouble_const_ptr dA, magma_int_t ldda, magmaDouble_ptr dB,
+          magma_int_t lddb, magma_queue_t queue);
+
+void trsm(magma_side_t side, magma_uplo_t uplo, magma_trans_t trans,
+          magma_diag_t diag, magma_int_t m, magma_int_t n, float alpha,
+          magmaFloat_const_ptr dA, magma_int_t ldda, magmaFloat_ptr dB,
+          magma_int_t lddb, magma_queue_t queue);
+
+void trmm(magma_side_t side, magma_uplo_t uplo, magma_trans_t trans,
+          magma_diag_t diag, magma_int_t m, magma_int_t n, double alpha,
+          magmaDouble_const_ptr dA, magma_int_t ldda, magmaDouble_ptr dB,
+          magma_int_t lddb, magma_queue_t queue);
+
+void trmm(magma_side_t side, magma_uplo_t uplo, magma_trans_t trans,
+          magma_diag_t diag, magma_int_t m, magma_int_t n, float alpha,
+          magmaFloat_const_ptr dA, magma_int_t ldda, magmaFloat_ptr dB,
+          magma_int_t lddb, magma_queue_t queue);
+
+magma_int_t potrf_gpu(magma_uplo_t uplo, magma_int_t n, magmaDouble_ptr dA,
+                      magma_int_t ldda, magma_int_t* info);
+
+magma_int_t potrf_gpu(magma_uplo_t uplo, magma_int_t n, magmaFloat_ptr dA,
+                      magma_int_t ldda, magma_int_t* info);
+
 magma_int_t geqrf2_gpu(magma_int_t m, magma_int_t n, magmaDouble_ptr dA,
                        magma_int_t ldda, double* tau, magma_int_t* info);
 
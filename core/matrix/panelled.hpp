@@ -0,0 +1,50 @@
+#ifndef RLS_MATRIX_PANELLED_HPP
+#define RLS_MATRIX_PANELLED_HPP
+
+
+#include <string>
+#include "../../utils/io.hpp"
+
+
+namespace rls {
+namespace matrix {
+
+
+// Dense matrix left in its file (binary container or MatrixMarket array) and
+// read in panels of consecutive rows by every product, so that it never has
+// to fit in memory. A * x and A^T * u are computed panel by panel while the
+// reader fetches the next panel in the background. Host backend only.
+template <typename value_type, typename index_type>
+struct panelled {
+    index_type num_rows = 0;
+    index_type num_cols = 0;
+    io::panel_file file;
+    io::panel_reader<value_type>* reader = nullptr;
+
+    // Opens filename with panels of panel_rows rows (0: about 64 MB). Returns
+    // false if the file cannot be read.
+    bool open(std::string filename, index_type panel_rows)
+    {
+        if (!io::open_panels((char*)filename.c_str(), panel_rows, &file)) {
+            return false;
+        }
+        num_rows = file.num_rows;
+        num_cols = file.num_cols;
+        reader = new io::panel_reader<value_type>(&file);
+        return true;
+    }
+
+    void free()
+    {
+        delete reader;
+        reader = nullptr;
+        io::close_panels(&file);
+    }
+};
+
+
+}  // namespace matrix
+}  // namespace rls
+
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef RLS_MATRIX_SPARSE_HPP
+#define RLS_MATRIX_SPARSE_HPP
+
+
+#include "../memory/memory.hpp"
+
+
+namespace rls {
+namespace matrix {
+
+
+// Sparse matrix in compressed sparse row (CSR) format. A * x is computed row
+// by row; A^T * u is computed from the same arrays by accumulating per-thread
+// partial results over blocks of rows, so no transposed copy is stored.
+template <typename value_type, typename index_type>
+struct sparse {
+    index_type num_rows = 0;
+    index_type num_cols = 0;
+    index_type nnz = 0;
+    index_type* row_ptrs = nullptr;
+    index_type* col_idxs = nullptr;
+    value_type* values = nullptr;
+
+    void allocate(index_type num_rows_in, index_type num_cols_in,
+                  index_type nnz_in)
+    {
+        num_rows = num_rows_in;
+        num_cols = num_cols_in;
+        nnz = nnz_in;
+        memory::malloc(&row_ptrs, num_rows + 1);
+        memory::malloc(&col_idxs, nnz);
+        memory::malloc(&values, nnz);
+    }
+
+    void free()
+    {
+        memory::release_demoted_copies(values);
+        memory::free(row_ptrs);
+        memory::free(col_idxs);
+        memory::free(values);
+        row_ptrs = nullptr;
+        col_idxs = nullptr;
+        values = nullptr;
+    }
+};
+
+
+}  // namespace matrix
+}  // namespace rls
+
+
+#endif
@@ -1,6 +1,7 @@
 #include <cuda_runtime.h>
 #include <curand.h>
 #include <time.h>
+#include <unistd.h>
 #include "cublas_v2.h"
 #include "cuda_fp16.h"
 #include "magma_lapack.h"
@@ -12,10 +13,20 @@
 
 namespace rls {
 namespace detail {
+namespace {
+
+
+backend active_backend = backend::cuda;
+
+
+}  // anonymous namespace
 
 
 void configure_magma(magma_info& magma_config)
 {
+    set_backend(backend::cuda);
+    magma_config.exec = backend::cuda;
+    magma_config.seed = time(NULL);
     magma_init();
     cudaStreamCreate(&magma_config.cuda_stream);
     cublasCreate(&magma_config.cublas_handle);
@@ -27,16 +38,59 @@ void configure_magma(magma_info& magma_config)
         &magma_config.queue);
     curandCreateGenerator(&magma_config.rand_generator,
                           CURAND_RNG_PSEUDO_DEFAULT);
-    curandSetPseudoRandomGeneratorSeed(magma_config.rand_generator, time(NULL));
+    curandSetPseudoRandomGeneratorSeed(magma_config.rand_generator,
+                                       magma_config.seed);
+}
+
+void configure_host(magma_info& magma_config)
+{
+    set_backend(backend::host);
+    magma_config.exec = backend::host;
+    magma_config.queue = nullptr;
+    magma_config.num_devices = 0;
+    magma_config.seed = time(NULL);
+}
+
+void set_backend(backend exec) { active_backend = exec; }
+
+backend get_backend() { return active_backend; }
+
+bool use_host_backend() { return active_backend == backend::host; }
+
+size_t available_memory()
+{
+    if (use_host_backend()) {
+        return static_cast<size_t>(sysconf(_SC_AVPHYS_PAGES)) *
+               static_cast<size_t>(sysconf(_SC_PAGE_SIZE));
+    }
+    size_t free_bytes = 0;
+    size_t total_bytes = 0;
+    cudaMemGetInfo(&free_bytes, &total_bytes);
+    return free_bytes;
+}
+
+double sync_wtime(magma_queue_t queue)
+{
+    if (use_host_backend()) {
+        return magma_wtime();
+    }
+    return magma_sync_wtime(queue);
 }
 
+// TF32 only exists on the device; on the host the fp32 kernels are used.
 void use_tf32_math_operations(magma_info& magma_config)
 {
+    if (magma_config.exec == backend::host) {
+        return;
+    }
     cublasSetMathMode(magma_config.cublas_handle, CUBLAS_TF32_TENSOR_OP_MATH);
 }
 
 void disable_tf32_math_operations(magma_info& magma_config)
 {
+    if (magma_config.exec == backend::host) {
+        return;
+    }
     cublasSetMathMode(magma_config.cublas_handle, CUBLAS_DEFAULT_MATH);
 }
 
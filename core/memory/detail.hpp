@@ -5,12 +5,16 @@
 #include <cuda_runtime.h>
 #include <curand.h>
 #include <time.h>
+#include <vector>
 #include "cublas_v2.h"
 #include "cuda_fp16.h"
 #include "magma_lapack.h"
 #include "magma_v2.h"
 
 
+#include "../../include/base_types.hpp"
+
+
 namespace rls {
 namespace detail {
 
@@ -18,18 +22,54 @@ namespace detail {
 #define CUDA_MAX_NUM_THREADS_PER_BLOCK 1024
 #define CUDA_MAX_NUM_THREADS_PER_BLOCK_2D 32
 
+// Selects where the blas and memory wrappers execute.
+enum class backend { cuda, host };
+
+// Selects the QR factorization of the sketch, see preconditioner::factorize.
+struct qr_options {
+    qr_type type = qr_type::householder;
+    // Rows of the leaf blocks of tsqr; 0 uses one block per host thread.
+    magma_int_t block_size = 0;
+    // Seconds spent in every level of the tsqr tree, leaves first. Added up
+    // over the factorizations like t_qr; reset by the caller.
+    std::vector<double> t_levels;
+    // Seconds spent by cholqr2 in forming the Gram matrices and in factoring
+    // them and applying the factors, accumulated like t_levels.
+    double t_gram = 0.0;
+    double t_factor = 0.0;
+};
+
 struct magma_info {
-    magma_queue_t queue;
+    magma_queue_t queue = nullptr;
     cudaStream_t cuda_stream;
     cublasHandle_t cublas_handle;
     cusparseHandle_t cusparse_handle;
     magma_device_t cuda_device;
     curandGenerator_t rand_generator;
-    magma_int_t num_devices;
+    magma_int_t num_devices = 0;
+    backend exec = backend::cuda;
+    unsigned long long seed = 0;
+    qr_options qr;
 };
 
 void configure_magma(magma_info& magma_config);
 
+// Configures the host backend; no CUDA/MAGMA resources are created.
+void configure_host(magma_info& magma_config);
+
+void set_backend(backend exec);
+
+backend get_backend();
+
+bool use_host_backend();
+
+// Returns the free memory in bytes of the active backend: device memory on
+// cuda, available physical memory on the host.
+size_t available_memory();
+
+// Synchronizes the active backend and returns the wall-clock time.
+double sync_wtime(magma_queue_t queue);
+
 void use_tf32_math_operations(magma_info& magma_config);
 
 void disable_tf32_math_operations(magma_info& magma_config);
@@ -1,33 +1,151 @@
 #include <cuda_runtime.h>
 #include <iostream>
+#include <map>
+#include <type_traits>
+#include <typeindex>
+#include <typeinfo>
 #include "cublas_v2.h"
 #include "cuda_fp16.h"
 #include "magma_lapack.h"
 #include "magma_v2.h"
 
 
+#include "../../cuda/preconditioner/preconditioner_kernels.cuh"
+#include "../../host/blas/blas_kernels.hpp"
+#include "../../host/preconditioner/preconditioner_kernels.hpp"
+#include "detail.hpp"
+#include "memory.hpp"
+
+
 namespace rls {
 namespace memory {
+namespace {
+
+
+struct cached_copy {
+    void* values;
+    magma_int_t num_rows;
+    magma_int_t num_cols;
+    void (*release)(void*);
+};
+
+typedef std::map<std::pair<const void*, std::type_index>, cached_copy>
+    copy_cache;
+
+// Copies made by demoted_copy, keyed on the source buffer and the precision
+// of the copy.
+copy_cache& demoted_copies()
+{
+    static copy_cache cache;
+    return cache;
+}
+
+template <typename value_type>
+void release_copy(void* values)
+{
+    free(static_cast<value_type*>(values));
+}
+
+
+}  // end of anonymous namespace
 
 
-void malloc(magmaDouble_ptr* ptr, size_t n) { magma_dmalloc(ptr, n); }
+// On the host backend "device" buffers are aligned host allocations, so the
+// same pointers can be handed to the blas wrappers regardless of backend.
+
+void malloc(magmaDouble_ptr* ptr, size_t n)
+{
+    if (detail::use_host_backend()) {
+        magma_dmalloc_cpu(ptr, n);
+        return;
+    }
+    magma_dmalloc(ptr, n);
+}
 
-void malloc(magmaFloat_ptr* ptr, size_t n) { magma_smalloc(ptr, n); }
+void malloc(magmaFloat_ptr* ptr, size_t n)
+{
+    if (detail::use_host_backend()) {
+        magma_smalloc_cpu(ptr, n);
+        return;
+    }
+    magma_smalloc(ptr, n);
+}
 
 void malloc(__half** ptr, size_t n)
 {
+    if (detail::use_host_backend()) {
+        magma_malloc_cpu((void**)ptr, n * sizeof(magmaHalf));
+        return;
+    }
     magma_malloc((magma_ptr*)ptr, n * sizeof(magmaHalf));
 }
 
+void malloc(__nv_bfloat16** ptr, size_t n)
+{
+    if (detail::use_host_backend()) {
+        magma_malloc_cpu((void**)ptr, n * sizeof(__nv_bfloat16));
+        return;
+    }
+    magma_malloc((magma_ptr*)ptr, n * sizeof(__nv_bfloat16));
+}
+
+void malloc(magmaInt_ptr* ptr, size_t n)
+{
+    if (detail::use_host_backend()) {
+        magma_imalloc_cpu(ptr, n);
+        return;
+    }
+    magma_imalloc(ptr, n);
+}
+
 void malloc_cpu(double** ptr_ptr, size_t n) { magma_dmalloc_cpu(ptr_ptr, n); }
 
 void malloc_cpu(float** ptr_ptr, size_t n) { magma_smalloc_cpu(ptr_ptr, n); }
 
-void free(magmaDouble_ptr ptr) { magma_free(ptr); }
+void free(magmaDouble_ptr ptr)
+{
+    if (detail::use_host_backend()) {
+        magma_free_cpu(ptr);
+        return;
+    }
+    magma_free(ptr);
+}
+
+void free(magmaFloat_ptr ptr)
+{
+    if (detail::use_host_backend()) {
+        magma_free_cpu(ptr);
+        return;
+    }
+    magma_free(ptr);
+}
+
+void free(magmaHalf_ptr ptr)
+{
+    if (detail::use_host_backend()) {
+        magma_free_cpu(ptr);
+        return;
+    }
+    magma_free(ptr);
+}
 
-void free(magmaFloat_ptr ptr) { magma_free(ptr); }
+void free(__nv_bfloat16* ptr)
+{
+    if (detail::use_host_backend()) {
+        magma_free_cpu(ptr);
+        return;
+    }
+    magma_free(ptr);
+}
 
-void free(magmaHalf_ptr ptr) { magma_free(ptr); }
+void free(magmaInt_ptr ptr)
+{
+    if (detail::use_host_backend()) {
+        magma_free_cpu(ptr);
+        return;
+    }
+    magma_free(ptr);
+}
 
 void free_cpu(magmaDouble_ptr ptr) { magma_free_cpu(ptr); }
 
@@ -36,15 +154,182 @@ void free_cpu(magmaFloat_ptr ptr) { magma_free_cpu(ptr); }
 void setmatrix(magma_int_t m, magma_int_t n, double* A, magma_int_t ldA,
                double* B, magma_int_t ldB, magma_queue_t queue)
 {
+    if (detail::use_host_backend()) {
+        host::copy_matrix(m, n, A, ldA, B, ldB);
+        return;
+    }
     magma_dsetmatrix(m, n, A, ldA, B, ldB, queue);
 }
 
 void setmatrix(magma_int_t m, magma_int_t n, float* A, magma_int_t ldA,
                float* B, magma_int_t ldB, magma_queue_t queue)
 {
+    if (detail::use_host_backend()) {
+        host::copy_matrix(m, n, A, ldA, B, ldB);
+        return;
+    }
     magma_ssetmatrix(m, n, A, ldA, B, ldB, queue);
 }
 
+void getmatrix(magma_int_t m, magma_int_t n, double* A, magma_int_t ldA,
+               double* B, magma_int_t ldB, magma_queue_t queue)
+{
+    if (detail::use_host_backend()) {
+        host::copy_matrix(m, n, A, ldA, B, ldB);
+        return;
+    }
+    magma_dgetmatrix(m, n, A, ldA, B, ldB, queue);
+}
+
+void getmatrix(magma_int_t m, magma_int_t n, float* A, magma_int_t ldA,
+               float* B, magma_int_t ldB, magma_queue_t queue)
+{
+    if (detail::use_host_backend()) {
+        host::copy_matrix(m, n, A, ldA, B, ldB);
+        return;
+    }
+    magma_sgetmatrix(m, n, A, ldA, B, ldB, queue);
+}
+
+template <typename value_type_in, typename value_type, typename index_type>
+void demote(index_type num_rows, index_type num_cols, value_type* mtx,
+            index_type ld_mtx, value_type_in* mtx_rp, index_type ld_mtx_rp)
+{
+    if (detail::use_host_backend()) {
+        host::demote(num_rows, num_cols, mtx, ld_mtx, mtx_rp, ld_mtx_rp);
+        return;
+    }
+    cuda::demote(num_rows, num_cols, mtx, ld_mtx, mtx_rp, ld_mtx_rp);
+}
+
+template <typename value_type_in, typename value_type, typename index_type>
+void promote(index_type num_rows, index_type num_cols, value_type_in* mtx,
+             index_type ld_mtx, value_type* mtx_ip, index_type ld_mtx_ip)
+{
+    if (detail::use_host_backend()) {
+        host::promote(num_rows, num_cols, mtx, ld_mtx, mtx_ip, ld_mtx_ip);
+        return;
+    }
+    cuda::promote(num_rows, num_cols, mtx, ld_mtx, mtx_ip, ld_mtx_ip);
+}
+
+
+template void demote(magma_int_t num_rows, magma_int_t num_cols, double* mtx,
+                     magma_int_t ld_mtx, double* mtx_rp,
+                     magma_int_t ld_mtx_rp);
+
+template void demote(magma_int_t num_rows, magma_int_t num_cols, double* mtx,
+                     magma_int_t ld_mtx, float* mtx_rp, magma_int_t ld_mtx_rp);
+
+template void demote(magma_int_t num_rows, magma_int_t num_cols, double* mtx,
+                     magma_int_t ld_mtx, __half* mtx_rp,
+                     magma_int_t ld_mtx_rp);
+
+template void demote(magma_int_t num_rows, magma_int_t num_cols, double* mtx,
+                     magma_int_t ld_mtx, __nv_bfloat16* mtx_rp,
+                     magma_int_t ld_mtx_rp);
+
+template void demote(magma_int_t num_rows, magma_int_t num_cols, float* mtx,
+                     magma_int_t ld_mtx, float* mtx_rp, magma_int_t ld_mtx_rp);
+
+template void demote(magma_int_t num_rows, magma_int_t num_cols, float* mtx,
+                     magma_int_t ld_mtx, __half* mtx_rp,
+                     magma_int_t ld_mtx_rp);
+
+template void demote(magma_int_t num_rows, magma_int_t num_cols, float* mtx,
+                     magma_int_t ld_mtx, __nv_bfloat16* mtx_rp,
+                     magma_int_t ld_mtx_rp);
+
+template void promote(magma_int_t num_rows, magma_int_t num_cols, double* mtx,
+                      magma_int_t ld_mtx, double* mtx_ip,
+                      magma_int_t ld_mtx_ip);
+
+template void promote(magma_int_t num_rows, magma_int_t num_cols, float* mtx,
+                      magma_int_t ld_mtx, double* mtx_ip,
+                      magma_int_t ld_mtx_ip);
+
+template void promote(magma_int_t num_rows, magma_int_t num_cols, __half* mtx,
+                      magma_int_t ld_mtx, double* mtx_ip,
+                      magma_int_t ld_mtx_ip);
+
+template void promote(magma_int_t num_rows, magma_int_t num_cols,
+                      __nv_bfloat16* mtx, magma_int_t ld_mtx, double* mtx_ip,
+                      magma_int_t ld_mtx_ip);
+
+template void promote(magma_int_t num_rows, magma_int_t num_cols, float* mtx,
+                      magma_int_t ld_mtx, float* mtx_ip, magma_int_t ld_mtx_ip);
+
+template void promote(magma_int_t num_rows, magma_int_t num_cols, __half* mtx,
+                      magma_int_t ld_mtx, float* mtx_ip, magma_int_t ld_mtx_ip);
+
+template void promote(magma_int_t num_rows, magma_int_t num_cols,
+                      __nv_bfloat16* mtx, magma_int_t ld_mtx, float* mtx_ip,
+                      magma_int_t ld_mtx_ip);
+
+
+template <typename value_type_in, typename value_type, typename index_type>
+value_type_in* demoted_copy(index_type num_rows, index_type num_cols,
+                            value_type* mtx, index_type ld_mtx)
+{
+    if (std::is_same<value_type_in, value_type>::value) {
+        return reinterpret_cast<value_type_in*>(mtx);
+    }
+    auto& cache = demoted_copies();
+    auto key = std::make_pair(static_cast<const void*>(mtx),
+                              std::type_index(typeid(value_type_in)));
+    auto it = cache.find(key);
+    if (it != cache.end()) {
+        if ((it->second.num_rows == num_rows) &&
+            (it->second.num_cols == num_cols)) {
+            return static_cast<value_type_in*>(it->second.values);
+        }
+        it->second.release(it->second.values);
+        cache.erase(it);
+    }
+    value_type_in* values = nullptr;
+    malloc(&values, static_cast<size_t>(num_rows) * num_cols);
+    demote(num_rows, num_cols, mtx, ld_mtx, values, num_rows);
+    cached_copy copy = {values, num_rows, num_cols,
+                        release_copy<value_type_in>};
+    cache.insert(std::make_pair(key, copy));
+    return values;
+}
+
+void release_demoted_copies(const void* mtx)
+{
+    auto& cache = demoted_copies();
+    for (auto it = cache.begin(); it != cache.end();) {
+        if (it->first.first == mtx) {
+            it->second.release(it->second.values);
+            it = cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+
+template double* demoted_copy(magma_int_t num_rows, magma_int_t num_cols,
+                              double* mtx, magma_int_t ld_mtx);
+
+template float* demoted_copy(magma_int_t num_rows, magma_int_t num_cols,
+                             double* mtx, magma_int_t ld_mtx);
+
+template __half* demoted_copy(magma_int_t num_rows, magma_int_t num_cols,
+                              double* mtx, magma_int_t ld_mtx);
+
+template __nv_bfloat16* demoted_copy(magma_int_t num_rows, magma_int_t num_cols,
+                              double* mtx, magma_int_t ld_mtx);
+
+template float* demoted_copy(magma_int_t num_rows, magma_int_t num_cols,
+                             float* mtx, magma_int_t ld_mtx);
+
+template __half* demoted_copy(magma_int_t num_rows, magma_int_t num_cols,
+                              float* mtx, magma_int_t ld_mtx);
+
+template __nv_bfloat16* demoted_copy(magma_int_t num_rows, magma_int_t num_cols,
+                              float* mtx, magma_int_t ld_mtx);
+
 
 }  // end of namespace memory
 }  // end of namespace rls
@@ -2,6 +2,7 @@
 #define BLENDNPIK_MEMORY_HPP
 
 
+#include "cuda_bf16.h"
 #include "magma_v2.h"
 
 
@@ -15,6 +16,10 @@ void malloc(magmaFloat_ptr* ptr, size_t n);
 
 void malloc(magmaHalf_ptr* ptr, size_t n);
 
+void malloc(__nv_bfloat16** ptr, size_t n);
+
+void malloc(magmaInt_ptr* ptr, size_t n);
+
 void malloc_cpu(double** ptr_ptr, size_t n);
 
 void malloc_cpu(float** ptr_ptr, size_t n);
@@ -25,6 +30,10 @@ void free(magmaFloat_ptr ptr);
 
 void free(magmaHalf_ptr ptr);
 
+void free(__nv_bfloat16* ptr);
+
+void free(magmaInt_ptr ptr);
+
 void free_cpu(magmaDouble_ptr ptr);
 
 void free_cpu(magmaFloat_ptr ptr);
@@ -35,6 +44,33 @@ void setmatrix(magma_int_t m, magma_int_t n, double* A, magma_int_t ldA,
 void setmatrix(magma_int_t m, magma_int_t n, float* A, magma_int_t ldA,
                float* B, magma_int_t ldB, magma_queue_t queue);
 
+void getmatrix(magma_int_t m, magma_int_t n, double* A, magma_int_t ldA,
+               double* B, magma_int_t ldB, magma_queue_t queue);
+
+void getmatrix(magma_int_t m, magma_int_t n, float* A, magma_int_t ldA,
+               float* B, magma_int_t ldB, magma_queue_t queue);
+
+// Precision conversions on the active backend (cuda:: or host:: kernels).
+template <typename value_type_in, typename value_type, typename index_type>
+void demote(index_type num_rows, index_type num_cols, value_type* mtx,
+            index_type ld_mtx, value_type_in* mtx_rp, index_type ld_mtx_rp);
+
+template <typename value_type_in, typename value_type, typename index_type>
+void promote(index_type num_rows, index_type num_cols, value_type_in* mtx,
+             index_type ld_mtx, value_type* mtx_ip, index_type ld_mtx_ip);
+
+// Returns a copy of mtx in value_type_in precision with leading dimension
+// num_rows. Copies are cached on the mtx buffer and precision, so the
+// preconditioner and every solve on the same matrix share one demotion; mtx
+// itself is returned if no conversion is needed. The copies of a buffer stay
+// alive until release_demoted_copies is called on it, which must happen
+// before the buffer is freed or its values change.
+template <typename value_type_in, typename value_type, typename index_type>
+value_type_in* demoted_copy(index_type num_rows, index_type num_cols,
+                            value_type* mtx, index_type ld_mtx);
+
+void release_demoted_copies(const void* mtx);
+
 
 }  // end of namespace memory
 }  // end of namespace rls
@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+
+#include "../../include/base_types.hpp"
+#include "../memory/detail.hpp"
+#include "../memory/memory.hpp"
+#include "../solver/lsqr.hpp"
+#include "condition.hpp"
+
+
+namespace rls {
+namespace preconditioner {
+namespace {
+
+
+// Returns the number of eigenvalues of the symmetric tridiagonal matrix
+// (diag, offdiag) that are smaller than shift (Sturm count).
+int count_below(const std::vector<double>& diag,
+                const std::vector<double>& offdiag, double shift)
+{
+    int count = 0;
+    double q = 1.0;
+    for (std::size_t i = 0; i < diag.size(); i++) {
+        double off = (i > 0) ? offdiag[i - 1] * offdiag[i - 1] / q : 0.0;
+        q = diag[i] - shift - off;
+        if (q == 0.0) {
+            q = -std::numeric_limits<double>::min();
+        }
+        if (q < 0.0) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// Returns the eigenvalue of the symmetric tridiagonal matrix (diag, offdiag)
+// with the given index in ascending order, by bisection in the Gershgorin
+// interval.
+double tridiagonal_eigenvalue(const std::vector<double>& diag,
+                              const std::vector<double>& offdiag, int index)
+{
+    double lower = std::numeric_limits<double>::max();
+    double upper = -std::numeric_limits<double>::max();
+    for (std::size_t i = 0; i < diag.size(); i++) {
+        double radius = ((i > 0) ? std::abs(offdiag[i - 1]) : 0.0) +
+                        ((i + 1 < diag.size()) ? std::abs(offdiag[i]) : 0.0);
+        lower = std::min(lower, diag[i] - radius);
+        upper = std::max(upper, diag[i] + radius);
+    }
+    for (int it = 0; it < 200; it++) {
+        double mid = 0.5 * (lower + upper);
+        if ((mid <= lower) || (mid >= upper)) {
+            break;
+        }
+        if (count_below(diag, offdiag, mid) > index) {
+            upper = mid;
+        } else {
+            lower = mid;
+        }
+    }
+    return 0.5 * (lower + upper);
+}
+
+template <typename value_type, typename index_type, typename matrix_type>
+double estimate(index_type num_rows, index_type num_cols, matrix_type mtx,
+                value_type* precond_mtx, index_type ld_precond,
+                index_type num_steps, magma_queue_t queue)
+{
+    // The start vector is drawn on the host with a fixed seed so repeated
+    // estimates of the same preconditioner agree.
+    std::vector<value_type> start_host(num_rows);
+    std::mt19937 generator(0);
+    std::normal_distribution<double> normal(0.0, 1.0);
+    for (auto& value : start_host) {
+        value = static_cast<value_type>(normal(generator));
+    }
+    value_type* start = nullptr;
+    memory::malloc(&start, num_rows);
+    memory::setmatrix(num_rows, 1, start_host.data(), num_rows, start,
+                      num_rows, queue);
+
+    solver::lsqr::workspace<value_type, value_type, index_type> ws;
+    solver::lsqr::temp_scalars<value_type, index_type> scalars;
+    solver::lsqr::start_bidiagonalization(num_rows, num_cols, mtx, start,
+                                          precond_mtx, ld_precond, scalars, ws,
+                                          queue);
+    std::vector<double> alpha(1, scalars.alpha);
+    std::vector<double> beta;
+    num_steps = std::min(num_steps, num_cols);
+    for (index_type step = 0; (step < num_steps) && (alpha.back() > 0);
+         step++) {
+        solver::lsqr::bidiagonalize(num_rows, num_cols, mtx, precond_mtx,
+                                    ld_precond, scalars, ws, queue);
+        beta.push_back(scalars.beta);
+        alpha.push_back(scalars.alpha);
+    }
+    ws.free();
+    memory::free(start);
+    if (beta.empty()) {
+        return 1.0;
+    }
+
+    // B^T * B for the (k + 1) x k lower bidiagonal B with diagonal alpha and
+    // subdiagonal beta.
+    auto k = beta.size();
+    std::vector<double> diag(k);
+    std::vector<double> offdiag(k - 1);
+    for (std::size_t i = 0; i < k; i++) {
+        diag[i] = alpha[i] * alpha[i] + beta[i] * beta[i];
+        if (i + 1 < k) {
+            offdiag[i] = beta[i] * alpha[i + 1];
+        }
+    }
+    auto largest = tridiagonal_eigenvalue(diag, offdiag, k - 1);
+    auto smallest = tridiagonal_eigenvalue(diag, offdiag, 0);
+    if (smallest <= 0.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return std::sqrt(largest / smallest);
+}
+
+
+}  // end of anonymous namespace
+
+
+template <typename value_type, typename index_type>
+double estimate_condition(index_type num_rows, index_type num_cols,
+                          value_type* mtx, value_type* precond_mtx,
+                          index_type ld_precond, index_type num_steps,
+                          magma_queue_t queue)
+{
+    return estimate(num_rows, num_cols, mtx, precond_mtx, ld_precond,
+                    num_steps, queue);
+}
+
+template <typename value_type, typename index_type>
+double estimate_condition(matrix::sparse<value_type, index_type>* mtx,
+                          value_type* precond_mtx, index_type ld_precond,
+                          index_type num_steps, magma_queue_t queue)
+{
+    return estimate(mtx->num_rows, mtx->num_cols, mtx, precond_mtx,
+                    ld_precond, num_steps, queue);
+}
+
+
+template double estimate_condition(magma_int_t num_rows, magma_int_t num_cols,
+                                   double* mtx, double* precond_mtx,
+                                   magma_int_t ld_precond,
+                                   magma_int_t num_steps, magma_queue_t queue);
+
+template double estimate_condition(magma_int_t num_rows, magma_int_t num_cols,
+                                   float* mtx, float* precond_mtx,
+                                   magma_int_t ld_precond,
+                                   magma_int_t num_steps, magma_queue_t queue);
+
+template double estimate_condition(matrix::sparse<double, magma_int_t>* mtx,
+                                   double* precond_mtx, magma_int_t ld_precond,
+                                   magma_int_t num_steps, magma_queue_t queue);
+
+template double estimate_condition(matrix::sparse<float, magma_int_t>* mtx,
+                                   float* precond_mtx, magma_int_t ld_precond,
+                                   magma_int_t num_steps, magma_queue_t queue);
+
+
+}  // namespace preconditioner
+}  // namespace rls
@@ -0,0 +1,27 @@
+#include "../matrix/sparse.hpp"
+#include "../memory/detail.hpp"
+
+
+namespace rls {
+namespace preconditioner {
+
+
+// Estimates cond(A * R^{-1}) from num_steps steps of the Golub-Kahan
+// bidiagonalization of A * R^{-1}, started from a fixed pseudo-random vector.
+// The extreme singular values of the bidiagonal matrix approach those of
+// A * R^{-1} from inside, so the estimate is a lower bound that tightens with
+// num_steps; for a good preconditioner a few steps suffice. Costs 2 *
+// num_steps passes over mtx.
+template <typename value_type, typename index_type>
+double estimate_condition(index_type num_rows, index_type num_cols,
+                          value_type* mtx, value_type* precond_mtx,
+                          index_type ld_precond, index_type num_steps,
+                          magma_queue_t queue);
+
+template <typename value_type, typename index_type>
+double estimate_condition(matrix::sparse<value_type, index_type>* mtx,
+                          value_type* precond_mtx, index_type ld_precond,
+                          index_type num_steps, magma_queue_t queue);
+
+}  // namespace preconditioner
+}  // namespace rls
@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+
+#include "../../host/blas/blas_kernels.hpp"
+#include "../../host/preconditioner/preconditioner_kernels.hpp"
+#include "../../include/base_types.hpp"
+#include "../blas/blas.hpp"
+#include "../memory/detail.hpp"
+#include "../memory/memory.hpp"
+#include "factorize.hpp"
+
+
+namespace rls {
+namespace preconditioner {
+namespace {
+
+
+// Runs host::tsqr on dr_factor, through a host copy on the cuda backend, and
+// adds the time of every level to info.qr.t_levels.
+template <typename value_type, typename index_type>
+index_type tsqr(index_type num_rows, index_type num_cols, value_type* dr_factor,
+                index_type ld_r_factor, detail::magma_info& info)
+{
+    std::vector<double> t_levels;
+    index_type info_qr = 0;
+    if (detail::use_host_backend()) {
+        info_qr = host::tsqr(num_rows, num_cols, dr_factor, ld_r_factor,
+                             info.qr.block_size, &t_levels);
+    } else {
+        value_type* r_factor = nullptr;
+        memory::malloc_cpu(&r_factor, num_rows * num_cols);
+        memory::getmatrix(num_rows, num_cols, dr_factor, ld_r_factor,
+                          r_factor, num_rows, info.queue);
+        info_qr = host::tsqr(num_rows, num_cols, r_factor, num_rows,
+                             info.qr.block_size, &t_levels);
+        memory::setmatrix(num_cols, num_cols, r_factor, num_rows, dr_factor,
+                          ld_r_factor, info.queue);
+        memory::free_cpu(r_factor);
+    }
+    auto& total = info.qr.t_levels;
+    total.resize(std::max(total.size(), t_levels.size()), 0.0);
+    for (std::size_t level = 0; level < t_levels.size(); level++) {
+        total[level] += t_levels[level];
+    }
+    return info_qr;
+}
+
+
+// One CholeskyQR pass: dgram = chol(A^T A + shift * I) and, when the Cholesky
+// factorization succeeds, A = A * dgram^-1, with A the sketch in dr_factor.
+// The shifted pass uses shift = 11 (m n + n (n + 1)) u ||A||_F^2, which keeps
+// the Gram matrix positive definite for cond(A) up to about u^-1; gram is a
+// num_cols x num_cols host buffer for applying it.
+template <typename value_type, typename index_type>
+index_type cholqr(index_type num_rows, index_type num_cols,
+                  value_type* dr_factor, index_type ld_r_factor,
+                  value_type* dgram, value_type* gram, bool shifted,
+                  detail::magma_info& info)
+{
+    auto t = detail::sync_wtime(info.queue);
+    blas::syrk(MagmaUpper, MagmaTrans, num_cols, num_rows, 1.0, dr_factor,
+               ld_r_factor, 0.0, dgram, num_cols, info.queue);
+    if (shifted) {
+        memory::getmatrix(num_cols, num_cols, dgram, num_cols, gram, num_cols,
+                          info.queue);
+        double m = num_rows;
+        double n = num_cols;
+        double norm_squared = 0.0;
+        for (index_type i = 0; i < num_cols; i++) {
+            norm_squared += gram[i + i * num_cols];
+        }
+        double shift = 11.0 * (m * n + n * (n + 1)) *
+                       (std::numeric_limits<value_type>::epsilon() / 2) *
+                       norm_squared;
+        for (index_type i = 0; i < num_cols; i++) {
+            gram[i + i * num_cols] += shift;
+        }
+        memory::setmatrix(num_cols, num_cols, gram, num_cols, dgram, num_cols,
+                          info.queue);
+    }
+    auto t_factor = detail::sync_wtime(info.queue);
+    info.qr.t_gram += t_factor - t;
+    magma_int_t info_chol = 0;
+    blas::potrf_gpu(MagmaUpper, num_cols, dgram, num_cols, &info_chol);
+    if (info_chol == 0) {
+        blas::trsm(MagmaRight, MagmaUpper, MagmaNoTrans, MagmaNonUnit,
+                   num_rows, num_cols, 1.0, dgram, num_cols, dr_factor,
+                   ld_r_factor, info.queue);
+    }
+    info.qr.t_factor += detail::sync_wtime(info.queue) - t_factor;
+    return info_chol;
+}
+
+// CholeskyQR2: two CholeskyQR passes, the second one orthogonalizing the Q of
+// the first, whose triangles multiply to R. If the first Cholesky
+// factorization fails, a shifted pass followed by two plain ones is used
+// instead (shifted CholeskyQR3). Q is overwritten by R at the end. Returns
+// the failing potrf info otherwise, with the sketch restored up to rounding.
+template <typename value_type, typename index_type>
+index_type cholqr2(index_type num_rows, index_type num_cols,
+                   value_type* dr_factor, index_type ld_r_factor,
+                   detail::magma_info& info)
+{
+    value_type* dgram = nullptr;
+    value_type* gram = nullptr;
+    value_type* r_factor = nullptr;
+    memory::malloc(&dgram, num_cols * num_cols);
+    memory::malloc_cpu(&gram, num_cols * num_cols);
+    memory::malloc_cpu(&r_factor, num_cols * num_cols);
+    auto num_passes = 2;
+    auto info_chol = cholqr(num_rows, num_cols, dr_factor, ld_r_factor, dgram,
+                            gram, false, info);
+    if (info_chol != 0) {
+        num_passes = 3;
+        info_chol = cholqr(num_rows, num_cols, dr_factor, ld_r_factor, dgram,
+                           gram, true, info);
+    }
+    if (info_chol == 0) {
+        auto t = detail::sync_wtime(info.queue);
+        memory::getmatrix(num_cols, num_cols, dgram, num_cols, r_factor,
+                          num_cols, info.queue);
+        for (index_type col = 0; col < num_cols; col++) {
+            std::fill(r_factor + col * num_cols + col + 1,
+                      r_factor + (col + 1) * num_cols, value_type(0));
+        }
+        info.qr.t_factor += detail::sync_wtime(info.queue) - t;
+    }
+    for (auto pass = 1; (pass < num_passes) && (info_chol == 0); pass++) {
+        info_chol = cholqr(num_rows, num_cols, dr_factor, ld_r_factor, dgram,
+                           gram, false, info);
+        auto t = detail::sync_wtime(info.queue);
+        if (info_chol == 0) {
+            memory::getmatrix(num_cols, num_cols, dgram, num_cols, gram,
+                              num_cols, info.queue);
+            host::trmm(MagmaLeft, MagmaUpper, MagmaNoTrans, MagmaNonUnit,
+                       num_cols, num_cols, 1.0, gram, num_cols, r_factor,
+                       num_cols);
+        } else {
+            memory::setmatrix(num_cols, num_cols, r_factor, num_cols, dgram,
+                              num_cols, info.queue);
+            blas::trmm(MagmaRight, MagmaUpper, MagmaNoTrans, MagmaNonUnit,
+                       num_rows, num_cols, 1.0, dgram, num_cols, dr_factor,
+                       ld_r_factor, info.queue);
+        }
+        info.qr.t_factor += detail::sync_wtime(info.queue) - t;
+    }
+    if (info_chol == 0) {
+        memory::setmatrix(num_cols, num_cols, r_factor, num_cols, dr_factor,
+                          ld_r_factor, info.queue);
+    }
+    memory::free(dgram);
+    memory::free_cpu(gram);
+    memory::free_cpu(r_factor);
+    return info_chol;
+}
+
+template <typename value_type, typename index_type>
+index_type householder(index_type num_rows, index_type num_cols,
+                       value_type* dr_factor, index_type ld_r_factor)
+{
+    magma_int_t info_qr = 0;
+    value_type* tau = nullptr;
+    memory::malloc_cpu(&tau, num_rows);
+    blas::geqrf2_gpu(num_rows, num_cols, dr_factor, ld_r_factor, tau,
+                     &info_qr);
+    memory::free_cpu(tau);
+    return info_qr;
+}
+
+
+}  // anonymous namespace
+
+
+template <typename value_type, typename index_type>
+void factorize(index_type num_rows, index_type num_cols, value_type* dr_factor,
+               index_type ld_r_factor, detail::magma_info& info,
+               double* runtime, double* t_mm, double* t_qr)
+{
+    magma_int_t info_qr = 0;
+    auto t = detail::sync_wtime(info.queue);
+    if (info.qr.type == qr_type::tsqr) {
+        info_qr = tsqr(num_rows, num_cols, dr_factor, ld_r_factor, info);
+    } else if (info.qr.type == qr_type::cholqr2) {
+        info_qr = cholqr2(num_rows, num_cols, dr_factor, ld_r_factor, info);
+        if (info_qr != 0) {
+            printf(">>> cholqr2 failed (potrf info %d), falling back to "
+                   "householder qr\n",
+                   static_cast<int>(info_qr));
+            info_qr = householder(num_rows, num_cols, dr_factor, ld_r_factor);
+        }
+    } else {
+        info_qr = householder(num_rows, num_cols, dr_factor, ld_r_factor);
+    }
+    auto dt_qr = (detail::sync_wtime(info.queue) - t);
+    *t_mm += *runtime;
+    *t_qr += dt_qr;
+    *runtime += dt_qr;
+    if (info_qr == 0) {
+        printf(">>> qr exited without errors\n");
+    } else {
+        magma_xerbla("geqrf2_gpu", info_qr);
+    }
+}
+
+
+template void factorize(magma_int_t num_rows, magma_int_t num_cols,
+                        double* dr_factor, magma_int_t ld_r_factor,
+                        detail::magma_info& info, double* runtime,
+                        double* t_mm, double* t_qr);
+
+template void factorize(magma_int_t num_rows, magma_int_t num_cols,
+                        float* dr_factor, magma_int_t ld_r_factor,
+                        detail::magma_info& info, double* runtime,
+                        double* t_mm, double* t_qr);
+
+
+}  // namespace preconditioner
+}  // namespace rls
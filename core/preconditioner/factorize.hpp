@@ -0,0 +1,24 @@
+#include "../memory/detail.hpp"
+
+
+namespace rls {
+namespace preconditioner {
+
+
+// Computes the R factor of the num_rows x num_cols sketch in dr_factor, in
+// place and in value_type precision, with the factorization selected by
+// info.qr: Householder QR on the active backend (geqrf2_gpu), a tall-skinny
+// QR on the host threads (host::tsqr, see there), which copies the sketch to
+// the host on the cuda backend, or CholeskyQR2 (syrk + potrf twice, shifted
+// when the first potrf fails) on the active backend, which falls back to
+// Householder QR when a Cholesky factorization fails. Only the upper triangle
+// of the leading num_cols rows is meaningful afterwards. Adds runtime to t_mm
+// and the time of the factorization to t_qr and runtime, as the generate
+// functions do.
+template <typename value_type, typename index_type>
+void factorize(index_type num_rows, index_type num_cols, value_type* dr_factor,
+               index_type ld_r_factor, detail::magma_info& info,
+               double* runtime, double* t_mm, double* t_qr);
+
+}  // namespace preconditioner
+}  // namespace rls
@@ -2,10 +2,12 @@
 
 
 #include "../../cuda/preconditioner/preconditioner_kernels.cuh"
+#include "../../host/preconditioner/preconditioner_kernels.hpp"
 #include "../../include/base_types.hpp"
 #include "../blas/blas.hpp"
 #include "../memory/detail.hpp"
 #include "../memory/memory.hpp"
+#include "factorize.hpp"
 #include "gaussian.hpp"
 #include "../../utils/io.hpp"
 
@@ -28,23 +30,20 @@ void generate(index_type num_rows_sketch, index_type num_cols_sketch,
     // Performs matrix-matrix multiplication in value_type_internal precision
     // and promotes output to value_type precision.
     if (!std::is_same<value_type_internal, value_type>::value) {
-        value_type_internal* dmtx_rp = nullptr;
         value_type_internal* dsketch_rp = nullptr;
         value_type_internal* dresult_rp = nullptr;
-        memory::malloc(&dmtx_rp, ld_mtx * num_cols_mtx);
         memory::malloc(&dsketch_rp, ld_sketch * num_cols_sketch);
         memory::malloc(&dresult_rp, ld_r_factor * num_cols_mtx);
-        cuda::demote(num_rows_mtx, num_cols_mtx, dmtx, num_rows_mtx, dmtx_rp,
-                     num_rows_mtx);
-        cuda::demote(num_rows_sketch, num_cols_sketch, dsketch, num_rows_sketch,
-                     dsketch_rp, num_rows_sketch);
+        auto dmtx_rp = memory::demoted_copy<value_type_internal>(
+            num_rows_mtx, num_cols_mtx, dmtx, ld_mtx);
+        memory::demote(num_rows_sketch, num_cols_sketch, dsketch,
+                       num_rows_sketch, dsketch_rp, num_rows_sketch);
         blas::gemm(MagmaNoTrans, MagmaNoTrans, num_rows_sketch, num_cols_mtx,
                    num_rows_mtx, 1.0, dsketch_rp, num_rows_sketch, dmtx_rp,
                    num_rows_mtx, 0.0, dresult_rp, num_rows_sketch, info);
         cudaDeviceSynchronize();
-        cuda::promote(num_rows_sketch, num_cols_mtx, dresult_rp,
-                      num_rows_sketch, dr_factor, num_rows_sketch);
-        memory::free(dmtx_rp);
+        memory::promote(num_rows_sketch, num_cols_mtx, dresult_rp,
+                        num_rows_sketch, dr_factor, num_rows_sketch);
         memory::free(dsketch_rp);
         memory::free(dresult_rp);
     } else {
@@ -69,66 +68,198 @@ void generate(index_type num_rows_sketch, index_type num_cols_sketch,
     memory::free_cpu(tau);
 }
 
-// Generates the preconditioner and measures runtime.
+// Forms dsketch * A and measures runtime.
 template <typename value_type_internal, typename value_type,
           typename index_type>
-void generate(index_type num_rows_sketch, index_type num_cols_sketch,
-              value_type* dsketch, index_type ld_sketch,
-              index_type num_rows_mtx, index_type num_cols_mtx,
-              value_type* dmtx, index_type ld_mtx, value_type* dr_factor,
-              index_type ld_r_factor,
-              state<value_type_internal, value_type, index_type>* precond_state, 
-              detail::magma_info& info, double* runtime, double* t_mm,
-              double* t_qr)
+void sketch(index_type num_rows_sketch, index_type num_cols_sketch,
+            value_type* dsketch, index_type ld_sketch,
+            index_type num_rows_mtx, index_type num_cols_mtx,
+            value_type* dmtx, index_type ld_mtx, value_type* dresult,
+            index_type ld_result,
+            state<value_type_internal, value_type, index_type>* precond_state,
+            detail::magma_info& info, double* runtime)
 {
     // Performs matrix-matrix multiplication in value_type_internal precision
     // and promotes output to value_type precision.
     if (!std::is_same<value_type_internal, value_type>::value) {
-        cuda::demote(num_rows_mtx, num_cols_mtx, dmtx, num_rows_mtx, precond_state->dmtx_rp,
-                     num_rows_mtx);
-        cuda::demote(num_rows_sketch, num_cols_sketch, dsketch, num_rows_sketch,
-                     precond_state->dsketch_rp, num_rows_sketch);
+        auto dmtx_rp = memory::demoted_copy<value_type_internal>(
+            num_rows_mtx, num_cols_mtx, dmtx, ld_mtx);
+        memory::demote(num_rows_sketch, num_cols_sketch, dsketch,
+                       num_rows_sketch, precond_state->dsketch_rp,
+                       num_rows_sketch);
         cudaDeviceSynchronize();
-        auto t = magma_sync_wtime(info.queue);
+        auto t = detail::sync_wtime(info.queue);
         blas::gemm(MagmaNoTrans, MagmaNoTrans, num_rows_sketch, num_cols_mtx,
-                   num_rows_mtx, 1.0, precond_state->dsketch_rp, num_rows_sketch, precond_state->dmtx_rp,
+                   num_rows_mtx, 1.0, precond_state->dsketch_rp, num_rows_sketch, dmtx_rp,
                    num_rows_mtx, 0.0, precond_state->dresult_rp, num_rows_sketch, info);
-        *runtime += (magma_sync_wtime(info.queue) - t);
+        *runtime += (detail::sync_wtime(info.queue) - t);
         cudaDeviceSynchronize();
-        cuda::promote(num_rows_sketch, num_cols_mtx, precond_state->dresult_rp,
-                      num_rows_sketch, dr_factor, num_rows_sketch);
+        memory::promote(num_rows_sketch, num_cols_mtx,
+                        precond_state->dresult_rp, num_rows_sketch, dresult,
+                        ld_result);
     } else {
-        auto t = magma_sync_wtime(info.queue);
+        auto t = detail::sync_wtime(info.queue);
         blas::gemm(MagmaNoTrans, MagmaNoTrans, num_rows_sketch, num_cols_mtx,
                    num_rows_mtx, 1.0, dsketch, num_rows_sketch, dmtx,
-                   num_rows_mtx, 0.0, dr_factor, ld_r_factor, info);
+                   num_rows_mtx, 0.0, dresult, ld_result, info);
         cudaDeviceSynchronize();
-        *runtime += (magma_sync_wtime(info.queue) - t);
+        *runtime += (detail::sync_wtime(info.queue) - t);
     }
+}
 
-    // Performs qr factorization in value_type precision.
-    magma_int_t info_qr = 0;
-    value_type* tau = nullptr;
-    memory::malloc_cpu(&tau, num_rows_sketch);
-    auto t = magma_sync_wtime(info.queue);
-    blas::geqrf2_gpu(num_rows_sketch, num_cols_mtx, dr_factor, ld_r_factor, tau,
-                     &info_qr);
+// Generates the preconditioner and measures runtime.
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void generate(index_type num_rows_sketch, index_type num_cols_sketch,
+              value_type* dsketch, index_type ld_sketch,
+              index_type num_rows_mtx, index_type num_cols_mtx,
+              value_type* dmtx, index_type ld_mtx, value_type* dr_factor,
+              index_type ld_r_factor,
+              state<value_type_internal, value_type, index_type>* precond_state, 
+              detail::magma_info& info, double* runtime, double* t_mm,
+              double* t_qr)
+{
+    sketch(num_rows_sketch, num_cols_sketch, dsketch, ld_sketch, num_rows_mtx,
+           num_cols_mtx, dmtx, ld_mtx, dr_factor, ld_r_factor, precond_state,
+           info, runtime);
+    factorize(num_rows_sketch, num_cols_mtx, dr_factor, ld_r_factor, info,
+              runtime, t_mm, t_qr);
+}
 
-    std::cout << "dr_factor: \n";
-    // rls::io::print_mtx_gpu(5, 5, (double*)dr_factor, num_cols_mtx, info.queue);
-    rls::io::print_mtx_gpu(5, 5, (double*)dr_factor, ld_r_factor, info.queue);
-    auto dt_qr = (magma_sync_wtime(info.queue) - t);
-    *t_mm += *runtime;
-    *t_qr += dt_qr;
-    *runtime += dt_qr;
-    if (info_qr == 0) {
-        printf(">>> qr exited without errors\n");
-    } else {
-        magma_xerbla("geqrf2_gpu", info_qr);
-    }
-    memory::free_cpu(tau);
+// Forms S * A with the fused sketch and measures runtime.
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void sketch(index_type num_rows_sketch, index_type num_rows_mtx,
+            index_type num_cols_mtx, value_type* dmtx, index_type ld_mtx,
+            value_type* dresult, index_type ld_result,
+            detail::magma_info& info, double* runtime)
+{
+    auto t = detail::sync_wtime(info.queue);
+    host::gaussian_sketch<value_type_internal>(
+        num_rows_sketch, num_rows_mtx, num_cols_mtx, dmtx, ld_mtx, dresult,
+        ld_result, info.seed);
+    *runtime += (detail::sync_wtime(info.queue) - t);
 }
 
+// Generates the preconditioner with the fused sketch and measures runtime.
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void generate(index_type num_rows_sketch, index_type num_rows_mtx,
+              index_type num_cols_mtx, value_type* dmtx, index_type ld_mtx,
+              value_type* dr_factor, index_type ld_r_factor,
+              detail::magma_info& info, double* runtime, double* t_mm,
+              double* t_qr)
+{
+    sketch<value_type_internal>(num_rows_sketch, num_rows_mtx, num_cols_mtx,
+                                dmtx, ld_mtx, dr_factor, ld_r_factor, info,
+                                runtime);
+    factorize(num_rows_sketch, num_cols_mtx, dr_factor, ld_r_factor, info,
+              runtime, t_mm, t_qr);
+}
+
+// Generates the preconditioner of a sparse matrix and measures runtime.
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void generate(index_type num_rows_sketch,
+              matrix::sparse<value_type, index_type>* mtx,
+              value_type* dr_factor, index_type ld_r_factor,
+              detail::magma_info& info, double* runtime, double* t_mm,
+              double* t_qr)
+{
+    auto t = detail::sync_wtime(info.queue);
+    host::gaussian_sketch<value_type_internal>(
+        num_rows_sketch, mtx->num_rows, mtx->num_cols, mtx->row_ptrs,
+        mtx->col_idxs, mtx->values, dr_factor, ld_r_factor, info.seed);
+    *runtime += (detail::sync_wtime(info.queue) - t);
+
+    factorize(num_rows_sketch, mtx->num_cols, dr_factor, ld_r_factor, info,
+              runtime, t_mm, t_qr);
+}
+
+
+template void sketch<__half, double, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t num_cols_sketch, double* dsketch,
+    magma_int_t ld_sketch, magma_int_t num_rows_mtx, magma_int_t num_cols_mtx,
+    double* dmtx, magma_int_t ld_mtx, double* dresult, magma_int_t ld_result,
+    state<__half, double, magma_int_t>* precond_state, detail::magma_info& info,
+    double* runtime);
+
+template void sketch<__nv_bfloat16, double, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t num_cols_sketch, double* dsketch,
+    magma_int_t ld_sketch, magma_int_t num_rows_mtx, magma_int_t num_cols_mtx,
+    double* dmtx, magma_int_t ld_mtx, double* dresult, magma_int_t ld_result,
+    state<__nv_bfloat16, double, magma_int_t>* precond_state,
+    detail::magma_info& info, double* runtime);
+
+template void sketch<__half, float, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t num_cols_sketch, float* dsketch,
+    magma_int_t ld_sketch, magma_int_t num_rows_mtx, magma_int_t num_cols_mtx,
+    float* dmtx, magma_int_t ld_mtx, float* dresult, magma_int_t ld_result,
+    state<__half, float, magma_int_t>* precond_state, detail::magma_info& info,
+    double* runtime);
+
+template void sketch<__nv_bfloat16, float, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t num_cols_sketch, float* dsketch,
+    magma_int_t ld_sketch, magma_int_t num_rows_mtx, magma_int_t num_cols_mtx,
+    float* dmtx, magma_int_t ld_mtx, float* dresult, magma_int_t ld_result,
+    state<__nv_bfloat16, float, magma_int_t>* precond_state,
+    detail::magma_info& info, double* runtime);
+
+template void sketch<float, double, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t num_cols_sketch, double* dsketch,
+    magma_int_t ld_sketch, magma_int_t num_rows_mtx, magma_int_t num_cols_mtx,
+    double* dmtx, magma_int_t ld_mtx, double* dresult, magma_int_t ld_result,
+    state<float, double, magma_int_t>* precond_state, detail::magma_info& info,
+    double* runtime);
+
+template void sketch<float, float, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t num_cols_sketch, float* dsketch,
+    magma_int_t ld_sketch, magma_int_t num_rows_mtx, magma_int_t num_cols_mtx,
+    float* dmtx, magma_int_t ld_mtx, float* dresult, magma_int_t ld_result,
+    state<float, float, magma_int_t>* precond_state, detail::magma_info& info,
+    double* runtime);
+
+template void sketch<double, double, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t num_cols_sketch, double* dsketch,
+    magma_int_t ld_sketch, magma_int_t num_rows_mtx, magma_int_t num_cols_mtx,
+    double* dmtx, magma_int_t ld_mtx, double* dresult, magma_int_t ld_result,
+    state<double, double, magma_int_t>* precond_state, detail::magma_info& info,
+    double* runtime);
+
+template void sketch<__half, double, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows_mtx,
+    magma_int_t num_cols_mtx, double* dmtx, magma_int_t ld_mtx, double* dresult,
+    magma_int_t ld_result, detail::magma_info& info, double* runtime);
+
+template void sketch<__nv_bfloat16, double, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows_mtx,
+    magma_int_t num_cols_mtx, double* dmtx, magma_int_t ld_mtx, double* dresult,
+    magma_int_t ld_result, detail::magma_info& info, double* runtime);
+
+template void sketch<__half, float, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows_mtx,
+    magma_int_t num_cols_mtx, float* dmtx, magma_int_t ld_mtx, float* dresult,
+    magma_int_t ld_result, detail::magma_info& info, double* runtime);
+
+template void sketch<__nv_bfloat16, float, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows_mtx,
+    magma_int_t num_cols_mtx, float* dmtx, magma_int_t ld_mtx, float* dresult,
+    magma_int_t ld_result, detail::magma_info& info, double* runtime);
+
+template void sketch<float, double, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows_mtx,
+    magma_int_t num_cols_mtx, double* dmtx, magma_int_t ld_mtx, double* dresult,
+    magma_int_t ld_result, detail::magma_info& info, double* runtime);
+
+template void sketch<float, float, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows_mtx,
+    magma_int_t num_cols_mtx, float* dmtx, magma_int_t ld_mtx, float* dresult,
+    magma_int_t ld_result, detail::magma_info& info, double* runtime);
+
+template void sketch<double, double, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows_mtx,
+    magma_int_t num_cols_mtx, double* dmtx, magma_int_t ld_mtx, double* dresult,
+    magma_int_t ld_result, detail::magma_info& info, double* runtime);
 
 template void generate<__half, double, magma_int_t>(
     magma_int_t num_rows_sketch, magma_int_t num_cols_sketch, double* dsketch,
@@ -136,12 +267,24 @@ template void generate<__half, double, magma_int_t>(
     double* dmtx, magma_int_t ld_mtx, double* dr_factor,
     magma_int_t ld_r_factor, double* hat_mtx, detail::magma_info& info);
 
+template void generate<__nv_bfloat16, double, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t num_cols_sketch, double* dsketch,
+    magma_int_t ld_sketch, magma_int_t num_rows_mtx, magma_int_t num_cols_mtx,
+    double* dmtx, magma_int_t ld_mtx, double* dr_factor,
+    magma_int_t ld_r_factor, double* hat_mtx, detail::magma_info& info);
+
 template void generate<__half, float, magma_int_t>(
     magma_int_t num_rows_sketch, magma_int_t num_cols_sketch, float* dsketch,
     magma_int_t ld_sketch, magma_int_t num_rows_mtx, magma_int_t num_cols_mtx,
     float* dmtx, magma_int_t ld_mtx, float* dr_factor, magma_int_t ld_r_factor,
     float* hat_mtx, detail::magma_info& info);
 
+template void generate<__nv_bfloat16, float, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t num_cols_sketch, float* dsketch,
+    magma_int_t ld_sketch, magma_int_t num_rows_mtx, magma_int_t num_cols_mtx,
+    float* dmtx, magma_int_t ld_mtx, float* dr_factor, magma_int_t ld_r_factor,
+    float* hat_mtx, detail::magma_info& info);
+
 template void generate<float, double, magma_int_t>(
     magma_int_t num_rows_sketch, magma_int_t num_cols_sketch, double* dsketch,
     magma_int_t ld_sketch, magma_int_t num_rows_mtx, magma_int_t num_cols_mtx,
@@ -167,6 +310,13 @@ template void generate<__half, double, magma_int_t>(
     magma_int_t ld_r_faclor, state<__half, double, magma_int_t>* precond_state, detail::magma_info& info,
     double* runtime, double* t_mm, double* t_qr);
 
+template void generate<__nv_bfloat16, double, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t num_cols_sketch, double* dsketch,
+    magma_int_t ld_sketch, magma_int_t num_rows_mtx, magma_int_t num_cols_mtx,
+    double* dmtx, magma_int_t ld_mtx, double* dr_factor,
+    magma_int_t ld_r_faclor, state<__nv_bfloat16, double, magma_int_t>* precond_state, detail::magma_info& info,
+    double* runtime, double* t_mm, double* t_qr);
+
 template void generate<__half, float, magma_int_t>(
     magma_int_t num_rows_sketch, magma_int_t num_cols_sketch, float* dsketch,
     magma_int_t ld_sketch, magma_int_t num_rows_mtx, magma_int_t num_cols_mtx,
@@ -174,6 +324,13 @@ template void generate<__half, float, magma_int_t>(
     state<__half, float, magma_int_t>* precond_state, detail::magma_info& info, double* runtime, double* t_mm,
     double* t_qr);
 
+template void generate<__nv_bfloat16, float, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t num_cols_sketch, float* dsketch,
+    magma_int_t ld_sketch, magma_int_t num_rows_mtx, magma_int_t num_cols_mtx,
+    float* dmtx, magma_int_t ld_mtx, float* dr_factor, magma_int_t ld_r_factor,
+    state<__nv_bfloat16, float, magma_int_t>* precond_state, detail::magma_info& info, double* runtime, double* t_mm,
+    double* t_qr);
+
 template void generate<float, double, magma_int_t>(
     magma_int_t num_rows_sketch, magma_int_t num_cols_sketch, double* dsketch,
     magma_int_t ld_sketch, magma_int_t num_rows_mtx, magma_int_t num_cols_mtx,
@@ -196,6 +353,91 @@ template void generate<double, double, magma_int_t>(
     double* runtime, double* t_mm, double* t_qr);
 
 
+template void generate<__half, double, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows_mtx,
+    magma_int_t num_cols_mtx, double* dmtx, magma_int_t ld_mtx,
+    double* dr_factor, magma_int_t ld_r_factor, detail::magma_info& info,
+    double* runtime, double* t_mm, double* t_qr);
+
+template void generate<__nv_bfloat16, double, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows_mtx,
+    magma_int_t num_cols_mtx, double* dmtx, magma_int_t ld_mtx,
+    double* dr_factor, magma_int_t ld_r_factor, detail::magma_info& info,
+    double* runtime, double* t_mm, double* t_qr);
+
+template void generate<__half, float, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows_mtx,
+    magma_int_t num_cols_mtx, float* dmtx, magma_int_t ld_mtx,
+    float* dr_factor, magma_int_t ld_r_factor, detail::magma_info& info,
+    double* runtime, double* t_mm, double* t_qr);
+
+template void generate<__nv_bfloat16, float, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows_mtx,
+    magma_int_t num_cols_mtx, float* dmtx, magma_int_t ld_mtx,
+    float* dr_factor, magma_int_t ld_r_factor, detail::magma_info& info,
+    double* runtime, double* t_mm, double* t_qr);
+
+template void generate<float, double, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows_mtx,
+    magma_int_t num_cols_mtx, double* dmtx, magma_int_t ld_mtx,
+    double* dr_factor, magma_int_t ld_r_factor, detail::magma_info& info,
+    double* runtime, double* t_mm, double* t_qr);
+
+template void generate<float, float, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows_mtx,
+    magma_int_t num_cols_mtx, float* dmtx, magma_int_t ld_mtx,
+    float* dr_factor, magma_int_t ld_r_factor, detail::magma_info& info,
+    double* runtime, double* t_mm, double* t_qr);
+
+template void generate<double, double, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows_mtx,
+    magma_int_t num_cols_mtx, double* dmtx, magma_int_t ld_mtx,
+    double* dr_factor, magma_int_t ld_r_factor, detail::magma_info& info,
+    double* runtime, double* t_mm, double* t_qr);
+
+template void generate<__half, double, magma_int_t>(
+    magma_int_t num_rows_sketch, matrix::sparse<double, magma_int_t>* mtx,
+    double* dr_factor,
+    magma_int_t ld_r_factor, detail::magma_info& info, double* runtime,
+    double* t_mm, double* t_qr);
+
+template void generate<__nv_bfloat16, double, magma_int_t>(
+    magma_int_t num_rows_sketch, matrix::sparse<double, magma_int_t>* mtx,
+    double* dr_factor,
+    magma_int_t ld_r_factor, detail::magma_info& info, double* runtime,
+    double* t_mm, double* t_qr);
+
+template void generate<__half, float, magma_int_t>(
+    magma_int_t num_rows_sketch, matrix::sparse<float, magma_int_t>* mtx,
+    float* dr_factor,
+    magma_int_t ld_r_factor, detail::magma_info& info, double* runtime,
+    double* t_mm, double* t_qr);
+
+template void generate<__nv_bfloat16, float, magma_int_t>(
+    magma_int_t num_rows_sketch, matrix::sparse<float, magma_int_t>* mtx,
+    float* dr_factor,
+    magma_int_t ld_r_factor, detail::magma_info& info, double* runtime,
+    double* t_mm, double* t_qr);
+
+template void generate<float, double, magma_int_t>(
+    magma_int_t num_rows_sketch, matrix::sparse<double, magma_int_t>* mtx,
+    double* dr_factor,
+    magma_int_t ld_r_factor, detail::magma_info& info, double* runtime,
+    double* t_mm, double* t_qr);
+
+template void generate<float, float, magma_int_t>(
+    magma_int_t num_rows_sketch, matrix::sparse<float, magma_int_t>* mtx,
+    float* dr_factor,
+    magma_int_t ld_r_factor, detail::magma_info& info, double* runtime,
+    double* t_mm, double* t_qr);
+
+template void generate<double, double, magma_int_t>(
+    magma_int_t num_rows_sketch, matrix::sparse<double, magma_int_t>* mtx,
+    double* dr_factor,
+    magma_int_t ld_r_factor, detail::magma_info& info, double* runtime,
+    double* t_mm, double* t_qr);
+
+
 }  // namespace gaussian
 }  // namespace preconditioner
 }  // namespace rls
@@ -1,3 +1,4 @@
+#include "../matrix/sparse.hpp"
 #include "../memory/detail.hpp"
 
 
@@ -7,8 +8,9 @@ namespace gaussian {
 
 template <typename value_type_internal, typename value_type,
           typename index_type>
+// Buffers of the mixed precision sketch product. The copy of the matrix is
+// taken from memory::demoted_copy and is not owned by the state.
 struct state{ 
-    value_type_internal* dmtx_rp = nullptr;
     value_type_internal* dsketch_rp = nullptr;
     value_type_internal* dresult_rp = nullptr;
     value_type* tau = nullptr;
@@ -16,14 +18,12 @@ struct state{
     void allocate(index_type ld_mtx, index_type num_cols_mtx, 
         index_type num_rows_sketch, index_type num_cols_sketch, index_type ld_sketch,
         index_type ld_r_factor) {
-        memory::malloc(&dmtx_rp, ld_mtx * num_cols_mtx);
         memory::malloc(&dsketch_rp, ld_sketch * num_cols_sketch);
         memory::malloc(&dresult_rp, ld_r_factor * num_cols_mtx);
         memory::malloc_cpu(&tau, num_rows_sketch);
     }
 
     void free() {
-        memory::free(dmtx_rp);
         memory::free(dsketch_rp);
         memory::free(dresult_rp);
         memory::free_cpu(tau);
@@ -50,6 +50,52 @@ void generate(index_type num_rows_sketch, index_type num_cols_sketch,
               detail::magma_info& info, double* runtime, double* t_mm,
               double* t_qr);
 
+// Forms dsketch * A in dresult, in value_type_internal precision, without
+// factorizing it.
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void sketch(index_type num_rows_sketch, index_type num_cols_sketch,
+            value_type* dsketch, index_type ld_sketch,
+            index_type num_rows_mtx, index_type num_cols_mtx,
+            value_type* dmtx, index_type ld_mtx, value_type* dresult,
+            index_type ld_result,
+            state<value_type_internal, value_type, index_type>* precond_state,
+            detail::magma_info& info, double* runtime);
+
+// Forms S * A in dresult with the fused sketch of the overload below, without
+// factorizing it. Entries of S depend only on (info.seed, row, col), so
+// sketching the columns of A in separate calls gives the same S. Host backend
+// only.
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void sketch(index_type num_rows_sketch, index_type num_rows_mtx,
+            index_type num_cols_mtx, value_type* dmtx, index_type ld_mtx,
+            value_type* dresult, index_type ld_result,
+            detail::magma_info& info, double* runtime);
+
+// Overload that never stores the sketch: its tiles are generated inside the
+// sketch-times-mtx product (host::gaussian_sketch, see there) in
+// value_type_internal precision, from info.seed. Host backend only; the cuda
+// backend uses the overloads above with a sketch stored by curand.
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void generate(index_type num_rows_sketch, index_type num_rows_mtx,
+              index_type num_cols_mtx, value_type* dmtx, index_type ld_mtx,
+              value_type* dr_factor, index_type ld_r_factor,
+              detail::magma_info& info, double* runtime, double* t_mm,
+              double* t_qr);
+
+// Overload for mtx in CSR format, on the host backend. The sketch is
+// generated like above and applied to the nonzeros of mtx in
+// value_type_internal precision.
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void generate(index_type num_rows_sketch,
+              matrix::sparse<value_type, index_type>* mtx,
+              value_type* dr_factor, index_type ld_r_factor,
+              detail::magma_info& info, double* runtime, double* t_mm,
+              double* t_qr);
+
 }  // namespace gaussian
 }  // namespace preconditioner
 }  // namespace rls
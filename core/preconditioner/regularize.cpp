@@ -0,0 +1,87 @@
+#include <iostream>
+
+
+#include "../../cuda/solver/lsqr_kernels.cuh"
+#include "../../host/solver/lsqr_kernels.hpp"
+#include "../../include/base_types.hpp"
+#include "../blas/blas.hpp"
+#include "../memory/detail.hpp"
+#include "../memory/memory.hpp"
+#include "regularize.hpp"
+
+
+namespace rls {
+namespace preconditioner {
+namespace {
+
+
+template <typename value_type, typename index_type>
+void set_values(index_type num_elems, value_type val, value_type* values)
+{
+    if (detail::use_host_backend()) {
+        host::set_values(num_elems, val, values);
+    } else {
+        cuda::set_values(num_elems, val, values);
+    }
+}
+
+
+}  // anonymous namespace
+
+
+template <typename value_type, typename index_type>
+void regularize(index_type num_cols, value_type damp, value_type* dr_factor,
+                index_type ld_r_factor, detail::magma_info& info,
+                double* runtime, double* t_qr)
+{
+    if (damp == value_type(0)) {
+        return;
+    }
+    index_type inc = 1;
+    index_type ld_stacked = 2 * num_cols;
+    value_type* stacked = nullptr;
+    value_type* diag = nullptr;
+    value_type* tau = nullptr;
+    memory::malloc(&stacked, ld_stacked * num_cols);
+    memory::malloc(&diag, num_cols);
+    memory::malloc_cpu(&tau, num_cols);
+    auto t = detail::sync_wtime(info.queue);
+    set_values(ld_stacked * num_cols, value_type(0), stacked);
+    set_values(num_cols, damp, diag);
+    for (index_type col = 0; col < num_cols; col++) {
+        blas::copy(col + 1, dr_factor + col * ld_r_factor, inc,
+                   stacked + col * ld_stacked, inc, info.queue);
+    }
+    blas::copy(num_cols, diag, inc, stacked + num_cols, ld_stacked + 1,
+               info.queue);
+
+    magma_int_t info_qr = 0;
+    blas::geqrf2_gpu(ld_stacked, num_cols, stacked, ld_stacked, tau,
+                     &info_qr);
+    if (info_qr != 0) {
+        magma_xerbla("geqrf2_gpu", info_qr);
+    }
+    for (index_type col = 0; col < num_cols; col++) {
+        blas::copy(col + 1, stacked + col * ld_stacked, inc,
+                   dr_factor + col * ld_r_factor, inc, info.queue);
+    }
+    auto dt_qr = (detail::sync_wtime(info.queue) - t);
+    *t_qr += dt_qr;
+    *runtime += dt_qr;
+    memory::free(stacked);
+    memory::free(diag);
+    memory::free_cpu(tau);
+}
+
+
+template void regularize(magma_int_t num_cols, double damp, double* dr_factor,
+                         magma_int_t ld_r_factor, detail::magma_info& info,
+                         double* runtime, double* t_qr);
+
+template void regularize(magma_int_t num_cols, float damp, float* dr_factor,
+                         magma_int_t ld_r_factor, detail::magma_info& info,
+                         double* runtime, double* t_qr);
+
+
+}  // namespace preconditioner
+}  // namespace rls
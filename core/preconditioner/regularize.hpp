@@ -0,0 +1,18 @@
+#include "../memory/detail.hpp"
+
+
+namespace rls {
+namespace preconditioner {
+
+
+// Turns the R factor of S * A into that of the sketch of the ridge operator
+// [S * A; damp * I], so that R^T R = (S A)^T (S A) + damp^2 I. Only the
+// 2n x n matrix [R; damp * I] is factorized, never the stacked sketch. The
+// upper triangle of dr_factor is overwritten; damp = 0 leaves it unchanged.
+template <typename value_type, typename index_type>
+void regularize(index_type num_cols, value_type damp, value_type* dr_factor,
+                index_type ld_r_factor, detail::magma_info& info,
+                double* runtime, double* t_qr);
+
+}  // namespace preconditioner
+}  // namespace rls
@@ -0,0 +1,214 @@
+#include <iostream>
+
+
+#include "../../host/preconditioner/preconditioner_kernels.hpp"
+#include "../../include/base_types.hpp"
+#include "../blas/blas.hpp"
+#include "../memory/detail.hpp"
+#include "../memory/memory.hpp"
+#include "factorize.hpp"
+#include "sparse_sign.hpp"
+
+
+namespace rls {
+namespace preconditioner {
+namespace sparse_sign {
+
+
+// Forms S * A and measures runtime.
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void sketch(index_type num_rows_sketch, index_type nnz_per_col,
+            index_type num_rows_mtx, index_type num_cols_mtx,
+            value_type* dmtx, index_type ld_mtx, value_type* dresult,
+            index_type ld_result, detail::magma_info& info, double* runtime)
+{
+    // Applies the embedding in value_type_internal precision.
+    auto t = detail::sync_wtime(info.queue);
+    if (detail::use_host_backend()) {
+        host::sparse_sign_sketch<value_type_internal>(
+            num_rows_sketch, nnz_per_col, num_rows_mtx, num_cols_mtx, dmtx,
+            ld_mtx, dresult, ld_result, info.seed);
+    } else {
+        value_type* mtx = nullptr;
+        value_type* result = nullptr;
+        memory::malloc_cpu(&mtx, num_rows_mtx * num_cols_mtx);
+        memory::malloc_cpu(&result, num_rows_sketch * num_cols_mtx);
+        memory::getmatrix(num_rows_mtx, num_cols_mtx, dmtx, ld_mtx, mtx,
+                          num_rows_mtx, info.queue);
+        host::sparse_sign_sketch<value_type_internal>(
+            num_rows_sketch, nnz_per_col, num_rows_mtx, num_cols_mtx, mtx,
+            num_rows_mtx, result, num_rows_sketch, info.seed);
+        memory::setmatrix(num_rows_sketch, num_cols_mtx, result,
+                          num_rows_sketch, dresult, ld_result, info.queue);
+        memory::free_cpu(mtx);
+        memory::free_cpu(result);
+    }
+    *runtime += (detail::sync_wtime(info.queue) - t);
+}
+
+// Generates the preconditioner and measures runtime.
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void generate(index_type num_rows_sketch, index_type nnz_per_col,
+              index_type num_rows_mtx, index_type num_cols_mtx,
+              value_type* dmtx, index_type ld_mtx, value_type* dr_factor,
+              index_type ld_r_factor, detail::magma_info& info, double* runtime,
+              double* t_mm, double* t_qr)
+{
+    sketch<value_type_internal>(num_rows_sketch, nnz_per_col, num_rows_mtx,
+                                num_cols_mtx, dmtx, ld_mtx, dr_factor,
+                                ld_r_factor, info, runtime);
+    factorize(num_rows_sketch, num_cols_mtx, dr_factor, ld_r_factor, info,
+              runtime, t_mm, t_qr);
+}
+
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void generate(index_type num_rows_sketch, index_type nnz_per_col,
+              matrix::sparse<value_type, index_type>* mtx,
+              value_type* dr_factor, index_type ld_r_factor,
+              detail::magma_info& info, double* runtime, double* t_mm,
+              double* t_qr)
+{
+    auto t = detail::sync_wtime(info.queue);
+    host::sparse_sign_sketch<value_type_internal>(
+        num_rows_sketch, nnz_per_col, mtx->num_rows, mtx->num_cols,
+        mtx->row_ptrs, mtx->col_idxs, mtx->values, dr_factor, ld_r_factor,
+        info.seed);
+    *runtime += (detail::sync_wtime(info.queue) - t);
+    factorize(num_rows_sketch, mtx->num_cols, dr_factor, ld_r_factor, info,
+              runtime, t_mm, t_qr);
+}
+
+
+template void sketch<__half, double, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    magma_int_t num_rows_mtx, magma_int_t num_cols_mtx, double* dmtx,
+    magma_int_t ld_mtx, double* dresult, magma_int_t ld_result,
+    detail::magma_info& info, double* runtime);
+
+template void sketch<__nv_bfloat16, double, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    magma_int_t num_rows_mtx, magma_int_t num_cols_mtx, double* dmtx,
+    magma_int_t ld_mtx, double* dresult, magma_int_t ld_result,
+    detail::magma_info& info, double* runtime);
+
+template void sketch<__half, float, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    magma_int_t num_rows_mtx, magma_int_t num_cols_mtx, float* dmtx,
+    magma_int_t ld_mtx, float* dresult, magma_int_t ld_result,
+    detail::magma_info& info, double* runtime);
+
+template void sketch<__nv_bfloat16, float, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    magma_int_t num_rows_mtx, magma_int_t num_cols_mtx, float* dmtx,
+    magma_int_t ld_mtx, float* dresult, magma_int_t ld_result,
+    detail::magma_info& info, double* runtime);
+
+template void sketch<float, double, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    magma_int_t num_rows_mtx, magma_int_t num_cols_mtx, double* dmtx,
+    magma_int_t ld_mtx, double* dresult, magma_int_t ld_result,
+    detail::magma_info& info, double* runtime);
+
+template void sketch<float, float, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    magma_int_t num_rows_mtx, magma_int_t num_cols_mtx, float* dmtx,
+    magma_int_t ld_mtx, float* dresult, magma_int_t ld_result,
+    detail::magma_info& info, double* runtime);
+
+template void sketch<double, double, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    magma_int_t num_rows_mtx, magma_int_t num_cols_mtx, double* dmtx,
+    magma_int_t ld_mtx, double* dresult, magma_int_t ld_result,
+    detail::magma_info& info, double* runtime);
+
+template void generate<__half, double, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    magma_int_t num_rows_mtx, magma_int_t num_cols_mtx, double* dmtx,
+    magma_int_t ld_mtx, double* dr_factor, magma_int_t ld_r_factor,
+    detail::magma_info& info, double* runtime, double* t_mm, double* t_qr);
+
+template void generate<__nv_bfloat16, double, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    magma_int_t num_rows_mtx, magma_int_t num_cols_mtx, double* dmtx,
+    magma_int_t ld_mtx, double* dr_factor, magma_int_t ld_r_factor,
+    detail::magma_info& info, double* runtime, double* t_mm, double* t_qr);
+
+template void generate<__half, float, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    magma_int_t num_rows_mtx, magma_int_t num_cols_mtx, float* dmtx,
+    magma_int_t ld_mtx, float* dr_factor, magma_int_t ld_r_factor,
+    detail::magma_info& info, double* runtime, double* t_mm, double* t_qr);
+
+template void generate<__nv_bfloat16, float, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    magma_int_t num_rows_mtx, magma_int_t num_cols_mtx, float* dmtx,
+    magma_int_t ld_mtx, float* dr_factor, magma_int_t ld_r_factor,
+    detail::magma_info& info, double* runtime, double* t_mm, double* t_qr);
+
+template void generate<float, double, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    magma_int_t num_rows_mtx, magma_int_t num_cols_mtx, double* dmtx,
+    magma_int_t ld_mtx, double* dr_factor, magma_int_t ld_r_factor,
+    detail::magma_info& info, double* runtime, double* t_mm, double* t_qr);
+
+template void generate<float, float, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    magma_int_t num_rows_mtx, magma_int_t num_cols_mtx, float* dmtx,
+    magma_int_t ld_mtx, float* dr_factor, magma_int_t ld_r_factor,
+    detail::magma_info& info, double* runtime, double* t_mm, double* t_qr);
+
+template void generate<double, double, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    magma_int_t num_rows_mtx, magma_int_t num_cols_mtx, double* dmtx,
+    magma_int_t ld_mtx, double* dr_factor, magma_int_t ld_r_factor,
+    detail::magma_info& info, double* runtime, double* t_mm, double* t_qr);
+
+template void generate<__half, double, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    matrix::sparse<double, magma_int_t>* mtx, double* dr_factor,
+    magma_int_t ld_r_factor, detail::magma_info& info, double* runtime,
+    double* t_mm, double* t_qr);
+
+template void generate<__nv_bfloat16, double, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    matrix::sparse<double, magma_int_t>* mtx, double* dr_factor,
+    magma_int_t ld_r_factor, detail::magma_info& info, double* runtime,
+    double* t_mm, double* t_qr);
+
+template void generate<__half, float, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    matrix::sparse<float, magma_int_t>* mtx, float* dr_factor,
+    magma_int_t ld_r_factor, detail::magma_info& info, double* runtime,
+    double* t_mm, double* t_qr);
+
+template void generate<__nv_bfloat16, float, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    matrix::sparse<float, magma_int_t>* mtx, float* dr_factor,
+    magma_int_t ld_r_factor, detail::magma_info& info, double* runtime,
+    double* t_mm, double* t_qr);
+
+template void generate<float, double, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    matrix::sparse<double, magma_int_t>* mtx, double* dr_factor,
+    magma_int_t ld_r_factor, detail::magma_info& info, double* runtime,
+    double* t_mm, double* t_qr);
+
+template void generate<float, float, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    matrix::sparse<float, magma_int_t>* mtx, float* dr_factor,
+    magma_int_t ld_r_factor, detail::magma_info& info, double* runtime,
+    double* t_mm, double* t_qr);
+
+template void generate<double, double, magma_int_t>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    matrix::sparse<double, magma_int_t>* mtx, double* dr_factor,
+    magma_int_t ld_r_factor, detail::magma_info& info, double* runtime,
+    double* t_mm, double* t_qr);
+
+
+}  // namespace sparse_sign
+}  // namespace preconditioner
+}  // namespace rls
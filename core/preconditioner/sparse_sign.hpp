@@ -0,0 +1,44 @@
+#include "../matrix/sparse.hpp"
+#include "../memory/detail.hpp"
+
+
+namespace rls {
+namespace preconditioner {
+namespace sparse_sign {
+
+
+// Forms S * A in dresult without factorizing it, where S is the embedding
+// described below. S depends only on info.seed, so sketching the columns of A
+// in separate calls gives the same S.
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void sketch(index_type num_rows_sketch, index_type nnz_per_col,
+            index_type num_rows_mtx, index_type num_cols_mtx,
+            value_type* dmtx, index_type ld_mtx, value_type* dresult,
+            index_type ld_result, detail::magma_info& info, double* runtime);
+
+// Generates the preconditioner R from the QR factorization of S * A, where S
+// is a sparse sign embedding with num_rows_sketch rows and nnz_per_col
+// nonzeros per column (the CountSketch if nnz_per_col = 1). S * A is formed on
+// the host without storing S; on the cuda backend A is copied to the host and
+// S * A is copied back before the QR factorization.
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void generate(index_type num_rows_sketch, index_type nnz_per_col,
+              index_type num_rows_mtx, index_type num_cols_mtx,
+              value_type* dmtx, index_type ld_mtx, value_type* dr_factor,
+              index_type ld_r_factor, detail::magma_info& info, double* runtime,
+              double* t_mm, double* t_qr);
+
+// Overload for mtx in CSR format, on the host backend.
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void generate(index_type num_rows_sketch, index_type nnz_per_col,
+              matrix::sparse<value_type, index_type>* mtx,
+              value_type* dr_factor, index_type ld_r_factor,
+              detail::magma_info& info, double* runtime, double* t_mm,
+              double* t_qr);
+
+}  // namespace sparse_sign
+}  // namespace preconditioner
+}  // namespace rls
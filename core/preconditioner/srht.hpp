@@ -0,0 +1,38 @@
+#include "../memory/detail.hpp"
+
+
+namespace rls {
+namespace preconditioner {
+namespace srht {
+
+
+// Returns the largest num_rows_sketch for a matrix with num_rows_mtx rows:
+// S samples distinct rows of the transform of A zero-padded to a power of two.
+magma_int_t max_rows(magma_int_t num_rows_mtx);
+
+// Forms S * A in dresult without factorizing it, where S is the transform
+// described below. S depends only on info.seed and the dimensions of A, so
+// sketching the columns of A in separate calls gives the same S.
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void sketch(index_type num_rows_sketch, index_type num_rows_mtx,
+            index_type num_cols_mtx, value_type* dmtx, index_type ld_mtx,
+            value_type* dresult, index_type ld_result,
+            detail::magma_info& info, double* runtime);
+
+// Generates the preconditioner R from the QR factorization of S * A, where S
+// is a subsampled randomized Hadamard transform with num_rows_sketch rows, at
+// most max_rows(num_rows_mtx). S * A is formed on the host without storing S;
+// on the cuda backend A is copied to the host and S * A is copied back before
+// the QR factorization.
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void generate(index_type num_rows_sketch, index_type num_rows_mtx,
+              index_type num_cols_mtx, value_type* dmtx, index_type ld_mtx,
+              value_type* dr_factor, index_type ld_r_factor,
+              detail::magma_info& info, double* runtime, double* t_mm,
+              double* t_qr);
+
+}  // namespace srht
+}  // namespace preconditioner
+}  // namespace rls
@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <cstdio>
+
+
+#include "../../host/preconditioner/preconditioner_kernels.hpp"
+#include "../../include/base_types.hpp"
+#include "../memory/detail.hpp"
+#include "../memory/memory.hpp"
+#include "factorize.hpp"
+#include "streamed.hpp"
+
+
+namespace rls {
+namespace preconditioner {
+namespace streamed {
+
+
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+bool generate(io::panel_file* file, index_type num_rows_sketch,
+              sketch_type sketch, index_type nnz_per_col,
+              value_type* dr_factor, index_type ld_r_factor,
+              detail::magma_info& info, double* runtime, double* t_mm,
+              double* t_qr)
+{
+    index_type num_cols = file->num_cols;
+    value_type* r_factor = dr_factor;
+    index_type ld_result = ld_r_factor;
+    if (!detail::use_host_backend()) {
+        memory::malloc_cpu(&r_factor, num_rows_sketch * num_cols);
+        ld_result = num_rows_sketch;
+    }
+    auto t = detail::sync_wtime(info.queue);
+    for (index_type col = 0; col < num_cols; col++) {
+        std::fill(r_factor + static_cast<std::size_t>(col) * ld_result,
+                  r_factor + static_cast<std::size_t>(col) * ld_result +
+                      num_rows_sketch,
+                  value_type(0));
+    }
+    magma_int_t rows = 0;
+    index_type row_offset = 0;
+    double t_wait = 0.0;
+    {
+        io::panel_reader<value_type> reader(file);
+        reader.start();
+        while (value_type* panel = reader.next(&rows)) {
+            if (sketch == sketch_type::sparse_sign) {
+                host::sparse_sign_sketch_add<value_type_internal>(
+                    num_rows_sketch, nnz_per_col, row_offset, rows, num_cols,
+                    panel, rows, r_factor, ld_result, info.seed);
+            } else {
+                host::gaussian_sketch_add<value_type_internal>(
+                    num_rows_sketch, row_offset, rows, num_cols, panel, rows,
+                    r_factor, ld_result, info.seed);
+            }
+            row_offset += rows;
+        }
+        t_wait = reader.t_wait;
+    }
+    if (rows < 0) {
+        if (!detail::use_host_backend()) {
+            memory::free_cpu(r_factor);
+        }
+        return false;
+    }
+    if (!detail::use_host_backend()) {
+        memory::setmatrix(num_rows_sketch, num_cols, r_factor, num_rows_sketch,
+                          dr_factor, ld_r_factor, info.queue);
+        memory::free_cpu(r_factor);
+    }
+    *runtime += (detail::sync_wtime(info.queue) - t);
+    printf(">>> streamed %d panels of %d rows, %.3f s waiting for reads\n",
+           file->num_panels, file->panel_rows, t_wait);
+
+    factorize(num_rows_sketch, num_cols, dr_factor, ld_r_factor, info, runtime,
+              t_mm, t_qr);
+    return true;
+}
+
+
+template bool generate<__half, double, magma_int_t>(
+    io::panel_file* file, magma_int_t num_rows_sketch, sketch_type sketch,
+    magma_int_t nnz_per_col, double* dr_factor, magma_int_t ld_r_factor,
+    detail::magma_info& info, double* runtime, double* t_mm, double* t_qr);
+
+template bool generate<__nv_bfloat16, double, magma_int_t>(
+    io::panel_file* file, magma_int_t num_rows_sketch, sketch_type sketch,
+    magma_int_t nnz_per_col, double* dr_factor, magma_int_t ld_r_factor,
+    detail::magma_info& info, double* runtime, double* t_mm, double* t_qr);
+
+template bool generate<float, double, magma_int_t>(
+    io::panel_file* file, magma_int_t num_rows_sketch, sketch_type sketch,
+    magma_int_t nnz_per_col, double* dr_factor, magma_int_t ld_r_factor,
+    detail::magma_info& info, double* runtime, double* t_mm, double* t_qr);
+
+template bool generate<double, double, magma_int_t>(
+    io::panel_file* file, magma_int_t num_rows_sketch, sketch_type sketch,
+    magma_int_t nnz_per_col, double* dr_factor, magma_int_t ld_r_factor,
+    detail::magma_info& info, double* runtime, double* t_mm, double* t_qr);
+
+template bool generate<__half, float, magma_int_t>(
+    io::panel_file* file, magma_int_t num_rows_sketch, sketch_type sketch,
+    magma_int_t nnz_per_col, float* dr_factor, magma_int_t ld_r_factor,
+    detail::magma_info& info, double* runtime, double* t_mm, double* t_qr);
+
+template bool generate<__nv_bfloat16, float, magma_int_t>(
+    io::panel_file* file, magma_int_t num_rows_sketch, sketch_type sketch,
+    magma_int_t nnz_per_col, float* dr_factor, magma_int_t ld_r_factor,
+    detail::magma_info& info, double* runtime, double* t_mm, double* t_qr);
+
+template bool generate<float, float, magma_int_t>(
+    io::panel_file* file, magma_int_t num_rows_sketch, sketch_type sketch,
+    magma_int_t nnz_per_col, float* dr_factor, magma_int_t ld_r_factor,
+    detail::magma_info& info, double* runtime, double* t_mm, double* t_qr);
+
+}  // namespace streamed
+}  // namespace preconditioner
+}  // namespace rls
@@ -0,0 +1,31 @@
+#include "../../include/base_types.hpp"
+#include "../../utils/io.hpp"
+#include "../memory/detail.hpp"
+
+
+namespace rls {
+namespace preconditioner {
+namespace streamed {
+
+
+// Generates the preconditioner R from the QR factorization of S * A for the
+// dense matrix A of file without holding A in memory. A background thread
+// reads the panels of file into two buffers used in turn, and S * panel is
+// added to the num_rows_sketch x num_cols sketch on the host while the next
+// panel is read. S is the Gaussian sketch (sketch_type::gaussian, also used
+// for srht, whose transform mixes all rows) or the sparse sign embedding with
+// nnz_per_col nonzeros per column, generated as in gaussian::generate and
+// sparse_sign::generate, so the result matches the in-memory sketch up to
+// rounding. The sketch is then copied to dr_factor and factorized. Returns
+// false if a panel cannot be read.
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+bool generate(io::panel_file* file, index_type num_rows_sketch,
+              sketch_type sketch, index_type nnz_per_col,
+              value_type* dr_factor, index_type ld_r_factor,
+              detail::magma_info& info, double* runtime, double* t_mm,
+              double* t_qr);
+
+}  // namespace streamed
+}  // namespace preconditioner
+}  // namespace rls
@@ -0,0 +1,376 @@
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "magma_v2.h"
+
+
+#include "../blas/blas.hpp"
+#include "../memory/detail.hpp"
+#include "../memory/memory.hpp"
+#include "base_types.hpp"
+#include "block_lsqr.hpp"
+#include "lsqr.hpp"
+
+namespace rls {
+namespace solver {
+namespace block_lsqr {
+namespace {
+
+
+// block_out = op(mtx) * block_in + beta * block_out on the first num_active
+// columns, with one gemm. In mixed precision the blocks are converted to
+// value_type_in around the product, as the device path of lsqr::run does
+// for single vectors.
+template <typename value_type_in, typename value_type, typename index_type>
+void multiply(magma_trans_t trans, index_type num_rows, index_type num_cols,
+              index_type num_active, value_type* mtx, value_type* block_in,
+              value_type beta, value_type* block_out,
+              workspace<value_type_in, value_type, index_type>& ws,
+              detail::magma_info& info)
+{
+    auto rows_in = (trans == MagmaNoTrans) ? num_cols : num_rows;
+    auto rows_out = (trans == MagmaNoTrans) ? num_rows : num_cols;
+    if (std::is_same<value_type_in, value_type>::value) {
+        blas::gemm(trans, MagmaNoTrans, rows_out, num_active, rows_in, 1.0,
+                   mtx, num_rows, block_in, rows_in, beta, block_out,
+                   rows_out, info);
+        return;
+    }
+    auto block_in_rp = (trans == MagmaNoTrans) ? ws.temp_in : ws.u_in;
+    auto block_out_rp = (trans == MagmaNoTrans) ? ws.u_in : ws.temp_in;
+    memory::demote(rows_in, num_active, block_in, rows_in, block_in_rp,
+                   rows_in);
+    if (beta != 0) {
+        memory::demote(rows_out, num_active, block_out, rows_out,
+                       block_out_rp, rows_out);
+    }
+    blas::gemm(trans, MagmaNoTrans, rows_out, num_active, rows_in, 1.0,
+               ws.mtx_in, num_rows, block_in_rp, rows_in, beta, block_out_rp,
+               rows_out, info);
+    memory::promote(rows_out, num_active, block_out_rp, rows_out, block_out,
+                    rows_out);
+}
+
+template <typename value_type, typename index_type>
+void swap_columns(index_type num_rows, value_type* first, value_type* second,
+                  value_type* scratch, magma_queue_t queue)
+{
+    index_type inc = 1;
+    blas::copy(num_rows, first, inc, scratch, inc, queue);
+    blas::copy(num_rows, second, inc, first, inc, queue);
+    blas::copy(num_rows, scratch, inc, second, inc, queue);
+}
+
+// Moves the bidiagonalization of slot into last, so that the active columns
+// stay in front.
+template <typename value_type_in, typename value_type, typename index_type>
+void swap_slots(
+    index_type slot, index_type last,
+    std::vector<lsqr::temp_scalars<value_type, index_type>>& scalars,
+    std::vector<index_type>& order,
+    workspace<value_type_in, value_type, index_type>& ws, magma_queue_t queue)
+{
+    if (slot == last) {
+        return;
+    }
+    auto num_rows = ws.num_rows;
+    auto num_cols = ws.num_cols;
+    swap_columns(num_rows, ws.u + slot * num_rows, ws.u + last * num_rows,
+                 ws.residual, queue);
+    swap_columns(num_cols, ws.v + slot * num_cols, ws.v + last * num_cols,
+                 ws.residual, queue);
+    swap_columns(num_cols, ws.w + slot * num_cols, ws.w + last * num_cols,
+                 ws.residual, queue);
+    std::swap(scalars[slot], scalars[last]);
+    std::swap(order[slot], order[last]);
+}
+
+// Block version of lsqr::step_1 on the first num_active columns.
+template <typename value_type_in, typename value_type, typename index_type>
+void step_1(index_type num_rows, index_type num_cols, index_type num_active,
+            value_type* mtx, value_type* precond_mtx, index_type ld_precond,
+            std::vector<lsqr::temp_scalars<value_type, index_type>>& scalars,
+            workspace<value_type_in, value_type, index_type>& ws,
+            detail::magma_info& info)
+{
+    index_type inc = 1;
+    auto queue = info.queue;
+    for (index_type j = 0; j < num_active; j++) {
+        auto temp = ws.temp + j * num_cols;
+        blas::copy(num_cols, ws.v + j * num_cols, inc, temp, inc, queue);
+        blas::trsv(MagmaUpper, MagmaNoTrans, MagmaNonUnit, num_cols,
+                   precond_mtx, ld_precond, temp, inc, queue);
+        blas::scale(num_rows, -scalars[j].alpha, ws.u + j * num_rows, inc,
+                    queue);
+    }
+    multiply(MagmaNoTrans, num_rows, num_cols, num_active, mtx, ws.temp,
+             value_type(1), ws.u, ws, info);
+    for (index_type j = 0; j < num_active; j++) {
+        auto& s = scalars[j];
+        auto u = ws.u + j * num_rows;
+        s.beta = blas::norm2(num_rows, u, inc, queue);
+        s.anorm = std::sqrt(s.anorm * s.anorm + s.alpha * s.alpha +
+                            s.beta * s.beta);
+        if (s.beta > 0) {
+            blas::scale(num_rows, 1 / s.beta, u, inc, queue);
+        }
+    }
+    multiply(MagmaTrans, num_rows, num_cols, num_active, mtx, ws.u,
+             value_type(0), ws.temp, ws, info);
+    for (index_type j = 0; j < num_active; j++) {
+        auto& s = scalars[j];
+        auto temp = ws.temp + j * num_cols;
+        auto v = ws.v + j * num_cols;
+        blas::trsv(MagmaUpper, MagmaTrans, MagmaNonUnit, num_cols,
+                   precond_mtx, ld_precond, temp, inc, queue);
+        blas::axpy(num_cols, -s.beta, v, inc, temp, inc, queue);
+        s.alpha = blas::norm2(num_cols, temp, inc, queue);
+        if (s.alpha > 0) {
+            blas::scale(num_cols, 1 / s.alpha, temp, inc, queue);
+        }
+        blas::copy(num_cols, temp, inc, v, inc, queue);
+    }
+}
+
+template <typename value_type_in, typename value_type, typename index_type>
+void solve(index_type num_rows, index_type num_cols, index_type num_rhs,
+           value_type* mtx, value_type* rhs, value_type* sol,
+           index_type max_iter, index_type* iter, value_type tol,
+           double* resnorm, value_type* precond_mtx, index_type ld_precond,
+           magma_queue_t queue, double* t_solve, convergence* info,
+           workspace<value_type_in, value_type, index_type>* ws)
+{
+    index_type inc = 1;
+    workspace<value_type_in, value_type, index_type> default_ws;
+    if (ws == nullptr) {
+        ws = &default_ws;
+    }
+    if ((ws->num_rows != num_rows) || (ws->num_cols != num_cols) ||
+        (ws->num_rhs < num_rhs)) {
+        ws->free();
+        ws->allocate(num_rows, num_cols, num_rhs);
+    }
+    if (!std::is_same<value_type_in, value_type>::value) {
+        ws->mtx_in = memory::demoted_copy<value_type_in>(num_rows, num_cols,
+                                                         mtx, num_rows);
+    }
+    detail::magma_info blas_info;
+    blas_info.queue = queue;
+
+    // Slot j of the blocks holds the bidiagonalization of rhs column
+    // order[j]; finished slots are kept after the num_active active ones.
+    std::vector<lsqr::temp_scalars<value_type, index_type>> scalars(num_rhs);
+    std::vector<stop_reason> reasons(num_rhs, stop_reason::none);
+    std::vector<index_type> iters(num_rhs, 0);
+    std::vector<index_type> order(num_rhs);
+    for (index_type j = 0; j < num_rhs; j++) {
+        order[j] = j;
+    }
+
+    *t_solve = 0;
+    double t = detail::sync_wtime(queue);
+    blas::copy(num_rows * num_rhs, rhs, inc, ws->u, inc, queue);
+    for (index_type j = 0; j < num_rhs; j++) {
+        auto u = ws->u + j * num_rows;
+        scalars[j].beta = blas::norm2(num_rows, u, inc, queue);
+        if (scalars[j].beta > 0) {
+            blas::scale(num_rows, 1 / scalars[j].beta, u, inc, queue);
+        }
+    }
+    multiply(MagmaTrans, num_rows, num_cols, num_rhs, mtx, ws->u,
+             value_type(0), ws->v, *ws, blas_info);
+    for (index_type j = 0; j < num_rhs; j++) {
+        auto& s = scalars[j];
+        auto v = ws->v + j * num_cols;
+        blas::trsv(MagmaUpper, MagmaTrans, MagmaNonUnit, num_cols,
+                   precond_mtx, ld_precond, v, inc, queue);
+        s.alpha = blas::norm2(num_cols, v, inc, queue);
+        if (s.alpha > 0) {
+            blas::scale(num_cols, 1 / s.alpha, v, inc, queue);
+        }
+        blas::copy(num_cols, v, inc, ws->w + j * num_cols, inc, queue);
+        s.phi_bar = s.beta;
+        s.rho_bar = s.alpha;
+        s.bnorm = s.beta;
+        s.rnorm = s.beta;
+        s.arnorm = s.alpha * s.beta;
+    }
+
+    index_type num_active = num_rhs;
+    index_type block_iter = 0;
+    auto retire = [&](index_type slot, stop_reason reason) {
+        reasons[order[slot]] = reason;
+        iters[order[slot]] = block_iter;
+        num_active--;
+        swap_slots(slot, num_active, scalars, order, *ws, queue);
+    };
+    for (auto j = num_active - 1; j >= 0; j--) {
+        if (scalars[j].alpha * scalars[j].beta == 0) {
+            retire(j, stop_reason::breakdown);
+        }
+    }
+    while (num_active > 0) {
+        step_1(num_rows, num_cols, num_active, mtx, precond_mtx, ld_precond,
+               scalars, *ws, blas_info);
+        for (index_type j = 0; j < num_active; j++) {
+            lsqr::temp_vectors<value_type, value_type, index_type> vectors;
+            vectors.v = ws->v + j * num_cols;
+            vectors.w = ws->w + j * num_cols;
+            vectors.temp = ws->temp + j * num_cols;
+            vectors.inc = inc;
+            lsqr::update_solution(num_cols, sol + order[j] * num_cols,
+                                  precond_mtx, ld_precond, scalars[j],
+                                  vectors, queue);
+        }
+        block_iter++;
+        for (auto j = num_active - 1; j >= 0; j--) {
+            auto reason =
+                lsqr::check_estimates(scalars[j], block_iter, max_iter, tol);
+            if (reason != stop_reason::none) {
+                retire(j, reason);
+            }
+        }
+    }
+
+    for (index_type j = 0; j < num_rhs; j++) {
+        auto col = order[j];
+        // A zero rhs is solved exactly by sol = 0.
+        resnorm[col] = (scalars[j].bnorm == 0)
+                           ? 0.0
+                           : lsqr::true_relres(num_rows, num_cols, mtx,
+                                               rhs + col * num_rows,
+                                               sol + col * num_cols,
+                                               ws->residual, queue);
+        iter[col] = iters[col];
+        if (info != nullptr) {
+            auto& s = scalars[j];
+            info[col].reason = reasons[col];
+            info[col].rnorm = s.rnorm;
+            info[col].arnorm = s.arnorm;
+            info[col].anorm = s.anorm;
+            info[col].acond = s.anorm * std::sqrt(s.ddnorm);
+            info[col].xnorm = s.xnorm;
+        }
+    }
+    *t_solve += (detail::sync_wtime(queue) - t);
+    default_ws.free();
+}
+
+}  // end of anonymous namespace
+
+
+template <typename value_type_in, typename value_type, typename index_type>
+void workspace<value_type_in, value_type, index_type>::allocate(
+    index_type num_rows_in, index_type num_cols_in, index_type num_rhs_in)
+{
+    num_rows = num_rows_in;
+    num_cols = num_cols_in;
+    num_rhs = num_rhs_in;
+    memory::malloc(&u, num_rows * num_rhs);
+    memory::malloc(&v, num_cols * num_rhs);
+    memory::malloc(&w, num_cols * num_rhs);
+    memory::malloc(&temp, num_cols * num_rhs);
+    memory::malloc(&residual, std::max(num_rows, num_cols));
+    if (!std::is_same<value_type_in, value_type>::value) {
+        memory::malloc(&u_in, num_rows * num_rhs);
+        memory::malloc(&temp_in, num_cols * num_rhs);
+    }
+}
+
+template <typename value_type_in, typename value_type, typename index_type>
+void workspace<value_type_in, value_type, index_type>::free()
+{
+    if (u == nullptr) {
+        return;
+    }
+    memory::free(u);
+    memory::free(v);
+    memory::free(w);
+    memory::free(temp);
+    memory::free(residual);
+    if (u_in != nullptr) {
+        memory::free(u_in);
+        memory::free(temp_in);
+    }
+    *this = workspace();
+}
+
+template struct workspace<double, double, magma_int_t>;
+template struct workspace<float, double, magma_int_t>;
+template struct workspace<__half, double, magma_int_t>;
+template struct workspace<__nv_bfloat16, double, magma_int_t>;
+template struct workspace<float, float, magma_int_t>;
+template struct workspace<__half, float, magma_int_t>;
+
+template struct workspace<__nv_bfloat16, float, magma_int_t>;
+
+
+// Preconditioned block LSQR.
+template <typename value_type_in, typename value_type, typename index_type>
+void run(index_type num_rows, index_type num_cols, index_type num_rhs,
+         value_type* mtx, value_type* rhs, value_type* sol,
+         index_type max_iter, index_type* iter, value_type tol,
+         double* resnorm, value_type* precond_mtx, index_type ld_precond,
+         magma_queue_t queue, double* t_solve, convergence* info,
+         workspace<value_type_in, value_type, index_type>* ws)
+{
+    solve<value_type_in>(num_rows, num_cols, num_rhs, mtx, rhs, sol, max_iter,
+                         iter, tol, resnorm, precond_mtx, ld_precond, queue,
+                         t_solve, info, ws);
+}
+
+template void run<double, double, magma_int_t>(
+    magma_int_t num_rows, magma_int_t num_cols, magma_int_t num_rhs,
+    double* mtx, double* rhs, double* sol, magma_int_t max_iter,
+    magma_int_t* iter, double tol, double* resnorm, double* precond_mtx,
+    magma_int_t ld_precond, magma_queue_t queue, double* t_solve,
+    convergence* info, workspace<double, double, magma_int_t>* ws);
+
+template void run<float, double, magma_int_t>(
+    magma_int_t num_rows, magma_int_t num_cols, magma_int_t num_rhs,
+    double* mtx, double* rhs, double* sol, magma_int_t max_iter,
+    magma_int_t* iter, double tol, double* resnorm, double* precond_mtx,
+    magma_int_t ld_precond, magma_queue_t queue, double* t_solve,
+    convergence* info, workspace<float, double, magma_int_t>* ws);
+
+template void run<__half, double, magma_int_t>(
+    magma_int_t num_rows, magma_int_t num_cols, magma_int_t num_rhs,
+    double* mtx, double* rhs, double* sol, magma_int_t max_iter,
+    magma_int_t* iter, double tol, double* resnorm, double* precond_mtx,
+    magma_int_t ld_precond, magma_queue_t queue, double* t_solve,
+    convergence* info, workspace<__half, double, magma_int_t>* ws);
+
+template void run<__nv_bfloat16, double, magma_int_t>(
+    magma_int_t num_rows, magma_int_t num_cols, magma_int_t num_rhs,
+    double* mtx, double* rhs, double* sol, magma_int_t max_iter,
+    magma_int_t* iter, double tol, double* resnorm, double* precond_mtx,
+    magma_int_t ld_precond, magma_queue_t queue, double* t_solve,
+    convergence* info, workspace<__nv_bfloat16, double, magma_int_t>* ws);
+
+template void run<float, float, magma_int_t>(
+    magma_int_t num_rows, magma_int_t num_cols, magma_int_t num_rhs,
+    float* mtx, float* rhs, float* sol, magma_int_t max_iter,
+    magma_int_t* iter, float tol, double* resnorm, float* precond_mtx,
+    magma_int_t ld_precond, magma_queue_t queue, double* t_solve,
+    convergence* info, workspace<float, float, magma_int_t>* ws);
+
+template void run<__half, float, magma_int_t>(
+    magma_int_t num_rows, magma_int_t num_cols, magma_int_t num_rhs,
+    float* mtx, float* rhs, float* sol, magma_int_t max_iter,
+    magma_int_t* iter, float tol, double* resnorm, float* precond_mtx,
+    magma_int_t ld_precond, magma_queue_t queue, double* t_solve,
+    convergence* info, workspace<__half, float, magma_int_t>* ws);
+
+template void run<__nv_bfloat16, float, magma_int_t>(
+    magma_int_t num_rows, magma_int_t num_cols, magma_int_t num_rhs,
+    float* mtx, float* rhs, float* sol, magma_int_t max_iter,
+    magma_int_t* iter, float tol, double* resnorm, float* precond_mtx,
+    magma_int_t ld_precond, magma_queue_t queue, double* t_solve,
+    convergence* info, workspace<__nv_bfloat16, float, magma_int_t>* ws);
+
+
+}  // namespace block_lsqr
+}  // namespace solver
+}  // namespace rls
@@ -0,0 +1,60 @@
+#ifndef BLOCK_LSQR_HPP
+#define BLOCK_LSQR_HPP
+
+
+#include "../include/base_types.hpp"
+#include "lsqr.hpp"
+
+
+namespace rls {
+namespace solver {
+namespace block_lsqr {
+
+
+using lsqr::convergence;
+using lsqr::stop_reason;
+
+// Buffers of block LSQR for num_rhs right-hand sides, stored column by
+// column: u is num_rows x num_rhs, v, w and temp are num_cols x num_rhs.
+// u_in and temp_in hold the blocks in value_type_in when the matrix-block
+// products run in a lower precision. Reused like lsqr::workspace.
+template <typename value_type_in, typename value_type, typename index_type>
+struct workspace {
+    index_type num_rows = 0;
+    index_type num_cols = 0;
+    index_type num_rhs = 0;
+    value_type* u = nullptr;
+    value_type* v = nullptr;
+    value_type* w = nullptr;
+    value_type* temp = nullptr;
+    value_type* residual = nullptr;
+    value_type_in* u_in = nullptr;
+    value_type_in* temp_in = nullptr;
+    value_type_in* mtx_in = nullptr;
+
+    void allocate(index_type num_rows_in, index_type num_cols_in,
+                  index_type num_rhs_in);
+
+    void free();
+};
+
+// Preconditioned LSQR for the num_rhs columns of rhs (ld num_rows) with one
+// preconditioner. The bidiagonalizations run in lockstep, so every iteration
+// reads mtx twice for all right-hand sides with gemm instead of gemv. Each
+// column stops on its own estimates; converged columns are moved behind the
+// active ones so the products shrink with them. sol (ld num_cols) must be
+// zero on entry; iter, resnorm and info, if given, have num_rhs entries.
+template <typename value_type_in, typename value_type, typename index_type>
+void run(index_type num_rows, index_type num_cols, index_type num_rhs,
+         value_type* mtx, value_type* rhs, value_type* sol,
+         index_type max_iter, index_type* iter, value_type tol,
+         double* resnorm, value_type* precond_mtx, index_type ld_precond,
+         magma_queue_t queue, double* t_solve, convergence* info = nullptr,
+         workspace<value_type_in, value_type, index_type>* ws = nullptr);
+
+}  // namespace block_lsqr
+}  // namespace solver
+}  // namespace rls
+
+
+#endif
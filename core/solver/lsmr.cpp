@@ -0,0 +1,394 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include "magma_v2.h"
+
+
+#include "../../cuda/solver/lsqr_kernels.cuh"
+#include "../../host/solver/lsqr_kernels.hpp"
+#include "../blas/blas.hpp"
+#include "../matrix/sparse.hpp"
+#include "../memory/detail.hpp"
+#include "../memory/memory.hpp"
+#include "base_types.hpp"
+#include "lsmr.hpp"
+#include "lsqr.hpp"
+
+namespace rls {
+namespace solver {
+namespace lsmr {
+namespace {
+
+
+// Recurrences of LSMR with damp = 0; a damped solve folds damp into the
+// operator instead, see lsqr::temp_scalars. The names follow Fong and Saunders,
+// "LSMR: an iterative algorithm for sparse least-squares problems" (2011).
+template <typename value_type>
+struct lsmr_scalars {
+    value_type alpha_bar;
+    value_type zeta_bar;
+    value_type rho = 1;
+    value_type rho_bar = 1;
+    value_type c_bar = 1;
+    value_type s_bar = 0;
+    value_type zeta = 0;
+    // Estimate of ||r||.
+    value_type beta_dd;
+    value_type beta_d = 0;
+    value_type rho_d_old = 1;
+    value_type tau_tilde_old = 0;
+    value_type theta_tilde = 0;
+    // Estimate of cond(A R^{-1}).
+    value_type max_rbar = 0;
+    value_type min_rbar = std::numeric_limits<value_type>::max();
+    value_type acond = 0;
+};
+
+template <typename value_type, typename index_type>
+void set_zero(index_type num_elems, value_type* values)
+{
+    if (detail::use_host_backend()) {
+        host::set_values(num_elems, value_type(0), values);
+    } else {
+        cuda::set_values(num_elems, value_type(0), values);
+    }
+}
+
+// Applies the two plane rotations of step k to the new alpha and beta of
+// the bidiagonalization and updates h, hbar, y and sol.
+template <typename value_type_in, typename value_type, typename index_type>
+void update(index_type num_cols, value_type* sol, value_type* precond_mtx,
+            index_type ld_precond, index_type iter,
+            lsqr::temp_scalars<value_type, index_type>& scalars,
+            lsmr_scalars<value_type>& rec,
+            workspace<value_type_in, value_type, index_type>& ws,
+            magma_queue_t queue)
+{
+    index_type inc = 1;
+    auto& vectors = ws.bidiag.vectors;
+    auto h = vectors.w;
+
+    // Rotation P_k eliminates beta from the lower bidiagonal matrix.
+    auto rho_old = rec.rho;
+    rec.rho = std::sqrt(rec.alpha_bar * rec.alpha_bar +
+                        scalars.beta * scalars.beta);
+    auto c = rec.alpha_bar / rec.rho;
+    auto s = scalars.beta / rec.rho;
+    auto theta_new = s * scalars.alpha;
+    rec.alpha_bar = c * scalars.alpha;
+
+    // Rotation Pbar_k eliminates theta_new from the upper bidiagonal R_k.
+    auto rho_bar_old = rec.rho_bar;
+    auto zeta_old = rec.zeta;
+    auto theta_bar = rec.s_bar * rec.rho;
+    auto rho_temp = rec.c_bar * rec.rho;
+    rec.rho_bar = std::sqrt(rho_temp * rho_temp + theta_new * theta_new);
+    rec.c_bar = rho_temp / rec.rho_bar;
+    rec.s_bar = theta_new / rec.rho_bar;
+    rec.zeta = rec.c_bar * rec.zeta_bar;
+    rec.zeta_bar = -rec.s_bar * rec.zeta_bar;
+
+    // hbar = h - theta_bar * rho / (rho_old * rho_bar_old) * hbar,
+    // y += zeta / (rho * rho_bar) * hbar and x = R^{-1} * y,
+    // h = v - theta_new / rho * h.
+    blas::scale(num_cols, -(theta_bar * rec.rho / (rho_old * rho_bar_old)),
+                ws.hbar, inc, queue);
+    blas::axpy(num_cols, value_type(1), h, inc, ws.hbar, inc, queue);
+    auto step = rec.zeta / (rec.rho * rec.rho_bar);
+    blas::axpy(num_cols, step, ws.hbar, inc, ws.y, inc, queue);
+    blas::copy(num_cols, ws.hbar, inc, vectors.temp, inc, queue);
+    blas::trsv(MagmaUpper, MagmaNoTrans, MagmaNonUnit, num_cols, precond_mtx,
+               ld_precond, vectors.temp, inc, queue);
+    blas::axpy(num_cols, step, vectors.temp, inc, sol, inc, queue);
+    blas::scale(num_cols, -(theta_new / rec.rho), h, inc, queue);
+    blas::axpy(num_cols, value_type(1), vectors.v, inc, h, inc, queue);
+
+    // Estimate of ||r|| from the rotations applied to beta_1 * e_1.
+    auto beta_hat = c * rec.beta_dd;
+    rec.beta_dd = -s * rec.beta_dd;
+    auto theta_tilde_old = rec.theta_tilde;
+    auto rho_tilde_old =
+        std::sqrt(rec.rho_d_old * rec.rho_d_old + theta_bar * theta_bar);
+    auto c_tilde_old = rec.rho_d_old / rho_tilde_old;
+    auto s_tilde_old = theta_bar / rho_tilde_old;
+    rec.theta_tilde = s_tilde_old * rec.rho_bar;
+    rec.rho_d_old = c_tilde_old * rec.rho_bar;
+    rec.beta_d = -s_tilde_old * rec.beta_d + c_tilde_old * beta_hat;
+    rec.tau_tilde_old =
+        (zeta_old - theta_tilde_old * rec.tau_tilde_old) / rho_tilde_old;
+    auto tau_d = (rec.zeta - rec.theta_tilde * rec.tau_tilde_old) /
+                 rec.rho_d_old;
+    scalars.rnorm = std::sqrt((rec.beta_d - tau_d) * (rec.beta_d - tau_d) +
+                              rec.beta_dd * rec.beta_dd);
+    scalars.arnorm = std::abs(rec.zeta_bar);
+    scalars.xnorm = blas::norm2(num_cols, ws.y, inc, queue);
+
+    rec.max_rbar = std::max(rec.max_rbar, rho_bar_old);
+    if (iter > 1) {
+        rec.min_rbar = std::min(rec.min_rbar, rho_bar_old);
+    }
+    rec.acond =
+        std::max(rec.max_rbar, rho_temp) / std::min(rec.min_rbar, rho_temp);
+}
+
+// Preconditioned LSMR on a dense matrix or a matrix::sparse.
+template <typename value_type_in, typename value_type, typename index_type,
+          typename matrix_type>
+void solve(index_type num_rows, index_type num_cols, matrix_type mtx,
+           value_type* rhs, value_type* init_sol, value_type* sol,
+           index_type max_iter, index_type* iter, value_type tol,
+           double* resnorm, value_type* precond_mtx, index_type ld_precond,
+           magma_queue_t queue, double* t_solve, convergence* info,
+           workspace<value_type_in, value_type, index_type>* ws,
+           value_type damp)
+{
+    index_type inc = 1;
+    lsqr::temp_scalars<value_type, index_type> scalars;
+    scalars.damp = damp;
+    lsmr_scalars<value_type> rec;
+    convergence default_info;
+    if (info == nullptr) {
+        info = &default_info;
+    }
+    workspace<value_type_in, value_type, index_type> default_ws;
+    if (ws == nullptr) {
+        ws = &default_ws;
+    }
+    if (ws->num_cols != num_cols) {
+        ws->free();
+        ws->allocate(num_cols);
+    }
+    // A warm start solves for the correction, as in lsqr::run.
+    auto warm = lsqr::start_from_guess(num_rows, num_cols, mtx, rhs, init_sol,
+                                       damp, ws->bidiag, queue);
+    auto start_rhs = warm ? ws->bidiag.residual : rhs;
+    lsqr::start_bidiagonalization(num_rows, num_cols, mtx, start_rhs,
+                                  precond_mtx, ld_precond, scalars, ws->bidiag,
+                                  queue);
+    if (warm) {
+        lsqr::warm_estimates(num_rows, num_cols, rhs, init_sol, precond_mtx,
+                             ld_precond, ws->bidiag.vectors.temp, scalars,
+                             queue);
+    }
+    auto& vectors = ws->bidiag.vectors;
+    auto rhsnorm = blas::norm2(num_rows, rhs, inc, queue);
+    auto rhs_scale = warm ? blas::norm2(num_rows, start_rhs, inc, queue) /
+                                ((rhsnorm > 0) ? rhsnorm : 1.0)
+                          : 1.0;
+    set_zero(num_cols, ws->hbar);
+    set_zero(num_cols, ws->y);
+    rec.alpha_bar = scalars.alpha;
+    rec.zeta_bar = scalars.alpha * scalars.beta;
+    rec.beta_dd = scalars.beta;
+
+    *iter = 0;
+    *t_solve = 0;
+    double t = detail::sync_wtime(queue);
+    // start_bidiagonalization leaves u or v zero for a zero rhs or a zero
+    // A^T * rhs, which stops here with sol = init_sol.
+    auto reason = (scalars.alpha * scalars.beta == 0) ? stop_reason::breakdown
+                                                      : stop_reason::none;
+    while (reason == stop_reason::none) {
+        lsqr::bidiagonalize(num_rows, num_cols, mtx, precond_mtx, ld_precond,
+                            scalars, ws->bidiag, queue);
+        *iter += 1;
+        update(num_cols, sol, precond_mtx, ld_precond, *iter, scalars, rec,
+               *ws, queue);
+        reason = lsqr::check_estimates(scalars, *iter, max_iter, tol);
+        if ((reason == stop_reason::none) && (info->res_check_interval > 0) &&
+            (*iter % info->res_check_interval == 0)) {
+            *resnorm = rhs_scale * lsqr::true_relres(num_rows, num_cols, mtx,
+                                                     start_rhs, sol,
+                                                     vectors.temp, queue);
+            if (*resnorm < tol) {
+                reason = stop_reason::true_residual;
+            }
+        }
+    }
+    if (warm) {
+        blas::axpy(num_cols, 1.0, init_sol, inc, sol, inc, queue);
+    }
+    if (warm || (reason != stop_reason::true_residual)) {
+        *resnorm = lsqr::true_relres(num_rows, num_cols, mtx, rhs, sol,
+                                     vectors.temp, queue);
+    }
+    *t_solve += (detail::sync_wtime(queue) - t);
+    info->reason = reason;
+    info->rnorm = scalars.rnorm;
+    info->arnorm = scalars.arnorm;
+    info->anorm = scalars.anorm;
+    info->acond = rec.acond;
+    info->xnorm = scalars.xnorm;
+    default_ws.free();
+}
+
+}  // end of anonymous namespace
+
+
+template <typename value_type_in, typename value_type, typename index_type>
+void workspace<value_type_in, value_type, index_type>::allocate(
+    index_type num_cols_in)
+{
+    num_cols = num_cols_in;
+    memory::malloc(&hbar, num_cols);
+    memory::malloc(&y, num_cols);
+}
+
+template <typename value_type_in, typename value_type, typename index_type>
+void workspace<value_type_in, value_type, index_type>::free()
+{
+    bidiag.free();
+    if (hbar == nullptr) {
+        return;
+    }
+    memory::free(hbar);
+    memory::free(y);
+    hbar = nullptr;
+    y = nullptr;
+    num_cols = 0;
+}
+
+template struct workspace<double, double, magma_int_t>;
+template struct workspace<float, double, magma_int_t>;
+template struct workspace<__half, double, magma_int_t>;
+template struct workspace<__nv_bfloat16, double, magma_int_t>;
+template struct workspace<float, float, magma_int_t>;
+template struct workspace<__half, float, magma_int_t>;
+
+template struct workspace<__nv_bfloat16, float, magma_int_t>;
+
+
+// Preconditioned LSMR.
+template <typename value_type_in, typename value_type, typename index_type>
+void run(index_type num_rows, index_type num_cols, value_type* mtx,
+         value_type* rhs, value_type* init_sol, value_type* sol,
+         index_type max_iter, index_type* iter, value_type tol,
+         double* resnorm, value_type* precond_mtx, index_type ld_precond,
+         magma_queue_t queue, double* t_solve, convergence* info,
+         workspace<value_type_in, value_type, index_type>* ws,
+         value_type damp)
+{
+    solve<value_type_in>(num_rows, num_cols, mtx, rhs, init_sol, sol, max_iter,
+                         iter, tol, resnorm, precond_mtx, ld_precond, queue,
+                         t_solve, info, ws, damp);
+}
+
+template void run<double, double, magma_int_t>(
+    magma_int_t num_rows, magma_int_t num_cols, double* mtx, double* rhs,
+    double* init_sol, double* sol, magma_int_t max_iter, magma_int_t* iter,
+    double tol, double* resnorm, double* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<double, double, magma_int_t>* ws, double damp);
+
+template void run<float, double, magma_int_t>(
+    magma_int_t num_rows, magma_int_t num_cols, double* mtx, double* rhs,
+    double* init_sol, double* sol, magma_int_t max_iter, magma_int_t* iter,
+    double tol, double* resnorm, double* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<float, double, magma_int_t>* ws, double damp);
+
+template void run<__half, double, magma_int_t>(
+    magma_int_t num_rows, magma_int_t num_cols, double* mtx, double* rhs,
+    double* init_sol, double* sol, magma_int_t max_iter, magma_int_t* iter,
+    double tol, double* resnorm, double* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<__half, double, magma_int_t>* ws, double damp);
+
+template void run<__nv_bfloat16, double, magma_int_t>(
+    magma_int_t num_rows, magma_int_t num_cols, double* mtx, double* rhs,
+    double* init_sol, double* sol, magma_int_t max_iter, magma_int_t* iter,
+    double tol, double* resnorm, double* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<__nv_bfloat16, double, magma_int_t>* ws, double damp);
+
+template void run<float, float, magma_int_t>(
+    magma_int_t num_rows, magma_int_t num_cols, float* mtx, float* rhs,
+    float* init_sol, float* sol, magma_int_t max_iter, magma_int_t* iter,
+    float tol, double* resnorm, float* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<float, float, magma_int_t>* ws, float damp);
+
+template void run<__half, float, magma_int_t>(
+    magma_int_t num_rows, magma_int_t num_cols, float* mtx, float* rhs,
+    float* init_sol, float* sol, magma_int_t max_iter, magma_int_t* iter,
+    float tol, double* resnorm, float* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<__half, float, magma_int_t>* ws, float damp);
+
+template void run<__nv_bfloat16, float, magma_int_t>(
+    magma_int_t num_rows, magma_int_t num_cols, float* mtx, float* rhs,
+    float* init_sol, float* sol, magma_int_t max_iter, magma_int_t* iter,
+    float tol, double* resnorm, float* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<__nv_bfloat16, float, magma_int_t>* ws, float damp);
+
+
+// Preconditioned LSMR for mtx in CSR format, on the host backend.
+template <typename value_type_in, typename value_type, typename index_type>
+void run(matrix::sparse<value_type, index_type>* mtx, value_type* rhs,
+         value_type* init_sol, value_type* sol, index_type max_iter,
+         index_type* iter, value_type tol, double* resnorm,
+         value_type* precond_mtx, index_type ld_precond, magma_queue_t queue,
+         double* t_solve, convergence* info,
+         workspace<value_type_in, value_type, index_type>* ws,
+         value_type damp)
+{
+    solve<value_type_in>(mtx->num_rows, mtx->num_cols, mtx, rhs, init_sol,
+                         sol, max_iter, iter, tol, resnorm, precond_mtx,
+                         ld_precond, queue, t_solve, info, ws, damp);
+}
+
+template void run<double, double, magma_int_t>(
+    matrix::sparse<double, magma_int_t>* mtx, double* rhs, double* init_sol,
+    double* sol, magma_int_t max_iter, magma_int_t* iter, double tol,
+    double* resnorm, double* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<double, double, magma_int_t>* ws, double damp);
+
+template void run<float, double, magma_int_t>(
+    matrix::sparse<double, magma_int_t>* mtx, double* rhs, double* init_sol,
+    double* sol, magma_int_t max_iter, magma_int_t* iter, double tol,
+    double* resnorm, double* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<float, double, magma_int_t>* ws, double damp);
+
+template void run<__half, double, magma_int_t>(
+    matrix::sparse<double, magma_int_t>* mtx, double* rhs, double* init_sol,
+    double* sol, magma_int_t max_iter, magma_int_t* iter, double tol,
+    double* resnorm, double* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<__half, double, magma_int_t>* ws, double damp);
+
+template void run<__nv_bfloat16, double, magma_int_t>(
+    matrix::sparse<double, magma_int_t>* mtx, double* rhs, double* init_sol,
+    double* sol, magma_int_t max_iter, magma_int_t* iter, double tol,
+    double* resnorm, double* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<__nv_bfloat16, double, magma_int_t>* ws, double damp);
+
+template void run<float, float, magma_int_t>(
+    matrix::sparse<float, magma_int_t>* mtx, float* rhs, float* init_sol,
+    float* sol, magma_int_t max_iter, magma_int_t* iter, float tol,
+    double* resnorm, float* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<float, float, magma_int_t>* ws, float damp);
+
+template void run<__half, float, magma_int_t>(
+    matrix::sparse<float, magma_int_t>* mtx, float* rhs, float* init_sol,
+    float* sol, magma_int_t max_iter, magma_int_t* iter, float tol,
+    double* resnorm, float* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<__half, float, magma_int_t>* ws, float damp);
+
+template void run<__nv_bfloat16, float, magma_int_t>(
+    matrix::sparse<float, magma_int_t>* mtx, float* rhs, float* init_sol,
+    float* sol, magma_int_t max_iter, magma_int_t* iter, float tol,
+    double* resnorm, float* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<__nv_bfloat16, float, magma_int_t>* ws, float damp);
+
+
+}  // namespace lsmr
+}  // namespace solver
+}  // namespace rls
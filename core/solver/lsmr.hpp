@@ -0,0 +1,63 @@
+#ifndef LSMR_HPP
+#define LSMR_HPP
+
+
+#include "../include/base_types.hpp"
+#include "../matrix/sparse.hpp"
+#include "lsqr.hpp"
+
+
+namespace rls {
+namespace solver {
+namespace lsmr {
+
+
+using lsqr::convergence;
+using lsqr::stop_reason;
+
+// Buffers of preconditioned LSMR. Extends the LSQR workspace, whose w holds
+// the search direction h, with hbar and y = R * x. Reused like
+// lsqr::workspace.
+template <typename value_type_in, typename value_type, typename index_type>
+struct workspace {
+    lsqr::workspace<value_type_in, value_type, index_type> bidiag;
+    index_type num_cols = 0;
+    value_type* hbar = nullptr;
+    value_type* y = nullptr;
+
+    void allocate(index_type num_cols_in);
+
+    void free();
+};
+
+// Preconditioned LSMR (Fong and Saunders), on the same bidiagonalization of
+// A * R^{-1} as lsqr::run. ||A^T r|| decreases monotonically, so it usually
+// stops earlier than LSQR on the least squares test. The residual estimate
+// is exact in exact arithmetic; info->acond estimates cond(A R^{-1}) from
+// the bidiagonal factor. init_sol warm-starts the iteration and a nonzero damp
+// solves the ridge problem, both as in lsqr::run.
+template <typename value_type_in, typename value_type, typename index_type>
+void run(index_type num_rows, index_type num_cols, value_type* mtx,
+         value_type* rhs, value_type* init_sol, value_type* sol,
+         index_type max_iter, index_type* iter, value_type tol,
+         double* resnorm, value_type* precond_mtx, index_type ld_precond,
+         magma_queue_t queue, double* t_solve, convergence* info = nullptr,
+         workspace<value_type_in, value_type, index_type>* ws = nullptr,
+         value_type damp = 0);
+
+// Preconditioned LSMR for mtx in CSR format. Host backend only.
+template <typename value_type_in, typename value_type, typename index_type>
+void run(matrix::sparse<value_type, index_type>* mtx, value_type* rhs,
+         value_type* init_sol, value_type* sol, index_type max_iter,
+         index_type* iter, value_type tol, double* resnorm,
+         value_type* precond_mtx, index_type ld_precond, magma_queue_t queue,
+         double* t_solve, convergence* info = nullptr,
+         workspace<value_type_in, value_type, index_type>* ws = nullptr,
+         value_type damp = 0);
+
+}  // namespace lsmr
+}  // namespace solver
+}  // namespace rls
+
+
+#endif
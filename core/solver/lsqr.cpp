@@ -1,5 +1,7 @@
 #include <cuda_runtime.h>
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
 #include <iostream>
 #include "cublas_v2.h"
 #include "cuda_fp16.h"
@@ -8,8 +10,13 @@
 
 
 #include "../../cuda/preconditioner/preconditioner_kernels.cuh"
+#include "../../host/solver/lsqr_kernels.hpp"
 #include "../../utils/io.hpp"
+#include "../../host/blas/blas_kernels.hpp"
 #include "../blas/blas.hpp"
+#include "../matrix/panelled.hpp"
+#include "../matrix/sparse.hpp"
+#include "../memory/detail.hpp"
 #include "../memory/memory.hpp"
 #include "base_types.hpp"
 #include "lsqr.hpp"
@@ -53,6 +60,81 @@ void precond_apply(magma_trans_t trans, magma_int_t num_rows,
                u_vector, inc_u, queue);
 }
 
+// Returns the matrix in the precision used for matrix-vector products.
+template <typename value_type_in, typename value_type, typename index_type>
+value_type_in* matvec_mtx(
+    value_type* mtx,
+    temp_vectors<value_type_in, value_type, index_type>& vectors)
+{
+    return std::is_same<value_type_in, value_type>::value
+               ? reinterpret_cast<value_type_in*>(mtx)
+               : vectors.mtx_in;
+}
+
+template <typename value_type, typename index_type>
+void set_zero(index_type num_elems, value_type* values)
+{
+    if (detail::use_host_backend()) {
+        host::set_values(num_elems, value_type(0), values);
+    } else {
+        cuda::set_values(num_elems, value_type(0), values);
+    }
+}
+
+// The rows damp * I of the operator [A; damp * I] act on vectors.u_damp, the
+// trailing num_cols entries of u; without damping these helpers do nothing.
+
+// Returns ||u_damp||^2, in double like the fused host kernels.
+template <typename value_type_in, typename value_type, typename index_type>
+double damp_norm2(
+    index_type num_cols, temp_scalars<value_type, index_type>& scalars,
+    temp_vectors<value_type_in, value_type, index_type>& vectors,
+    magma_queue_t queue)
+{
+    if (scalars.damp == value_type(0)) {
+        return 0;
+    }
+    double norm = blas::norm2(num_cols, vectors.u_damp, vectors.inc, queue);
+    return norm * norm;
+}
+
+// u_damp = damp * t - alpha * u_damp for t = R^{-1} * v, returns
+// ||u_damp||^2.
+template <typename value_type_in, typename value_type, typename index_type>
+double damp_forward(
+    index_type num_cols, value_type* t,
+    temp_scalars<value_type, index_type>& scalars,
+    temp_vectors<value_type_in, value_type, index_type>& vectors,
+    magma_queue_t queue)
+{
+    if (scalars.damp == value_type(0)) {
+        return 0;
+    }
+    blas::scale(num_cols, -scalars.alpha, vectors.u_damp, vectors.inc, queue);
+    blas::axpy(num_cols, scalars.damp, t, vectors.inc, vectors.u_damp,
+               vectors.inc, queue);
+    return damp_norm2(num_cols, scalars, vectors, queue);
+}
+
+// Normalizes u_damp by scalars.beta and adds damp * u_damp to y = A^T * u.
+template <typename value_type_in, typename value_type, typename index_type>
+void damp_backward(
+    index_type num_cols, value_type* y,
+    temp_scalars<value_type, index_type>& scalars,
+    temp_vectors<value_type_in, value_type, index_type>& vectors,
+    magma_queue_t queue)
+{
+    if (scalars.damp == value_type(0)) {
+        return;
+    }
+    if (scalars.beta > 0) {
+        blas::scale(num_cols, 1 / scalars.beta, vectors.u_damp, vectors.inc,
+                    queue);
+    }
+    blas::axpy(num_cols, scalars.damp, vectors.u_damp, vectors.inc, y,
+               vectors.inc, queue);
+}
+
 // Initializes preconditioned LSQR.
 template <typename value_type, typename index_type>
 void initialize(index_type num_rows, index_type num_cols, index_type* iter,
@@ -65,12 +147,16 @@ void initialize(index_type num_rows, index_type num_cols, index_type* iter,
     *iter = 0;
     *beta = blas::norm2(num_rows, rhs, inc, queue);
     blas::copy(num_rows, rhs, inc, u_vector, inc, queue);
-    blas::scale(num_rows, 1 / *beta, u_vector, inc, queue);
+    if (*beta > 0) {
+        blas::scale(num_rows, 1 / *beta, u_vector, inc, queue);
+    }
     blas::gemv(MagmaTrans, num_rows, num_cols, 1.0, mtx, num_rows, u_vector,
                inc, 1.0, v_vector, inc, queue);
 
     *alpha = blas::norm2(num_rows, v_vector, inc, queue);
-    blas::scale(num_rows, 1 / *alpha, v_vector, inc, queue);
+    if (*alpha > 0) {
+        blas::scale(num_rows, 1 / *alpha, v_vector, inc, queue);
+    }
     blas::copy(num_rows, v_vector, inc, w_vector, inc, queue);
     *rho_bar = *alpha;
     *phi_bar = *beta;
@@ -96,28 +182,58 @@ void initialize(index_type num_rows, index_type num_cols, value_type* mtx,
         memory::malloc(&vectors.mtx_in, num_rows * num_cols);
 
         if (sizeof(value_type) > sizeof(value_type_in)) {
-            cuda::demote(num_rows, num_cols, mtx, num_rows, vectors.mtx_in,
-                         num_rows);
+            memory::demote(num_rows, num_cols, mtx, num_rows, vectors.mtx_in,
+                           num_rows);
         } else if (sizeof(value_type) < sizeof(value_type_in)) {
-            cuda::promote(num_rows, num_cols, mtx, num_rows, vectors.mtx_in,
-                          num_rows);
+            memory::promote(num_rows, num_cols, mtx, num_rows, vectors.mtx_in,
+                            num_rows);
         }
     }
 
     *iter = 0;
     scalars.beta = blas::norm2(num_rows, rhs, vectors.inc, queue);
     blas::copy(num_rows, rhs, vectors.inc, vectors.u, vectors.inc, queue);
-    blas::scale(num_rows, 1 / scalars.beta, vectors.u, vectors.inc, queue);
+    if (scalars.beta > 0) {
+        blas::scale(num_rows, 1 / scalars.beta, vectors.u, vectors.inc,
+                    queue);
+    }
     blas::gemv(MagmaTrans, num_rows, num_cols, 1.0, mtx, num_rows, vectors.u,
                vectors.inc, 1.0, vectors.v, vectors.inc, queue);
 
     scalars.alpha = blas::norm2(num_cols, vectors.v, vectors.inc, queue);
-    blas::scale(num_cols, 1 / scalars.alpha, vectors.v, vectors.inc, queue);
+    if (scalars.alpha > 0) {
+        blas::scale(num_cols, 1 / scalars.alpha, vectors.v, vectors.inc,
+                    queue);
+    }
     blas::copy(num_cols, vectors.v, vectors.inc, vectors.w, vectors.inc, queue);
     scalars.rho_bar = scalars.alpha;
     scalars.phi_bar = scalars.beta;
 }
 
+// Normalizes v = R^{-T} * A^T * u and sets up the recurrences once u and beta
+// are known.
+template <typename value_type_in, typename value_type, typename index_type>
+void initialize_estimates(
+    index_type num_cols, value_type* precond_mtx, index_type ld_precond,
+    temp_scalars<value_type, index_type>& scalars,
+    temp_vectors<value_type_in, value_type, index_type>& vectors,
+    magma_queue_t queue)
+{
+    precond_apply(MagmaTrans, num_cols, precond_mtx, ld_precond, vectors.v,
+                  vectors.inc, queue);
+    scalars.alpha = blas::norm2(num_cols, vectors.v, vectors.inc, queue);
+    if (scalars.alpha > 0) {
+        blas::scale(num_cols, 1 / scalars.alpha, vectors.v, vectors.inc,
+                    queue);
+    }
+    blas::copy(num_cols, vectors.v, vectors.inc, vectors.w, vectors.inc, queue);
+    scalars.phi_bar = scalars.beta;
+    scalars.rho_bar = scalars.alpha;
+    scalars.bnorm = scalars.beta;
+    scalars.rnorm = scalars.beta;
+    scalars.arnorm = scalars.alpha * scalars.beta;
+}
+
 // Initializes preconditioned LSQR.
 template <typename value_type_in, typename value_type, typename index_type>
 void initialize(index_type num_rows, index_type num_cols, value_type* mtx,
@@ -126,88 +242,215 @@ void initialize(index_type num_rows, index_type num_cols, value_type* mtx,
                 temp_vectors<value_type_in, value_type, index_type>& vectors,
                 magma_queue_t queue)
 {
-    vectors.inc = 1;
-    memory::malloc(&vectors.u, num_rows);
-    memory::malloc(&vectors.v, num_rows);
-    memory::malloc(&vectors.w, num_rows);
-    memory::malloc(&vectors.temp, num_rows);
-    if (!std::is_same<value_type_in, value_type>::value) {
-        memory::malloc(&vectors.u_in, num_rows);
-        memory::malloc(&vectors.v_in, num_rows);
-        memory::malloc(&vectors.temp_in, num_rows);
-        memory::malloc(&vectors.mtx_in, num_rows * num_cols);
-        cuda::demote(num_rows, num_cols, mtx, num_rows, vectors.mtx_in,
-                     num_rows);
-    }
-
     *iter = 0;
-    scalars.beta = blas::norm2(num_rows, rhs, vectors.inc, queue);
-    std::cout << "scalars.beta: " << scalars.beta << "\n";
     blas::copy(num_rows, rhs, vectors.inc, vectors.u, vectors.inc, queue);
-    blas::scale(num_rows, 1 / scalars.beta, vectors.u, vectors.inc, queue);
+    scalars.beta = blas::norm2(num_rows, vectors.u, vectors.inc, queue);
+    scalars.beta = std::sqrt(double(scalars.beta) * scalars.beta +
+                             damp_norm2(num_cols, scalars, vectors, queue));
+    // A zero rhs leaves u = 0, so alpha = 0 and the solve stops on breakdown.
+    auto scale = (scalars.beta > 0) ? 1 / scalars.beta : value_type(1);
 
-    if (!std::is_same<value_type_in, value_type>::value) {
-        cuda::demote(num_rows, 1, vectors.u, num_rows, vectors.u_in, num_rows);
-        cuda::demote(num_rows, 1, vectors.v, num_rows, vectors.v_in, num_rows);
+    if (detail::use_host_backend()) {
+        host::scale_gemv_trans(num_rows, num_cols, matvec_mtx(mtx, vectors),
+                               num_rows, scale, vectors.u, value_type(0),
+                               vectors.v);
+    } else if (!std::is_same<value_type_in, value_type>::value) {
+        blas::scale(num_rows, scale, vectors.u, vectors.inc, queue);
+        memory::demote(num_rows, 1, vectors.u, num_rows, vectors.u_in,
+                       num_rows);
         blas::gemv(MagmaTrans, num_rows, num_cols, 1.0, vectors.mtx_in,
                    num_rows, vectors.u_in, vectors.inc, 0.0, vectors.v_in,
                    vectors.inc, queue);
-        cuda::promote(num_rows, 1, vectors.v_in, num_rows, vectors.v, num_rows);
+        memory::promote(num_rows, 1, vectors.v_in, num_rows, vectors.v,
+                        num_rows);
     } else {
+        blas::scale(num_rows, scale, vectors.u, vectors.inc, queue);
         blas::gemv(MagmaTrans, num_rows, num_cols, 1.0, mtx, num_rows,
                    vectors.u, vectors.inc, 0.0, vectors.v, vectors.inc, queue);
     }
+    damp_backward(num_cols, vectors.v, scalars, vectors, queue);
 
-    std::cout << "precond_mtx[0]: \n";
-    // rls::io::print_mtx_gpu(5, 5, precond_mtx, ld_precond, queue);
-    std::cout << "\n";
-    std::cout << "vectors.v[0]: \n";
-    // rls::io::print_mtx_gpu(1, 1, vectors.v, 1, queue);
-    std::cout << "\n";
-    std::cout << "  num_cols: " << num_cols << '\n';
-    std::cout << "ld_precond: " << ld_precond << '\n';
-
-    std::cout << "vectors before: \n";
-    rls::io::print_mtx_gpu(10, 1, (double*)vectors.v, num_cols, queue);
-    value_type one = 1.0;
-    // cuda::set_values(num_cols, one, vectors.v);
-    std::cout << "precond_mtx: \n";
-    rls::io::print_mtx_gpu(10, 10, (double*)precond_mtx, ld_precond, queue);
-    io::write_mtx("precond_mtx12.mtx", ld_precond, num_cols, (double*)precond_mtx, ld_precond, queue);
-    io::write_mtx("v12.mtx", num_cols, 1, (double*)vectors.v, num_cols, queue);
-    // (!) here I use the transpose maybe this is what I need to change in polymorhic branch
-    precond_apply(MagmaTrans, num_cols, precond_mtx, ld_precond, vectors.v,
-                  vectors.inc, queue);
-    io::write_mtx("v12.mtx", num_cols, 1, (double*)vectors.v, num_cols, queue);
+    initialize_estimates(num_cols, precond_mtx, ld_precond, scalars, vectors,
+                         queue);
+}
 
-    std::cout << "vectors after: \n";
-    rls::io::print_mtx_gpu(10, 1, (double*)vectors.v, num_cols, queue);
-    scalars.alpha = blas::norm2(num_cols, vectors.v, vectors.inc, queue);
-    std::cout << "scalars.alpha: " << scalars.alpha << '\n';
-    std::cout << "vectors.v[0]: \n";
-    // rls::io::print_mtx_gpu(1, 1, vectors.v, 1, queue);
+// Initializes preconditioned LSQR for mtx in CSR format, on the host backend.
+template <typename value_type_in, typename value_type, typename index_type>
+void initialize(index_type num_rows, index_type num_cols,
+                matrix::sparse<value_type, index_type>* mtx, value_type* rhs,
+                value_type* precond_mtx, index_type ld_precond,
+                index_type* iter, temp_scalars<value_type, index_type>& scalars,
+                temp_vectors<value_type_in, value_type, index_type>& vectors,
+                magma_queue_t queue)
+{
+    *iter = 0;
+    blas::copy(num_rows, rhs, vectors.inc, vectors.u, vectors.inc, queue);
+    scalars.beta = blas::norm2(num_rows, vectors.u, vectors.inc, queue);
+    scalars.beta = std::sqrt(double(scalars.beta) * scalars.beta +
+                             damp_norm2(num_cols, scalars, vectors, queue));
+    auto scale = (scalars.beta > 0) ? 1 / scalars.beta : value_type(1);
+    host::scale_spmv_trans(num_rows, num_cols, mtx->row_ptrs, mtx->col_idxs,
+                           matvec_mtx(mtx->values, vectors), scale,
+                           vectors.u, value_type(0), vectors.v);
+    damp_backward(num_cols, vectors.v, scalars, vectors, queue);
+    initialize_estimates(num_cols, precond_mtx, ld_precond, scalars, vectors,
+                         queue);
+}
 
-    blas::scale(num_cols, 1 / scalars.alpha, vectors.v, vectors.inc, queue);
-    blas::copy(num_cols, vectors.v, vectors.inc, vectors.w, vectors.inc, queue);
-    scalars.phi_bar = scalars.beta;
-    scalars.rho_bar = scalars.alpha;
+// Calls apply(panel, rows, row_offset) for the panels of mtx in order, in one
+// pass over its file. Exits if a panel cannot be read.
+template <typename value_type, typename index_type, typename panel_op>
+void for_each_panel(matrix::panelled<value_type, index_type>* mtx,
+                    panel_op apply)
+{
+    magma_int_t rows = 0;
+    index_type row_offset = 0;
+    mtx->reader->start();
+    while (value_type* panel = mtx->reader->next(&rows)) {
+        apply(panel, rows, row_offset);
+        row_offset += rows;
+    }
+    if (rows < 0) {
+        std::cerr << "reading a panel of the matrix failed\n";
+        std::exit(EXIT_FAILURE);
+    }
 }
 
+// Initializes preconditioned LSQR for a panelled mtx, on the host backend.
 template <typename value_type_in, typename value_type, typename index_type>
-void finalize(temp_vectors<value_type_in, value_type, index_type>& vectors)
+void initialize(index_type num_rows, index_type num_cols,
+                matrix::panelled<value_type, index_type>* mtx,
+                value_type* rhs, value_type* precond_mtx,
+                index_type ld_precond, index_type* iter,
+                temp_scalars<value_type, index_type>& scalars,
+                temp_vectors<value_type_in, value_type, index_type>& vectors,
+                magma_queue_t queue)
 {
-    memory::free(vectors.u);
-    memory::free(vectors.v);
-    memory::free(vectors.w);
-    memory::free(vectors.temp);
+    *iter = 0;
+    blas::copy(num_rows, rhs, vectors.inc, vectors.u, vectors.inc, queue);
+    scalars.beta = blas::norm2(num_rows, vectors.u, vectors.inc, queue);
+    scalars.beta = std::sqrt(double(scalars.beta) * scalars.beta +
+                             damp_norm2(num_cols, scalars, vectors, queue));
+    auto scale = (scalars.beta > 0) ? 1 / scalars.beta : value_type(1);
+    for_each_panel(mtx, [&](value_type* panel, index_type rows,
+                            index_type row_offset) {
+        host::scale_gemv_trans(rows, num_cols, panel, rows, scale,
+                               vectors.u + row_offset,
+                               value_type(row_offset > 0), vectors.v);
+    });
+    damp_backward(num_cols, vectors.v, scalars, vectors, queue);
+    initialize_estimates(num_cols, precond_mtx, ld_precond, scalars, vectors,
+                         queue);
+}
+
+// Sizes ws for a num_rows x num_cols problem and points it to the copy of
+// mtx used by the matrix-vector products.
+template <typename value_type_in, typename value_type, typename index_type>
+void prepare(index_type num_rows, index_type num_cols, value_type* mtx,
+             workspace<value_type_in, value_type, index_type>& ws)
+{
+    if ((ws.num_rows != num_rows) || (ws.num_cols != num_cols)) {
+        ws.free();
+        ws.allocate(num_rows, num_cols);
+    }
     if (!std::is_same<value_type_in, value_type>::value) {
-        memory::free(vectors.u_in);
-        memory::free(vectors.v_in);
-        memory::free(vectors.mtx_in);
-        memory::free(vectors.temp_in);
+        ws.vectors.mtx_in = memory::demoted_copy<value_type_in>(
+            num_rows, num_cols, mtx, num_rows);
+    }
+}
+
+template <typename value_type_in, typename value_type, typename index_type>
+void prepare(index_type num_rows, index_type num_cols,
+             matrix::sparse<value_type, index_type>* mtx,
+             workspace<value_type_in, value_type, index_type>& ws)
+{
+    if ((ws.num_rows != num_rows) || (ws.num_cols != num_cols)) {
+        ws.free();
+        ws.allocate(num_rows, num_cols);
+    }
+    if (!std::is_same<value_type_in, value_type>::value) {
+        ws.vectors.mtx_in = memory::demoted_copy<value_type_in>(
+            mtx->nnz, 1, mtx->values, mtx->nnz);
+    }
+}
+
+// The panels of a panelled mtx are read in value_type, so it needs no
+// demoted copy.
+template <typename value_type_in, typename value_type, typename index_type>
+void prepare(index_type num_rows, index_type num_cols,
+             matrix::panelled<value_type, index_type>* mtx,
+             workspace<value_type_in, value_type, index_type>& ws)
+{
+    if ((ws.num_rows != num_rows) || (ws.num_cols != num_cols)) {
+        ws.free();
+        ws.allocate(num_rows, num_cols);
     }
 }
 
+// Computes res_vector = rhs - mtx * sol.
+template <typename value_type, typename index_type>
+void residual(index_type num_rows, index_type num_cols, value_type* mtx,
+              value_type* rhs, value_type* sol, value_type* res_vector,
+              magma_queue_t queue)
+{
+    index_type inc = 1;
+    blas::copy(num_rows, rhs, inc, res_vector, inc, queue);
+    blas::gemv(MagmaNoTrans, num_rows, num_cols, -1.0, mtx, num_rows, sol, inc,
+               1.0, res_vector, inc, queue);
+}
+
+template <typename value_type, typename index_type>
+void residual(index_type num_rows, index_type num_cols,
+              matrix::sparse<value_type, index_type>* mtx, value_type* rhs,
+              value_type* sol, value_type* res_vector, magma_queue_t queue)
+{
+    index_type inc = 1;
+    blas::copy(num_rows, rhs, inc, res_vector, inc, queue);
+    host::spmv(num_rows, mtx->row_ptrs, mtx->col_idxs, mtx->values,
+               value_type(-1), sol, value_type(1), res_vector);
+}
+
+template <typename value_type, typename index_type>
+void residual(index_type num_rows, index_type num_cols,
+              matrix::panelled<value_type, index_type>* mtx, value_type* rhs,
+              value_type* sol, value_type* res_vector, magma_queue_t queue)
+{
+    index_type inc = 1;
+    blas::copy(num_rows, rhs, inc, res_vector, inc, queue);
+    for_each_panel(mtx, [&](value_type* panel, index_type rows,
+                            index_type row_offset) {
+        blas::gemv(MagmaNoTrans, rows, num_cols, -1.0, panel, rows, sol, inc,
+                   1.0, res_vector + row_offset, inc, queue);
+    });
+}
+
+// Sets u_damp to the damped rows -damp * init_sol of the starting residual.
+template <typename value_type_in, typename value_type, typename index_type>
+void start_damp(index_type num_cols, value_type* init_sol, bool warm,
+                value_type damp,
+                temp_vectors<value_type_in, value_type, index_type>& vectors,
+                magma_queue_t queue)
+{
+    if (damp == value_type(0)) {
+        return;
+    }
+    if (!warm) {
+        set_zero(num_cols, vectors.u_damp);
+        return;
+    }
+    blas::copy(num_cols, init_sol, vectors.inc, vectors.u_damp, vectors.inc,
+               queue);
+    blas::scale(num_cols, -damp, vectors.u_damp, vectors.inc, queue);
+}
+
+// Returns false if vec is missing or zero.
+template <typename value_type, typename index_type>
+bool nonzero(index_type size, value_type* vec, magma_queue_t queue)
+{
+    index_type inc = 1;
+    return (vec != nullptr) && (blas::norm2(size, vec, inc, queue) > 0);
+}
+
 // Step 1 of non-preconditioned LSQR.
 template <typename value_type, typename index_type>
 void step_1(index_type num_rows, index_type num_cols, value_type* alpha,
@@ -226,6 +469,51 @@ void step_1(index_type num_rows, index_type num_cols, value_type* alpha,
     blas::scale(num_rows, 1 / *alpha, v_vector, inc, queue);
 }
 
+// Accumulates the estimate of ||A * R^{-1}||_F from the new beta and the alpha
+// of the previous step.
+template <typename value_type, typename index_type>
+void update_anorm(temp_scalars<value_type, index_type>& scalars)
+{
+    scalars.anorm = std::sqrt(scalars.anorm * scalars.anorm +
+                              scalars.alpha * scalars.alpha +
+                              scalars.beta * scalars.beta);
+}
+
+// Step 1 of preconditioned LSQR on the host. Computes
+//     beta * u = A * R^{-1} * v - alpha * u,
+//     alpha * v = R^{-T} * A^T * u - beta * v,
+// with two passes over A and u: the first pass forms the new u and its norm,
+// the second normalizes u while accumulating A^T * u.
+template <typename value_type_in, typename value_type, typename index_type>
+void step_1_host(index_type num_rows, index_type num_cols, value_type* mtx,
+                 value_type* precond_mtx, index_type ld_precond,
+                 temp_scalars<value_type, index_type>& scalars,
+                 temp_vectors<value_type_in, value_type, index_type>& vectors,
+                 magma_queue_t queue)
+{
+    index_type inc = 1;
+    auto mtx_in = matvec_mtx(mtx, vectors);
+    blas::copy(num_cols, vectors.v, inc, vectors.temp, inc, queue);
+    precond_apply(MagmaNoTrans, num_cols, precond_mtx, ld_precond, vectors.temp,
+                  inc, queue);
+    scalars.beta = std::sqrt(
+        host::gemv_axpby_norm2(num_rows, num_cols, mtx_in, num_rows,
+                               vectors.temp, scalars.alpha, vectors.u) +
+        damp_forward(num_cols, vectors.temp, scalars, vectors, queue));
+    update_anorm(scalars);
+    host::scale_gemv_trans(num_rows, num_cols, mtx_in, num_rows,
+                           (scalars.beta > 0) ? 1 / scalars.beta : 1,
+                           vectors.u, value_type(0), vectors.temp);
+    damp_backward(num_cols, vectors.temp, scalars, vectors, queue);
+    precond_apply(MagmaTrans, num_cols, precond_mtx, ld_precond, vectors.temp,
+                  inc, queue);
+    scalars.alpha = std::sqrt(
+        host::axpby_norm2(num_cols, vectors.temp, scalars.beta, vectors.v));
+    if (scalars.alpha > 0) {
+        blas::scale(num_cols, 1 / scalars.alpha, vectors.v, inc, queue);
+    }
+}
+
 // Step 1 of preconditioned LSQR.
 template <typename value_type_in, typename value_type, typename index_type>
 void step_1(index_type num_rows, index_type num_cols, value_type* mtx,
@@ -234,72 +522,143 @@ void step_1(index_type num_rows, index_type num_cols, value_type* mtx,
             temp_vectors<value_type_in, value_type, index_type>& vectors,
             magma_queue_t queue)
 {
+    if (detail::use_host_backend()) {
+        step_1_host(num_rows, num_cols, mtx, precond_mtx, ld_precond, scalars,
+                    vectors, queue);
+        return;
+    }
+
     index_type inc = 1;
     // compute new u_vector
     blas::scale(num_rows, scalars.alpha, vectors.u, inc, queue);
     blas::copy(num_cols, vectors.v, inc, vectors.temp, inc, queue);
-    std::cout << "temp (before)\n";
-    // rls::io::print_mtx_gpu(10, 1, vectors.temp, num_cols, queue);
     precond_apply(MagmaNoTrans, num_cols, precond_mtx, ld_precond, vectors.temp,
                   inc, queue);
-    cudaDeviceSynchronize();
-    std::cout << "temp (after)\n";
-    // rls::io::print_mtx_gpu(10, 1, vectors.temp, num_cols, queue);
     if (!std::is_same<value_type_in, value_type>::value) {
-        cuda::demote(num_rows, 1, vectors.temp, num_rows, vectors.temp_in,
-                     num_rows);
-        cuda::demote(num_rows, 1, vectors.u, num_rows, vectors.u_in, num_rows);
-        cudaDeviceSynchronize();
+        memory::demote(num_cols, 1, vectors.temp, num_cols, vectors.temp_in,
+                       num_cols);
+        memory::demote(num_rows, 1, vectors.u, num_rows, vectors.u_in,
+                       num_rows);
         blas::gemv(MagmaNoTrans, num_rows, num_cols, 1.0, vectors.mtx_in,
                    num_rows, vectors.temp_in, inc, -1.0, vectors.u_in, inc,
                    queue);
-        cuda::promote(num_rows, 1, vectors.u_in, num_rows, vectors.u, num_rows);
-        cudaDeviceSynchronize();
+        memory::promote(num_rows, 1, vectors.u_in, num_rows, vectors.u,
+                        num_rows);
     } else {
-        std::cout << "u (before)\n";
-        // rls::io::print_mtx_gpu(10, 1, vectors.u, num_cols, queue);
         blas::gemv(MagmaNoTrans, num_rows, num_cols, 1.0, mtx, num_rows,
                    vectors.temp, inc, -1.0, vectors.u, inc, queue);
-        std::cout << "u (after)\n";
-        // rls::io::print_mtx_gpu(10, 1, vectors.u, num_cols, queue);
     }
     scalars.beta = blas::norm2(num_rows, vectors.u, inc, queue);
-    std::cout << "scalars.beta-step1: " << scalars.beta << '\n'; 
-    blas::scale(num_rows, 1 / scalars.beta, vectors.u, inc, queue);
+    scalars.beta = std::sqrt(
+        double(scalars.beta) * scalars.beta +
+        damp_forward(num_cols, vectors.temp, scalars, vectors, queue));
+    update_anorm(scalars);
+    if (scalars.beta > 0) {
+        blas::scale(num_rows, 1 / scalars.beta, vectors.u, inc, queue);
+    }
 
     // compute new v_vector
     if (!std::is_same<value_type_in, value_type>::value) {
-        cuda::demote(num_rows, 1, vectors.u, num_rows, vectors.u_in, num_rows);
-        cuda::demote(num_rows, 1, vectors.temp, num_rows, vectors.temp_in,
-                     num_rows);
-        cudaDeviceSynchronize();
+        memory::demote(num_rows, 1, vectors.u, num_rows, vectors.u_in,
+                       num_rows);
         blas::gemv(MagmaTrans, num_rows, num_cols, 1.0, vectors.mtx_in,
                    num_rows, vectors.u_in, inc, 0.0, vectors.temp_in, inc,
                    queue);
-        cuda::promote(num_rows, 1, vectors.temp_in, num_rows, vectors.temp,
-                      num_rows);
-        cudaDeviceSynchronize();
+        memory::promote(num_cols, 1, vectors.temp_in, num_cols, vectors.temp,
+                        num_cols);
     } else {
         blas::gemv(MagmaTrans, num_rows, num_cols, 1.0, mtx, num_rows,
                    vectors.u, inc, 0.0, vectors.temp, inc, queue);
     }
-
-    cudaDeviceSynchronize();
-    std::cout << "temp (before)\n";
-    // rls::io::print_mtx_gpu(10, 1, vectors.temp, num_cols, queue);
+    damp_backward(num_cols, vectors.temp, scalars, vectors, queue);
     precond_apply(MagmaTrans, num_cols, precond_mtx, ld_precond, vectors.temp,
                   inc, queue);
-    cudaDeviceSynchronize();
-    std::cout << "temp (after)\n";
-    // rls::io::print_mtx_gpu(10, 1, vectors.temp, num_cols, queue);
     blas::axpy(num_cols, -(scalars.beta), vectors.v, 1, vectors.temp, 1, queue);
     scalars.alpha = blas::norm2(num_cols, vectors.temp, inc, queue);
-    std::cout << "scalars.alpha-step1: " << scalars.alpha << '\n'; 
-
-    blas::scale(num_cols, 1 / scalars.alpha, vectors.temp, inc, queue);
+    if (scalars.alpha > 0) {
+        blas::scale(num_cols, 1 / scalars.alpha, vectors.temp, inc, queue);
+    }
     blas::copy(num_cols, vectors.temp, inc, vectors.v, inc, queue);
 }
 
+// Step 1 of preconditioned LSQR for mtx in CSR format, on the host backend.
+// Same passes as step_1_host.
+template <typename value_type_in, typename value_type, typename index_type>
+void step_1(index_type num_rows, index_type num_cols,
+            matrix::sparse<value_type, index_type>* mtx,
+            value_type* precond_mtx, index_type ld_precond,
+            temp_scalars<value_type, index_type>& scalars,
+            temp_vectors<value_type_in, value_type, index_type>& vectors,
+            magma_queue_t queue)
+{
+    index_type inc = 1;
+    auto values_in = matvec_mtx(mtx->values, vectors);
+    blas::copy(num_cols, vectors.v, inc, vectors.temp, inc, queue);
+    precond_apply(MagmaNoTrans, num_cols, precond_mtx, ld_precond, vectors.temp,
+                  inc, queue);
+    scalars.beta = std::sqrt(
+        host::spmv_axpby_norm2(num_rows, mtx->row_ptrs, mtx->col_idxs,
+                               values_in, vectors.temp, scalars.alpha,
+                               vectors.u) +
+        damp_forward(num_cols, vectors.temp, scalars, vectors, queue));
+    update_anorm(scalars);
+    host::scale_spmv_trans(num_rows, num_cols, mtx->row_ptrs, mtx->col_idxs,
+                           values_in,
+                           (scalars.beta > 0) ? 1 / scalars.beta : 1,
+                           vectors.u, value_type(0), vectors.temp);
+    damp_backward(num_cols, vectors.temp, scalars, vectors, queue);
+    precond_apply(MagmaTrans, num_cols, precond_mtx, ld_precond, vectors.temp,
+                  inc, queue);
+    scalars.alpha = std::sqrt(
+        host::axpby_norm2(num_cols, vectors.temp, scalars.beta, vectors.v));
+    if (scalars.alpha > 0) {
+        blas::scale(num_cols, 1 / scalars.alpha, vectors.v, inc, queue);
+    }
+}
+
+// Step 1 of preconditioned LSQR for a panelled mtx, on the host backend.
+// Same recurrences as step_1_host, but A * R^{-1} * v and A^T * u are formed
+// in one pass over the panels: A^T * u is accumulated from u before it is
+// normalized and scaled by 1 / beta afterwards, so that every iteration reads
+// the file once.
+template <typename value_type_in, typename value_type, typename index_type>
+void step_1(index_type num_rows, index_type num_cols,
+            matrix::panelled<value_type, index_type>* mtx,
+            value_type* precond_mtx, index_type ld_precond,
+            temp_scalars<value_type, index_type>& scalars,
+            temp_vectors<value_type_in, value_type, index_type>& vectors,
+            magma_queue_t queue)
+{
+    index_type inc = 1;
+    blas::copy(num_cols, vectors.v, inc, vectors.temp, inc, queue);
+    precond_apply(MagmaNoTrans, num_cols, precond_mtx, ld_precond, vectors.temp,
+                  inc, queue);
+    double norm2 = 0;
+    for_each_panel(mtx, [&](value_type* panel, index_type rows,
+                            index_type row_offset) {
+        norm2 += host::gemv_axpby_norm2(rows, num_cols, panel, rows,
+                                        vectors.temp, scalars.alpha,
+                                        vectors.u + row_offset);
+        host::scale_gemv_trans(rows, num_cols, panel, rows, value_type(1),
+                               vectors.u + row_offset,
+                               value_type(row_offset > 0), vectors.product);
+    });
+    scalars.beta = std::sqrt(
+        norm2 + damp_forward(num_cols, vectors.temp, scalars, vectors, queue));
+    update_anorm(scalars);
+    auto scale = (scalars.beta > 0) ? 1 / scalars.beta : value_type(1);
+    blas::scale(num_rows, scale, vectors.u, inc, queue);
+    blas::scale(num_cols, scale, vectors.product, inc, queue);
+    damp_backward(num_cols, vectors.product, scalars, vectors, queue);
+    precond_apply(MagmaTrans, num_cols, precond_mtx, ld_precond,
+                  vectors.product, inc, queue);
+    scalars.alpha = std::sqrt(
+        host::axpby_norm2(num_cols, vectors.product, scalars.beta, vectors.v));
+    if (scalars.alpha > 0) {
+        blas::scale(num_cols, 1 / scalars.alpha, vectors.v, inc, queue);
+    }
+}
+
 // Step 2 of non-preconditioned LSQR.
 template <typename value_type, typename index_type>
 void step_2(index_type num_rows, index_type num_cols, value_type alpha,
@@ -323,8 +682,7 @@ void step_2(index_type num_rows, index_type num_cols, value_type alpha,
 
 // Step 2 of preconditioned LSQR.
 template <typename value_type_in, typename value_type, typename index_type>
-void step_2(index_type num_rows, index_type num_cols, value_type* mtx,
-            value_type* rhs, value_type* sol, value_type* precond_mtx,
+void step_2(index_type num_cols, value_type* sol, value_type* precond_mtx,
             index_type ld_precond,
             temp_scalars<value_type, index_type>& scalars,
             temp_vectors<value_type_in, value_type, index_type>& vectors,
@@ -340,12 +698,29 @@ void step_2(index_type num_rows, index_type num_cols, value_type* mtx,
     auto phi = c * (scalars.phi_bar);
     scalars.phi_bar = s * (scalars.phi_bar);
     blas::copy(num_cols, vectors.w, inc, vectors.temp, inc, queue);
+    auto wnorm = blas::norm2(num_cols, vectors.w, inc, queue);
     precond_apply(MagmaNoTrans, num_cols, precond_mtx, ld_precond, vectors.temp,
                   inc, queue);
     blas::axpy(num_cols, phi / rho, vectors.temp, 1, sol, 1, queue);
     // compute new w_vector
     blas::scale(num_cols, -(theta / rho), vectors.w, inc, queue);
     blas::axpy(num_cols, 1.0, vectors.v, 1, vectors.w, 1, queue);
+
+    // Paige-Saunders estimates; ddnorm accumulates ||w / rho||^2 for cond and
+    // the plane rotations (cs2, sn2) track ||R * x||.
+    scalars.ddnorm += (wnorm / rho) * (wnorm / rho);
+    auto delta = scalars.sn2 * rho;
+    auto gamma_bar = -scalars.cs2 * rho;
+    auto rhs_z = phi - delta * scalars.z;
+    auto z_bar = rhs_z / gamma_bar;
+    scalars.xnorm = std::sqrt(scalars.xxnorm + z_bar * z_bar);
+    auto gamma = std::sqrt(gamma_bar * gamma_bar + theta * theta);
+    scalars.cs2 = gamma_bar / gamma;
+    scalars.sn2 = theta / gamma;
+    scalars.z = rhs_z / gamma;
+    scalars.xxnorm += scalars.z * scalars.z;
+    scalars.rnorm = scalars.phi_bar;
+    scalars.arnorm = scalars.alpha * std::abs(c) * scalars.phi_bar;
 }
 
 template <typename value_type, typename index_type>
@@ -356,13 +731,8 @@ bool check_stopping_criteria(index_type num_rows, index_type num_cols,
                              double* resnorm, magma_queue_t queue)
 {
     *iter += 1;
-    index_type inc = 1;
-    blas::copy(num_rows, rhs, inc, res_vector, inc, queue);
-    blas::gemv(MagmaNoTrans, num_rows, num_cols, -1.0, mtx, num_rows, sol, inc,
-               1.0, res_vector, inc, queue);
-    auto rhsnorm = blas::norm2(num_rows, rhs, inc, queue);
-    *resnorm = blas::norm2(num_rows, res_vector, inc, queue);
-    *resnorm = *resnorm / rhsnorm;
+    *resnorm =
+        true_relres(num_rows, num_cols, mtx, rhs, sol, res_vector, queue);
     if ((*iter >= max_iter) || (*resnorm < max_true_relres)) {
         return true;
     } else {
@@ -385,15 +755,655 @@ template <typename value_type>
 void free_memory(value_type* u_vector, value_type* v_vector,
                  value_type* w_vector, value_type* tmp_vector)
 {
-    magma_free(u_vector);
-    magma_free(v_vector);
-    magma_free(w_vector);
-    magma_free(tmp_vector);
+    memory::free(u_vector);
+    memory::free(v_vector);
+    memory::free(w_vector);
+    memory::free(tmp_vector);
+}
+
+// Preconditioned LSQR on a dense matrix, a matrix::sparse or a
+// matrix::panelled.
+template <typename value_type_in, typename value_type, typename index_type,
+          typename matrix_type>
+void solve(index_type num_rows, index_type num_cols, matrix_type mtx,
+           value_type* rhs, value_type* init_sol, value_type* sol,
+           index_type max_iter, index_type* iter, value_type tol,
+           double* resnorm, value_type* precond_mtx, index_type ld_precond,
+           magma_queue_t queue, double* t_solve, convergence* info,
+           workspace<value_type_in, value_type, index_type>* ws,
+           value_type damp)
+{
+    index_type inc = 1;
+    temp_scalars<value_type, index_type> scalars;
+    scalars.damp = damp;
+    convergence default_info;
+    if (info == nullptr) {
+        info = &default_info;
+    }
+    workspace<value_type_in, value_type, index_type> default_ws;
+    if (ws == nullptr) {
+        ws = &default_ws;
+    }
+    // With a warm start the iteration solves for the correction from
+    // r0 = rhs - A * init_sol; the true residual of the correction is
+    // rescaled by ||r0|| / ||rhs|| to stay relative to rhs.
+    auto warm = start_from_guess(num_rows, num_cols, mtx, rhs, init_sol, damp,
+                                 *ws, queue);
+    auto start_rhs = warm ? ws->residual : rhs;
+    auto& vectors = ws->vectors;
+    initialize(num_rows, num_cols, mtx, start_rhs, precond_mtx, ld_precond,
+               iter, scalars, vectors, queue);
+    if (warm) {
+        warm_estimates(num_rows, num_cols, rhs, init_sol, precond_mtx,
+                       ld_precond, vectors.temp, scalars, queue);
+    }
+    auto rhsnorm = blas::norm2(num_rows, rhs, inc, queue);
+    auto rhs_scale = warm ? blas::norm2(num_rows, start_rhs, inc, queue) /
+                                ((rhsnorm > 0) ? rhsnorm : 1.0)
+                          : 1.0;
+    *t_solve = 0;
+    double t = detail::sync_wtime(queue);
+    auto reason = (scalars.alpha * scalars.beta == 0) ? stop_reason::breakdown
+                                                      : stop_reason::none;
+    while (reason == stop_reason::none) {
+        step_1(num_rows, num_cols, mtx, precond_mtx, ld_precond, scalars,
+               vectors, queue);
+        step_2(num_cols, sol, precond_mtx, ld_precond, scalars, vectors,
+               queue);
+        *iter += 1;
+        reason = check_estimates(scalars, *iter, max_iter, tol);
+        if ((reason == stop_reason::none) && (info->res_check_interval > 0) &&
+            (*iter % info->res_check_interval == 0)) {
+            *resnorm = rhs_scale * true_relres(num_rows, num_cols, mtx,
+                                               start_rhs, sol, vectors.temp,
+                                               queue);
+            if (*resnorm < tol) {
+                reason = stop_reason::true_residual;
+            }
+        }
+    }
+    if (warm) {
+        blas::axpy(num_cols, 1.0, init_sol, inc, sol, inc, queue);
+    }
+    if (warm || (reason != stop_reason::true_residual)) {
+        *resnorm = true_relres(num_rows, num_cols, mtx, rhs, sol, vectors.temp,
+                               queue);
+    }
+    *t_solve += (detail::sync_wtime(queue) - t);
+    info->reason = reason;
+    info->rnorm = scalars.rnorm;
+    info->arnorm = scalars.arnorm;
+    info->anorm = scalars.anorm;
+    info->acond = scalars.anorm * std::sqrt(scalars.ddnorm);
+    info->xnorm = scalars.xnorm;
+    default_ws.free();
 }
 
 }  // end of anonymous namespace
 
 
+// Returns ||rhs - mtx * sol|| / ||rhs||, or ||rhs - mtx * sol|| for a zero
+// rhs. Costs a full pass over mtx.
+template <typename value_type, typename index_type, typename matrix_type>
+double true_relres(index_type num_rows, index_type num_cols, matrix_type mtx,
+                   value_type* rhs, value_type* sol, value_type* res_vector,
+                   magma_queue_t queue)
+{
+    index_type inc = 1;
+    residual(num_rows, num_cols, mtx, rhs, sol, res_vector, queue);
+    auto rhsnorm = blas::norm2(num_rows, rhs, inc, queue);
+    auto resnorm = blas::norm2(num_rows, res_vector, inc, queue);
+    return (rhsnorm > 0) ? resnorm / rhsnorm : resnorm;
+}
+
+template <typename value_type_in, typename value_type, typename index_type,
+          typename matrix_type>
+bool start_from_guess(index_type num_rows, index_type num_cols,
+                      matrix_type mtx, value_type* rhs, value_type* init_sol,
+                      value_type damp,
+                      workspace<value_type_in, value_type, index_type>& ws,
+                      magma_queue_t queue)
+{
+    prepare(num_rows, num_cols, mtx, ws);
+    auto warm = nonzero(num_cols, init_sol, queue);
+    start_damp(num_cols, init_sol, warm, damp, ws.vectors, queue);
+    if (!warm) {
+        return false;
+    }
+    residual(num_rows, num_cols, mtx, rhs, init_sol, ws.residual, queue);
+    return true;
+}
+
+// Tests the Paige-Saunders estimates with atol = btol = tol. Costs no passes
+// over mtx.
+template <typename value_type, typename index_type>
+stop_reason check_estimates(temp_scalars<value_type, index_type>& scalars,
+                            index_type iter, index_type max_iter,
+                            value_type tol)
+{
+    auto rtol = tol * (scalars.bnorm +
+                       scalars.anorm * (scalars.xnorm + scalars.x0norm));
+    if (scalars.rnorm <= rtol) {
+        return stop_reason::residual;
+    } else if (scalars.arnorm <= tol * scalars.anorm * scalars.rnorm) {
+        return stop_reason::least_squares;
+    } else if (scalars.alpha == 0) {
+        return stop_reason::breakdown;
+    } else if (iter >= max_iter) {
+        return stop_reason::max_iter;
+    }
+    return stop_reason::none;
+}
+
+template <typename value_type, typename index_type>
+void warm_estimates(index_type num_rows, index_type num_cols, value_type* rhs,
+                    value_type* init_sol, value_type* precond_mtx,
+                    index_type ld_precond, value_type* temp,
+                    temp_scalars<value_type, index_type>& scalars,
+                    magma_queue_t queue)
+{
+    index_type inc = 1;
+    scalars.bnorm = blas::norm2(num_rows, rhs, inc, queue);
+    blas::copy(num_cols, init_sol, inc, temp, inc, queue);
+    blas::trmv(MagmaUpper, MagmaNoTrans, MagmaNonUnit, num_cols, precond_mtx,
+               ld_precond, temp, inc, queue);
+    scalars.x0norm = blas::norm2(num_cols, temp, inc, queue);
+}
+
+template <typename value_type_in, typename value_type, typename index_type>
+void update_solution(
+    index_type num_cols, value_type* sol, value_type* precond_mtx,
+    index_type ld_precond, temp_scalars<value_type, index_type>& scalars,
+    temp_vectors<value_type_in, value_type, index_type>& vectors,
+    magma_queue_t queue)
+{
+    step_2(num_cols, sol, precond_mtx, ld_precond, scalars, vectors, queue);
+}
+
+template <typename value_type_in, typename value_type, typename index_type>
+void start_bidiagonalization(
+    index_type num_rows, index_type num_cols, value_type* mtx, value_type* rhs,
+    value_type* precond_mtx, index_type ld_precond,
+    temp_scalars<value_type, index_type>& scalars,
+    workspace<value_type_in, value_type, index_type>& ws, magma_queue_t queue)
+{
+    index_type iter = 0;
+    prepare(num_rows, num_cols, mtx, ws);
+    initialize(num_rows, num_cols, mtx, rhs, precond_mtx, ld_precond, &iter,
+               scalars, ws.vectors, queue);
+}
+
+template <typename value_type_in, typename value_type, typename index_type>
+void start_bidiagonalization(
+    index_type num_rows, index_type num_cols,
+    matrix::sparse<value_type, index_type>* mtx, value_type* rhs,
+    value_type* precond_mtx, index_type ld_precond,
+    temp_scalars<value_type, index_type>& scalars,
+    workspace<value_type_in, value_type, index_type>& ws, magma_queue_t queue)
+{
+    index_type iter = 0;
+    prepare(num_rows, num_cols, mtx, ws);
+    initialize(num_rows, num_cols, mtx, rhs, precond_mtx, ld_precond, &iter,
+               scalars, ws.vectors, queue);
+}
+
+template <typename value_type_in, typename value_type, typename index_type>
+void bidiagonalize(index_type num_rows, index_type num_cols, value_type* mtx,
+                   value_type* precond_mtx, index_type ld_precond,
+                   temp_scalars<value_type, index_type>& scalars,
+                   workspace<value_type_in, value_type, index_type>& ws,
+                   magma_queue_t queue)
+{
+    step_1(num_rows, num_cols, mtx, precond_mtx, ld_precond, scalars,
+           ws.vectors, queue);
+}
+
+template <typename value_type_in, typename value_type, typename index_type>
+void bidiagonalize(index_type num_rows, index_type num_cols,
+                   matrix::sparse<value_type, index_type>* mtx,
+                   value_type* precond_mtx, index_type ld_precond,
+                   temp_scalars<value_type, index_type>& scalars,
+                   workspace<value_type_in, value_type, index_type>& ws,
+                   magma_queue_t queue)
+{
+    step_1(num_rows, num_cols, mtx, precond_mtx, ld_precond, scalars,
+           ws.vectors, queue);
+}
+
+template void start_bidiagonalization(
+    magma_int_t num_rows, magma_int_t num_cols, double* mtx, double* rhs,
+    double* precond_mtx, magma_int_t ld_precond,
+    temp_scalars<double, magma_int_t>& scalars,
+    workspace<double, double, magma_int_t>& ws, magma_queue_t queue);
+
+template void start_bidiagonalization(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::sparse<double, magma_int_t>* mtx, double* rhs, double* precond_mtx,
+    magma_int_t ld_precond,
+    temp_scalars<double, magma_int_t>& scalars,
+    workspace<double, double, magma_int_t>& ws, magma_queue_t queue);
+
+template void start_bidiagonalization(
+    magma_int_t num_rows, magma_int_t num_cols, double* mtx, double* rhs,
+    double* precond_mtx, magma_int_t ld_precond,
+    temp_scalars<double, magma_int_t>& scalars,
+    workspace<float, double, magma_int_t>& ws, magma_queue_t queue);
+
+template void start_bidiagonalization(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::sparse<double, magma_int_t>* mtx, double* rhs, double* precond_mtx,
+    magma_int_t ld_precond,
+    temp_scalars<double, magma_int_t>& scalars,
+    workspace<float, double, magma_int_t>& ws, magma_queue_t queue);
+
+template void start_bidiagonalization(
+    magma_int_t num_rows, magma_int_t num_cols, double* mtx, double* rhs,
+    double* precond_mtx, magma_int_t ld_precond,
+    temp_scalars<double, magma_int_t>& scalars,
+    workspace<__half, double, magma_int_t>& ws, magma_queue_t queue);
+
+template void start_bidiagonalization(
+    magma_int_t num_rows, magma_int_t num_cols, double* mtx, double* rhs,
+    double* precond_mtx, magma_int_t ld_precond,
+    temp_scalars<double, magma_int_t>& scalars,
+    workspace<__nv_bfloat16, double, magma_int_t>& ws, magma_queue_t queue);
+
+template void start_bidiagonalization(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::sparse<double, magma_int_t>* mtx, double* rhs, double* precond_mtx,
+    magma_int_t ld_precond,
+    temp_scalars<double, magma_int_t>& scalars,
+    workspace<__half, double, magma_int_t>& ws, magma_queue_t queue);
+
+template void start_bidiagonalization(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::sparse<double, magma_int_t>* mtx, double* rhs, double* precond_mtx,
+    magma_int_t ld_precond,
+    temp_scalars<double, magma_int_t>& scalars,
+    workspace<__nv_bfloat16, double, magma_int_t>& ws, magma_queue_t queue);
+
+template void start_bidiagonalization(
+    magma_int_t num_rows, magma_int_t num_cols, float* mtx, float* rhs,
+    float* precond_mtx, magma_int_t ld_precond,
+    temp_scalars<float, magma_int_t>& scalars,
+    workspace<float, float, magma_int_t>& ws, magma_queue_t queue);
+
+template void start_bidiagonalization(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::sparse<float, magma_int_t>* mtx, float* rhs, float* precond_mtx,
+    magma_int_t ld_precond,
+    temp_scalars<float, magma_int_t>& scalars,
+    workspace<float, float, magma_int_t>& ws, magma_queue_t queue);
+
+template void start_bidiagonalization(
+    magma_int_t num_rows, magma_int_t num_cols, float* mtx, float* rhs,
+    float* precond_mtx, magma_int_t ld_precond,
+    temp_scalars<float, magma_int_t>& scalars,
+    workspace<__half, float, magma_int_t>& ws, magma_queue_t queue);
+
+template void start_bidiagonalization(
+    magma_int_t num_rows, magma_int_t num_cols, float* mtx, float* rhs,
+    float* precond_mtx, magma_int_t ld_precond,
+    temp_scalars<float, magma_int_t>& scalars,
+    workspace<__nv_bfloat16, float, magma_int_t>& ws, magma_queue_t queue);
+
+template void start_bidiagonalization(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::sparse<float, magma_int_t>* mtx, float* rhs, float* precond_mtx,
+    magma_int_t ld_precond,
+    temp_scalars<float, magma_int_t>& scalars,
+    workspace<__half, float, magma_int_t>& ws, magma_queue_t queue);
+
+template void start_bidiagonalization(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::sparse<float, magma_int_t>* mtx, float* rhs, float* precond_mtx,
+    magma_int_t ld_precond,
+    temp_scalars<float, magma_int_t>& scalars,
+    workspace<__nv_bfloat16, float, magma_int_t>& ws, magma_queue_t queue);
+
+template void bidiagonalize(
+    magma_int_t num_rows, magma_int_t num_cols, double* mtx,
+    double* precond_mtx, magma_int_t ld_precond,
+    temp_scalars<double, magma_int_t>& scalars,
+    workspace<double, double, magma_int_t>& ws, magma_queue_t queue);
+
+template void bidiagonalize(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::sparse<double, magma_int_t>* mtx, double* precond_mtx,
+    magma_int_t ld_precond,
+    temp_scalars<double, magma_int_t>& scalars,
+    workspace<double, double, magma_int_t>& ws, magma_queue_t queue);
+
+template void bidiagonalize(
+    magma_int_t num_rows, magma_int_t num_cols, double* mtx,
+    double* precond_mtx, magma_int_t ld_precond,
+    temp_scalars<double, magma_int_t>& scalars,
+    workspace<float, double, magma_int_t>& ws, magma_queue_t queue);
+
+template void bidiagonalize(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::sparse<double, magma_int_t>* mtx, double* precond_mtx,
+    magma_int_t ld_precond,
+    temp_scalars<double, magma_int_t>& scalars,
+    workspace<float, double, magma_int_t>& ws, magma_queue_t queue);
+
+template void bidiagonalize(
+    magma_int_t num_rows, magma_int_t num_cols, double* mtx,
+    double* precond_mtx, magma_int_t ld_precond,
+    temp_scalars<double, magma_int_t>& scalars,
+    workspace<__half, double, magma_int_t>& ws, magma_queue_t queue);
+
+template void bidiagonalize(
+    magma_int_t num_rows, magma_int_t num_cols, double* mtx,
+    double* precond_mtx, magma_int_t ld_precond,
+    temp_scalars<double, magma_int_t>& scalars,
+    workspace<__nv_bfloat16, double, magma_int_t>& ws, magma_queue_t queue);
+
+template void bidiagonalize(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::sparse<double, magma_int_t>* mtx, double* precond_mtx,
+    magma_int_t ld_precond,
+    temp_scalars<double, magma_int_t>& scalars,
+    workspace<__half, double, magma_int_t>& ws, magma_queue_t queue);
+
+template void bidiagonalize(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::sparse<double, magma_int_t>* mtx, double* precond_mtx,
+    magma_int_t ld_precond,
+    temp_scalars<double, magma_int_t>& scalars,
+    workspace<__nv_bfloat16, double, magma_int_t>& ws, magma_queue_t queue);
+
+template void bidiagonalize(
+    magma_int_t num_rows, magma_int_t num_cols, float* mtx,
+    float* precond_mtx, magma_int_t ld_precond,
+    temp_scalars<float, magma_int_t>& scalars,
+    workspace<float, float, magma_int_t>& ws, magma_queue_t queue);
+
+template void bidiagonalize(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::sparse<float, magma_int_t>* mtx, float* precond_mtx,
+    magma_int_t ld_precond,
+    temp_scalars<float, magma_int_t>& scalars,
+    workspace<float, float, magma_int_t>& ws, magma_queue_t queue);
+
+template void bidiagonalize(
+    magma_int_t num_rows, magma_int_t num_cols, float* mtx,
+    float* precond_mtx, magma_int_t ld_precond,
+    temp_scalars<float, magma_int_t>& scalars,
+    workspace<__half, float, magma_int_t>& ws, magma_queue_t queue);
+
+template void bidiagonalize(
+    magma_int_t num_rows, magma_int_t num_cols, float* mtx,
+    float* precond_mtx, magma_int_t ld_precond,
+    temp_scalars<float, magma_int_t>& scalars,
+    workspace<__nv_bfloat16, float, magma_int_t>& ws, magma_queue_t queue);
+
+template void bidiagonalize(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::sparse<float, magma_int_t>* mtx, float* precond_mtx,
+    magma_int_t ld_precond,
+    temp_scalars<float, magma_int_t>& scalars,
+    workspace<__half, float, magma_int_t>& ws, magma_queue_t queue);
+
+template void bidiagonalize(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::sparse<float, magma_int_t>* mtx, float* precond_mtx,
+    magma_int_t ld_precond,
+    temp_scalars<float, magma_int_t>& scalars,
+    workspace<__nv_bfloat16, float, magma_int_t>& ws, magma_queue_t queue);
+
+template bool start_from_guess(
+    magma_int_t num_rows, magma_int_t num_cols, double* mtx, double* rhs,
+    double* init_sol, double damp, workspace<double, double, magma_int_t>& ws,
+    magma_queue_t queue);
+
+template bool start_from_guess(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::sparse<double, magma_int_t>* mtx, double* rhs, double* init_sol,
+    double damp, workspace<double, double, magma_int_t>& ws,
+    magma_queue_t queue);
+
+template bool start_from_guess(
+    magma_int_t num_rows, magma_int_t num_cols, double* mtx, double* rhs,
+    double* init_sol, double damp, workspace<float, double, magma_int_t>& ws,
+    magma_queue_t queue);
+
+template bool start_from_guess(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::sparse<double, magma_int_t>* mtx, double* rhs, double* init_sol,
+    double damp, workspace<float, double, magma_int_t>& ws,
+    magma_queue_t queue);
+
+template bool start_from_guess(
+    magma_int_t num_rows, magma_int_t num_cols, double* mtx, double* rhs,
+    double* init_sol, double damp, workspace<__half, double, magma_int_t>& ws,
+    magma_queue_t queue);
+
+template bool start_from_guess(
+    magma_int_t num_rows, magma_int_t num_cols, double* mtx, double* rhs,
+    double* init_sol, double damp,
+    workspace<__nv_bfloat16, double, magma_int_t>& ws, magma_queue_t queue);
+
+template bool start_from_guess(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::sparse<double, magma_int_t>* mtx, double* rhs, double* init_sol,
+    double damp, workspace<__half, double, magma_int_t>& ws,
+    magma_queue_t queue);
+
+template bool start_from_guess(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::sparse<double, magma_int_t>* mtx, double* rhs, double* init_sol,
+    double damp, workspace<__nv_bfloat16, double, magma_int_t>& ws,
+    magma_queue_t queue);
+
+template bool start_from_guess(
+    magma_int_t num_rows, magma_int_t num_cols, float* mtx, float* rhs,
+    float* init_sol, float damp, workspace<float, float, magma_int_t>& ws,
+    magma_queue_t queue);
+
+template bool start_from_guess(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::sparse<float, magma_int_t>* mtx, float* rhs, float* init_sol,
+    float damp, workspace<float, float, magma_int_t>& ws, magma_queue_t queue);
+
+template bool start_from_guess(
+    magma_int_t num_rows, magma_int_t num_cols, float* mtx, float* rhs,
+    float* init_sol, float damp, workspace<__half, float, magma_int_t>& ws,
+    magma_queue_t queue);
+
+template bool start_from_guess(
+    magma_int_t num_rows, magma_int_t num_cols, float* mtx, float* rhs,
+    float* init_sol, float damp,
+    workspace<__nv_bfloat16, float, magma_int_t>& ws, magma_queue_t queue);
+
+template bool start_from_guess(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::sparse<float, magma_int_t>* mtx, float* rhs, float* init_sol,
+    float damp, workspace<__half, float, magma_int_t>& ws, magma_queue_t queue);
+
+template bool start_from_guess(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::sparse<float, magma_int_t>* mtx, float* rhs, float* init_sol,
+    float damp, workspace<__nv_bfloat16, float, magma_int_t>& ws,
+    magma_queue_t queue);
+
+template double true_relres(magma_int_t num_rows, magma_int_t num_cols,
+                            double* mtx, double* rhs, double* sol,
+                            double* res_vector, magma_queue_t queue);
+
+template double true_relres(magma_int_t num_rows, magma_int_t num_cols,
+                            matrix::sparse<double, magma_int_t>* mtx,
+                            double* rhs, double* sol, double* res_vector,
+                            magma_queue_t queue);
+
+template double true_relres(magma_int_t num_rows, magma_int_t num_cols,
+                            float* mtx, float* rhs, float* sol,
+                            float* res_vector, magma_queue_t queue);
+
+template double true_relres(magma_int_t num_rows, magma_int_t num_cols,
+                            matrix::sparse<float, magma_int_t>* mtx,
+                            float* rhs, float* sol, float* res_vector,
+                            magma_queue_t queue);
+
+template bool start_from_guess(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::panelled<double, magma_int_t>* mtx, double* rhs, double* init_sol,
+    double damp, workspace<double, double, magma_int_t>& ws,
+    magma_queue_t queue);
+
+template bool start_from_guess(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::panelled<double, magma_int_t>* mtx, double* rhs, double* init_sol,
+    double damp, workspace<float, double, magma_int_t>& ws,
+    magma_queue_t queue);
+
+template bool start_from_guess(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::panelled<double, magma_int_t>* mtx, double* rhs, double* init_sol,
+    double damp, workspace<__half, double, magma_int_t>& ws,
+    magma_queue_t queue);
+
+template bool start_from_guess(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::panelled<double, magma_int_t>* mtx, double* rhs, double* init_sol,
+    double damp, workspace<__nv_bfloat16, double, magma_int_t>& ws,
+    magma_queue_t queue);
+
+template bool start_from_guess(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::panelled<float, magma_int_t>* mtx, float* rhs, float* init_sol,
+    float damp, workspace<float, float, magma_int_t>& ws, magma_queue_t queue);
+
+template bool start_from_guess(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::panelled<float, magma_int_t>* mtx, float* rhs, float* init_sol,
+    float damp, workspace<__half, float, magma_int_t>& ws, magma_queue_t queue);
+
+template bool start_from_guess(
+    magma_int_t num_rows, magma_int_t num_cols,
+    matrix::panelled<float, magma_int_t>* mtx, float* rhs, float* init_sol,
+    float damp, workspace<__nv_bfloat16, float, magma_int_t>& ws,
+    magma_queue_t queue);
+
+template double true_relres(magma_int_t num_rows, magma_int_t num_cols,
+                            matrix::panelled<double, magma_int_t>* mtx,
+                            double* rhs, double* sol, double* res_vector,
+                            magma_queue_t queue);
+
+template double true_relres(magma_int_t num_rows, magma_int_t num_cols,
+                            matrix::panelled<float, magma_int_t>* mtx,
+                            float* rhs, float* sol, float* res_vector,
+                            magma_queue_t queue);
+
+template stop_reason check_estimates(
+    temp_scalars<double, magma_int_t>& scalars, magma_int_t iter,
+    magma_int_t max_iter, double tol);
+
+template stop_reason check_estimates(
+    temp_scalars<float, magma_int_t>& scalars, magma_int_t iter,
+    magma_int_t max_iter, float tol);
+
+template void warm_estimates(magma_int_t num_rows, magma_int_t num_cols,
+                             double* rhs, double* init_sol,
+                             double* precond_mtx, magma_int_t ld_precond,
+                             double* temp,
+                             temp_scalars<double, magma_int_t>& scalars,
+                             magma_queue_t queue);
+
+template void warm_estimates(magma_int_t num_rows, magma_int_t num_cols,
+                             float* rhs, float* init_sol, float* precond_mtx,
+                             magma_int_t ld_precond, float* temp,
+                             temp_scalars<float, magma_int_t>& scalars,
+                             magma_queue_t queue);
+
+template void update_solution(
+    magma_int_t num_cols, double* sol, double* precond_mtx,
+    magma_int_t ld_precond, temp_scalars<double, magma_int_t>& scalars,
+    temp_vectors<double, double, magma_int_t>& vectors, magma_queue_t queue);
+
+template void update_solution(
+    magma_int_t num_cols, float* sol, float* precond_mtx,
+    magma_int_t ld_precond, temp_scalars<float, magma_int_t>& scalars,
+    temp_vectors<float, float, magma_int_t>& vectors, magma_queue_t queue);
+
+
+template <typename value_type_in, typename value_type, typename index_type>
+void workspace<value_type_in, value_type, index_type>::allocate(
+    index_type num_rows_in, index_type num_cols_in)
+{
+    num_rows = num_rows_in;
+    num_cols = num_cols_in;
+    vectors.inc = 1;
+    memory::malloc(&vectors.u, num_rows);
+    memory::malloc(&vectors.v, num_cols);
+    memory::malloc(&vectors.w, num_cols);
+    memory::malloc(&vectors.temp, std::max(num_rows, num_cols));
+    memory::malloc(&residual, num_rows);
+    memory::malloc(&vectors.u_damp, num_cols);
+    memory::malloc(&vectors.product, num_cols);
+    // The host kernels widen mtx_in on the fly and need no demoted vectors.
+    if (!std::is_same<value_type_in, value_type>::value &&
+        !detail::use_host_backend()) {
+        memory::malloc(&vectors.u_in, num_rows);
+        memory::malloc(&vectors.v_in, num_rows);
+        memory::malloc(&vectors.temp_in, num_rows);
+    }
+}
+
+template <typename value_type_in, typename value_type, typename index_type>
+void workspace<value_type_in, value_type, index_type>::free()
+{
+    if (vectors.u == nullptr) {
+        return;
+    }
+    memory::free(vectors.u);
+    memory::free(vectors.v);
+    memory::free(vectors.w);
+    memory::free(vectors.temp);
+    memory::free(residual);
+    memory::free(vectors.u_damp);
+    memory::free(vectors.product);
+    residual = nullptr;
+    if (vectors.u_in != nullptr) {
+        memory::free(vectors.u_in);
+        memory::free(vectors.v_in);
+        memory::free(vectors.temp_in);
+    }
+    vectors = temp_vectors<value_type_in, value_type, index_type>();
+    num_rows = 0;
+    num_cols = 0;
+}
+
+template struct workspace<double, double, magma_int_t>;
+template struct workspace<float, double, magma_int_t>;
+template struct workspace<__half, double, magma_int_t>;
+template struct workspace<__nv_bfloat16, double, magma_int_t>;
+template struct workspace<float, float, magma_int_t>;
+template struct workspace<__half, float, magma_int_t>;
+
+template struct workspace<__nv_bfloat16, float, magma_int_t>;
+
+
+const char* to_string(stop_reason reason)
+{
+    switch (reason) {
+    case stop_reason::residual:
+        return "residual estimate";
+    case stop_reason::least_squares:
+        return "least squares estimate";
+    case stop_reason::true_residual:
+        return "true residual";
+    case stop_reason::breakdown:
+        return "breakdown";
+    case stop_reason::stagnation:
+        return "stagnation";
+    case stop_reason::max_iter:
+        return "max iterations";
+    default:
+        return "none";
+    }
+}
+
 // Non-preconditioned LSQR.
 template <typename value_type, typename index_type>
 void run(index_type num_rows, index_type num_cols, value_type* mtx,
@@ -447,59 +1457,193 @@ void run(index_type num_rows, index_type num_cols, value_type* mtx,
          value_type* rhs, value_type* init_sol, value_type* sol,
          index_type max_iter, index_type* iter, value_type tol, double* resnorm,
          value_type* precond_mtx, index_type ld_precond, magma_queue_t queue,
-         double* t_solve)
+         double* t_solve, convergence* info,
+         workspace<value_type_in, value_type, index_type>* ws,
+         value_type damp)
 {
-    temp_scalars<value_type, index_type> scalars;
-    temp_vectors<value_type_in, value_type, index_type> vectors;
-    initialize(num_rows, num_cols, mtx, rhs, precond_mtx, ld_precond, iter,
-               scalars, vectors, queue);
-    *t_solve = 0;
-    double t = magma_sync_wtime(queue);
-    // while (1) {
-        step_1(num_rows, num_cols, mtx, precond_mtx, ld_precond, scalars,
-               vectors, queue);
-        // step_2(num_rows, num_cols, mtx, rhs, sol, precond_mtx, ld_precond,
-            //    scalars, vectors, queue);
-        // if (check_stopping_criteria(num_rows, num_cols, mtx, rhs, sol,
-                                    // vectors.temp, iter, max_iter, tol, resnorm,
-                                    // queue)) {
-            // break;
-        // }
-    // }
-    *t_solve += (magma_sync_wtime(queue) - t);
-    finalize(vectors);
+    solve<value_type_in>(num_rows, num_cols, mtx, rhs, init_sol, sol, max_iter,
+                         iter, tol, resnorm, precond_mtx, ld_precond, queue,
+                         t_solve, info, ws, damp);
 }
 
 template void run<double, double, magma_int_t>(
     magma_int_t num_rows, magma_int_t num_cols, double* mtx, double* rhs,
     double* init_sol, double* sol, magma_int_t max_iter, magma_int_t* iter,
     double tol, double* resnorm, double* precond_mtx, magma_int_t ld_precond,
-    magma_queue_t queue, double* t_solve);
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<double, double, magma_int_t>* ws, double damp);
 
 template void run<float, double, magma_int_t>(
     magma_int_t num_rows, magma_int_t num_cols, double* mtx, double* rhs,
     double* init_sol, double* sol, magma_int_t max_iter, magma_int_t* iter,
     double tol, double* resnorm, double* precond_mtx, magma_int_t ld_precond,
-    magma_queue_t queue, double* t_solve);
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<float, double, magma_int_t>* ws, double damp);
 
 template void run<__half, double, magma_int_t>(
     magma_int_t num_rows, magma_int_t num_cols, double* mtx, double* rhs,
     double* init_sol, double* sol, magma_int_t max_iter, magma_int_t* iter,
     double tol, double* resnorm, double* precond_mtx, magma_int_t ld_precond,
-    magma_queue_t queue, double* t_solve);
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<__half, double, magma_int_t>* ws, double damp);
+
+template void run<__nv_bfloat16, double, magma_int_t>(
+    magma_int_t num_rows, magma_int_t num_cols, double* mtx, double* rhs,
+    double* init_sol, double* sol, magma_int_t max_iter, magma_int_t* iter,
+    double tol, double* resnorm, double* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<__nv_bfloat16, double, magma_int_t>* ws, double damp);
 
 template void run<float, float, magma_int_t>(
     magma_int_t num_rows, magma_int_t num_cols, float* mtx, float* rhs,
     float* init_sol, float* sol, magma_int_t max_iter, magma_int_t* iter,
     float tol, double* resnorm, float* precond_mtx, magma_int_t ld_precond,
-    magma_queue_t queue, double* t_solve);
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<float, float, magma_int_t>* ws, float damp);
 
 template void run<__half, float, magma_int_t>(
     magma_int_t num_rows, magma_int_t num_cols, float* mtx, float* rhs,
     float* init_sol, float* sol, magma_int_t max_iter, magma_int_t* iter,
     float tol, double* resnorm, float* precond_mtx, magma_int_t ld_precond,
-    magma_queue_t queue, double* t_solve);
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<__half, float, magma_int_t>* ws, float damp);
+
+template void run<__nv_bfloat16, float, magma_int_t>(
+    magma_int_t num_rows, magma_int_t num_cols, float* mtx, float* rhs,
+    float* init_sol, float* sol, magma_int_t max_iter, magma_int_t* iter,
+    float tol, double* resnorm, float* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<__nv_bfloat16, float, magma_int_t>* ws, float damp);
+
+
+// Preconditioned LSQR for mtx in CSR format, on the host backend.
+template <typename value_type_in, typename value_type, typename index_type>
+void run(matrix::sparse<value_type, index_type>* mtx, value_type* rhs,
+         value_type* init_sol, value_type* sol, index_type max_iter,
+         index_type* iter, value_type tol, double* resnorm,
+         value_type* precond_mtx, index_type ld_precond, magma_queue_t queue,
+         double* t_solve, convergence* info,
+         workspace<value_type_in, value_type, index_type>* ws,
+         value_type damp)
+{
+    solve<value_type_in>(mtx->num_rows, mtx->num_cols, mtx, rhs, init_sol,
+                         sol, max_iter, iter, tol, resnorm, precond_mtx,
+                         ld_precond, queue, t_solve, info, ws, damp);
+}
+
+template void run<double, double, magma_int_t>(
+    matrix::sparse<double, magma_int_t>* mtx, double* rhs, double* init_sol,
+    double* sol, magma_int_t max_iter, magma_int_t* iter, double tol,
+    double* resnorm, double* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<double, double, magma_int_t>* ws, double damp);
+
+template void run<float, double, magma_int_t>(
+    matrix::sparse<double, magma_int_t>* mtx, double* rhs, double* init_sol,
+    double* sol, magma_int_t max_iter, magma_int_t* iter, double tol,
+    double* resnorm, double* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<float, double, magma_int_t>* ws, double damp);
+
+template void run<__half, double, magma_int_t>(
+    matrix::sparse<double, magma_int_t>* mtx, double* rhs, double* init_sol,
+    double* sol, magma_int_t max_iter, magma_int_t* iter, double tol,
+    double* resnorm, double* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<__half, double, magma_int_t>* ws, double damp);
+
+template void run<__nv_bfloat16, double, magma_int_t>(
+    matrix::sparse<double, magma_int_t>* mtx, double* rhs, double* init_sol,
+    double* sol, magma_int_t max_iter, magma_int_t* iter, double tol,
+    double* resnorm, double* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<__nv_bfloat16, double, magma_int_t>* ws, double damp);
+
+template void run<float, float, magma_int_t>(
+    matrix::sparse<float, magma_int_t>* mtx, float* rhs, float* init_sol,
+    float* sol, magma_int_t max_iter, magma_int_t* iter, float tol,
+    double* resnorm, float* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<float, float, magma_int_t>* ws, float damp);
+
+template void run<__half, float, magma_int_t>(
+    matrix::sparse<float, magma_int_t>* mtx, float* rhs, float* init_sol,
+    float* sol, magma_int_t max_iter, magma_int_t* iter, float tol,
+    double* resnorm, float* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<__half, float, magma_int_t>* ws, float damp);
+
+template void run<__nv_bfloat16, float, magma_int_t>(
+    matrix::sparse<float, magma_int_t>* mtx, float* rhs, float* init_sol,
+    float* sol, magma_int_t max_iter, magma_int_t* iter, float tol,
+    double* resnorm, float* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<__nv_bfloat16, float, magma_int_t>* ws, float damp);
+
+
+// Preconditioned LSQR for a panelled mtx, on the host backend.
+template <typename value_type_in, typename value_type, typename index_type>
+void run(matrix::panelled<value_type, index_type>* mtx, value_type* rhs,
+         value_type* init_sol, value_type* sol, index_type max_iter,
+         index_type* iter, value_type tol, double* resnorm,
+         value_type* precond_mtx, index_type ld_precond, magma_queue_t queue,
+         double* t_solve, convergence* info,
+         workspace<value_type_in, value_type, index_type>* ws,
+         value_type damp)
+{
+    solve<value_type_in>(mtx->num_rows, mtx->num_cols, mtx, rhs, init_sol,
+                         sol, max_iter, iter, tol, resnorm, precond_mtx,
+                         ld_precond, queue, t_solve, info, ws, damp);
+}
+
+template void run<double, double, magma_int_t>(
+    matrix::panelled<double, magma_int_t>* mtx, double* rhs, double* init_sol,
+    double* sol, magma_int_t max_iter, magma_int_t* iter, double tol,
+    double* resnorm, double* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<double, double, magma_int_t>* ws, double damp);
+
+template void run<float, double, magma_int_t>(
+    matrix::panelled<double, magma_int_t>* mtx, double* rhs, double* init_sol,
+    double* sol, magma_int_t max_iter, magma_int_t* iter, double tol,
+    double* resnorm, double* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<float, double, magma_int_t>* ws, double damp);
+
+template void run<__half, double, magma_int_t>(
+    matrix::panelled<double, magma_int_t>* mtx, double* rhs, double* init_sol,
+    double* sol, magma_int_t max_iter, magma_int_t* iter, double tol,
+    double* resnorm, double* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<__half, double, magma_int_t>* ws, double damp);
+
+template void run<__nv_bfloat16, double, magma_int_t>(
+    matrix::panelled<double, magma_int_t>* mtx, double* rhs, double* init_sol,
+    double* sol, magma_int_t max_iter, magma_int_t* iter, double tol,
+    double* resnorm, double* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<__nv_bfloat16, double, magma_int_t>* ws, double damp);
+
+template void run<float, float, magma_int_t>(
+    matrix::panelled<float, magma_int_t>* mtx, float* rhs, float* init_sol,
+    float* sol, magma_int_t max_iter, magma_int_t* iter, float tol,
+    double* resnorm, float* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<float, float, magma_int_t>* ws, float damp);
+
+template void run<__half, float, magma_int_t>(
+    matrix::panelled<float, magma_int_t>* mtx, float* rhs, float* init_sol,
+    float* sol, magma_int_t max_iter, magma_int_t* iter, float tol,
+    double* resnorm, float* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<__half, float, magma_int_t>* ws, float damp);
 
+template void run<__nv_bfloat16, float, magma_int_t>(
+    matrix::panelled<float, magma_int_t>* mtx, float* rhs, float* init_sol,
+    float* sol, magma_int_t max_iter, magma_int_t* iter, float tol,
+    double* resnorm, float* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, convergence* info,
+    workspace<__nv_bfloat16, float, magma_int_t>* ws, float damp);
 
 }  // namespace lsqr
 }  // namespace solver
@@ -3,6 +3,8 @@
 
 
 #include "../include/base_types.hpp"
+#include "../matrix/panelled.hpp"
+#include "../matrix/sparse.hpp"
 
 
 namespace rls {
@@ -12,37 +14,225 @@ namespace lsqr {
 
 template <typename value_type_in, typename value_type, typename index_type>
 struct temp_vectors{
-    value_type* u;
-    value_type* v;
-    value_type* w;
-    value_type* temp;
-    value_type_in* u_in;
-    value_type_in* v_in;
-    value_type_in* temp_in;
-    value_type_in* mtx_in;
+    value_type* u = nullptr;
+    value_type* v = nullptr;
+    value_type* w = nullptr;
+    value_type* temp = nullptr;
+    value_type_in* u_in = nullptr;
+    value_type_in* v_in = nullptr;
+    value_type_in* temp_in = nullptr;
+    value_type_in* mtx_in = nullptr;
+    // Last num_cols entries of u for the rows damp * I of a damped solve.
+    value_type* u_damp = nullptr;
+    // A^T * u of a matrix::panelled, formed in the same pass as A * temp.
+    value_type* product = nullptr;
     index_type inc;
 };
 
+// Buffers of preconditioned LSQR for one problem shape and precision pair.
+// A workspace passed to run is sized by the first call and reused by the
+// following ones, which then allocate nothing. vectors.mtx_in points to the
+// copy of the matrix cached by memory::demoted_copy and is not owned here.
+template <typename value_type_in, typename value_type, typename index_type>
+struct workspace {
+    index_type num_rows = 0;
+    index_type num_cols = 0;
+    temp_vectors<value_type_in, value_type, index_type> vectors;
+    // rhs - A * init_sol of a warm start.
+    value_type* residual = nullptr;
+
+    void allocate(index_type num_rows_in, index_type num_cols_in);
+
+    void free();
+};
+
 template <typename value_type, typename index_type>
 struct temp_scalars{
     value_type alpha;
     value_type beta;
     value_type rho_bar;
     value_type phi_bar;
+    // The bidiagonalization runs on [A; damp * I] if damp is nonzero.
+    value_type damp = 0;
+    // Recurrences of the Paige-Saunders estimates.
+    value_type bnorm = 0;
+    value_type anorm = 0;
+    value_type ddnorm = 0;
+    value_type xxnorm = 0;
+    value_type z = 0;
+    value_type cs2 = -1;
+    value_type sn2 = 0;
+    value_type rnorm = 0;
+    value_type arnorm = 0;
+    value_type xnorm = 0;
+    // ||R * init_sol|| of a warm start; xnorm only covers the correction.
+    value_type x0norm = 0;
+};
+
+enum class stop_reason {
+    none,
+    residual,       // ||r|| <= tol * (||b|| + ||A|| ||x||)
+    least_squares,  // ||A^T r|| <= tol * ||A|| ||r||
+    true_residual,  // ||b - A x|| / ||b|| < tol, checked every k iterations
+    breakdown,      // alpha = 0, x solves the least squares problem
+    stagnation,     // refinement no longer reduces ||A^T r||
+    max_iter
+};
+
+// Controls how often the true residual is evaluated and returns the
+// estimates of the last run. All norms are of the preconditioned operator
+// A * R^{-1}; xnorm is ||R * x||.
+struct convergence {
+    // The true residual is evaluated every res_check_interval iterations, or
+    // only at termination if 0. The estimates are tested every iteration.
+    int res_check_interval = 0;
+    stop_reason reason = stop_reason::none;
+    double rnorm = 0.0;
+    double arnorm = 0.0;
+    double anorm = 0.0;
+    double acond = 0.0;
+    double xnorm = 0.0;
 };
 
+const char* to_string(stop_reason reason);
+
 template <typename value_type, typename index_type>
 void run(index_type num_rows, index_type num_cols, value_type* mtx,
           value_type* rhs, value_type* init_sol, value_type* sol,
           index_type max_iter, index_type* iter, value_type tol,
           double* resnorm, magma_queue_t queue);
 
+// Preconditioned LSQR. A nonzero init_sol warm-starts the iteration, which
+// then solves for the correction from rhs - mtx * init_sol; pass nullptr or a
+// zero vector for a cold start. sol must be zero on entry and must not alias
+// init_sol.
+// A nonzero damp solves the ridge problem
+//     min ||mtx * x - rhs||^2 + damp^2 ||x||^2
+// by bidiagonalizing [mtx; damp * I] * R^{-1} without forming it; R should
+// then come from utils::precondition with the same damp. The estimates in
+// info are of the damped problem, resnorm is ||rhs - mtx * x|| / ||rhs||.
 template <typename value_type_in, typename value_type, typename index_type>
 void run(index_type num_rows, index_type num_cols, value_type* mtx,
           value_type* rhs, value_type* init_sol, value_type* sol,
           index_type max_iter, index_type* iter, value_type tol,
           double* resnorm, value_type* precond_mtx, index_type ld_precond,
-          magma_queue_t queue, double* t_solve);
+          magma_queue_t queue, double* t_solve,
+          convergence* info = nullptr,
+          workspace<value_type_in, value_type, index_type>* ws = nullptr,
+          value_type damp = 0);
+
+// Preconditioned LSQR for mtx in CSR format. Host backend only.
+template <typename value_type_in, typename value_type, typename index_type>
+void run(matrix::sparse<value_type, index_type>* mtx, value_type* rhs,
+         value_type* init_sol, value_type* sol, index_type max_iter,
+         index_type* iter, value_type tol, double* resnorm,
+         value_type* precond_mtx, index_type ld_precond, magma_queue_t queue,
+         double* t_solve, convergence* info = nullptr,
+         workspace<value_type_in, value_type, index_type>* ws = nullptr,
+         value_type damp = 0);
+
+// Preconditioned LSQR for a dense mtx that stays in its file and is read in
+// row panels by every iteration, while the next panel is read ahead. The
+// panels are read in value_type, so value_type_in only selects the
+// workspace. Host backend only.
+template <typename value_type_in, typename value_type, typename index_type>
+void run(matrix::panelled<value_type, index_type>* mtx, value_type* rhs,
+         value_type* init_sol, value_type* sol, index_type max_iter,
+         index_type* iter, value_type tol, double* resnorm,
+         value_type* precond_mtx, index_type ld_precond, magma_queue_t queue,
+         double* t_solve, convergence* info = nullptr,
+         workspace<value_type_in, value_type, index_type>* ws = nullptr,
+         value_type damp = 0);
+
+// Building blocks of preconditioned LSQR, shared with solver::lsmr. Both
+// solvers run the Golub-Kahan bidiagonalization of A * R^{-1} and differ only
+// in how they update the solution from it.
+
+// Sizes ws for the problem and computes beta * u = rhs and
+// alpha * v = R^{-T} * A^T * u. Sets vectors.w to v and the estimates of the
+// starting point in scalars. With scalars.damp nonzero, u is extended by
+// vectors.u_damp as set by start_from_guess.
+template <typename value_type_in, typename value_type, typename index_type>
+void start_bidiagonalization(
+    index_type num_rows, index_type num_cols, value_type* mtx, value_type* rhs,
+    value_type* precond_mtx, index_type ld_precond,
+    temp_scalars<value_type, index_type>& scalars,
+    workspace<value_type_in, value_type, index_type>& ws, magma_queue_t queue);
+
+template <typename value_type_in, typename value_type, typename index_type>
+void start_bidiagonalization(
+    index_type num_rows, index_type num_cols,
+    matrix::sparse<value_type, index_type>* mtx, value_type* rhs,
+    value_type* precond_mtx, index_type ld_precond,
+    temp_scalars<value_type, index_type>& scalars,
+    workspace<value_type_in, value_type, index_type>& ws, magma_queue_t queue);
+
+// Computes the next beta, u, alpha and v:
+//     beta * u = A * R^{-1} * v - alpha * u,
+//     alpha * v = R^{-T} * A^T * u - beta * v,
+// and accumulates the estimate of ||A * R^{-1}||_F in scalars.anorm.
+template <typename value_type_in, typename value_type, typename index_type>
+void bidiagonalize(index_type num_rows, index_type num_cols, value_type* mtx,
+                   value_type* precond_mtx, index_type ld_precond,
+                   temp_scalars<value_type, index_type>& scalars,
+                   workspace<value_type_in, value_type, index_type>& ws,
+                   magma_queue_t queue);
+
+template <typename value_type_in, typename value_type, typename index_type>
+void bidiagonalize(index_type num_rows, index_type num_cols,
+                   matrix::sparse<value_type, index_type>* mtx,
+                   value_type* precond_mtx, index_type ld_precond,
+                   temp_scalars<value_type, index_type>& scalars,
+                   workspace<value_type_in, value_type, index_type>& ws,
+                   magma_queue_t queue);
+
+// Sizes ws for the problem and, if init_sol is nonzero, stores
+// rhs - A * init_sol in ws.residual and returns true. Returns false for a
+// missing or zero init_sol, which is a cold start. With a nonzero damp,
+// ws.vectors.u_damp is set to the damped rows of the starting residual,
+// -damp * init_sol or zero.
+template <typename value_type_in, typename value_type, typename index_type,
+          typename matrix_type>
+bool start_from_guess(index_type num_rows, index_type num_cols,
+                      matrix_type mtx, value_type* rhs, value_type* init_sol,
+                      value_type damp,
+                      workspace<value_type_in, value_type, index_type>& ws,
+                      magma_queue_t queue);
+
+// Returns ||rhs - mtx * sol|| / ||rhs||, or ||rhs - mtx * sol|| for a zero
+// rhs, using res_vector as scratch.
+template <typename value_type, typename index_type, typename matrix_type>
+double true_relres(index_type num_rows, index_type num_cols, matrix_type mtx,
+                   value_type* rhs, value_type* sol, value_type* res_vector,
+                   magma_queue_t queue);
+
+// Tests scalars.rnorm, arnorm, anorm, xnorm and bnorm against tol. The
+// residual test bounds ||R * x|| by xnorm + x0norm.
+template <typename value_type, typename index_type>
+stop_reason check_estimates(temp_scalars<value_type, index_type>& scalars,
+                            index_type iter, index_type max_iter,
+                            value_type tol);
+
+// Makes the estimates of a warm start from init_sol relative to the original
+// problem rather than to the correction, as without a guess: sets
+// scalars.bnorm to ||rhs|| and scalars.x0norm to ||R * init_sol||. Call after
+// start_bidiagonalization; temp is num_cols scratch.
+template <typename value_type, typename index_type>
+void warm_estimates(index_type num_rows, index_type num_cols, value_type* rhs,
+                    value_type* init_sol, value_type* precond_mtx,
+                    index_type ld_precond, value_type* temp,
+                    temp_scalars<value_type, index_type>& scalars,
+                    magma_queue_t queue);
+
+// Updates sol += R^{-1} * w * phi / rho and w from the plane rotation of the
+// new alpha and beta, and the estimates in scalars. Reads vectors.v and
+// vectors.w and uses vectors.temp as scratch.
+template <typename value_type_in, typename value_type, typename index_type>
+void update_solution(
+    index_type num_cols, value_type* sol, value_type* precond_mtx,
+    index_type ld_precond, temp_scalars<value_type, index_type>& scalars,
+    temp_vectors<value_type_in, value_type, index_type>& vectors,
+    magma_queue_t queue);
 
 } // namespace lsqr
 } // namespace solver
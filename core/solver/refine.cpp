@@ -0,0 +1,300 @@
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <type_traits>
+#include "cuda_fp16.h"
+#include "magma_v2.h"
+
+
+#include "../../cuda/solver/lsqr_kernels.cuh"
+#include "../../host/solver/lsqr_kernels.hpp"
+#include "../blas/blas.hpp"
+#include "../memory/detail.hpp"
+#include "../memory/memory.hpp"
+#include "base_types.hpp"
+#include "refine.hpp"
+
+namespace rls {
+namespace solver {
+namespace refine {
+namespace {
+
+
+template <typename value_type, typename index_type>
+void set_zero(index_type num_elems, value_type* values)
+{
+    if (detail::use_host_backend()) {
+        host::set_values(num_elems, value_type(0), values);
+    } else {
+        cuda::set_values(num_elems, value_type(0), values);
+    }
+}
+
+// q = A * t, returns ||q||^2.
+template <typename value_type_in, typename value_type, typename index_type>
+value_type apply(index_type num_rows, index_type num_cols,
+                 workspace<value_type_in, value_type, index_type>& ws,
+                 magma_queue_t queue)
+{
+    index_type inc = 1;
+    if (detail::use_host_backend()) {
+        return host::gemv_axpby_norm2(num_rows, num_cols, ws.mtx_in, num_rows,
+                                      ws.t, value_type(0), ws.q);
+    }
+    if (!std::is_same<value_type_in, value_type>::value) {
+        memory::demote(num_cols, 1, ws.t, num_cols, ws.t_in, num_cols);
+        blas::gemv(MagmaNoTrans, num_rows, num_cols, 1.0, ws.mtx_in, num_rows,
+                   ws.t_in, inc, 0.0, ws.q_in, inc, queue);
+        memory::promote(num_rows, 1, ws.q_in, num_rows, ws.q, num_rows);
+    } else {
+        blas::gemv(MagmaNoTrans, num_rows, num_cols, 1.0,
+                   reinterpret_cast<value_type*>(ws.mtx_in), num_rows, ws.t,
+                   inc, 0.0, ws.q, inc, queue);
+    }
+    auto norm = blas::norm2(num_rows, ws.q, inc, queue);
+    return norm * norm;
+}
+
+// t = A^T * q.
+template <typename value_type_in, typename value_type, typename index_type>
+void apply_trans(index_type num_rows, index_type num_cols,
+                 workspace<value_type_in, value_type, index_type>& ws,
+                 magma_queue_t queue)
+{
+    index_type inc = 1;
+    if (detail::use_host_backend()) {
+        host::scale_gemv_trans(num_rows, num_cols, ws.mtx_in, num_rows,
+                               value_type(1), ws.q, value_type(0), ws.t);
+    } else if (!std::is_same<value_type_in, value_type>::value) {
+        memory::demote(num_rows, 1, ws.q, num_rows, ws.q_in, num_rows);
+        blas::gemv(MagmaTrans, num_rows, num_cols, 1.0, ws.mtx_in, num_rows,
+                   ws.q_in, inc, 0.0, ws.t_in, inc, queue);
+        memory::promote(num_cols, 1, ws.t_in, num_cols, ws.t, num_cols);
+    } else {
+        blas::gemv(MagmaTrans, num_rows, num_cols, 1.0,
+                   reinterpret_cast<value_type*>(ws.mtx_in), num_rows, ws.q,
+                   inc, 0.0, ws.t, inc, queue);
+    }
+}
+
+// Solves A^T * A * d = s for the s in ws.g by CGLS on
+//     (A * R^{-1})^T * (A * R^{-1}) * y = R^{-T} * s,
+// until the residual of y has dropped by tol, and stores d = R^{-1} * y in
+// ws.y. Returns the number of iterations.
+template <typename value_type_in, typename value_type, typename index_type>
+index_type correct(index_type num_rows, index_type num_cols,
+                   index_type max_iter, value_type tol,
+                   workspace<value_type_in, value_type, index_type>& ws,
+                   magma_queue_t queue)
+{
+    index_type inc = 1;
+    blas::trsv(MagmaUpper, MagmaTrans, MagmaNonUnit, num_cols, ws.precond,
+               num_cols, ws.g, inc, queue);
+    set_zero(num_cols, ws.y);
+    blas::copy(num_cols, ws.g, inc, ws.p, inc, queue);
+    auto gnorm = blas::norm2(num_cols, ws.g, inc, queue);
+    auto gamma = gnorm * gnorm;
+    auto stop = tol * gnorm;
+    index_type iter = 0;
+    while ((iter < max_iter) && (gnorm > stop)) {
+        blas::copy(num_cols, ws.p, inc, ws.t, inc, queue);
+        blas::trsv(MagmaUpper, MagmaNoTrans, MagmaNonUnit, num_cols,
+                   ws.precond, num_cols, ws.t, inc, queue);
+        auto qnorm2 = apply(num_rows, num_cols, ws, queue);
+        if (qnorm2 == value_type(0)) {
+            break;
+        }
+        auto alpha = gamma / qnorm2;
+        blas::axpy(num_cols, alpha, ws.p, inc, ws.y, inc, queue);
+        apply_trans(num_rows, num_cols, ws, queue);
+        blas::trsv(MagmaUpper, MagmaTrans, MagmaNonUnit, num_cols, ws.precond,
+                   num_cols, ws.t, inc, queue);
+        blas::axpy(num_cols, -alpha, ws.t, inc, ws.g, inc, queue);
+        gnorm = blas::norm2(num_cols, ws.g, inc, queue);
+        auto gamma_next = gnorm * gnorm;
+        blas::scale(num_cols, gamma_next / gamma, ws.p, inc, queue);
+        blas::axpy(num_cols, value_type(1), ws.g, inc, ws.p, inc, queue);
+        gamma = gamma_next;
+        iter++;
+    }
+    blas::trsv(MagmaUpper, MagmaNoTrans, MagmaNonUnit, num_cols, ws.precond,
+               num_cols, ws.y, inc, queue);
+    return iter;
+}
+
+// Computes ws.residual = rhs - A * sol and ws.normal_residual = A^T * r in
+// double and returns their norms.
+template <typename value_type_in, typename value_type, typename index_type>
+void residuals(index_type num_rows, index_type num_cols, double* mtx,
+               double* rhs, double* sol,
+               workspace<value_type_in, value_type, index_type>& ws,
+               double* rnorm, double* snorm, magma_queue_t queue)
+{
+    index_type inc = 1;
+    blas::copy(num_rows, rhs, inc, ws.residual, inc, queue);
+    blas::gemv(MagmaNoTrans, num_rows, num_cols, -1.0, mtx, num_rows, sol, inc,
+               1.0, ws.residual, inc, queue);
+    blas::gemv(MagmaTrans, num_rows, num_cols, 1.0, mtx, num_rows, ws.residual,
+               inc, 0.0, ws.normal_residual, inc, queue);
+    *rnorm = blas::norm2(num_rows, ws.residual, inc, queue);
+    *snorm = blas::norm2(num_cols, ws.normal_residual, inc, queue);
+}
+
+}  // end of anonymous namespace
+
+
+template <typename value_type_in, typename value_type, typename index_type>
+void workspace<value_type_in, value_type, index_type>::allocate(
+    index_type num_rows_in, index_type num_cols_in)
+{
+    num_rows = num_rows_in;
+    num_cols = num_cols_in;
+    memory::malloc(&residual, num_rows);
+    memory::malloc(&normal_residual, num_cols);
+    memory::malloc(&correction, num_cols);
+    memory::malloc(&precond, num_cols * num_cols);
+    memory::malloc(&y, num_cols);
+    memory::malloc(&p, num_cols);
+    memory::malloc(&g, num_cols);
+    memory::malloc(&t, num_cols);
+    memory::malloc(&q, num_rows);
+    set_zero(num_rows, q);
+    if (!std::is_same<value_type_in, value_type>::value) {
+        memory::malloc(&t_in, num_cols);
+        memory::malloc(&q_in, num_rows);
+    }
+}
+
+template <typename value_type_in, typename value_type, typename index_type>
+void workspace<value_type_in, value_type, index_type>::free()
+{
+    if (residual == nullptr) {
+        return;
+    }
+    memory::free(residual);
+    memory::free(normal_residual);
+    memory::free(correction);
+    memory::free(precond);
+    memory::free(y);
+    memory::free(p);
+    memory::free(g);
+    memory::free(t);
+    memory::free(q);
+    if (t_in != nullptr) {
+        memory::free(t_in);
+        memory::free(q_in);
+    }
+    *this = workspace();
+}
+
+template struct workspace<float, float, magma_int_t>;
+template struct workspace<__half, float, magma_int_t>;
+
+template struct workspace<__nv_bfloat16, float, magma_int_t>;
+
+
+// Mixed precision iterative refinement around preconditioned CGLS.
+template <typename value_type_in, typename value_type, typename index_type>
+void run(index_type num_rows, index_type num_cols, double* mtx, double* rhs,
+         double* init_sol, double* sol, index_type max_iter, index_type* iter,
+         double tol, double* resnorm, double* precond_mtx,
+         index_type ld_precond, magma_queue_t queue, double* t_solve,
+         refinement* settings,
+         workspace<value_type_in, value_type, index_type>* ws)
+{
+    index_type inc = 1;
+    refinement default_settings;
+    if (settings == nullptr) {
+        settings = &default_settings;
+    }
+    workspace<value_type_in, value_type, index_type> default_ws;
+    if (ws == nullptr) {
+        ws = &default_ws;
+    }
+    if ((ws->num_rows != num_rows) || (ws->num_cols != num_cols)) {
+        ws->free();
+        ws->allocate(num_rows, num_cols);
+    }
+    ws->mtx_in = memory::demoted_copy<value_type_in>(num_rows, num_cols, mtx,
+                                                     num_rows);
+    memory::demote(num_cols, num_cols, precond_mtx, ld_precond, ws->precond,
+                   num_cols);
+
+    *iter = 0;
+    *t_solve = 0;
+    double t = detail::sync_wtime(queue);
+    if ((init_sol != nullptr) &&
+        (blas::norm2(num_cols, init_sol, inc, queue) > 0)) {
+        blas::copy(num_cols, init_sol, inc, sol, inc, queue);
+    }
+    auto anorm = blas::norm2(num_rows * num_cols, mtx, inc, queue);
+    auto bnorm = blas::norm2(num_rows, rhs, inc, queue);
+    settings->steps = 0;
+    settings->reason = stop_reason::none;
+    double rnorm = 0.0;
+    double snorm = 0.0;
+    double last_rnorm = 0.0;
+    double last_snorm = std::numeric_limits<double>::max();
+    while (settings->reason == stop_reason::none) {
+        residuals(num_rows, num_cols, mtx, rhs, sol, *ws, &rnorm, &snorm,
+                  queue);
+        if (snorm >= last_snorm) {
+            // The last correction did not help; undo it.
+            blas::axpy(num_cols, -1.0, ws->correction, inc, sol, inc, queue);
+            rnorm = last_rnorm;
+            snorm = last_snorm;
+            settings->reason = stop_reason::stagnation;
+        } else if (snorm <= tol * anorm * rnorm) {
+            settings->reason = stop_reason::least_squares;
+        } else if ((settings->steps >= settings->max_steps) ||
+                   (*iter >= max_iter)) {
+            settings->reason = stop_reason::max_iter;
+        }
+        if (settings->reason != stop_reason::none) {
+            break;
+        }
+        // The correction solve runs on s / ||s||, which fits value_type.
+        blas::scale(num_cols, 1 / snorm, ws->normal_residual, inc, queue);
+        memory::demote(num_cols, 1, ws->normal_residual, num_cols, ws->g,
+                       num_cols);
+        *iter += correct(num_rows, num_cols, max_iter - *iter,
+                         (value_type)settings->inner_tol, *ws, queue);
+        memory::promote(num_cols, 1, ws->y, num_cols, ws->correction,
+                        num_cols);
+        blas::scale(num_cols, snorm, ws->correction, inc, queue);
+        blas::axpy(num_cols, 1.0, ws->correction, inc, sol, inc, queue);
+        settings->steps += 1;
+        last_rnorm = rnorm;
+        last_snorm = snorm;
+    }
+    *resnorm = (bnorm > 0) ? rnorm / bnorm : 0.0;
+    settings->normal_resnorm = (rnorm > 0) ? snorm / (anorm * rnorm) : 0.0;
+    *t_solve += (detail::sync_wtime(queue) - t);
+    default_ws.free();
+}
+
+template void run<float, float, magma_int_t>(
+    magma_int_t num_rows, magma_int_t num_cols, double* mtx, double* rhs,
+    double* init_sol, double* sol, magma_int_t max_iter, magma_int_t* iter,
+    double tol, double* resnorm, double* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, refinement* settings,
+    workspace<float, float, magma_int_t>* ws);
+
+template void run<__half, float, magma_int_t>(
+    magma_int_t num_rows, magma_int_t num_cols, double* mtx, double* rhs,
+    double* init_sol, double* sol, magma_int_t max_iter, magma_int_t* iter,
+    double tol, double* resnorm, double* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, refinement* settings,
+    workspace<__half, float, magma_int_t>* ws);
+
+template void run<__nv_bfloat16, float, magma_int_t>(
+    magma_int_t num_rows, magma_int_t num_cols, double* mtx, double* rhs,
+    double* init_sol, double* sol, magma_int_t max_iter, magma_int_t* iter,
+    double tol, double* resnorm, double* precond_mtx, magma_int_t ld_precond,
+    magma_queue_t queue, double* t_solve, refinement* settings,
+    workspace<__nv_bfloat16, float, magma_int_t>* ws);
+
+
+}  // namespace refine
+}  // namespace solver
+}  // namespace rls
@@ -0,0 +1,81 @@
+#ifndef REFINE_HPP
+#define REFINE_HPP
+
+
+#include "../include/base_types.hpp"
+#include "lsqr.hpp"
+
+
+namespace rls {
+namespace solver {
+namespace refine {
+
+
+using lsqr::stop_reason;
+
+// Controls the outer loop of run and returns what it did.
+struct refinement {
+    // Relative tolerance of each correction solve.
+    double inner_tol = 1e-4;
+    int max_steps = 20;
+    int steps = 0;
+    stop_reason reason = stop_reason::none;
+    // ||A^T r|| / (||A||_F ||r||) of the returned solution, in double.
+    double normal_resnorm = 0.0;
+};
+
+// Buffers of the refinement: the double residuals and correction of the outer
+// loop and the value_type vectors of the correction solves. R is kept as a
+// num_cols x num_cols value_type copy; mtx_in points to the value_type_in
+// copy of the matrix cached by memory::demoted_copy and is not owned here.
+// Reused like lsqr::workspace.
+template <typename value_type_in, typename value_type, typename index_type>
+struct workspace {
+    index_type num_rows = 0;
+    index_type num_cols = 0;
+    double* residual = nullptr;
+    double* normal_residual = nullptr;
+    double* correction = nullptr;
+    value_type* precond = nullptr;
+    value_type* y = nullptr;
+    value_type* p = nullptr;
+    value_type* g = nullptr;
+    value_type* t = nullptr;
+    value_type* q = nullptr;
+    value_type_in* t_in = nullptr;
+    value_type_in* q_in = nullptr;
+    value_type_in* mtx_in = nullptr;
+
+    void allocate(index_type num_rows_in, index_type num_cols_in);
+
+    void free();
+};
+
+// Mixed precision iterative refinement for min ||mtx * x - rhs||. mtx, rhs,
+// sol and the preconditioner stay in double; every step computes
+// s = mtx^T * (rhs - mtx * sol) in double and solves
+//     mtx^T * mtx * d = s
+// in value_type, with the matrix read in value_type_in, by preconditioned
+// CGLS (the conjugate gradient form of LSQR) to settings->inner_tol, then
+// adds d to sol. Starting the correction solve from s rather than from the
+// residual itself keeps the large residual of an inconsistent problem out of
+// the low precision vectors, so the result reaches double accuracy as long
+// as cond(mtx) * unit roundoff of value_type_in is well below one.
+// Stops once ||A^T r|| <= tol * ||A||_F * ||r||, when ||A^T r|| stops
+// decreasing (the previous solution is kept), or after settings->max_steps
+// steps or max_iter CGLS iterations in total, which are returned in iter.
+// init_sol warm-starts as in lsqr::run; sol must be zero on entry.
+template <typename value_type_in, typename value_type, typename index_type>
+void run(index_type num_rows, index_type num_cols, double* mtx, double* rhs,
+         double* init_sol, double* sol, index_type max_iter, index_type* iter,
+         double tol, double* resnorm, double* precond_mtx,
+         index_type ld_precond, magma_queue_t queue, double* t_solve,
+         refinement* settings = nullptr,
+         workspace<value_type_in, value_type, index_type>* ws = nullptr);
+
+}  // namespace refine
+}  // namespace solver
+}  // namespace rls
+
+
+#endif
@@ -5,6 +5,7 @@
 
 
 #include "cublas_v2.h"
+#include "cuda_bf16.h"
 #include "cuda_fp16.h"
 #include "magma_lapack.h"
 #include "magma_v2.h"
@@ -76,6 +77,32 @@ __global__ void demote_kernel(index_type num_rows, index_type num_cols,
     }
 }
 
+template <typename index_type>
+__global__ void demote_kernel(index_type num_rows, index_type num_cols,
+                              double* mtx, index_type ld_mtx,
+                              __nv_bfloat16* mtx_rp, index_type ld_mtx_rp)
+{
+    auto row = blockIdx.x * blockDim.x + threadIdx.x;
+    auto col = blockIdx.y * blockDim.y + threadIdx.y;
+    if ((row < num_rows) && (col < num_cols)) {
+        mtx_rp[row + ld_mtx_rp * col] =
+            __double2bfloat16(mtx[row + ld_mtx * col]);
+    }
+}
+
+template <typename index_type>
+__global__ void demote_kernel(index_type num_rows, index_type num_cols,
+                              float* mtx, index_type ld_mtx,
+                              __nv_bfloat16* mtx_rp, index_type ld_mtx_rp)
+{
+    auto row = blockIdx.x * blockDim.x + threadIdx.x;
+    auto col = blockIdx.y * blockDim.y + threadIdx.y;
+    if ((row < num_rows) && (col < num_cols)) {
+        mtx_rp[row + ld_mtx_rp * col] =
+            __float2bfloat16(mtx[row + ld_mtx * col]);
+    }
+}
+
 template <typename index_type>
 __global__ void demote_kernel(index_type num_rows, index_type num_cols,
                               double* mtx, index_type ld_mtx, double* mtx_rp,
@@ -137,6 +164,32 @@ __global__ void promote_kernel(index_type num_rows, index_type num_cols,
     }
 }
 
+template <typename index_type>
+__global__ void promote_kernel(index_type num_rows, index_type num_cols,
+                               __nv_bfloat16* mtx, index_type ld_mtx,
+                               double* mtx_ip, index_type ld_mtx_ip)
+{
+    auto row = blockIdx.x * blockDim.x + threadIdx.x;
+    auto col = blockIdx.y * blockDim.y + threadIdx.y;
+    if ((row < num_rows) && (col < num_cols)) {
+        mtx_ip[row + ld_mtx_ip * col] =
+            (double)__bfloat162float(mtx[row + ld_mtx * col]);
+    }
+}
+
+template <typename index_type>
+__global__ void promote_kernel(index_type num_rows, index_type num_cols,
+                               __nv_bfloat16* mtx, index_type ld_mtx,
+                               float* mtx_ip, index_type ld_mtx_ip)
+{
+    auto row = blockIdx.x * blockDim.x + threadIdx.x;
+    auto col = blockIdx.y * blockDim.y + threadIdx.y;
+    if ((row < num_rows) && (col < num_cols)) {
+        mtx_ip[row + ld_mtx_ip * col] =
+            __bfloat162float(mtx[row + ld_mtx * col]);
+    }
+}
+
 template <typename value_type_in, typename value_type, typename index_type>
 __host__ void demote(index_type num_rows, index_type num_cols, value_type* mtx,
                      index_type ld_mtx, value_type_in* mtx_rp,
@@ -205,14 +258,46 @@ template __host__ void demote(magma_int_t num_rows, magma_int_t num_cols,
                               float* mtx, magma_int_t ld_mtx, __half* mtx_rp,
                               magma_int_t ld_mtx_rp);
 
+template __host__ void demote(magma_int_t num_rows, magma_int_t num_cols,
+                              double* mtx, magma_int_t ld_mtx,
+                              __nv_bfloat16* mtx_rp, magma_int_t ld_mtx_rp);
+
+template __host__ void demote(magma_int_t num_rows, magma_int_t num_cols,
+                              float* mtx, magma_int_t ld_mtx,
+                              __nv_bfloat16* mtx_rp, magma_int_t ld_mtx_rp);
+
 template __host__ void demote(magma_int_t num_rows, magma_int_t num_cols,
                               double* mtx, magma_int_t ld_mtx, float* mtx_rp,
                               magma_int_t ld_mtx_rp);
 
+template __host__ void demote(magma_int_t num_rows, magma_int_t num_cols,
+                              double* mtx, magma_int_t ld_mtx, double* mtx_rp,
+                              magma_int_t ld_mtx_rp);
+
+template __host__ void demote(magma_int_t num_rows, magma_int_t num_cols,
+                              float* mtx, magma_int_t ld_mtx, float* mtx_rp,
+                              magma_int_t ld_mtx_rp);
+
 template __host__ void promote(magma_int_t num_rows, magma_int_t num_cols,
                                __half* mtx, magma_int_t ld_mtx, double* mtx_ip,
                                magma_int_t ld_mtx_ip);
 
+template __host__ void promote(magma_int_t num_rows, magma_int_t num_cols,
+                               __nv_bfloat16* mtx, magma_int_t ld_mtx,
+                               double* mtx_ip, magma_int_t ld_mtx_ip);
+
+template __host__ void promote(magma_int_t num_rows, magma_int_t num_cols,
+                               __nv_bfloat16* mtx, magma_int_t ld_mtx,
+                               float* mtx_ip, magma_int_t ld_mtx_ip);
+
+template __host__ void promote(magma_int_t num_rows, magma_int_t num_cols,
+                               double* mtx, magma_int_t ld_mtx, double* mtx_ip,
+                               magma_int_t ld_mtx_ip);
+
+template __host__ void promote(magma_int_t num_rows, magma_int_t num_cols,
+                               float* mtx, magma_int_t ld_mtx, float* mtx_ip,
+                               magma_int_t ld_mtx_ip);
+
 template __host__ void promote(magma_int_t num_rows, magma_int_t num_cols,
                                __half* mtx, magma_int_t ld_mtx, float* mtx_ip,
                                magma_int_t ld_mtx_ip);
@@ -3,6 +3,7 @@
 #include <string>
 #include <type_traits>
 #include "cublas_v2.h"
+#include "cuda_bf16.h"
 #include "cuda_fp16.h"
 #include "magma_lapack.h"
 #include "magma_v2.h"
@@ -131,6 +132,8 @@ template __global__ void set_values_1d_kernel(magma_int_t num_elems, float val,
 
 template __global__ void set_values_1d_kernel(magma_int_t num_elems, __half val, __half* values);
 
+template __global__ void set_values_1d_kernel(magma_int_t num_elems, __nv_bfloat16 val, __nv_bfloat16* values);
+
 template <typename value_type, typename index_type>
 void set_values(index_type num_elems, value_type val, value_type* values)
 {
@@ -145,6 +148,9 @@ template void set_values(magma_int_t num_elems, float val, float* values);
 
 template void set_values(magma_int_t num_elems, __half val, __half* values);
 
+template void set_values(magma_int_t num_elems, __nv_bfloat16 val,
+                         __nv_bfloat16* values);
+
 
 }  // namespace cuda
 }  // namespace rls
@@ -0,0 +1,654 @@
+#include <omp.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "magma_lapack.h"
+#include "magma_v2.h"
+
+
+#include "../precision.hpp"
+#include "blas_kernels.hpp"
+
+
+namespace rls {
+namespace host {
+namespace {
+
+
+// Rows handled by one task in the column-major kernels; chosen so that a
+// block of the output vector stays in L1 while the columns are streamed.
+const magma_int_t row_block_size = 1024;
+
+
+inline std::size_t offset(magma_int_t index, magma_int_t stride)
+{
+    return static_cast<std::size_t>(index) * static_cast<std::size_t>(stride);
+}
+
+// y = alpha * A * x + beta * y for a column-major A.
+template <typename value_type, typename index_type>
+void gemv_notrans(index_type num_rows, index_type num_cols,
+                  typename arithmetic<value_type>::type alpha,
+                  const value_type* mtx, index_type ld,
+                  const value_type* u_vector, index_type inc_u,
+                  typename arithmetic<value_type>::type beta,
+                  value_type* v_vector, index_type inc_v)
+{
+    using accumulator = typename arithmetic<value_type>::type;
+    index_type num_blocks = (num_rows + row_block_size - 1) / row_block_size;
+#pragma omp parallel
+    {
+        std::vector<accumulator> acc(row_block_size);
+#pragma omp for schedule(static)
+        for (index_type block = 0; block < num_blocks; block++) {
+            index_type row_begin = block * row_block_size;
+            index_type len = std::min(row_block_size, num_rows - row_begin);
+            std::fill(acc.begin(), acc.begin() + len, accumulator(0));
+            for (index_type col = 0; col < num_cols; col++) {
+                accumulator x = alpha * arithmetic<value_type>::load(
+                                            u_vector[offset(col, inc_u)]);
+                const value_type* column =
+                    mtx + offset(col, ld) + row_begin;
+                accumulator* a = acc.data();
+#pragma omp simd
+                for (index_type i = 0; i < len; i++) {
+                    a[i] += arithmetic<value_type>::load(column[i]) * x;
+                }
+            }
+            for (index_type i = 0; i < len; i++) {
+                auto& v = v_vector[offset(row_begin + i, inc_v)];
+                accumulator result = acc[i];
+                if (beta != accumulator(0)) {
+                    result += beta * arithmetic<value_type>::load(v);
+                }
+                v = arithmetic<value_type>::store(result);
+            }
+        }
+    }
+}
+
+// y = alpha * A^T * x + beta * y for a column-major A.
+template <typename value_type, typename index_type>
+void gemv_trans(index_type num_rows, index_type num_cols,
+                typename arithmetic<value_type>::type alpha,
+                const value_type* mtx, index_type ld,
+                const value_type* u_vector, index_type inc_u,
+                typename arithmetic<value_type>::type beta,
+                value_type* v_vector, index_type inc_v)
+{
+    using accumulator = typename arithmetic<value_type>::type;
+    std::vector<accumulator> result(num_cols, accumulator(0));
+    if (num_cols >= 4 * omp_get_max_threads() || inc_u != 1) {
+        // Enough columns to keep every thread busy with whole dot products.
+#pragma omp parallel for schedule(static)
+        for (index_type col = 0; col < num_cols; col++) {
+            const value_type* column = mtx + offset(col, ld);
+            accumulator sum = 0;
+            if (inc_u == 1) {
+#pragma omp simd reduction(+ : sum)
+                for (index_type i = 0; i < num_rows; i++) {
+                    sum += arithmetic<value_type>::load(column[i]) *
+                           arithmetic<value_type>::load(u_vector[i]);
+                }
+            } else {
+                for (index_type i = 0; i < num_rows; i++) {
+                    sum += arithmetic<value_type>::load(column[i]) *
+                           arithmetic<value_type>::load(
+                               u_vector[offset(i, inc_u)]);
+                }
+            }
+            result[col] = sum;
+        }
+    } else {
+        // Tall and skinny: every thread reduces its row blocks into a
+        // private partial result.
+        index_type num_blocks =
+            (num_rows + row_block_size - 1) / row_block_size;
+#pragma omp parallel
+        {
+            std::vector<accumulator> partial(num_cols, accumulator(0));
+#pragma omp for schedule(static)
+            for (index_type block = 0; block < num_blocks; block++) {
+                index_type row_begin = block * row_block_size;
+                index_type len =
+                    std::min(row_block_size, num_rows - row_begin);
+                const value_type* u = u_vector + row_begin;
+                for (index_type col = 0; col < num_cols; col++) {
+                    const value_type* column =
+                        mtx + offset(col, ld) + row_begin;
+                    accumulator sum = 0;
+#pragma omp simd reduction(+ : sum)
+                    for (index_type i = 0; i < len; i++) {
+                        sum += arithmetic<value_type>::load(column[i]) *
+                               arithmetic<value_type>::load(u[i]);
+                    }
+                    partial[col] += sum;
+                }
+            }
+#pragma omp critical
+            for (index_type col = 0; col < num_cols; col++) {
+                result[col] += partial[col];
+            }
+        }
+    }
+    for (index_type col = 0; col < num_cols; col++) {
+        auto& v = v_vector[offset(col, inc_v)];
+        accumulator value = alpha * result[col];
+        if (beta != accumulator(0)) {
+            value += beta * arithmetic<value_type>::load(v);
+        }
+        v = arithmetic<value_type>::store(value);
+    }
+}
+
+// Widens a num_rows x num_cols block of fp16 values to fp32.
+void widen(magma_int_t num_rows, magma_int_t num_cols, const __half* source,
+           magma_int_t ld_source, float* dest, magma_int_t ld_dest)
+{
+#pragma omp parallel for schedule(static)
+    for (magma_int_t col = 0; col < num_cols; col++) {
+        half_to_float(num_rows, source + offset(col, ld_source),
+                      dest + offset(col, ld_dest));
+    }
+}
+
+// Widens a num_rows x num_cols block of bfloat16 values to fp32.
+void widen(magma_int_t num_rows, magma_int_t num_cols,
+           const __nv_bfloat16* source, magma_int_t ld_source, float* dest,
+           magma_int_t ld_dest)
+{
+#pragma omp parallel for schedule(static)
+    for (magma_int_t col = 0; col < num_cols; col++) {
+        bfloat16_to_float(num_rows, source + offset(col, ld_source),
+                          dest + offset(col, ld_dest));
+    }
+}
+
+// Narrows the m x n fp32 result of a gemm back into C.
+void narrow(magma_int_t m, magma_int_t n, const float* C_wide, __half* C,
+            magma_int_t ldC)
+{
+#pragma omp parallel for schedule(static)
+    for (magma_int_t col = 0; col < n; col++) {
+        for (magma_int_t row = 0; row < m; row++) {
+            C[row + offset(col, ldC)] =
+                arithmetic<__half>::store(C_wide[row + offset(col, m)]);
+        }
+    }
+}
+
+void narrow(magma_int_t m, magma_int_t n, const float* C_wide,
+            __nv_bfloat16* C, magma_int_t ldC)
+{
+#pragma omp parallel for schedule(static)
+    for (magma_int_t col = 0; col < n; col++) {
+        float_to_bfloat16(m, C_wide + offset(col, m), C + offset(col, ldC));
+    }
+}
+
+// gemm for storage types narrower than fp32: panels of A and B are widened to
+// fp32 and accumulated with sgemm.
+template <typename value_type>
+void gemm_widened(magma_trans_t transA, magma_trans_t transB, magma_int_t m,
+                  magma_int_t n, magma_int_t k, float alpha,
+                  const value_type* A, magma_int_t ldA, const value_type* B,
+                  magma_int_t ldB, float beta, value_type* C, magma_int_t ldC)
+{
+    const magma_int_t panel_size = 256;
+    // C is not read when beta is zero (as in BLAS), it may be uninitialized.
+    std::vector<float> C_wide(offset(m, n), 0.0f);
+    if (beta != 0.0f) {
+        widen(m, n, C, ldC, C_wide.data(), m);
+        if (beta != 1.0f) {
+            scale(m * n, beta, C_wide.data(), magma_int_t(1));
+        }
+    }
+    std::vector<float> A_panel(offset(m, panel_size));
+    std::vector<float> B_panel(offset(n, panel_size));
+    for (magma_int_t k_begin = 0; k_begin < k; k_begin += panel_size) {
+        magma_int_t len = std::min(panel_size, k - k_begin);
+        magma_int_t ld_A_panel = 0;
+        magma_int_t ld_B_panel = 0;
+        if (transA == MagmaNoTrans) {
+            widen(m, len, A + offset(k_begin, ldA), ldA,
+                  A_panel.data(), m);
+            ld_A_panel = m;
+        } else {
+            widen(len, m, A + k_begin, ldA, A_panel.data(), len);
+            ld_A_panel = len;
+        }
+        if (transB == MagmaNoTrans) {
+            widen(len, n, B + k_begin, ldB, B_panel.data(), len);
+            ld_B_panel = len;
+        } else {
+            widen(n, len, B + offset(k_begin, ldB), ldB,
+                  B_panel.data(), n);
+            ld_B_panel = n;
+        }
+        gemm(transA, transB, m, n, len, alpha, A_panel.data(), ld_A_panel,
+             B_panel.data(), ld_B_panel, 1.0f, C_wide.data(), m);
+    }
+    narrow(m, n, C_wide.data(), C, ldC);
+}
+
+
+// Returns ||v|| as max |v_i| * ||v / max |v_i|||, for vectors whose squares
+// overflow or underflow in double.
+template <typename value_type, typename index_type>
+double scaled_norm2(index_type num_rows, const value_type* v_vector,
+                    index_type inc)
+{
+    double scale = 0;
+#pragma omp parallel for reduction(max : scale) schedule(static)
+    for (index_type i = 0; i < num_rows; i++) {
+        scale = std::max(scale, std::abs(double(v_vector[offset(i, inc)])));
+    }
+    if (!(scale > 0) || std::isinf(scale)) {
+        return scale;
+    }
+    double sum = 0;
+#pragma omp parallel for reduction(+ : sum) schedule(static)
+    for (index_type i = 0; i < num_rows; i++) {
+        double v = v_vector[offset(i, inc)] / scale;
+        sum += v * v;
+    }
+    return scale * std::sqrt(sum);
+}
+
+
+}  // anonymous namespace
+
+
+// Accumulates the squares in double, which cannot overflow or underflow for
+// float entries; double vectors for which it does are summed again scaled by
+// their largest entry, as the reference nrm2 does.
+template <typename value_type, typename index_type>
+value_type norm2(index_type num_rows, const value_type* v_vector,
+                 index_type inc)
+{
+    double sum = 0;
+    if (inc == 1) {
+#pragma omp parallel for simd reduction(+ : sum) schedule(static)
+        for (index_type i = 0; i < num_rows; i++) {
+            double v = v_vector[i];
+            sum += v * v;
+        }
+    } else {
+#pragma omp parallel for reduction(+ : sum) schedule(static)
+        for (index_type i = 0; i < num_rows; i++) {
+            double v = v_vector[offset(i, inc)];
+            sum += v * v;
+        }
+    }
+    if ((sum < std::numeric_limits<double>::min()) || std::isinf(sum)) {
+        return static_cast<value_type>(scaled_norm2(num_rows, v_vector, inc));
+    }
+    return static_cast<value_type>(std::sqrt(sum));
+}
+
+template <typename value_type, typename index_type>
+value_type dot(index_type num_rows, const value_type* u_vector,
+               index_type inc_u, const value_type* v_vector, index_type inc_v)
+{
+    value_type sum = 0;
+    if ((inc_u == 1) && (inc_v == 1)) {
+#pragma omp parallel for simd reduction(+ : sum) schedule(static)
+        for (index_type i = 0; i < num_rows; i++) {
+            sum += u_vector[i] * v_vector[i];
+        }
+    } else {
+#pragma omp parallel for reduction(+ : sum) schedule(static)
+        for (index_type i = 0; i < num_rows; i++) {
+            sum += u_vector[offset(i, inc_u)] *
+                   v_vector[offset(i, inc_v)];
+        }
+    }
+    return sum;
+}
+
+template <typename value_type, typename index_type>
+void copy(index_type num_rows, const value_type* source_vector,
+          index_type inc_u, value_type* dest_vector, index_type inc_v)
+{
+    if ((inc_u == 1) && (inc_v == 1)) {
+#pragma omp parallel for simd schedule(static)
+        for (index_type i = 0; i < num_rows; i++) {
+            dest_vector[i] = source_vector[i];
+        }
+    } else {
+#pragma omp parallel for schedule(static)
+        for (index_type i = 0; i < num_rows; i++) {
+            dest_vector[offset(i, inc_v)] =
+                source_vector[offset(i, inc_u)];
+        }
+    }
+}
+
+template <typename value_type, typename index_type>
+void scale(index_type num_rows, value_type alpha, value_type* v_vector,
+           index_type inc)
+{
+    if (inc == 1) {
+#pragma omp parallel for simd schedule(static)
+        for (index_type i = 0; i < num_rows; i++) {
+            v_vector[i] *= alpha;
+        }
+    } else {
+#pragma omp parallel for schedule(static)
+        for (index_type i = 0; i < num_rows; i++) {
+            v_vector[offset(i, inc)] *= alpha;
+        }
+    }
+}
+
+template <typename value_type, typename index_type>
+void axpy(index_type num_rows, value_type alpha, const value_type* u_vector,
+          index_type inc_u, value_type* v_vector, index_type inc_v)
+{
+    if ((inc_u == 1) && (inc_v == 1)) {
+#pragma omp parallel for simd schedule(static)
+        for (index_type i = 0; i < num_rows; i++) {
+            v_vector[i] += alpha * u_vector[i];
+        }
+    } else {
+#pragma omp parallel for schedule(static)
+        for (index_type i = 0; i < num_rows; i++) {
+            v_vector[offset(i, inc_v)] +=
+                alpha * u_vector[offset(i, inc_u)];
+        }
+    }
+}
+
+template <typename value_type, typename index_type>
+void copy_matrix(index_type num_rows, index_type num_cols,
+                 const value_type* source, index_type ld_source,
+                 value_type* dest, index_type ld_dest)
+{
+    if ((ld_source == num_rows) && (ld_dest == num_rows)) {
+        copy(num_rows * num_cols, source, index_type(1), dest, index_type(1));
+        return;
+    }
+#pragma omp parallel for schedule(static)
+    for (index_type col = 0; col < num_cols; col++) {
+        std::copy(source + offset(col, ld_source),
+                  source + offset(col, ld_source) + num_rows,
+                  dest + offset(col, ld_dest));
+    }
+}
+
+template <typename value_type, typename index_type>
+void gemv(magma_trans_t trans, index_type num_rows, index_type num_cols,
+          typename arithmetic<value_type>::type alpha, const value_type* mtx,
+          index_type ld, const value_type* u_vector, index_type inc_u,
+          typename arithmetic<value_type>::type beta, value_type* v_vector,
+          index_type inc_v)
+{
+    if (trans == MagmaNoTrans) {
+        gemv_notrans(num_rows, num_cols, alpha, mtx, ld, u_vector, inc_u, beta,
+                     v_vector, inc_v);
+    } else {
+        gemv_trans(num_rows, num_cols, alpha, mtx, ld, u_vector, inc_u, beta,
+                   v_vector, inc_v);
+    }
+}
+
+template <typename value_type, typename index_type>
+void spmv(index_type num_rows, const index_type* row_ptrs,
+          const index_type* col_idxs, const value_type* values,
+          value_type alpha, const value_type* u_vector, value_type beta,
+          value_type* v_vector)
+{
+#pragma omp parallel for schedule(dynamic, row_block_size)
+    for (index_type row = 0; row < num_rows; row++) {
+        value_type sum = 0;
+        for (index_type k = row_ptrs[row]; k < row_ptrs[row + 1]; k++) {
+            sum += values[k] * u_vector[col_idxs[k]];
+        }
+        v_vector[row] = (beta == value_type(0))
+                            ? alpha * sum
+                            : alpha * sum + beta * v_vector[row];
+    }
+}
+
+void trsv(magma_uplo_t uplo, magma_trans_t trans, magma_diag_t diag,
+          magma_int_t n, const double* mtx, magma_int_t ld, double* x,
+          magma_int_t incx)
+{
+    blasf77_dtrsv(lapack_uplo_const(uplo), lapack_trans_const(trans),
+                  lapack_diag_const(diag), &n, mtx, &ld, x, &incx);
+}
+
+void trsv(magma_uplo_t uplo, magma_trans_t trans, magma_diag_t diag,
+          magma_int_t n, const float* mtx, magma_int_t ld, float* x,
+          magma_int_t incx)
+{
+    blasf77_strsv(lapack_uplo_const(uplo), lapack_trans_const(trans),
+                  lapack_diag_const(diag), &n, mtx, &ld, x, &incx);
+}
+
+void trmv(magma_uplo_t uplo, magma_trans_t trans, magma_diag_t diag,
+          magma_int_t n, const double* mtx, magma_int_t ld, double* x,
+          magma_int_t incx)
+{
+    blasf77_dtrmv(lapack_uplo_const(uplo), lapack_trans_const(trans),
+                  lapack_diag_const(diag), &n, mtx, &ld, x, &incx);
+}
+
+void trmv(magma_uplo_t uplo, magma_trans_t trans, magma_diag_t diag,
+          magma_int_t n, const float* mtx, magma_int_t ld, float* x,
+          magma_int_t incx)
+{
+    blasf77_strmv(lapack_uplo_const(uplo), lapack_trans_const(trans),
+                  lapack_diag_const(diag), &n, mtx, &ld, x, &incx);
+}
+
+void gemm(magma_trans_t transA, magma_trans_t transB, magma_int_t m,
+          magma_int_t n, magma_int_t k, double alpha, const double* A,
+          magma_int_t ldA, const double* B, magma_int_t ldB, double beta,
+          double* C, magma_int_t ldC)
+{
+    blasf77_dgemm(lapack_trans_const(transA), lapack_trans_const(transB), &m,
+                  &n, &k, &alpha, A, &ldA, B, &ldB, &beta, C, &ldC);
+}
+
+void gemm(magma_trans_t transA, magma_trans_t transB, magma_int_t m,
+          magma_int_t n, magma_int_t k, float alpha, const float* A,
+          magma_int_t ldA, const float* B, magma_int_t ldB, float beta,
+          float* C, magma_int_t ldC)
+{
+    blasf77_sgemm(lapack_trans_const(transA), lapack_trans_const(transB), &m,
+                  &n, &k, &alpha, A, &ldA, B, &ldB, &beta, C, &ldC);
+}
+
+void gemm(magma_trans_t transA, magma_trans_t transB, magma_int_t m,
+          magma_int_t n, magma_int_t k, float alpha, const __half* A,
+          magma_int_t ldA, const __half* B, magma_int_t ldB, float beta,
+          __half* C, magma_int_t ldC)
+{
+    gemm_widened(transA, transB, m, n, k, alpha, A, ldA, B, ldB, beta, C,
+                 ldC);
+}
+
+void gemm(magma_trans_t transA, magma_trans_t transB, magma_int_t m,
+          magma_int_t n, magma_int_t k, float alpha, const __nv_bfloat16* A,
+          magma_int_t ldA, const __nv_bfloat16* B, magma_int_t ldB,
+          float beta, __nv_bfloat16* C, magma_int_t ldC)
+{
+    gemm_widened(transA, transB, m, n, k, alpha, A, ldA, B, ldB, beta, C,
+                 ldC);
+}
+
+void syrk(magma_uplo_t uplo, magma_trans_t trans, magma_int_t n,
+          magma_int_t k, double alpha, const double* A, magma_int_t ldA,
+          double beta, double* C, magma_int_t ldC)
+{
+    blasf77_dsyrk(lapack_uplo_const(uplo), lapack_trans_const(trans), &n, &k,
+                  &alpha, A, &ldA, &beta, C, &ldC);
+}
+
+void syrk(magma_uplo_t uplo, magma_trans_t trans, magma_int_t n,
+          magma_int_t k, float alpha, const float* A, magma_int_t ldA,
+          float beta, float* C, magma_int_t ldC)
+{
+    blasf77_ssyrk(lapack_uplo_const(uplo), lapack_trans_const(trans), &n, &k,
+                  &alpha, A, &ldA, &beta, C, &ldC);
+}
+
+void trsm(magma_side_t side, magma_uplo_t uplo, magma_trans_t trans,
+          magma_diag_t diag, magma_int_t m, magma_int_t n, double alpha,
+          const double* A, magma_int_t ldA, double* B, magma_int_t ldB)
+{
+    blasf77_dtrsm(lapack_side_const(side), lapack_uplo_const(uplo),
+                  lapack_trans_const(trans), lapack_diag_const(diag), &m, &n,
+                  &alpha, A, &ldA, B, &ldB);
+}
+
+void trsm(magma_side_t side, magma_uplo_t uplo, magma_trans_t trans,
+          magma_diag_t diag, magma_int_t m, magma_int_t n, float alpha,
+          const float* A, magma_int_t ldA, float* B, magma_int_t ldB)
+{
+    blasf77_strsm(lapack_side_const(side), lapack_uplo_const(uplo),
+                  lapack_trans_const(trans), lapack_diag_const(diag), &m, &n,
+                  &alpha, A, &ldA, B, &ldB);
+}
+
+void trmm(magma_side_t side, magma_uplo_t uplo, magma_trans_t trans,
+          magma_diag_t diag, magma_int_t m, magma_int_t n, double alpha,
+          const double* A, magma_int_t ldA, double* B, magma_int_t ldB)
+{
+    blasf77_dtrmm(lapack_side_const(side), lapack_uplo_const(uplo),
+                  lapack_trans_const(trans), lapack_diag_const(diag), &m, &n,
+                  &alpha, A, &ldA, B, &ldB);
+}
+
+void trmm(magma_side_t side, magma_uplo_t uplo, magma_trans_t trans,
+          magma_diag_t diag, magma_int_t m, magma_int_t n, float alpha,
+          const float* A, magma_int_t ldA, float* B, magma_int_t ldB)
+{
+    blasf77_strmm(lapack_side_const(side), lapack_uplo_const(uplo),
+                  lapack_trans_const(trans), lapack_diag_const(diag), &m, &n,
+                  &alpha, A, &ldA, B, &ldB);
+}
+
+magma_int_t potrf(magma_uplo_t uplo, magma_int_t n, double* A,
+                  magma_int_t ldA, magma_int_t* info)
+{
+    lapackf77_dpotrf(lapack_uplo_const(uplo), &n, A, &ldA, info);
+    return *info;
+}
+
+magma_int_t potrf(magma_uplo_t uplo, magma_int_t n, float* A,
+                  magma_int_t ldA, magma_int_t* info)
+{
+    lapackf77_spotrf(lapack_uplo_const(uplo), &n, A, &ldA, info);
+    return *info;
+}
+
+magma_int_t geqrf(magma_int_t m, magma_int_t n, double* A, magma_int_t ldA,
+                  double* tau, magma_int_t* info)
+{
+    magma_int_t lwork = -1;
+    double work_size = 0;
+    lapackf77_dgeqrf(&m, &n, A, &ldA, tau, &work_size, &lwork, info);
+    lwork = static_cast<magma_int_t>(work_size);
+    std::vector<double> work(std::max(lwork, magma_int_t(1)));
+    lapackf77_dgeqrf(&m, &n, A, &ldA, tau, work.data(), &lwork, info);
+    return *info;
+}
+
+magma_int_t geqrf(magma_int_t m, magma_int_t n, float* A, magma_int_t ldA,
+                  float* tau, magma_int_t* info)
+{
+    magma_int_t lwork = -1;
+    float work_size = 0;
+    lapackf77_sgeqrf(&m, &n, A, &ldA, tau, &work_size, &lwork, info);
+    lwork = static_cast<magma_int_t>(work_size);
+    std::vector<float> work(std::max(lwork, magma_int_t(1)));
+    lapackf77_sgeqrf(&m, &n, A, &ldA, tau, work.data(), &lwork, info);
+    return *info;
+}
+
+
+template double norm2(magma_int_t num_rows, const double* v_vector,
+                      magma_int_t inc);
+
+template float norm2(magma_int_t num_rows, const float* v_vector,
+                     magma_int_t inc);
+
+template double dot(magma_int_t num_rows, const double* u_vector,
+                    magma_int_t inc_u, const double* v_vector,
+                    magma_int_t inc_v);
+
+template float dot(magma_int_t num_rows, const float* u_vector,
+                   magma_int_t inc_u, const float* v_vector,
+                   magma_int_t inc_v);
+
+template void copy(magma_int_t num_rows, const double* source_vector,
+                   magma_int_t inc_u, double* dest_vector, magma_int_t inc_v);
+
+template void copy(magma_int_t num_rows, const float* source_vector,
+                   magma_int_t inc_u, float* dest_vector, magma_int_t inc_v);
+
+template void scale(magma_int_t num_rows, double alpha, double* v_vector,
+                    magma_int_t inc);
+
+template void scale(magma_int_t num_rows, float alpha, float* v_vector,
+                    magma_int_t inc);
+
+template void axpy(magma_int_t num_rows, double alpha, const double* u_vector,
+                   magma_int_t inc_u, double* v_vector, magma_int_t inc_v);
+
+template void axpy(magma_int_t num_rows, float alpha, const float* u_vector,
+                   magma_int_t inc_u, float* v_vector, magma_int_t inc_v);
+
+template void copy_matrix(magma_int_t num_rows, magma_int_t num_cols,
+                          const double* source, magma_int_t ld_source,
+                          double* dest, magma_int_t ld_dest);
+
+template void copy_matrix(magma_int_t num_rows, magma_int_t num_cols,
+                          const float* source, magma_int_t ld_source,
+                          float* dest, magma_int_t ld_dest);
+
+template void copy_matrix(magma_int_t num_rows, magma_int_t num_cols,
+                          const __half* source, magma_int_t ld_source,
+                          __half* dest, magma_int_t ld_dest);
+
+template void copy_matrix(magma_int_t num_rows, magma_int_t num_cols,
+                          const __nv_bfloat16* source, magma_int_t ld_source,
+                          __nv_bfloat16* dest, magma_int_t ld_dest);
+
+template void gemv(magma_trans_t trans, magma_int_t num_rows,
+                   magma_int_t num_cols, double alpha, const double* mtx,
+                   magma_int_t ld, const double* u_vector, magma_int_t inc_u,
+                   double beta, double* v_vector, magma_int_t inc_v);
+
+template void gemv(magma_trans_t trans, magma_int_t num_rows,
+                   magma_int_t num_cols, float alpha, const float* mtx,
+                   magma_int_t ld, const float* u_vector, magma_int_t inc_u,
+                   float beta, float* v_vector, magma_int_t inc_v);
+
+template void gemv(magma_trans_t trans, magma_int_t num_rows,
+                   magma_int_t num_cols, float alpha, const __half* mtx,
+                   magma_int_t ld, const __half* u_vector, magma_int_t inc_u,
+                   float beta, __half* v_vector, magma_int_t inc_v);
+
+template void gemv(magma_trans_t trans, magma_int_t num_rows,
+                   magma_int_t num_cols, float alpha,
+                   const __nv_bfloat16* mtx, magma_int_t ld,
+                   const __nv_bfloat16* u_vector, magma_int_t inc_u,
+                   float beta, __nv_bfloat16* v_vector, magma_int_t inc_v);
+
+template void spmv(magma_int_t num_rows, const magma_int_t* row_ptrs,
+                   const magma_int_t* col_idxs, const double* values,
+                   double alpha, const double* u_vector, double beta,
+                   double* v_vector);
+
+template void spmv(magma_int_t num_rows, const magma_int_t* row_ptrs,
+                   const magma_int_t* col_idxs, const float* values,
+                   float alpha, const float* u_vector, float beta,
+                   float* v_vector);
+
+
+}  // namespace host
+}  // namespace rls
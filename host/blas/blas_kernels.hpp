@@ -0,0 +1,141 @@
+#ifndef HOST_BLAS_KERNELS_HPP
+#define HOST_BLAS_KERNELS_HPP
+
+
+#include "magma_v2.h"
+
+
+#include "../precision.hpp"
+
+
+namespace rls {
+namespace host {
+
+
+// Level-1 and level-2 kernels are implemented with OpenMP so that the
+// memory-bound parts of LSQR scale with the number of cores. Level-3 kernels
+// and factorizations forward to the CPU BLAS/LAPACK that MAGMA links against.
+
+template <typename value_type, typename index_type>
+value_type norm2(index_type num_rows, const value_type* v_vector,
+                 index_type inc);
+
+template <typename value_type, typename index_type>
+value_type dot(index_type num_rows, const value_type* u_vector,
+               index_type inc_u, const value_type* v_vector, index_type inc_v);
+
+template <typename value_type, typename index_type>
+void copy(index_type num_rows, const value_type* source_vector,
+          index_type inc_u, value_type* dest_vector, index_type inc_v);
+
+template <typename value_type, typename index_type>
+void scale(index_type num_rows, value_type alpha, value_type* v_vector,
+           index_type inc);
+
+template <typename value_type, typename index_type>
+void axpy(index_type num_rows, value_type alpha, const value_type* u_vector,
+          index_type inc_u, value_type* v_vector, index_type inc_v);
+
+template <typename value_type, typename index_type>
+void copy_matrix(index_type num_rows, index_type num_cols,
+                 const value_type* source, index_type ld_source,
+                 value_type* dest, index_type ld_dest);
+
+// v = alpha * op(mtx) * u + beta * v. Storage types narrower than fp32 are
+// accumulated in fp32.
+template <typename value_type, typename index_type>
+void gemv(magma_trans_t trans, index_type num_rows, index_type num_cols,
+          typename arithmetic<value_type>::type alpha, const value_type* mtx,
+          index_type ld, const value_type* u_vector, index_type inc_u,
+          typename arithmetic<value_type>::type beta, value_type* v_vector,
+          index_type inc_v);
+
+// v = alpha * mtx * u + beta * v for mtx in CSR format.
+template <typename value_type, typename index_type>
+void spmv(index_type num_rows, const index_type* row_ptrs,
+          const index_type* col_idxs, const value_type* values,
+          value_type alpha, const value_type* u_vector, value_type beta,
+          value_type* v_vector);
+
+void trsv(magma_uplo_t uplo, magma_trans_t trans, magma_diag_t diag,
+          magma_int_t n, const double* mtx, magma_int_t ld, double* x,
+          magma_int_t incx);
+
+void trsv(magma_uplo_t uplo, magma_trans_t trans, magma_diag_t diag,
+          magma_int_t n, const float* mtx, magma_int_t ld, float* x,
+          magma_int_t incx);
+
+void trmv(magma_uplo_t uplo, magma_trans_t trans, magma_diag_t diag,
+          magma_int_t n, const double* mtx, magma_int_t ld, double* x,
+          magma_int_t incx);
+
+void trmv(magma_uplo_t uplo, magma_trans_t trans, magma_diag_t diag,
+          magma_int_t n, const float* mtx, magma_int_t ld, float* x,
+          magma_int_t incx);
+
+void gemm(magma_trans_t transA, magma_trans_t transB, magma_int_t m,
+          magma_int_t n, magma_int_t k, double alpha, const double* A,
+          magma_int_t ldA, const double* B, magma_int_t ldB, double beta,
+          double* C, magma_int_t ldC);
+
+void gemm(magma_trans_t transA, magma_trans_t transB, magma_int_t m,
+          magma_int_t n, magma_int_t k, float alpha, const float* A,
+          magma_int_t ldA, const float* B, magma_int_t ldB, float beta,
+          float* C, magma_int_t ldC);
+
+// fp16 storage, fp32 compute: panels of A and B are widened to fp32 and
+// accumulated with sgemm.
+void gemm(magma_trans_t transA, magma_trans_t transB, magma_int_t m,
+          magma_int_t n, magma_int_t k, float alpha, const __half* A,
+          magma_int_t ldA, const __half* B, magma_int_t ldB, float beta,
+          __half* C, magma_int_t ldC);
+
+// bfloat16 storage, fp32 compute, widened like fp16.
+void gemm(magma_trans_t transA, magma_trans_t transB, magma_int_t m,
+          magma_int_t n, magma_int_t k, float alpha, const __nv_bfloat16* A,
+          magma_int_t ldA, const __nv_bfloat16* B, magma_int_t ldB,
+          float beta, __nv_bfloat16* C, magma_int_t ldC);
+
+// C = alpha * op(A)^T * op(A) + beta * C on the uplo triangle of C.
+void syrk(magma_uplo_t uplo, magma_trans_t trans, magma_int_t n,
+          magma_int_t k, double alpha, const double* A, magma_int_t ldA,
+          double beta, double* C, magma_int_t ldC);
+
+void syrk(magma_uplo_t uplo, magma_trans_t trans, magma_int_t n,
+          magma_int_t k, float alpha, const float* A, magma_int_t ldA,
+          float beta, float* C, magma_int_t ldC);
+
+void trsm(magma_side_t side, magma_uplo_t uplo, magma_trans_t trans,
+          magma_diag_t diag, magma_int_t m, magma_int_t n, double alpha,
+          const double* A, magma_int_t ldA, double* B, magma_int_t ldB);
+
+void trsm(magma_side_t side, magma_uplo_t uplo, magma_trans_t trans,
+          magma_diag_t diag, magma_int_t m, magma_int_t n, float alpha,
+          const float* A, magma_int_t ldA, float* B, magma_int_t ldB);
+
+void trmm(magma_side_t side, magma_uplo_t uplo, magma_trans_t trans,
+          magma_diag_t diag, magma_int_t m, magma_int_t n, double alpha,
+          const double* A, magma_int_t ldA, double* B, magma_int_t ldB);
+
+void trmm(magma_side_t side, magma_uplo_t uplo, magma_trans_t trans,
+          magma_diag_t diag, magma_int_t m, magma_int_t n, float alpha,
+          const float* A, magma_int_t ldA, float* B, magma_int_t ldB);
+
+magma_int_t potrf(magma_uplo_t uplo, magma_int_t n, double* A,
+                  magma_int_t ldA, magma_int_t* info);
+
+magma_int_t potrf(magma_uplo_t uplo, magma_int_t n, float* A,
+                  magma_int_t ldA, magma_int_t* info);
+
+magma_int_t geqrf(magma_int_t m, magma_int_t n, double* A, magma_int_t ldA,
+                  double* tau, magma_int_t* info);
+
+magma_int_t geqrf(magma_int_t m, magma_int_t n, float* A, magma_int_t ldA,
+                  float* tau, magma_int_t* info);
+
+
+}  // namespace host
+}  // namespace rls
+
+
+#endif
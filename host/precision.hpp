@@ -0,0 +1,235 @@
+#ifndef HOST_PRECISION_HPP
+#define HOST_PRECISION_HPP
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "cuda_bf16.h"
+#include "cuda_fp16.h"
+#if defined(__F16C__) || defined(__AVX512BF16__)
+#include <immintrin.h>
+#endif
+
+
+namespace rls {
+namespace host {
+
+
+// Converts IEEE-754 binary16 to binary32, in hardware when F16C is available.
+inline float half_to_float(std::uint16_t bits)
+{
+#ifdef __F16C__
+    return _cvtsh_ss(bits);
+#else
+    std::uint32_t sign = static_cast<std::uint32_t>(bits & 0x8000u) << 16;
+    std::uint32_t exponent = (bits >> 10) & 0x1fu;
+    std::uint32_t mantissa = bits & 0x3ffu;
+    std::uint32_t result = 0;
+    if (exponent == 0) {
+        if (mantissa == 0) {
+            result = sign;
+        } else {
+            // Normalizes a subnormal value.
+            exponent = 113;
+            while ((mantissa & 0x400u) == 0) {
+                mantissa <<= 1;
+                exponent -= 1;
+            }
+            mantissa &= 0x3ffu;
+            result = sign | (exponent << 23) | (mantissa << 13);
+        }
+    } else if (exponent == 0x1fu) {
+        result = sign | 0x7f800000u | (mantissa << 13);
+    } else {
+        result = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    float value;
+    std::memcpy(&value, &result, sizeof(value));
+    return value;
+#endif
+}
+
+// Converts IEEE-754 binary32 to binary16 in software, rounding to nearest
+// even.
+inline std::uint16_t float_to_half(float value)
+{
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    std::uint32_t sign = (bits >> 16) & 0x8000u;
+    std::uint32_t magnitude = bits & 0x7fffffffu;
+    if (magnitude >= 0x7f800000u) {
+        // Inf and NaN (NaN stays quiet).
+        return static_cast<std::uint16_t>(
+            sign | 0x7c00u | ((magnitude > 0x7f800000u) ? 0x200u : 0u));
+    }
+    if (magnitude >= 0x477ff000u) {
+        // Rounds to infinity (>= 65520).
+        return static_cast<std::uint16_t>(sign | 0x7c00u);
+    }
+    if (magnitude < 0x38800000u) {
+        // Subnormal result (< 2^-14).
+        if (magnitude < 0x33000000u) {
+            return static_cast<std::uint16_t>(sign);
+        }
+        std::uint32_t exponent = magnitude >> 23;
+        std::uint32_t mantissa = (magnitude & 0x7fffffu) | 0x800000u;
+        std::uint32_t shift = 126 - exponent;
+        std::uint32_t result = mantissa >> shift;
+        std::uint32_t remainder = mantissa & ((1u << shift) - 1);
+        std::uint32_t halfway = 1u << (shift - 1);
+        if ((remainder > halfway) ||
+            ((remainder == halfway) && (result & 1u))) {
+            result += 1;
+        }
+        return static_cast<std::uint16_t>(sign | result);
+    }
+    std::uint32_t result = (magnitude - 0x38000000u) >> 13;
+    std::uint32_t remainder = magnitude & 0x1fffu;
+    if ((remainder > 0x1000u) || ((remainder == 0x1000u) && (result & 1u))) {
+        result += 1;
+    }
+    return static_cast<std::uint16_t>(sign | result);
+}
+
+// bfloat16 is the upper half of a binary32, so widening is a shift.
+inline float bfloat16_to_float(std::uint16_t bits)
+{
+    std::uint32_t result = static_cast<std::uint32_t>(bits) << 16;
+    float value;
+    std::memcpy(&value, &result, sizeof(value));
+    return value;
+}
+
+// Converts binary32 to bfloat16, rounding to nearest even.
+inline std::uint16_t float_to_bfloat16(float value)
+{
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    if ((bits & 0x7fffffffu) > 0x7f800000u) {
+        // Keeps NaN quiet instead of rounding it to infinity.
+        return static_cast<std::uint16_t>((bits >> 16) | 0x40u);
+    }
+    bits += 0x7fffu + ((bits >> 16) & 1u);
+    return static_cast<std::uint16_t>(bits >> 16);
+}
+
+// Maps a storage type to the type used for host arithmetic, along with the
+// conversions between the two.
+template <typename value_type>
+struct arithmetic {
+    using type = value_type;
+
+    static type load(value_type value) { return value; }
+
+    static value_type store(type value) { return value; }
+};
+
+// __half is only used for storage on the host; arithmetic is done in fp32.
+template <>
+struct arithmetic<__half> {
+    using type = float;
+
+    static type load(__half value)
+    {
+        std::uint16_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return half_to_float(bits);
+    }
+
+    static __half store(type value)
+    {
+        std::uint16_t bits = float_to_half(value);
+        __half result;
+        std::memcpy(&result, &bits, sizeof(bits));
+        return result;
+    }
+};
+
+// Like __half, __nv_bfloat16 is a storage format with fp32 arithmetic. Its
+// fp32 range avoids the overflow of fp16 on unscaled data, at the cost of
+// three fewer mantissa bits.
+template <>
+struct arithmetic<__nv_bfloat16> {
+    using type = float;
+
+    static type load(__nv_bfloat16 value)
+    {
+        std::uint16_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bfloat16_to_float(bits);
+    }
+
+    static __nv_bfloat16 store(type value)
+    {
+        std::uint16_t bits = float_to_bfloat16(value);
+        __nv_bfloat16 result;
+        std::memcpy(&result, &bits, sizeof(bits));
+        return result;
+    }
+};
+
+// Widens num_elems contiguous fp16 values to fp32, eight at a time when F16C is
+// available.
+inline void half_to_float(std::size_t num_elems, const __half* source,
+                          float* dest)
+{
+    std::size_t i = 0;
+#ifdef __F16C__
+    for (; i + 8 <= num_elems; i += 8) {
+        __m128i bits =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        _mm256_storeu_ps(dest + i, _mm256_cvtph_ps(bits));
+    }
+#endif
+    for (; i < num_elems; i++) {
+        dest[i] = arithmetic<__half>::load(source[i]);
+    }
+}
+
+// Widens num_elems contiguous bfloat16 values to fp32; the shifts vectorize
+// on any ISA.
+inline void bfloat16_to_float(std::size_t num_elems,
+                              const __nv_bfloat16* source, float* dest)
+{
+    const std::uint16_t* bits = reinterpret_cast<const std::uint16_t*>(source);
+    std::uint32_t* result = reinterpret_cast<std::uint32_t*>(dest);
+#pragma omp simd
+    for (std::size_t i = 0; i < num_elems; i++) {
+        result[i] = static_cast<std::uint32_t>(bits[i]) << 16;
+    }
+}
+
+// Narrows num_elems contiguous fp32 values to bfloat16, sixteen at a time
+// with the AVX512-BF16 conversion when available. Unlike the portable path,
+// the instruction flushes subnormal inputs to zero.
+inline void float_to_bfloat16(std::size_t num_elems, const float* source,
+                              __nv_bfloat16* dest)
+{
+    std::size_t i = 0;
+#ifdef __AVX512BF16__
+    for (; i + 16 <= num_elems; i += 16) {
+        __m256bh packed = _mm512_cvtneps_pbh(_mm512_loadu_ps(source + i));
+        std::memcpy(dest + i, &packed, sizeof(packed));
+    }
+#endif
+    for (; i < num_elems; i++) {
+        dest[i] = arithmetic<__nv_bfloat16>::store(source[i]);
+    }
+}
+
+// Converts between two storage types through their arithmetic types.
+template <typename value_type_out, typename value_type>
+inline value_type_out convert(value_type value)
+{
+    using accumulator = typename arithmetic<value_type_out>::type;
+    return arithmetic<value_type_out>::store(
+        static_cast<accumulator>(arithmetic<value_type>::load(value)));
+}
+
+
+}  // namespace host
+}  // namespace rls
+
+
+#endif
@@ -0,0 +1,1024 @@
+#include <omp.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <unordered_set>
+#include <vector>
+#include "cuda_fp16.h"
+#include "magma_v2.h"
+
+
+#include "../blas/blas_kernels.hpp"
+#include "../precision.hpp"
+#include "preconditioner_kernels.hpp"
+
+
+namespace rls {
+namespace host {
+namespace {
+
+
+// Length of the leading blocks of the Walsh-Hadamard transform, which are
+// transformed while they stay in cache.
+const std::size_t fwht_block_size = 1 << 12;
+
+
+// Rows of mtx per task of the sparse sign sketch. The hashed rows and signs of
+// a block are computed once and reused for every column.
+const std::size_t sparse_sketch_block_size = 256;
+
+
+// Rows of mtx per task of the fused Gaussian sketch. The num_rows_sketch x
+// gaussian_sketch_tile_rows tile of S that multiplies them is generated by
+// the task right before its gemm and never stored in full.
+const std::size_t gaussian_sketch_tile_rows = 256;
+
+
+// Philox blocks generated together by gaussian_column.
+const std::size_t philox_batch_size = 64;
+
+
+// Mixes the bits of x (splitmix64 finalizer).
+inline unsigned long long hash(unsigned long long x)
+{
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2,
+// 3"): ten rounds of a keyed bijection of the 128-bit counter, so every block
+// of four outputs is computed directly from (key, counter). Maps the counters
+// (x0[i], x1[i], x2[i], x3[i]) of num_blocks blocks in place; the blocks are
+// independent, so the rounds vectorize across them.
+inline void philox(std::size_t num_blocks, std::uint32_t* x0,
+                   std::uint32_t* x1, std::uint32_t* x2, std::uint32_t* x3,
+                   std::uint32_t key0, std::uint32_t key1)
+{
+#pragma omp simd
+    for (std::size_t i = 0; i < num_blocks; i++) {
+        std::uint32_t c0 = x0[i];
+        std::uint32_t c1 = x1[i];
+        std::uint32_t c2 = x2[i];
+        std::uint32_t c3 = x3[i];
+        std::uint32_t k0 = key0;
+        std::uint32_t k1 = key1;
+        for (int round = 0; round < 10; round++) {
+            std::uint64_t product0 = std::uint64_t(0xd2511f53u) * c0;
+            std::uint64_t product1 = std::uint64_t(0xcd9e8d57u) * c2;
+            c0 = static_cast<std::uint32_t>(product1 >> 32) ^ c1 ^ k0;
+            c1 = static_cast<std::uint32_t>(product1);
+            c2 = static_cast<std::uint32_t>(product0 >> 32) ^ c3 ^ k1;
+            c3 = static_cast<std::uint32_t>(product0);
+            k0 += 0x9e3779b9u;
+            k1 += 0xbb67ae85u;
+        }
+        x0[i] = c0;
+        x1[i] = c1;
+        x2[i] = c2;
+        x3[i] = c3;
+    }
+}
+
+// Writes rows [0, num_rows) of column col of the standard Gaussian sketch,
+// rounded to value_type_internal, to values. Rows 4 i to 4 i + 3 come from
+// the philox block with counter (i, col) and key seed through the Box-Muller
+// transform, so every entry depends only on (seed, row, col). The transform
+// runs in the arithmetic type of value_type_internal.
+template <typename value_type_internal>
+void gaussian_column(unsigned long long seed, unsigned long long col,
+                     std::size_t num_rows,
+                     typename arithmetic<value_type_internal>::type* values)
+{
+    using accumulator = typename arithmetic<value_type_internal>::type;
+    const accumulator two_pi = accumulator(6.283185307179586);
+    const accumulator scale = accumulator(1.0 / 4294967296.0);
+    std::uint32_t x[4][philox_batch_size];
+    for (std::size_t begin = 0; begin < num_rows;
+         begin += 4 * philox_batch_size) {
+        std::size_t num_blocks =
+            std::min(philox_batch_size, (num_rows - begin + 3) / 4);
+        for (std::size_t i = 0; i < num_blocks; i++) {
+            std::size_t block = begin / 4 + i;
+            x[0][i] = static_cast<std::uint32_t>(block);
+            x[1][i] = static_cast<std::uint32_t>(block >> 32);
+            x[2][i] = static_cast<std::uint32_t>(col);
+            x[3][i] = static_cast<std::uint32_t>(col >> 32);
+        }
+        philox(num_blocks, x[0], x[1], x[2], x[3],
+               static_cast<std::uint32_t>(seed),
+               static_cast<std::uint32_t>(seed >> 32));
+        for (std::size_t i = 0; i < num_blocks; i++) {
+            accumulator normals[4];
+            for (int pair = 0; pair < 2; pair++) {
+                accumulator radius = std::sqrt(
+                    accumulator(-2) *
+                    std::log((x[2 * pair][i] + accumulator(1)) * scale));
+                accumulator angle = two_pi * (x[2 * pair + 1][i] * scale);
+                normals[2 * pair] = radius * std::cos(angle);
+                normals[2 * pair + 1] = radius * std::sin(angle);
+            }
+            std::size_t row = begin + 4 * i;
+            std::size_t len = std::min(num_rows - row, std::size_t(4));
+            for (std::size_t j = 0; j < len; j++) {
+                values[row + j] = arithmetic<value_type_internal>::load(
+                    convert<value_type_internal>(normals[j]));
+            }
+        }
+    }
+}
+
+// In-place unnormalized Walsh-Hadamard transform of len = 2^k values.
+template <typename value_type>
+void fwht(std::size_t len, value_type* values)
+{
+    std::size_t block = std::min(len, fwht_block_size);
+    for (std::size_t begin = 0; begin < len; begin += block) {
+        for (std::size_t h = 1; h < block; h <<= 1) {
+            for (std::size_t i = begin; i < begin + block; i += 2 * h) {
+                value_type* x = values + i;
+                value_type* y = values + i + h;
+#pragma omp simd
+                for (std::size_t j = 0; j < h; j++) {
+                    value_type a = x[j];
+                    value_type b = y[j];
+                    x[j] = a + b;
+                    y[j] = a - b;
+                }
+            }
+        }
+    }
+    for (std::size_t h = block; h < len; h <<= 1) {
+        for (std::size_t i = 0; i < len; i += 2 * h) {
+            value_type* x = values + i;
+            value_type* y = values + i + h;
+#pragma omp simd
+            for (std::size_t j = 0; j < h; j++) {
+                value_type a = x[j];
+                value_type b = y[j];
+                x[j] = a + b;
+                y[j] = a - b;
+            }
+        }
+    }
+}
+
+// Draws num_samples distinct indices of [0, population) in increasing order
+// (Floyd's algorithm).
+std::vector<std::size_t> sample_without_replacement(std::size_t num_samples,
+                                                    std::size_t population,
+                                                    unsigned long long seed)
+{
+    std::mt19937_64 engine(seed);
+    std::unordered_set<std::size_t> selected;
+    for (std::size_t j = population - num_samples; j < population; j++) {
+        std::uniform_int_distribution<std::size_t> distribution(0, j);
+        std::size_t sample = distribution(engine);
+        if (!selected.insert(sample).second) {
+            selected.insert(j);
+        }
+    }
+    std::vector<std::size_t> samples(selected.begin(), selected.end());
+    std::sort(samples.begin(), samples.end());
+    return samples;
+}
+
+// Hashes column col of the sparse sign embedding to nnz distinct rows of
+// [0, num_rows) and their signs.
+template <typename value_type, typename index_type>
+void sparse_sign_column(unsigned long long seed, std::size_t col,
+                        index_type nnz, index_type num_rows, index_type* rows,
+                        value_type* signs)
+{
+    unsigned long long key = hash(seed ^ hash(col));
+    for (index_type j = 0; j < nnz; j++) {
+        index_type row = static_cast<index_type>(key % num_rows);
+        while (std::find(rows, rows + j, row) != rows + j) {
+            key = hash(key);
+            row = static_cast<index_type>(key % num_rows);
+        }
+        rows[j] = row;
+        signs[j] = (key >> 63) ? value_type(-1) : value_type(1);
+        key = hash(key);
+    }
+}
+
+template <typename value_type_out, typename value_type, typename index_type>
+void convert_mtx(index_type num_rows, index_type num_cols,
+                 const value_type* mtx, index_type ld_mtx,
+                 value_type_out* mtx_out, index_type ld_mtx_out)
+{
+#pragma omp parallel for schedule(static)
+    for (index_type col = 0; col < num_cols; col++) {
+        const value_type* source =
+            mtx + static_cast<std::size_t>(col) * ld_mtx;
+        value_type_out* dest =
+            mtx_out + static_cast<std::size_t>(col) * ld_mtx_out;
+#pragma omp simd
+        for (index_type row = 0; row < num_rows; row++) {
+            dest[row] = convert<value_type_out>(source[row]);
+        }
+    }
+}
+
+// Copies the upper triangle of the num_cols x num_cols matrix source to dest
+// and zeroes the strictly lower part of dest.
+template <typename value_type, typename index_type>
+void copy_triangle(index_type num_cols, const value_type* source,
+                   index_type ld_source, value_type* dest, index_type ld_dest)
+{
+    for (index_type col = 0; col < num_cols; col++) {
+        const value_type* source_col = source + std::size_t(col) * ld_source;
+        value_type* dest_col = dest + std::size_t(col) * ld_dest;
+        for (index_type row = 0; row <= col; row++) {
+            dest_col[row] = source_col[row];
+        }
+        for (index_type row = col + 1; row < num_cols; row++) {
+            dest_col[row] = value_type(0);
+        }
+    }
+}
+
+// Returns the unscaled product of columns [row_offset, row_offset + num_rows)
+// of the sparse sign embedding with mtx, a block of rows of a larger matrix,
+// as a num_rows_sketch x num_cols matrix in the arithmetic type.
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+std::vector<typename arithmetic<value_type_internal>::type>
+sparse_sign_product(index_type num_rows_sketch, index_type nnz,
+                    index_type num_rows, index_type num_cols,
+                    const value_type* mtx, index_type ld_mtx,
+                    std::size_t row_offset, unsigned long long seed)
+{
+    using accumulator = typename arithmetic<value_type_internal>::type;
+    std::size_t result_size =
+        static_cast<std::size_t>(num_rows_sketch) * num_cols;
+    long long num_blocks = static_cast<long long>(
+        (num_rows + sparse_sketch_block_size - 1) / sparse_sketch_block_size);
+    std::vector<accumulator> total(result_size, accumulator(0));
+#pragma omp parallel
+    {
+        std::vector<accumulator> partial(result_size, accumulator(0));
+        std::vector<index_type> rows(sparse_sketch_block_size * nnz);
+        std::vector<accumulator> signs(sparse_sketch_block_size * nnz);
+#pragma omp for schedule(static)
+        for (long long block = 0; block < num_blocks; block++) {
+            std::size_t row_begin = block * sparse_sketch_block_size;
+            index_type len = static_cast<index_type>(std::min(
+                sparse_sketch_block_size, num_rows - row_begin));
+            for (index_type i = 0; i < len; i++) {
+                sparse_sign_column(seed, row_offset + row_begin + i, nnz,
+                                   num_rows_sketch, rows.data() + i * nnz,
+                                   signs.data() + i * nnz);
+            }
+            for (index_type col = 0; col < num_cols; col++) {
+                const value_type* column =
+                    mtx + static_cast<std::size_t>(col) * ld_mtx + row_begin;
+                accumulator* dest = partial.data() +
+                                    static_cast<std::size_t>(col) *
+                                        num_rows_sketch;
+                for (index_type i = 0; i < len; i++) {
+                    accumulator value = arithmetic<value_type_internal>::load(
+                        convert<value_type_internal>(column[i]));
+                    const index_type* r = rows.data() + i * nnz;
+                    const accumulator* sign = signs.data() + i * nnz;
+                    for (index_type j = 0; j < nnz; j++) {
+                        dest[r[j]] += sign[j] * value;
+                    }
+                }
+            }
+        }
+#pragma omp critical
+        for (std::size_t i = 0; i < result_size; i++) {
+            total[i] += partial[i];
+        }
+    }
+    return total;
+}
+
+// Returns the product of columns [row_offset, row_offset + num_rows) of the
+// Gaussian sketch with mtx, a block of rows of a larger matrix, as a
+// num_rows_sketch x num_cols matrix in the arithmetic type.
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+std::vector<typename arithmetic<value_type_internal>::type>
+gaussian_product(index_type num_rows_sketch, index_type num_rows,
+                 index_type num_cols, const value_type* mtx, index_type ld_mtx,
+                 std::size_t row_offset, unsigned long long seed)
+{
+    using accumulator = typename arithmetic<value_type_internal>::type;
+    std::size_t result_size =
+        static_cast<std::size_t>(num_rows_sketch) * num_cols;
+    long long num_tiles = static_cast<long long>(
+        (num_rows + gaussian_sketch_tile_rows - 1) / gaussian_sketch_tile_rows);
+    std::vector<accumulator> total(result_size, accumulator(0));
+#pragma omp parallel
+    {
+        std::vector<accumulator> partial(result_size, accumulator(0));
+        std::vector<accumulator> sketch(static_cast<std::size_t>(
+                                            num_rows_sketch) *
+                                        gaussian_sketch_tile_rows);
+        std::vector<accumulator> block(gaussian_sketch_tile_rows * num_cols);
+#pragma omp for schedule(dynamic)
+        for (long long tile = 0; tile < num_tiles; tile++) {
+            std::size_t row_begin = tile * gaussian_sketch_tile_rows;
+            index_type len = static_cast<index_type>(std::min(
+                gaussian_sketch_tile_rows, num_rows - row_begin));
+            for (index_type i = 0; i < len; i++) {
+                gaussian_column<value_type_internal>(
+                    seed, row_offset + row_begin + i, num_rows_sketch,
+                    sketch.data() +
+                        static_cast<std::size_t>(i) * num_rows_sketch);
+            }
+            for (index_type col = 0; col < num_cols; col++) {
+                const value_type* source =
+                    mtx + static_cast<std::size_t>(col) * ld_mtx + row_begin;
+                accumulator* dest =
+                    block.data() + static_cast<std::size_t>(col) * len;
+#pragma omp simd
+                for (index_type i = 0; i < len; i++) {
+                    dest[i] = arithmetic<value_type_internal>::load(
+                        convert<value_type_internal>(source[i]));
+                }
+            }
+            gemm(MagmaNoTrans, MagmaNoTrans, num_rows_sketch, num_cols, len,
+                 accumulator(1), sketch.data(), num_rows_sketch, block.data(),
+                 len, accumulator(1), partial.data(), num_rows_sketch);
+        }
+#pragma omp critical
+        for (std::size_t i = 0; i < result_size; i++) {
+            total[i] += partial[i];
+        }
+    }
+    return total;
+}
+
+// Stores scale * total, a num_rows_sketch x num_cols matrix, to result, or
+// adds it if accumulate is set.
+template <typename accumulator, typename value_type, typename index_type>
+void store_sketch(index_type num_rows_sketch, index_type num_cols,
+                  const std::vector<accumulator>& total, accumulator scale,
+                  value_type* result, index_type ld_result, bool accumulate)
+{
+#pragma omp parallel for schedule(static)
+    for (index_type col = 0; col < num_cols; col++) {
+        const accumulator* source =
+            total.data() + static_cast<std::size_t>(col) * num_rows_sketch;
+        value_type* dest = result + static_cast<std::size_t>(col) * ld_result;
+        for (index_type row = 0; row < num_rows_sketch; row++) {
+            auto value = static_cast<value_type>(scale * source[row]);
+            dest[row] = accumulate ? dest[row] + value : value;
+        }
+    }
+}
+
+
+}  // anonymous namespace
+
+
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void srht_sketch(index_type num_rows_sketch, index_type num_rows,
+                 index_type num_cols, const value_type* mtx, index_type ld_mtx,
+                 value_type* result, index_type ld_result,
+                 unsigned long long seed)
+{
+    using accumulator = typename arithmetic<value_type_internal>::type;
+    std::size_t padded_rows = 1;
+    while (padded_rows < static_cast<std::size_t>(num_rows)) {
+        padded_rows <<= 1;
+    }
+    auto rows = sample_without_replacement(num_rows_sketch, padded_rows,
+                                           hash(seed));
+    std::vector<accumulator> signs(num_rows);
+#pragma omp parallel for simd schedule(static)
+    for (index_type row = 0; row < num_rows; row++) {
+        signs[row] = (hash(seed ^ static_cast<unsigned long long>(row)) >> 63)
+                         ? accumulator(-1)
+                         : accumulator(1);
+    }
+    auto scale = 1 / std::sqrt(static_cast<accumulator>(num_rows_sketch));
+#pragma omp parallel
+    {
+        std::vector<accumulator> buffer(padded_rows);
+        accumulator* x = buffer.data();
+#pragma omp for schedule(dynamic)
+        for (index_type col = 0; col < num_cols; col++) {
+            const value_type* column =
+                mtx + static_cast<std::size_t>(col) * ld_mtx;
+#pragma omp simd
+            for (index_type row = 0; row < num_rows; row++) {
+                x[row] = signs[row] * arithmetic<value_type_internal>::load(
+                                          convert<value_type_internal>(
+                                              column[row]));
+            }
+            std::fill(x + num_rows, x + padded_rows, accumulator(0));
+            fwht(padded_rows, x);
+            value_type* dest =
+                result + static_cast<std::size_t>(col) * ld_result;
+            for (index_type row = 0; row < num_rows_sketch; row++) {
+                dest[row] = static_cast<value_type>(scale * x[rows[row]]);
+            }
+        }
+    }
+}
+
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void sparse_sign_sketch(index_type num_rows_sketch, index_type nnz_per_col,
+                        index_type num_rows, index_type num_cols,
+                        const value_type* mtx, index_type ld_mtx,
+                        value_type* result, index_type ld_result,
+                        unsigned long long seed)
+{
+    using accumulator = typename arithmetic<value_type_internal>::type;
+    index_type nnz = std::max(index_type(1),
+                              std::min(nnz_per_col, num_rows_sketch));
+    auto total = sparse_sign_product<value_type_internal>(
+        num_rows_sketch, nnz, num_rows, num_cols, mtx, ld_mtx, 0, seed);
+    auto scale = 1 / std::sqrt(static_cast<accumulator>(nnz));
+    store_sketch(num_rows_sketch, num_cols, total, scale, result, ld_result,
+                 false);
+}
+
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void sparse_sign_sketch_add(index_type num_rows_sketch,
+                            index_type nnz_per_col, index_type row_offset,
+                            index_type num_rows, index_type num_cols,
+                            const value_type* mtx, index_type ld_mtx,
+                            value_type* result, index_type ld_result,
+                            unsigned long long seed)
+{
+    using accumulator = typename arithmetic<value_type_internal>::type;
+    index_type nnz = std::max(index_type(1),
+                              std::min(nnz_per_col, num_rows_sketch));
+    auto total = sparse_sign_product<value_type_internal>(
+        num_rows_sketch, nnz, num_rows, num_cols, mtx, ld_mtx,
+        static_cast<std::size_t>(row_offset), seed);
+    auto scale = 1 / std::sqrt(static_cast<accumulator>(nnz));
+    store_sketch(num_rows_sketch, num_cols, total, scale, result, ld_result,
+                 true);
+}
+
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void sparse_sign_sketch(index_type num_rows_sketch, index_type nnz_per_col,
+                        index_type num_rows, index_type num_cols,
+                        const index_type* row_ptrs, const index_type* col_idxs,
+                        const value_type* values, value_type* result,
+                        index_type ld_result, unsigned long long seed)
+{
+    using accumulator = typename arithmetic<value_type_internal>::type;
+    index_type nnz = std::max(index_type(1),
+                              std::min(nnz_per_col, num_rows_sketch));
+    std::size_t result_size =
+        static_cast<std::size_t>(num_rows_sketch) * num_cols;
+    std::vector<accumulator> total(result_size, accumulator(0));
+#pragma omp parallel
+    {
+        std::vector<accumulator> partial(result_size, accumulator(0));
+        std::vector<index_type> rows(nnz);
+        std::vector<accumulator> signs(nnz);
+#pragma omp for schedule(dynamic, sparse_sketch_block_size)
+        for (index_type row = 0; row < num_rows; row++) {
+            sparse_sign_column(seed, row, nnz, num_rows_sketch, rows.data(),
+                               signs.data());
+            for (index_type k = row_ptrs[row]; k < row_ptrs[row + 1]; k++) {
+                accumulator value = arithmetic<value_type_internal>::load(
+                    convert<value_type_internal>(values[k]));
+                accumulator* dest =
+                    partial.data() +
+                    static_cast<std::size_t>(col_idxs[k]) * num_rows_sketch;
+                for (index_type j = 0; j < nnz; j++) {
+                    dest[rows[j]] += signs[j] * value;
+                }
+            }
+        }
+#pragma omp critical
+        for (std::size_t i = 0; i < result_size; i++) {
+            total[i] += partial[i];
+        }
+    }
+    auto scale = 1 / std::sqrt(static_cast<accumulator>(nnz));
+#pragma omp parallel for schedule(static)
+    for (index_type col = 0; col < num_cols; col++) {
+        for (index_type row = 0; row < num_rows_sketch; row++) {
+            result[row + static_cast<std::size_t>(col) * ld_result] =
+                static_cast<value_type>(
+                    scale * total[row + static_cast<std::size_t>(col) *
+                                            num_rows_sketch]);
+        }
+    }
+}
+
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void gaussian_sketch(index_type num_rows_sketch, index_type num_rows,
+                     index_type num_cols, const value_type* mtx,
+                     index_type ld_mtx, value_type* result,
+                     index_type ld_result, unsigned long long seed)
+{
+    using accumulator = typename arithmetic<value_type_internal>::type;
+    auto total = gaussian_product<value_type_internal>(
+        num_rows_sketch, num_rows, num_cols, mtx, ld_mtx, 0, seed);
+    store_sketch(num_rows_sketch, num_cols, total, accumulator(1), result,
+                 ld_result, false);
+}
+
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void gaussian_sketch_add(index_type num_rows_sketch, index_type row_offset,
+                         index_type num_rows, index_type num_cols,
+                         const value_type* mtx, index_type ld_mtx,
+                         value_type* result, index_type ld_result,
+                         unsigned long long seed)
+{
+    using accumulator = typename arithmetic<value_type_internal>::type;
+    auto total = gaussian_product<value_type_internal>(
+        num_rows_sketch, num_rows, num_cols, mtx, ld_mtx,
+        static_cast<std::size_t>(row_offset), seed);
+    store_sketch(num_rows_sketch, num_cols, total, accumulator(1), result,
+                 ld_result, true);
+}
+
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void gaussian_sketch(index_type num_rows_sketch, index_type num_rows,
+                     index_type num_cols, const index_type* row_ptrs,
+                     const index_type* col_idxs, const value_type* values,
+                     value_type* result, index_type ld_result,
+                     unsigned long long seed)
+{
+    using accumulator = typename arithmetic<value_type_internal>::type;
+    std::size_t result_size =
+        static_cast<std::size_t>(num_rows_sketch) * num_cols;
+    std::vector<accumulator> total(result_size, accumulator(0));
+#pragma omp parallel
+    {
+        std::vector<accumulator> partial(result_size, accumulator(0));
+        std::vector<accumulator> column(num_rows_sketch);
+#pragma omp for schedule(dynamic, sparse_sketch_block_size)
+        for (index_type row = 0; row < num_rows; row++) {
+            if (row_ptrs[row] == row_ptrs[row + 1]) {
+                continue;
+            }
+            gaussian_column<value_type_internal>(seed, row, num_rows_sketch,
+                                                 column.data());
+            for (index_type k = row_ptrs[row]; k < row_ptrs[row + 1]; k++) {
+                accumulator value = arithmetic<value_type_internal>::load(
+                    convert<value_type_internal>(values[k]));
+                accumulator* dest =
+                    partial.data() +
+                    static_cast<std::size_t>(col_idxs[k]) * num_rows_sketch;
+#pragma omp simd
+                for (index_type i = 0; i < num_rows_sketch; i++) {
+                    dest[i] += column[i] * value;
+                }
+            }
+        }
+#pragma omp critical
+        for (std::size_t i = 0; i < result_size; i++) {
+            total[i] += partial[i];
+        }
+    }
+#pragma omp parallel for schedule(static)
+    for (index_type col = 0; col < num_cols; col++) {
+        for (index_type row = 0; row < num_rows_sketch; row++) {
+            result[row + static_cast<std::size_t>(col) * ld_result] =
+                static_cast<value_type>(
+                    total[row + static_cast<std::size_t>(col) *
+                                    num_rows_sketch]);
+        }
+    }
+}
+
+template <typename value_type_in, typename value_type, typename index_type>
+void demote(index_type num_rows, index_type num_cols, const value_type* mtx,
+            index_type ld_mtx, value_type_in* mtx_rp, index_type ld_mtx_rp)
+{
+    convert_mtx(num_rows, num_cols, mtx, ld_mtx, mtx_rp, ld_mtx_rp);
+}
+
+template <typename value_type_in, typename value_type, typename index_type>
+void promote(index_type num_rows, index_type num_cols,
+             const value_type_in* mtx, index_type ld_mtx, value_type* mtx_ip,
+             index_type ld_mtx_ip)
+{
+    convert_mtx(num_rows, num_cols, mtx, ld_mtx, mtx_ip, ld_mtx_ip);
+}
+
+template <typename value_type, typename index_type>
+index_type tsqr(index_type num_rows, index_type num_cols, value_type* mtx,
+                index_type ld_mtx, index_type block_size,
+                std::vector<double>* t_levels)
+{
+    if (block_size <= 0) {
+        index_type num_threads = omp_get_max_threads();
+        block_size = (num_rows + num_threads - 1) / num_threads;
+    }
+    // Every leaf needs at least num_cols rows for its R factor to be square.
+    block_size = std::max(block_size, num_cols);
+    index_type num_blocks = std::max(index_type(1), num_rows / block_size);
+    index_type status = 0;
+
+    // Leaves: the QR factorization of every block, in place.
+    auto t = omp_get_wtime();
+#pragma omp parallel for schedule(dynamic)
+    for (index_type block = 0; block < num_blocks; block++) {
+        index_type row_begin = block * block_size;
+        index_type len = (block == num_blocks - 1) ? num_rows - row_begin
+                                                   : block_size;
+        std::vector<value_type> tau(num_cols);
+        index_type info = 0;
+        geqrf(len, num_cols, mtx + row_begin, ld_mtx, tau.data(), &info);
+        if (info != 0) {
+#pragma omp critical
+            status = info;
+        }
+    }
+    t_levels->push_back(omp_get_wtime() - t);
+
+    // Levels of the tree: the R factors of blocks block and block + stride
+    // are stacked and factorized, and the result replaces the first one.
+    for (index_type stride = 1; stride < num_blocks; stride *= 2) {
+        t = omp_get_wtime();
+        index_type num_pairs = (num_blocks + 2 * stride - 1) / (2 * stride);
+#pragma omp parallel for schedule(dynamic)
+        for (index_type pair = 0; pair < num_pairs; pair++) {
+            index_type first = 2 * stride * pair;
+            index_type second = first + stride;
+            if (second >= num_blocks) {
+                continue;
+            }
+            value_type* r_first = mtx + first * block_size;
+            value_type* r_second = mtx + second * block_size;
+            index_type ld_stacked = 2 * num_cols;
+            std::vector<value_type> stacked(std::size_t(ld_stacked) *
+                                            num_cols);
+            std::vector<value_type> tau(num_cols);
+            copy_triangle(num_cols, r_first, ld_mtx, stacked.data(),
+                          ld_stacked);
+            copy_triangle(num_cols, r_second, ld_mtx,
+                          stacked.data() + num_cols, ld_stacked);
+            index_type info = 0;
+            geqrf(ld_stacked, num_cols, stacked.data(), ld_stacked,
+                  tau.data(), &info);
+            if (info != 0) {
+#pragma omp critical
+                status = info;
+            }
+            copy_triangle(num_cols, stacked.data(), ld_stacked, r_first,
+                          ld_mtx);
+        }
+        t_levels->push_back(omp_get_wtime() - t);
+    }
+    return status;
+}
+
+
+template void srht_sketch<double>(magma_int_t num_rows_sketch,
+                                  magma_int_t num_rows, magma_int_t num_cols,
+                                  const double* mtx, magma_int_t ld_mtx,
+                                  double* result, magma_int_t ld_result,
+                                  unsigned long long seed);
+
+template void srht_sketch<float>(magma_int_t num_rows_sketch,
+                                 magma_int_t num_rows, magma_int_t num_cols,
+                                 const double* mtx, magma_int_t ld_mtx,
+                                 double* result, magma_int_t ld_result,
+                                 unsigned long long seed);
+
+template void srht_sketch<__half>(magma_int_t num_rows_sketch,
+                                  magma_int_t num_rows, magma_int_t num_cols,
+                                  const double* mtx, magma_int_t ld_mtx,
+                                  double* result, magma_int_t ld_result,
+                                  unsigned long long seed);
+
+template void srht_sketch<__nv_bfloat16>(magma_int_t num_rows_sketch,
+                                  magma_int_t num_rows, magma_int_t num_cols,
+                                  const double* mtx, magma_int_t ld_mtx,
+                                  double* result, magma_int_t ld_result,
+                                  unsigned long long seed);
+
+template void srht_sketch<float>(magma_int_t num_rows_sketch,
+                                 magma_int_t num_rows, magma_int_t num_cols,
+                                 const float* mtx, magma_int_t ld_mtx,
+                                 float* result, magma_int_t ld_result,
+                                 unsigned long long seed);
+
+template void srht_sketch<__half>(magma_int_t num_rows_sketch,
+                                  magma_int_t num_rows, magma_int_t num_cols,
+                                  const float* mtx, magma_int_t ld_mtx,
+                                  float* result, magma_int_t ld_result,
+                                  unsigned long long seed);
+
+template void srht_sketch<__nv_bfloat16>(magma_int_t num_rows_sketch,
+                                  magma_int_t num_rows, magma_int_t num_cols,
+                                  const float* mtx, magma_int_t ld_mtx,
+                                  float* result, magma_int_t ld_result,
+                                  unsigned long long seed);
+
+template void sparse_sign_sketch<double>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col, magma_int_t num_rows,
+    magma_int_t num_cols, const double* mtx, magma_int_t ld_mtx,
+    double* result, magma_int_t ld_result, unsigned long long seed);
+
+template void sparse_sign_sketch<float>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col, magma_int_t num_rows,
+    magma_int_t num_cols, const double* mtx, magma_int_t ld_mtx,
+    double* result, magma_int_t ld_result, unsigned long long seed);
+
+template void sparse_sign_sketch<__half>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col, magma_int_t num_rows,
+    magma_int_t num_cols, const double* mtx, magma_int_t ld_mtx,
+    double* result, magma_int_t ld_result, unsigned long long seed);
+
+template void sparse_sign_sketch<__nv_bfloat16>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col, magma_int_t num_rows,
+    magma_int_t num_cols, const double* mtx, magma_int_t ld_mtx,
+    double* result, magma_int_t ld_result, unsigned long long seed);
+
+template void sparse_sign_sketch<float>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col, magma_int_t num_rows,
+    magma_int_t num_cols, const float* mtx, magma_int_t ld_mtx,
+    float* result, magma_int_t ld_result, unsigned long long seed);
+
+template void sparse_sign_sketch<__half>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col, magma_int_t num_rows,
+    magma_int_t num_cols, const float* mtx, magma_int_t ld_mtx,
+    float* result, magma_int_t ld_result, unsigned long long seed);
+
+template void sparse_sign_sketch<__nv_bfloat16>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col, magma_int_t num_rows,
+    magma_int_t num_cols, const float* mtx, magma_int_t ld_mtx,
+    float* result, magma_int_t ld_result, unsigned long long seed);
+
+template void sparse_sign_sketch<double>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col, magma_int_t num_rows,
+    magma_int_t num_cols, const magma_int_t* row_ptrs,
+    const magma_int_t* col_idxs, const double* values, double* result,
+    magma_int_t ld_result, unsigned long long seed);
+
+template void sparse_sign_sketch<float>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col, magma_int_t num_rows,
+    magma_int_t num_cols, const magma_int_t* row_ptrs,
+    const magma_int_t* col_idxs, const double* values, double* result,
+    magma_int_t ld_result, unsigned long long seed);
+
+template void sparse_sign_sketch<__half>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col, magma_int_t num_rows,
+    magma_int_t num_cols, const magma_int_t* row_ptrs,
+    const magma_int_t* col_idxs, const double* values, double* result,
+    magma_int_t ld_result, unsigned long long seed);
+
+template void sparse_sign_sketch<__nv_bfloat16>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col, magma_int_t num_rows,
+    magma_int_t num_cols, const magma_int_t* row_ptrs,
+    const magma_int_t* col_idxs, const double* values, double* result,
+    magma_int_t ld_result, unsigned long long seed);
+
+template void sparse_sign_sketch<float>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col, magma_int_t num_rows,
+    magma_int_t num_cols, const magma_int_t* row_ptrs,
+    const magma_int_t* col_idxs, const float* values, float* result,
+    magma_int_t ld_result, unsigned long long seed);
+
+template void sparse_sign_sketch<__half>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col, magma_int_t num_rows,
+    magma_int_t num_cols, const magma_int_t* row_ptrs,
+    const magma_int_t* col_idxs, const float* values, float* result,
+    magma_int_t ld_result, unsigned long long seed);
+
+template void sparse_sign_sketch<__nv_bfloat16>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col, magma_int_t num_rows,
+    magma_int_t num_cols, const magma_int_t* row_ptrs,
+    const magma_int_t* col_idxs, const float* values, float* result,
+    magma_int_t ld_result, unsigned long long seed);
+
+template void gaussian_sketch<double>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows, magma_int_t num_cols,
+    const double* mtx, magma_int_t ld_mtx, double* result,
+    magma_int_t ld_result, unsigned long long seed);
+
+template void gaussian_sketch<float>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows, magma_int_t num_cols,
+    const double* mtx, magma_int_t ld_mtx, double* result,
+    magma_int_t ld_result, unsigned long long seed);
+
+template void gaussian_sketch<__half>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows, magma_int_t num_cols,
+    const double* mtx, magma_int_t ld_mtx, double* result,
+    magma_int_t ld_result, unsigned long long seed);
+
+template void gaussian_sketch<__nv_bfloat16>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows, magma_int_t num_cols,
+    const double* mtx, magma_int_t ld_mtx, double* result,
+    magma_int_t ld_result, unsigned long long seed);
+
+template void gaussian_sketch<float>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows, magma_int_t num_cols,
+    const float* mtx, magma_int_t ld_mtx, float* result,
+    magma_int_t ld_result, unsigned long long seed);
+
+template void gaussian_sketch<__half>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows, magma_int_t num_cols,
+    const float* mtx, magma_int_t ld_mtx, float* result,
+    magma_int_t ld_result, unsigned long long seed);
+
+template void gaussian_sketch<__nv_bfloat16>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows, magma_int_t num_cols,
+    const float* mtx, magma_int_t ld_mtx, float* result,
+    magma_int_t ld_result, unsigned long long seed);
+
+template void sparse_sign_sketch_add<double>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    magma_int_t row_offset, magma_int_t num_rows, magma_int_t num_cols,
+    const double* mtx, magma_int_t ld_mtx, double* result,
+    magma_int_t ld_result, unsigned long long seed);
+
+template void sparse_sign_sketch_add<float>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    magma_int_t row_offset, magma_int_t num_rows, magma_int_t num_cols,
+    const double* mtx, magma_int_t ld_mtx, double* result,
+    magma_int_t ld_result, unsigned long long seed);
+
+template void sparse_sign_sketch_add<__half>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    magma_int_t row_offset, magma_int_t num_rows, magma_int_t num_cols,
+    const double* mtx, magma_int_t ld_mtx, double* result,
+    magma_int_t ld_result, unsigned long long seed);
+
+template void sparse_sign_sketch_add<__nv_bfloat16>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    magma_int_t row_offset, magma_int_t num_rows, magma_int_t num_cols,
+    const double* mtx, magma_int_t ld_mtx, double* result,
+    magma_int_t ld_result, unsigned long long seed);
+
+template void sparse_sign_sketch_add<float>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    magma_int_t row_offset, magma_int_t num_rows, magma_int_t num_cols,
+    const float* mtx, magma_int_t ld_mtx, float* result,
+    magma_int_t ld_result, unsigned long long seed);
+
+template void sparse_sign_sketch_add<__half>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    magma_int_t row_offset, magma_int_t num_rows, magma_int_t num_cols,
+    const float* mtx, magma_int_t ld_mtx, float* result,
+    magma_int_t ld_result, unsigned long long seed);
+
+template void sparse_sign_sketch_add<__nv_bfloat16>(
+    magma_int_t num_rows_sketch, magma_int_t nnz_per_col,
+    magma_int_t row_offset, magma_int_t num_rows, magma_int_t num_cols,
+    const float* mtx, magma_int_t ld_mtx, float* result,
+    magma_int_t ld_result, unsigned long long seed);
+
+template void gaussian_sketch_add<double>(
+    magma_int_t num_rows_sketch, magma_int_t row_offset, magma_int_t num_rows,
+    magma_int_t num_cols, const double* mtx, magma_int_t ld_mtx,
+    double* result, magma_int_t ld_result, unsigned long long seed);
+
+template void gaussian_sketch_add<float>(
+    magma_int_t num_rows_sketch, magma_int_t row_offset, magma_int_t num_rows,
+    magma_int_t num_cols, const double* mtx, magma_int_t ld_mtx,
+    double* result, magma_int_t ld_result, unsigned long long seed);
+
+template void gaussian_sketch_add<__half>(
+    magma_int_t num_rows_sketch, magma_int_t row_offset, magma_int_t num_rows,
+    magma_int_t num_cols, const double* mtx, magma_int_t ld_mtx,
+    double* result, magma_int_t ld_result, unsigned long long seed);
+
+template void gaussian_sketch_add<__nv_bfloat16>(
+    magma_int_t num_rows_sketch, magma_int_t row_offset, magma_int_t num_rows,
+    magma_int_t num_cols, const double* mtx, magma_int_t ld_mtx,
+    double* result, magma_int_t ld_result, unsigned long long seed);
+
+template void gaussian_sketch_add<float>(
+    magma_int_t num_rows_sketch, magma_int_t row_offset, magma_int_t num_rows,
+    magma_int_t num_cols, const float* mtx, magma_int_t ld_mtx,
+    float* result, magma_int_t ld_result, unsigned long long seed);
+
+template void gaussian_sketch_add<__half>(
+    magma_int_t num_rows_sketch, magma_int_t row_offset, magma_int_t num_rows,
+    magma_int_t num_cols, const float* mtx, magma_int_t ld_mtx,
+    float* result, magma_int_t ld_result, unsigned long long seed);
+
+template void gaussian_sketch_add<__nv_bfloat16>(
+    magma_int_t num_rows_sketch, magma_int_t row_offset, magma_int_t num_rows,
+    magma_int_t num_cols, const float* mtx, magma_int_t ld_mtx,
+    float* result, magma_int_t ld_result, unsigned long long seed);
+
+template void gaussian_sketch<double>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows, magma_int_t num_cols,
+    const magma_int_t* row_ptrs, const magma_int_t* col_idxs,
+    const double* values, double* result, magma_int_t ld_result,
+    unsigned long long seed);
+
+template void gaussian_sketch<float>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows, magma_int_t num_cols,
+    const magma_int_t* row_ptrs, const magma_int_t* col_idxs,
+    const double* values, double* result, magma_int_t ld_result,
+    unsigned long long seed);
+
+template void gaussian_sketch<__half>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows, magma_int_t num_cols,
+    const magma_int_t* row_ptrs, const magma_int_t* col_idxs,
+    const double* values, double* result, magma_int_t ld_result,
+    unsigned long long seed);
+
+template void gaussian_sketch<__nv_bfloat16>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows, magma_int_t num_cols,
+    const magma_int_t* row_ptrs, const magma_int_t* col_idxs,
+    const double* values, double* result, magma_int_t ld_result,
+    unsigned long long seed);
+
+template void gaussian_sketch<float>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows, magma_int_t num_cols,
+    const magma_int_t* row_ptrs, const magma_int_t* col_idxs,
+    const float* values, float* result, magma_int_t ld_result,
+    unsigned long long seed);
+
+template void gaussian_sketch<__half>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows, magma_int_t num_cols,
+    const magma_int_t* row_ptrs, const magma_int_t* col_idxs,
+    const float* values, float* result, magma_int_t ld_result,
+    unsigned long long seed);
+
+template void gaussian_sketch<__nv_bfloat16>(
+    magma_int_t num_rows_sketch, magma_int_t num_rows, magma_int_t num_cols,
+    const magma_int_t* row_ptrs, const magma_int_t* col_idxs,
+    const float* values, float* result, magma_int_t ld_result,
+    unsigned long long seed);
+
+template void demote(magma_int_t num_rows, magma_int_t num_cols,
+                     const double* mtx, magma_int_t ld_mtx, double* mtx_rp,
+                     magma_int_t ld_mtx_rp);
+
+template void demote(magma_int_t num_rows, magma_int_t num_cols,
+                     const double* mtx, magma_int_t ld_mtx, float* mtx_rp,
+                     magma_int_t ld_mtx_rp);
+
+template void demote(magma_int_t num_rows, magma_int_t num_cols,
+                     const double* mtx, magma_int_t ld_mtx, __half* mtx_rp,
+                     magma_int_t ld_mtx_rp);
+
+template void demote(magma_int_t num_rows, magma_int_t num_cols,
+                     const double* mtx, magma_int_t ld_mtx,
+                     __nv_bfloat16* mtx_rp, magma_int_t ld_mtx_rp);
+
+template void demote(magma_int_t num_rows, magma_int_t num_cols,
+                     const float* mtx, magma_int_t ld_mtx, float* mtx_rp,
+                     magma_int_t ld_mtx_rp);
+
+template void demote(magma_int_t num_rows, magma_int_t num_cols,
+                     const float* mtx, magma_int_t ld_mtx, __half* mtx_rp,
+                     magma_int_t ld_mtx_rp);
+
+template void demote(magma_int_t num_rows, magma_int_t num_cols,
+                     const float* mtx, magma_int_t ld_mtx,
+                     __nv_bfloat16* mtx_rp, magma_int_t ld_mtx_rp);
+
+template void promote(magma_int_t num_rows, magma_int_t num_cols,
+                      const double* mtx, magma_int_t ld_mtx, double* mtx_ip,
+                      magma_int_t ld_mtx_ip);
+
+template void promote(magma_int_t num_rows, magma_int_t num_cols,
+                      const float* mtx, magma_int_t ld_mtx, double* mtx_ip,
+                      magma_int_t ld_mtx_ip);
+
+template void promote(magma_int_t num_rows, magma_int_t num_cols,
+                      const __half* mtx, magma_int_t ld_mtx, double* mtx_ip,
+                      magma_int_t ld_mtx_ip);
+
+template void promote(magma_int_t num_rows, magma_int_t num_cols,
+                      const __nv_bfloat16* mtx, magma_int_t ld_mtx,
+                      double* mtx_ip, magma_int_t ld_mtx_ip);
+
+template void promote(magma_int_t num_rows, magma_int_t num_cols,
+                      const float* mtx, magma_int_t ld_mtx, float* mtx_ip,
+                      magma_int_t ld_mtx_ip);
+
+template void promote(magma_int_t num_rows, magma_int_t num_cols,
+                      const __half* mtx, magma_int_t ld_mtx, float* mtx_ip,
+                      magma_int_t ld_mtx_ip);
+
+template void promote(magma_int_t num_rows, magma_int_t num_cols,
+                      const __nv_bfloat16* mtx, magma_int_t ld_mtx,
+                      float* mtx_ip, magma_int_t ld_mtx_ip);
+
+
+template magma_int_t tsqr(magma_int_t num_rows, magma_int_t num_cols,
+                          double* mtx, magma_int_t ld_mtx,
+                          magma_int_t block_size,
+                          std::vector<double>* t_levels);
+
+template magma_int_t tsqr(magma_int_t num_rows, magma_int_t num_cols,
+                          float* mtx, magma_int_t ld_mtx,
+                          magma_int_t block_size,
+                          std::vector<double>* t_levels);
+
+
+}  // namespace host
+}  // namespace rls
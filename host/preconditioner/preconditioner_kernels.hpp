@@ -0,0 +1,129 @@
+#ifndef HOST_PRECONDITIONER_KERNELS_HPP
+#define HOST_PRECONDITIONER_KERNELS_HPP
+
+
+#include <vector>
+#include "magma_v2.h"
+
+
+namespace rls {
+namespace host {
+
+
+// Computes result = S * mtx for the subsampled randomized Hadamard transform
+// S = sqrt(1 / num_rows_sketch) * P * H * D. D flips the signs of the rows of
+// mtx, H is the Walsh-Hadamard transform of the rows zero-padded to a power of
+// two and P keeps num_rows_sketch of the padded rows, chosen uniformly without
+// replacement, so num_rows_sketch must not exceed the padded size. mtx is
+// rounded to value_type_internal and transformed in its arithmetic type, one
+// column per thread, in O(num_rows log num_rows) per column.
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void srht_sketch(index_type num_rows_sketch, index_type num_rows,
+                 index_type num_cols, const value_type* mtx, index_type ld_mtx,
+                 value_type* result, index_type ld_result,
+                 unsigned long long seed);
+
+// Computes result = S * mtx for a sparse sign embedding S with nnz_per_col
+// nonzeros +-1/sqrt(nnz_per_col) per column, in distinct rows given by hashing
+// the column index with seed (nnz_per_col = 1 is the CountSketch). S is never
+// stored: each thread scatter-adds a block of rows of mtx into its own partial
+// copy of the result and the partial results are summed at the end, so the
+// cost is O(nnz_per_col * num_rows * num_cols).
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void sparse_sign_sketch(index_type num_rows_sketch, index_type nnz_per_col,
+                        index_type num_rows, index_type num_cols,
+                        const value_type* mtx, index_type ld_mtx,
+                        value_type* result, index_type ld_result,
+                        unsigned long long seed);
+
+// Adds the product of columns [row_offset, row_offset + num_rows) of the
+// sparse sign embedding of sparse_sign_sketch with mtx, rows row_offset
+// onwards of a larger matrix, to result. Summing over the row panels of a
+// matrix gives its sparse_sign_sketch up to rounding, so the sketch can be
+// accumulated one panel at a time.
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void sparse_sign_sketch_add(index_type num_rows_sketch,
+                            index_type nnz_per_col, index_type row_offset,
+                            index_type num_rows, index_type num_cols,
+                            const value_type* mtx, index_type ld_mtx,
+                            value_type* result, index_type ld_result,
+                            unsigned long long seed);
+
+// Overload of sparse_sign_sketch for mtx in CSR format. Every nonzero of row i
+// of mtx is scattered into the rows of column i of S, in O(nnz_per_col * nnz).
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void sparse_sign_sketch(index_type num_rows_sketch, index_type nnz_per_col,
+                        index_type num_rows, index_type num_cols,
+                        const index_type* row_ptrs, const index_type* col_idxs,
+                        const value_type* values, value_type* result,
+                        index_type ld_result, unsigned long long seed);
+
+// Computes result = S * mtx for a standard Gaussian S without storing S: the
+// entries of S come from a counter-based generator (philox) keyed by seed and
+// indexed by (row, col), so S does not depend on the number of threads or the
+// tiling. Each thread generates the tile of S that multiplies a block of rows
+// of mtx, rounded to value_type_internal, and accumulates tile * block into
+// its own partial copy of the result with a gemm in the arithmetic type of
+// value_type_internal. Needs O(num_rows_sketch * (num_cols + tile)) memory
+// per thread instead of the num_rows_sketch * num_rows of a stored sketch.
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void gaussian_sketch(index_type num_rows_sketch, index_type num_rows,
+                     index_type num_cols, const value_type* mtx,
+                     index_type ld_mtx, value_type* result,
+                     index_type ld_result, unsigned long long seed);
+
+// Adds the product of columns [row_offset, row_offset + num_rows) of the
+// Gaussian sketch of gaussian_sketch with mtx, rows row_offset onwards of a
+// larger matrix, to result, as sparse_sign_sketch_add does.
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void gaussian_sketch_add(index_type num_rows_sketch, index_type row_offset,
+                         index_type num_rows, index_type num_cols,
+                         const value_type* mtx, index_type ld_mtx,
+                         value_type* result, index_type ld_result,
+                         unsigned long long seed);
+
+// Overload of gaussian_sketch for mtx in CSR format. Column i of S is
+// generated once for row i of mtx and scaled into the result for each of its
+// nonzeros, in O(num_rows_sketch * nnz); empty rows are skipped.
+template <typename value_type_internal, typename value_type,
+          typename index_type>
+void gaussian_sketch(index_type num_rows_sketch, index_type num_rows,
+                     index_type num_cols, const index_type* row_ptrs,
+                     const index_type* col_idxs, const value_type* values,
+                     value_type* result, index_type ld_result,
+                     unsigned long long seed);
+
+template <typename value_type_in, typename value_type, typename index_type>
+void demote(index_type num_rows, index_type num_cols, const value_type* mtx,
+            index_type ld_mtx, value_type_in* mtx_rp, index_type ld_mtx_rp);
+
+template <typename value_type_in, typename value_type, typename index_type>
+void promote(index_type num_rows, index_type num_cols,
+             const value_type_in* mtx, index_type ld_mtx, value_type* mtx_ip,
+             index_type ld_mtx_ip);
+
+
+// Computes the R factor of mtx (num_rows >= num_cols) by a tall-skinny QR:
+// blocks of block_size rows (0: one block per thread) are factorized in
+// parallel and their R factors are merged pairwise up a binary tree. Q is
+// not formed. R is left in the upper triangle of the leading num_cols rows
+// of mtx, whose other rows are overwritten. Appends the seconds spent in
+// every level of the tree to t_levels, leaves first, and returns the LAPACK
+// info.
+template <typename value_type, typename index_type>
+index_type tsqr(index_type num_rows, index_type num_cols, value_type* mtx,
+                index_type ld_mtx, index_type block_size,
+                std::vector<double>* t_levels);
+
+
+}  // namespace host
+}  // namespace rls
+
+
+#endif
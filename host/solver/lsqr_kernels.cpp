@@ -0,0 +1,415 @@
+#include <omp.h>
+#include <algorithm>
+#include <vector>
+#include "cuda_bf16.h"
+#include "cuda_fp16.h"
+#include "magma_v2.h"
+
+
+#include "../blas/blas_kernels.hpp"
+#include "../precision.hpp"
+#include "lsqr_kernels.hpp"
+
+
+namespace rls {
+namespace host {
+namespace {
+
+
+// Rows per task; a block of u (and of the accumulator) stays in L1 while the
+// columns of mtx are streamed through it.
+const magma_int_t row_block_size = 1024;
+
+// Returns len entries of a column of mtx in its arithmetic type. Only fp16
+// and bfloat16 storage need widening, which goes through buffer.
+template <typename value_type>
+const value_type* load_block(magma_int_t len, const value_type* column,
+                             value_type* buffer)
+{
+    return column;
+}
+
+const float* load_block(magma_int_t len, const __half* column, float* buffer)
+{
+    half_to_float(len, column, buffer);
+    return buffer;
+}
+
+const float* load_block(magma_int_t len, const __nv_bfloat16* column,
+                        float* buffer)
+{
+    bfloat16_to_float(len, column, buffer);
+    return buffer;
+}
+
+
+}  // anonymous namespace
+
+
+template <typename value_type, typename index_type>
+void set_values(index_type num_elems, value_type val, value_type* values)
+{
+#pragma omp parallel for schedule(static)
+    for (index_type i = 0; i < num_elems; i++) {
+        values[i] = val;
+    }
+}
+
+// Sets init_sol = 0, sol = 1, rhs = mtx * sol and then resets sol to
+// init_sol, matching cuda::default_initialization.
+template <typename value_type, typename index_type>
+void default_initialization(index_type num_rows, index_type num_cols,
+                            value_type* mtx, value_type* init_sol,
+                            value_type* sol, value_type* rhs)
+{
+    index_type inc = 1;
+    set_values(num_cols, value_type(0), init_sol);
+    set_values(num_cols, value_type(1), sol);
+    gemv(MagmaNoTrans, num_rows, num_cols, value_type(1), mtx, num_rows, sol,
+         inc, value_type(0), rhs, inc);
+    copy(num_cols, init_sol, inc, sol, inc);
+}
+
+template <typename value_type, typename index_type>
+void solution_initialization(index_type num_rows, value_type* init_sol,
+                             value_type* sol)
+{
+    set_values(num_rows, value_type(0), init_sol);
+    set_values(num_rows, value_type(0), sol);
+}
+
+template <typename value_type_in, typename value_type, typename index_type>
+double gemv_axpby_norm2(index_type num_rows, index_type num_cols,
+                        const value_type_in* mtx, index_type ld,
+                        const value_type* t, value_type alpha,
+                        value_type* u)
+{
+    using accumulator = typename arithmetic<value_type_in>::type;
+    index_type num_blocks = (num_rows + row_block_size - 1) / row_block_size;
+    double sum = 0;
+#pragma omp parallel reduction(+ : sum)
+    {
+        std::vector<accumulator> acc(row_block_size);
+        std::vector<accumulator> buffer(row_block_size);
+#pragma omp for schedule(static)
+        for (index_type block = 0; block < num_blocks; block++) {
+            index_type row_begin = block * row_block_size;
+            index_type len = std::min(row_block_size, num_rows - row_begin);
+            accumulator* a = acc.data();
+            std::fill(a, a + len, accumulator(0));
+            for (index_type col = 0; col < num_cols; col++) {
+                accumulator x = static_cast<accumulator>(t[col]);
+                const accumulator* column = load_block(
+                    len, mtx + static_cast<std::size_t>(col) * ld + row_begin,
+                    buffer.data());
+#pragma omp simd
+                for (index_type i = 0; i < len; i++) {
+                    a[i] += column[i] * x;
+                }
+            }
+            value_type* u_block = u + row_begin;
+#pragma omp simd reduction(+ : sum)
+            for (index_type i = 0; i < len; i++) {
+                value_type value =
+                    static_cast<value_type>(a[i]) - alpha * u_block[i];
+                u_block[i] = value;
+                sum += double(value) * value;
+            }
+        }
+    }
+    return sum;
+}
+
+template <typename value_type_in, typename value_type, typename index_type>
+void scale_gemv_trans(index_type num_rows, index_type num_cols,
+                      const value_type_in* mtx, index_type ld,
+                      value_type scale, value_type* u, value_type beta,
+                      value_type* result)
+{
+    using accumulator = typename arithmetic<value_type_in>::type;
+    index_type num_blocks = (num_rows + row_block_size - 1) / row_block_size;
+    std::vector<accumulator> total(num_cols, accumulator(0));
+#pragma omp parallel
+    {
+        std::vector<accumulator> partial(num_cols, accumulator(0));
+        std::vector<accumulator> u_acc(row_block_size);
+        std::vector<accumulator> buffer(row_block_size);
+#pragma omp for schedule(static)
+        for (index_type block = 0; block < num_blocks; block++) {
+            index_type row_begin = block * row_block_size;
+            index_type len = std::min(row_block_size, num_rows - row_begin);
+            value_type* u_block = u + row_begin;
+            accumulator* x = u_acc.data();
+#pragma omp simd
+            for (index_type i = 0; i < len; i++) {
+                u_block[i] *= scale;
+                x[i] = static_cast<accumulator>(u_block[i]);
+            }
+            for (index_type col = 0; col < num_cols; col++) {
+                const accumulator* column = load_block(
+                    len, mtx + static_cast<std::size_t>(col) * ld + row_begin,
+                    buffer.data());
+                accumulator sum = 0;
+#pragma omp simd reduction(+ : sum)
+                for (index_type i = 0; i < len; i++) {
+                    sum += column[i] * x[i];
+                }
+                partial[col] += sum;
+            }
+        }
+#pragma omp critical
+        for (index_type col = 0; col < num_cols; col++) {
+            total[col] += partial[col];
+        }
+    }
+    for (index_type col = 0; col < num_cols; col++) {
+        value_type value = static_cast<value_type>(total[col]);
+        result[col] = (beta == value_type(0)) ? value
+                                              : value + beta * result[col];
+    }
+}
+
+template <typename value_type_in, typename value_type, typename index_type>
+double spmv_axpby_norm2(index_type num_rows, const index_type* row_ptrs,
+                        const index_type* col_idxs,
+                        const value_type_in* values, const value_type* t,
+                        value_type alpha, value_type* u)
+{
+    using accumulator = typename arithmetic<value_type_in>::type;
+    double sum = 0;
+#pragma omp parallel for reduction(+ : sum) schedule(dynamic, row_block_size)
+    for (index_type row = 0; row < num_rows; row++) {
+        accumulator acc = 0;
+        for (index_type k = row_ptrs[row]; k < row_ptrs[row + 1]; k++) {
+            acc += arithmetic<value_type_in>::load(values[k]) *
+                   static_cast<accumulator>(t[col_idxs[k]]);
+        }
+        value_type value = static_cast<value_type>(acc) - alpha * u[row];
+        u[row] = value;
+        sum += double(value) * value;
+    }
+    return sum;
+}
+
+template <typename value_type_in, typename value_type, typename index_type>
+void scale_spmv_trans(index_type num_rows, index_type num_cols,
+                      const index_type* row_ptrs, const index_type* col_idxs,
+                      const value_type_in* values, value_type scale,
+                      value_type* u, value_type beta, value_type* result)
+{
+    using accumulator = typename arithmetic<value_type_in>::type;
+    std::vector<accumulator> total(num_cols, accumulator(0));
+#pragma omp parallel
+    {
+        std::vector<accumulator> partial(num_cols, accumulator(0));
+#pragma omp for schedule(dynamic, row_block_size)
+        for (index_type row = 0; row < num_rows; row++) {
+            u[row] *= scale;
+            accumulator x = static_cast<accumulator>(u[row]);
+            for (index_type k = row_ptrs[row]; k < row_ptrs[row + 1]; k++) {
+                partial[col_idxs[k]] +=
+                    arithmetic<value_type_in>::load(values[k]) * x;
+            }
+        }
+#pragma omp critical
+        for (index_type col = 0; col < num_cols; col++) {
+            total[col] += partial[col];
+        }
+    }
+    for (index_type col = 0; col < num_cols; col++) {
+        value_type value = static_cast<value_type>(total[col]);
+        result[col] = (beta == value_type(0)) ? value
+                                              : value + beta * result[col];
+    }
+}
+
+template <typename value_type, typename index_type>
+double axpby_norm2(index_type num_rows, const value_type* t,
+                   value_type beta, value_type* v)
+{
+    double sum = 0;
+#pragma omp parallel for simd reduction(+ : sum) schedule(static)
+    for (index_type i = 0; i < num_rows; i++) {
+        value_type value = t[i] - beta * v[i];
+        v[i] = value;
+        sum += double(value) * value;
+    }
+    return sum;
+}
+
+
+template void default_initialization(magma_int_t num_rows,
+                                     magma_int_t num_cols, double* mtx,
+                                     double* init_sol, double* sol,
+                                     double* rhs);
+
+template void default_initialization(magma_int_t num_rows,
+                                     magma_int_t num_cols, float* mtx,
+                                     float* init_sol, float* sol, float* rhs);
+
+template void solution_initialization(magma_int_t num_rows, double* init_sol,
+                                      double* sol);
+
+template void solution_initialization(magma_int_t num_rows, float* init_sol,
+                                      float* sol);
+
+template void set_values(magma_int_t num_elems, double val, double* values);
+
+template void set_values(magma_int_t num_elems, float val, float* values);
+
+template void set_values(magma_int_t num_elems, __half val, __half* values);
+
+template void set_values(magma_int_t num_elems, __nv_bfloat16 val,
+                         __nv_bfloat16* values);
+
+template double gemv_axpby_norm2(magma_int_t num_rows, magma_int_t num_cols,
+                                 const double* mtx, magma_int_t ld,
+                                 const double* t, double alpha, double* u);
+
+template double gemv_axpby_norm2(magma_int_t num_rows, magma_int_t num_cols,
+                                 const float* mtx, magma_int_t ld,
+                                 const double* t, double alpha, double* u);
+
+template double gemv_axpby_norm2(magma_int_t num_rows, magma_int_t num_cols,
+                                 const __half* mtx, magma_int_t ld,
+                                 const double* t, double alpha, double* u);
+
+template double gemv_axpby_norm2(magma_int_t num_rows, magma_int_t num_cols,
+                                 const __nv_bfloat16* mtx, magma_int_t ld,
+                                 const double* t, double alpha, double* u);
+
+template double gemv_axpby_norm2(magma_int_t num_rows, magma_int_t num_cols,
+                                 const float* mtx, magma_int_t ld,
+                                 const float* t, float alpha, float* u);
+
+template double gemv_axpby_norm2(magma_int_t num_rows, magma_int_t num_cols,
+                                 const __half* mtx, magma_int_t ld,
+                                 const float* t, float alpha, float* u);
+
+template double gemv_axpby_norm2(magma_int_t num_rows, magma_int_t num_cols,
+                                 const __nv_bfloat16* mtx, magma_int_t ld,
+                                 const float* t, float alpha, float* u);
+
+template void scale_gemv_trans(magma_int_t num_rows, magma_int_t num_cols,
+                               const double* mtx, magma_int_t ld, double scale,
+                               double* u, double beta, double* result);
+
+template void scale_gemv_trans(magma_int_t num_rows, magma_int_t num_cols,
+                               const float* mtx, magma_int_t ld, double scale,
+                               double* u, double beta, double* result);
+
+template void scale_gemv_trans(magma_int_t num_rows, magma_int_t num_cols,
+                               const __half* mtx, magma_int_t ld, double scale,
+                               double* u, double beta, double* result);
+
+template void scale_gemv_trans(magma_int_t num_rows, magma_int_t num_cols,
+                               const __nv_bfloat16* mtx, magma_int_t ld,
+                               double scale, double* u, double beta,
+                               double* result);
+
+template void scale_gemv_trans(magma_int_t num_rows, magma_int_t num_cols,
+                               const float* mtx, magma_int_t ld, float scale,
+                               float* u, float beta, float* result);
+
+template void scale_gemv_trans(magma_int_t num_rows, magma_int_t num_cols,
+                               const __half* mtx, magma_int_t ld, float scale,
+                               float* u, float beta, float* result);
+
+template void scale_gemv_trans(magma_int_t num_rows, magma_int_t num_cols,
+                               const __nv_bfloat16* mtx, magma_int_t ld,
+                               float scale, float* u, float beta,
+                               float* result);
+
+template double spmv_axpby_norm2(magma_int_t num_rows,
+                                 const magma_int_t* row_ptrs,
+                                 const magma_int_t* col_idxs,
+                                 const double* values, const double* t,
+                                 double alpha, double* u);
+
+template double spmv_axpby_norm2(magma_int_t num_rows,
+                                 const magma_int_t* row_ptrs,
+                                 const magma_int_t* col_idxs,
+                                 const float* values, const double* t,
+                                 double alpha, double* u);
+
+template double spmv_axpby_norm2(magma_int_t num_rows,
+                                 const magma_int_t* row_ptrs,
+                                 const magma_int_t* col_idxs,
+                                 const __half* values, const double* t,
+                                 double alpha, double* u);
+
+template double spmv_axpby_norm2(magma_int_t num_rows,
+                                 const magma_int_t* row_ptrs,
+                                 const magma_int_t* col_idxs,
+                                 const __nv_bfloat16* values, const double* t,
+                                 double alpha, double* u);
+
+template double spmv_axpby_norm2(magma_int_t num_rows,
+                                 const magma_int_t* row_ptrs,
+                                 const magma_int_t* col_idxs,
+                                 const float* values, const float* t,
+                                 float alpha, float* u);
+
+template double spmv_axpby_norm2(magma_int_t num_rows,
+                                 const magma_int_t* row_ptrs,
+                                 const magma_int_t* col_idxs,
+                                 const __half* values, const float* t,
+                                 float alpha, float* u);
+
+template double spmv_axpby_norm2(magma_int_t num_rows,
+                                 const magma_int_t* row_ptrs,
+                                 const magma_int_t* col_idxs,
+                                 const __nv_bfloat16* values, const float* t,
+                                 float alpha, float* u);
+
+template void scale_spmv_trans(magma_int_t num_rows, magma_int_t num_cols,
+                               const magma_int_t* row_ptrs,
+                               const magma_int_t* col_idxs,
+                               const double* values, double scale, double* u,
+                               double beta, double* result);
+
+template void scale_spmv_trans(magma_int_t num_rows, magma_int_t num_cols,
+                               const magma_int_t* row_ptrs,
+                               const magma_int_t* col_idxs,
+                               const float* values, double scale, double* u,
+                               double beta, double* result);
+
+template void scale_spmv_trans(magma_int_t num_rows, magma_int_t num_cols,
+                               const magma_int_t* row_ptrs,
+                               const magma_int_t* col_idxs,
+                               const __half* values, double scale, double* u,
+                               double beta, double* result);
+
+template void scale_spmv_trans(magma_int_t num_rows, magma_int_t num_cols,
+                               const magma_int_t* row_ptrs,
+                               const magma_int_t* col_idxs,
+                               const __nv_bfloat16* values, double scale,
+                               double* u, double beta, double* result);
+
+template void scale_spmv_trans(magma_int_t num_rows, magma_int_t num_cols,
+                               const magma_int_t* row_ptrs,
+                               const magma_int_t* col_idxs,
+                               const float* values, float scale, float* u,
+                               float beta, float* result);
+
+template void scale_spmv_trans(magma_int_t num_rows, magma_int_t num_cols,
+                               const magma_int_t* row_ptrs,
+                               const magma_int_t* col_idxs,
+                               const __half* values, float scale, float* u,
+                               float beta, float* result);
+
+template void scale_spmv_trans(magma_int_t num_rows, magma_int_t num_cols,
+                               const magma_int_t* row_ptrs,
+                               const magma_int_t* col_idxs,
+                               const __nv_bfloat16* values, float scale,
+                               float* u, float beta, float* result);
+
+template double axpby_norm2(magma_int_t num_rows, const double* t, double beta,
+                            double* v);
+
+template double axpby_norm2(magma_int_t num_rows, const float* t, float beta,
+                            float* v);
+
+
+}  // namespace host
+}  // namespace rls
@@ -0,0 +1,71 @@
+#ifndef HOST_LSQR_KERNELS_HPP
+#define HOST_LSQR_KERNELS_HPP
+
+
+#include "magma_v2.h"
+
+
+namespace rls {
+namespace host {
+
+
+template <typename value_type, typename index_type>
+void default_initialization(index_type num_rows, index_type num_cols,
+                            value_type* mtx, value_type* init_sol,
+                            value_type* sol, value_type* rhs);
+
+template <typename value_type, typename index_type>
+void solution_initialization(index_type num_rows, value_type* init_sol,
+                             value_type* sol);
+
+template <typename value_type, typename index_type>
+void set_values(index_type num_elems, value_type val, value_type* values);
+
+// Fused kernels of the Golub-Kahan bidiagonalization. mtx may be stored in a
+// lower precision (value_type_in) than the vectors; its entries are widened on
+// the fly, so no demoted copies of the vectors are needed. Squared norms are
+// accumulated and returned in double, so that they neither overflow nor
+// underflow for float vectors.
+
+// u = mtx * t - alpha * u, returns ||u||^2. Reads mtx and u once.
+template <typename value_type_in, typename value_type, typename index_type>
+double gemv_axpby_norm2(index_type num_rows, index_type num_cols,
+                        const value_type_in* mtx, index_type ld,
+                        const value_type* t, value_type alpha,
+                        value_type* u);
+
+// u = scale * u and result = mtx^T * u + beta * result, in one pass over mtx
+// and u.
+template <typename value_type_in, typename value_type, typename index_type>
+void scale_gemv_trans(index_type num_rows, index_type num_cols,
+                      const value_type_in* mtx, index_type ld,
+                      value_type scale, value_type* u, value_type beta,
+                      value_type* result);
+
+// u = mtx * t - alpha * u for mtx in CSR format, returns ||u||^2.
+template <typename value_type_in, typename value_type, typename index_type>
+double spmv_axpby_norm2(index_type num_rows, const index_type* row_ptrs,
+                        const index_type* col_idxs,
+                        const value_type_in* values, const value_type* t,
+                        value_type alpha, value_type* u);
+
+// u = scale * u and result = mtx^T * u + beta * result for mtx in CSR format,
+// in one pass over mtx and u. Each thread accumulates its rows into a partial
+// result of length num_cols.
+template <typename value_type_in, typename value_type, typename index_type>
+void scale_spmv_trans(index_type num_rows, index_type num_cols,
+                      const index_type* row_ptrs, const index_type* col_idxs,
+                      const value_type_in* values, value_type scale,
+                      value_type* u, value_type beta, value_type* result);
+
+// v = t - beta * v, returns ||v||^2.
+template <typename value_type, typename index_type>
+double axpby_norm2(index_type num_rows, const value_type* t,
+                   value_type beta, value_type* v);
+
+
+}  // namespace host
+}  // namespace rls
+
+
+#endif
@@ -7,6 +7,12 @@
 
 namespace rls {
     using dim2 = magma_int_t[2];
+
+    // Random embedding S used to form the sketch S * A of the preconditioner.
+    enum class sketch_type { gaussian, srht, sparse_sign };
+
+    // Factorization of the sketch S * A that yields the R factor.
+    enum class qr_type { householder, tsqr, cholqr2 };
 }
 
 
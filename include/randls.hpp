@@ -13,8 +13,12 @@
 #include "../utils/init_kernels.hpp"
 #include "../utils/io.hpp"
 #include "../cuda/preconditioner/preconditioner_kernels.cuh"
+#include "../core/blas/blas.hpp"
 #include "../core/memory/detail.hpp"
 #include "../core/solver/lsqr.hpp"
+#include "../core/solver/lsmr.hpp"
+#include "../core/solver/block_lsqr.hpp"
+#include "../core/solver/refine.hpp"
 #include "../cuda/solver/lsqr_kernels.cuh"
 
 
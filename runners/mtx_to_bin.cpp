@@ -0,0 +1,53 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+#include "../include/randls.hpp"
+
+
+// Converts a MatrixMarket array file to the binary matrix container read by
+// run_lsqr, or verifies the checksum of a binary file.
+//
+//     mtx_to_bin in.mtx out.bin [fp64|fp32]
+//     mtx_to_bin --verify in.bin
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> args(argv + 1, argv + argc);
+    if ((args.size() == 2) && (args[0].compare("--verify") == 0)) {
+        rls::io::mapped_mtx mapped;
+        if (!rls::io::map_bin((char*)args[1].c_str(), &mapped, true)) {
+            return EXIT_FAILURE;
+        }
+        std::cout << args[1] << ": " << mapped.header.num_rows << " x "
+                  << mapped.header.num_cols << ", "
+                  << ((mapped.header.dtype == rls::io::bin_fp64) ? "fp64"
+                                                                 : "fp32")
+                  << ", checksum ok\n";
+        rls::io::unmap_bin(&mapped);
+        return EXIT_SUCCESS;
+    }
+    if ((args.size() < 2) || (args.size() > 3)) {
+        std::cout << "usage: mtx_to_bin in.mtx out.bin [fp64|fp32]\n"
+                  << "       mtx_to_bin --verify in.bin\n";
+        return EXIT_FAILURE;
+    }
+
+    magma_int_t num_rows = 0;
+    magma_int_t num_cols = 0;
+    rls::io::read_mtx_size((char*)args[0].c_str(), &num_rows, &num_cols);
+    std::vector<double> mtx(static_cast<std::size_t>(num_rows) * num_cols);
+    rls::io::read_mtx_values((char*)args[0].c_str(), num_rows, num_cols,
+                             mtx.data());
+    if ((args.size() == 3) && (args[2].compare("fp32") == 0)) {
+        std::vector<float> mtx_fp32(mtx.begin(), mtx.end());
+        rls::io::write_bin((char*)args[1].c_str(), num_rows, num_cols,
+                           mtx_fp32.data(), num_rows);
+    } else {
+        rls::io::write_bin((char*)args[1].c_str(), num_rows, num_cols,
+                           mtx.data(), num_rows);
+    }
+    std::cout << args[1] << ": " << num_rows << " x " << num_cols << '\n';
+    return EXIT_SUCCESS;
+}
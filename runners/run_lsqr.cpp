@@ -1,5 +1,11 @@
+#include <algorithm>
 #include <cstdlib>
+#include <functional>
+#include <iomanip>
 #include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
 #include <vector>
 
 
@@ -23,6 +29,10 @@ int precision_parser(std::string prec, std::string prec_in)
         return 5;
     } else if ((prec.compare("fp32") == 0) && (prec_in.compare("fp16") == 0)) {
         return 6;
+    } else if ((prec.compare("fp64") == 0) && (prec_in.compare("bf16") == 0)) {
+        return 7;
+    } else if ((prec.compare("fp32") == 0) && (prec_in.compare("bf16") == 0)) {
+        return 8;
     }
     return -1;
 }
@@ -33,6 +43,7 @@ struct lsqr {
     magma_int_t num_rows = 0;
     magma_int_t num_cols = 0;
     magma_int_t sampled_rows = 0;
+    magma_int_t num_rhs = 1;
     magma_int_t max_iter = num_rows;
     magma_int_t iter = 0;
     magma_int_t argc = 0;
@@ -42,6 +53,13 @@ struct lsqr {
     void* dmtx = nullptr;
     void* sol = nullptr;
     void* init_sol = nullptr;
+    void* warm_sol = nullptr;
+    // Initial guess of the next solve: warm_sol, or the previous solution on
+    // a regularization path.
+    void* guess = nullptr;
+    void* path_sol = nullptr;
+    void* base_precond = nullptr;
+    magma_int_t base_rows = 0;
     void* rhs = nullptr;
     void* precond_mtx = nullptr;
     double sampling_coeff = 1.01;
@@ -55,19 +73,93 @@ struct lsqr {
     double t_total_avg = 0.0;
     double t_mm_avg = 0.0;
     double t_qr_avg = 0.0;
+    // t_qr of every level of the tsqr tree, leaves first.
+    std::vector<double> t_qr_levels_avg;
+    // t_qr of cholqr2 split into the Gram and factor phases.
+    double t_qr_gram_avg = 0.0;
+    double t_qr_factor_avg = 0.0;
     double tol = 1e-6;
+    double damp = 0.0;
+    std::vector<double> damp_path;
+    std::vector<magma_int_t> path_iters;
+    std::vector<double> path_times;
+    std::vector<double> path_relres;
     double relres_norm = 0.0;
     double relres_norm_avg = 0.0;
     bool use_precond = false;
+    bool sparse = false;
+    void* sparse_mtx = nullptr;
+    rls::sketch_type sketch = rls::sketch_type::gaussian;
+    magma_int_t sketch_nnz = 8;
+    bool auto_sketch = false;
+    bool sketch_solve = false;
+    bool sketch_warm_start = false;
+    // Sketch A from its file in row panels instead of from memory.
+    bool stream = false;
+    magma_int_t panel_rows = 0;
+    // Leave A in its file and let LSQR read it in row panels too.
+    bool panelled = false;
+    void* panelled_mtx = nullptr;
+    bool refine = false;
+    rls::solver::refine::refinement refinement_info;
+    rls::utils::sketch_selection selection;
+    rls::solver::lsqr::convergence convergence_info;
+    void* solver_ws = nullptr;
+    std::function<void()> free_solver_ws;
     std::string filename_out;
     std::vector<std::string> args;
+    std::map<std::string, std::string> options;
+
+    void parse_options();
+
+    std::string option(std::string name, std::string default_value);
 
     void run();
 
+    void run_once();
+
+    void load();
+
     void dispatch_preconditioner();
 
     void dispatch_solver();
 
+    void solve_path();
+
+    void unload();
+
+    template <typename value_type>
+    void load_problem();
+
+    template <typename value_type>
+    void load_warm_start();
+
+    template <typename value_type_in, typename value_type>
+    void precondition();
+
+    template <typename workspace_type>
+    workspace_type* solver_workspace();
+
+    template <typename value_type_in, typename value_type>
+    void solve();
+
+    template <typename value_type_in, typename value_type>
+    void solve_block();
+
+    template <typename value_type_in>
+    void solve_refined();
+
+    template <typename value_type>
+    void check_sketch_solution();
+
+    template <typename value_type>
+    void next_damp(std::size_t index);
+
+    template <typename value_type>
+    void free_problem();
+
+    std::string sketch_name();
+
     void print_runtime_info();
 
     void write_output();
@@ -77,88 +169,280 @@ struct lsqr {
     void finalize();
 };
 
-// Selects the version of the preconditioner to be used.
-void lsqr::dispatch_preconditioner()
+// Parses the optional "--name value" pairs that follow the positional
+// arguments.
+void lsqr::parse_options()
 {
-    auto first_index = 1;
-    std::string filename_mtx = args[first_index + 4];
-    std::string filename_rhs = args[first_index + 5];
-    std::cout << "  filename_mtx: " << filename_mtx << '\n';
-    std::cout << "  filename_rhs: " << filename_rhs << '\n';
-    std::cout << "sampling_coeff: " << sampling_coeff << '\n';
+    auto first_index = 12;
+    for (auto i = first_index; i + 1 < (int)args.size(); i += 2) {
+        if (args[i].compare(0, 2, "--") != 0) {
+            std::cout << "Ignoring unexpected argument: " << args[i] << '\n';
+            i -= 1;
+            continue;
+        }
+        options[args[i].substr(2)] = args[i + 1];
+    }
+}
+
+// Returns the value of an optional argument or default_value if unset.
+std::string lsqr::option(std::string name, std::string default_value)
+{
+    auto it = options.find(name);
+    return (it == options.end()) ? default_value : it->second;
+}
 
+// Reads the problem once; it is reused by every warmup and timed run.
+void lsqr::load()
+{
+    auto first_index = 1;
+    std::cout << "  filename_mtx: " << args[first_index + 4] << '\n';
+    std::cout << "  filename_rhs: " << args[first_index + 5] << '\n';
     if (args[first_index + 6].compare("precond") == 0) {
         use_precond = true;
+        auto_sketch = (args[first_index + 7].compare("auto") == 0);
         sampling_coeff = std::atof(args[first_index + 7].c_str());
     }
+    std::cout << "sampling_coeff: " << sampling_coeff << '\n';
+    if (option("sketch", "gaussian").compare("srht") == 0) {
+        sketch = rls::sketch_type::srht;
+    } else if (option("sketch", "gaussian").compare("sparse_sign") == 0) {
+        sketch = rls::sketch_type::sparse_sign;
+        sketch_nnz = std::atoi(option("sketch_nnz", "8").c_str());
+    } else if (option("sketch", "gaussian").compare("countsketch") == 0) {
+        sketch = rls::sketch_type::sparse_sign;
+        sketch_nnz = 1;
+    }
+    if (option("qr", "householder").compare("tsqr") == 0) {
+        magma_config.qr.type = rls::qr_type::tsqr;
+        magma_config.qr.block_size =
+            std::atoi(option("qr_block_size", "0").c_str());
+    }
+    if (option("qr", "householder").compare("cholqr2") == 0) {
+        magma_config.qr.type = rls::qr_type::cholqr2;
+    }
+    selection.target_cond = std::atof(option("target_cond", "10").c_str());
+    selection.choose_sketch = (options.count("sketch") == 0);
+    selection.sketch = sketch;
+    damp = std::atof(option("damp", "0").c_str());
+    std::stringstream path_values(option("damp_path", ""));
+    std::string value;
+    while (std::getline(path_values, value, ',')) {
+        damp_path.push_back(std::atof(value.c_str()));
+    }
+    sketch_solve = (option("sketch_solve", "off").compare("on") == 0);
+    sketch_warm_start = (option("sketch_solve", "off").compare("warm") == 0);
+    if ((sketch_solve || sketch_warm_start) && (auto_sketch || !use_precond)) {
+        std::cout << "--sketch_solve needs a numeric sampling coefficient, "
+                     "running LSQR\n";
+        sketch_solve = false;
+        sketch_warm_start = false;
+    }
+    stream = (option("stream", "off").compare("on") == 0);
+    panel_rows = std::atoi(option("panel_rows", "0").c_str());
+    if (stream && (auto_sketch || sketch_solve || sketch_warm_start)) {
+        std::cout << "--stream needs a numeric sampling coefficient and no "
+                     "--sketch_solve, sketching from memory\n";
+        stream = false;
+    }
+    panelled = stream && !sparse && use_precond &&
+               (magma_config.exec == rls::detail::backend::host) &&
+               (option("solver", "lsqr").compare("lsqr") == 0) &&
+               (option("refine", "off").compare("on") != 0);
+    // srht mixes all rows of A, so it is replaced where A is sketched by rows.
+    if ((sketch == rls::sketch_type::srht) && (sparse || stream)) {
+        std::cout << "srht is not supported for "
+                  << (sparse ? "sparse matrices" : "--stream")
+                  << ", using a gaussian sketch\n";
+        sketch = rls::sketch_type::gaussian;
+        selection.sketch = sketch;
+    }
+    if ((damp != 0.0) && sketch_solve) {
+        std::cout << "--damp is not supported by --sketch_solve on, running "
+                     "damped LSQR\n";
+        sketch_solve = false;
+    }
 
+    if (args[first_index].compare("fp64") == 0) {
+        load_problem<double>();
+    } else {
+        load_problem<float>();
+    }
+    if (!damp_path.empty() && (sketch_solve || !use_precond)) {
+        std::cout << "--damp_path needs the preconditioner and LSQR or LSMR, "
+                     "ignoring\n";
+        damp_path.clear();
+    }
+    refine = (option("refine", "off").compare("on") == 0);
+    if (refine &&
+        ((args[first_index].compare("fp64") != 0) ||
+         (args[first_index + 2].compare("fp32") != 0) || sparse ||
+         (num_rhs > 1) || !use_precond || sketch_solve || (damp != 0.0) ||
+         !damp_path.empty())) {
+        std::cout << "--refine needs a dense problem with one rhs, a fp64 "
+                     "preconditioner, a fp32 solver and no --damp, ignoring\n";
+        refine = false;
+    }
+    if (num_rhs > 1) {
+        if ((damp != 0.0) || !damp_path.empty()) {
+            std::cout << "--damp is not supported by block LSQR, ignoring\n";
+            damp = 0.0;
+            damp_path.clear();
+        }
+        sketch_warm_start = false;
+        return;
+    }
+    if (args[first_index].compare("fp64") == 0) {
+        load_warm_start<double>();
+    } else {
+        load_warm_start<float>();
+    }
+    guess = warm_sol;
+}
+
+template <typename value_type>
+void lsqr::load_problem()
+{
+    std::string filename_mtx = args[5];
+    std::string filename_rhs = args[6];
+    if (sparse) {
+        auto mtx = new rls::matrix::sparse<value_type, magma_int_t>();
+        rls::utils::load(filename_mtx, filename_rhs, mtx,
+                         (value_type**)&init_sol, (value_type**)&sol,
+                         (value_type**)&rhs, magma_config);
+        num_rows = mtx->num_rows;
+        num_cols = mtx->num_cols;
+        sparse_mtx = mtx;
+        return;
+    }
+    if (panelled) {
+        auto mtx = new rls::matrix::panelled<value_type, magma_int_t>();
+        rls::utils::load(filename_mtx, filename_rhs, panel_rows, mtx,
+                         (value_type**)&init_sol, (value_type**)&sol,
+                         (value_type**)&rhs, magma_config);
+        num_rows = mtx->num_rows;
+        num_cols = mtx->num_cols;
+        panelled_mtx = mtx;
+        return;
+    }
+    rls::utils::load(filename_mtx, filename_rhs, &num_rows, &num_cols,
+                     (value_type**)&mtx, (value_type**)&dmtx,
+                     (value_type**)&init_sol, (value_type**)&sol,
+                     (value_type**)&rhs, magma_config, &num_rhs);
+}
+
+// Reads the initial guess of --init_sol, or allocates the buffer for the
+// sketch-and-solve warm start.
+template <typename value_type>
+void lsqr::load_warm_start()
+{
+    if (sketch_warm_start) {
+        rls::memory::malloc((value_type**)&warm_sol, num_cols);
+    } else if (options.count("init_sol") > 0) {
+        rls::utils::load_initial_guess(options["init_sol"], num_cols,
+                                       (value_type**)&warm_sol, magma_config);
+    }
+}
+
+// Selects the version of the preconditioner to be used.
+void lsqr::dispatch_preconditioner()
+{
+    auto first_index = 1;
     switch (precision_parser(args[first_index], args[first_index + 1])) {
     case 0:
-        rls::utils::initialize_with_precond<double, double, int>(
-            filename_mtx, filename_rhs, &num_rows, &num_cols, (double**)&mtx,
-            (double**)&dmtx, (double**)&init_sol, (double**)&sol,
-            (double**)&rhs, sampling_coeff, &sampled_rows,
-            (double**)&precond_mtx, magma_config, &t_precond, &t_mm, &t_qr);
+        precondition<double, double>();
         break;
-
     case 1:
-        rls::utils::initialize_with_precond<float, double, int>(
-            filename_mtx, filename_rhs, &num_rows, &num_cols, (double**)&mtx,
-            (double**)&dmtx, (double**)&init_sol, (double**)&sol,
-            (double**)&rhs, sampling_coeff, &sampled_rows,
-            (double**)&precond_mtx, magma_config, &t_precond, &t_mm, &t_qr);
+        precondition<float, double>();
         break;
-
     case 2:
         rls::detail::use_tf32_math_operations(magma_config);
-        rls::utils::initialize_with_precond<float, double, int>(
-            filename_mtx, filename_rhs, &num_rows, &num_cols, (double**)&mtx,
-            (double**)&dmtx, (double**)&init_sol, (double**)&sol, (double**)&rhs,
-            sampling_coeff, &sampled_rows, (double**)&precond_mtx, magma_config,
-            &t_precond, &t_mm, &t_qr);
+        precondition<float, double>();
         rls::detail::disable_tf32_math_operations(magma_config);
         break;
-
     case 3:
-        rls::utils::initialize_with_precond<__half, double, int>(
-            filename_mtx, filename_rhs, &num_rows, &num_cols, (double**)&mtx,
-            (double**)&dmtx, (double**)&init_sol, (double**)&sol,
-            (double**)&rhs, sampling_coeff, &sampled_rows,
-            (double**)&precond_mtx, magma_config, &t_precond, &t_mm, &t_qr);
+        precondition<__half, double>();
         break;
-
     case 4:
-        rls::utils::initialize_with_precond<float, float, int>(
-            filename_mtx, filename_rhs, &num_rows, &num_cols, (float**)&mtx,
-            (float**)&dmtx, (float**)&init_sol, (float**)&sol, (float**)&rhs,
-            sampling_coeff, &sampled_rows, (float**)&precond_mtx, magma_config,
-            &t_precond, &t_mm, &t_qr);
+        precondition<float, float>();
         break;
-
     case 5:
         rls::detail::use_tf32_math_operations(magma_config);
-        rls::utils::initialize_with_precond<float, float, int>(
-            filename_mtx, filename_rhs, &num_rows, &num_cols, (float**)&mtx,
-            (float**)&dmtx, (float**)&init_sol, (float**)&sol, (float**)&rhs,
-            sampling_coeff, &sampled_rows, (float**)&precond_mtx, magma_config,
-            &t_precond, &t_mm, &t_qr);
+        precondition<float, float>();
         rls::detail::disable_tf32_math_operations(magma_config);
         break;
-
     case 6:
-        rls::utils::initialize_with_precond<__half, float, int>(
-            filename_mtx, filename_rhs, &num_rows, &num_cols, (float**)&mtx,
-            (float**)&dmtx, (float**)&init_sol, (float**)&sol, (float**)&rhs,
-            sampling_coeff, &sampled_rows, (float**)&precond_mtx, magma_config,
-            &t_precond, &t_mm, &t_qr);
+        precondition<__half, float>();
+        break;
+    case 7:
+        precondition<__nv_bfloat16, double>();
+        break;
+    case 8:
+        precondition<__nv_bfloat16, float>();
         break;
-
     default:
         std::cout << "Exitting without running lsqr." << '\n';
         break;
     }
 }
 
+// Computes the preconditioner into precond_mtx, which is allocated by the
+// first call and overwritten by the following ones.
+template <typename value_type_in, typename value_type>
+void lsqr::precondition()
+{
+    typedef rls::matrix::sparse<value_type, magma_int_t> sparse_type;
+    if (sketch_solve || sketch_warm_start) {
+        auto sketch_sol = (value_type*)(sketch_solve ? sol : warm_sol);
+        if (sparse) {
+            rls::utils::sketch_and_solve<value_type_in>(
+                (sparse_type*)sparse_mtx, (value_type*)rhs, sampling_coeff,
+                &sampled_rows, (value_type**)&precond_mtx, sketch_sol,
+                magma_config, &t_precond, &t_mm, &t_qr, sketch, sketch_nnz);
+        } else {
+            rls::utils::sketch_and_solve<value_type_in>(
+                num_rows, num_cols, (value_type*)dmtx, (value_type*)rhs,
+                sampling_coeff, &sampled_rows, (value_type**)&precond_mtx,
+                sketch_sol, magma_config, &t_precond, &t_mm, &t_qr, sketch,
+                sketch_nnz);
+        }
+        return;
+    }
+    if (auto_sketch) {
+        if (sparse) {
+            rls::utils::precondition_auto<value_type_in>(
+                (sparse_type*)sparse_mtx,
+                selection, &sampled_rows, (value_type**)&precond_mtx,
+                magma_config, &t_precond, &t_mm, &t_qr, sketch_nnz, damp);
+        } else {
+            rls::utils::precondition_auto<value_type_in>(
+                num_rows, num_cols, (value_type*)dmtx, selection,
+                &sampled_rows, (value_type**)&precond_mtx, magma_config,
+                &t_precond, &t_mm, &t_qr, sketch_nnz, damp);
+        }
+        sampling_coeff = selection.sampling_coeff;
+        sketch = selection.sketch;
+        return;
+    }
+    if (stream && !sparse) {
+        rls::utils::precondition<value_type_in>(
+            args[5], panel_rows, sampling_coeff, &sampled_rows,
+            (value_type**)&precond_mtx, magma_config, &t_precond, &t_mm,
+            &t_qr, sketch, sketch_nnz, damp);
+        return;
+    }
+    if (sparse) {
+        rls::utils::precondition<value_type_in>(
+            (sparse_type*)sparse_mtx, sampling_coeff, &sampled_rows,
+            (value_type**)&precond_mtx, magma_config, &t_precond, &t_mm,
+            &t_qr, sketch, sketch_nnz, damp);
+        return;
+    }
+    rls::utils::precondition<value_type_in>(
+        num_rows, num_cols, (value_type*)dmtx, sampling_coeff, &sampled_rows,
+        (value_type**)&precond_mtx, magma_config, &t_precond, &t_mm, &t_qr,
+        sketch, sketch_nnz, damp);
+}
+
 // Selects the version of the solver to be used.
 void lsqr::dispatch_solver()
 {
@@ -167,86 +451,344 @@ void lsqr::dispatch_solver()
     iter = 0;
     tol = std::atof(args[0].c_str());
     relres_norm = 0.0;
+    convergence_info.res_check_interval =
+        std::atoi(option("res_check", "0").c_str());
+    if (refine) {
+        // The problem is in double; the solver precisions are those of the
+        // correction solves.
+        if (args[first_index + 1].compare("fp16") == 0) {
+            solve_refined<__half>();
+        } else if (args[first_index + 1].compare("bf16") == 0) {
+            solve_refined<__nv_bfloat16>();
+        } else {
+            if (args[first_index + 1].compare("tf32") == 0) {
+                rls::detail::use_tf32_math_operations(magma_config);
+            }
+            solve_refined<float>();
+            rls::detail::disable_tf32_math_operations(magma_config);
+        }
+        return;
+    }
     switch (precision_parser(args[first_index], args[first_index + 1])) {
     case 0:
-        rls::solver::lsqr::run<double>(
-            num_rows, num_cols, (double*)dmtx, (double*)rhs, (double*)init_sol,
-            (double*)sol, max_iter, &iter, tol, &relres_norm,
-            (double*)precond_mtx, sampled_rows, magma_config.queue, &t_solve);
-        rls::utils::finalize_with_precond(
-            (double*)mtx, (double*)dmtx, (double*)init_sol, (double*)sol,
-            (double*)rhs, (double*)precond_mtx, magma_config);
+        solve<double, double>();
         break;
     case 1:
-        rls::solver::lsqr::run<float>(
-            num_rows, num_cols, (double*)dmtx, (double*)rhs, (double*)init_sol,
-            (double*)sol, max_iter, &iter, tol, &relres_norm,
-            (double*)precond_mtx, sampled_rows, magma_config.queue, &t_solve);
-        rls::utils::finalize_with_precond(
-            (double*)mtx, (double*)dmtx, (double*)init_sol, (double*)sol,
-            (double*)rhs, (double*)precond_mtx, magma_config);
+        solve<float, double>();
         break;
-
     case 2:
         rls::detail::use_tf32_math_operations(magma_config);
-        rls::solver::lsqr::run<float>(
-            num_rows, num_cols, (double*)dmtx, (double*)rhs, (double*)init_sol,
-            (double*)sol, max_iter, &iter, tol, &relres_norm,
-            (double*)precond_mtx, sampled_rows, magma_config.queue, &t_solve);
+        solve<float, double>();
         rls::detail::disable_tf32_math_operations(magma_config);
-        rls::utils::finalize_with_precond(
-            (double*)mtx, (double*)dmtx, (double*)init_sol, (double*)sol,
-            (double*)rhs, (double*)precond_mtx, magma_config);
         break;
-
     case 3:
-        rls::solver::lsqr::run<__half>(
-            num_rows, num_cols, (double*)dmtx, (double*)rhs, (double*)init_sol,
-            (double*)sol, max_iter, &iter, tol, &relres_norm,
-            (double*)precond_mtx, sampled_rows, magma_config.queue, &t_solve);
-        rls::utils::finalize_with_precond(
-            (double*)mtx, (double*)dmtx, (double*)init_sol, (double*)sol,
-            (double*)rhs, (double*)precond_mtx, magma_config);
+        solve<__half, double>();
         break;
-
     case 4:
-        rls::solver::lsqr::run<float, float, magma_int_t>(
-            num_rows, num_cols, (float*)dmtx, (float*)rhs, (float*)init_sol,
-            (float*)sol, max_iter, &iter, tol, &relres_norm,
-            (float*)precond_mtx, sampled_rows, magma_config.queue, &t_solve);
-        rls::utils::finalize_with_precond(
-            (float*)mtx, (float*)dmtx, (float*)init_sol, (float*)sol,
-            (float*)rhs, (float*)precond_mtx, magma_config);
+        solve<float, float>();
         break;
-
     case 5:
         rls::detail::use_tf32_math_operations(magma_config);
-        rls::solver::lsqr::run<float, float, magma_int_t>(
-            num_rows, num_cols, (float*)dmtx, (float*)rhs, (float*)init_sol,
-            (float*)sol, max_iter, &iter, tol, &relres_norm,
-            (float*)precond_mtx, sampled_rows, magma_config.queue, &t_solve);
+        solve<float, float>();
         rls::detail::disable_tf32_math_operations(magma_config);
-        rls::utils::finalize_with_precond(
-            (float*)mtx, (float*)dmtx, (float*)init_sol, (float*)sol,
-            (float*)rhs, (float*)precond_mtx, magma_config);
         break;
-
     case 6:
-        rls::solver::lsqr::run<__half, float, magma_int_t>(
-            num_rows, num_cols, (float*)dmtx, (float*)rhs, (float*)init_sol,
-            (float*)sol, max_iter, &iter, tol, &relres_norm,
-            (float*)precond_mtx, sampled_rows, magma_config.queue, &t_solve);
-        rls::utils::finalize_with_precond(
-            (float*)mtx, (float*)dmtx, (float*)init_sol, (float*)sol,
-            (float*)rhs, (float*)precond_mtx, magma_config);
+        solve<__half, float>();
+        break;
+    case 7:
+        solve<__nv_bfloat16, double>();
+        break;
+    case 8:
+        solve<__nv_bfloat16, float>();
         break;
-
     default:
         std::cout << "No option specified for solver.\n";
         break;
     }
 }
 
+// Returns the solver workspace, which is created by the first solve and
+// reused by the others.
+template <typename workspace_type>
+workspace_type* lsqr::solver_workspace()
+{
+    if (solver_ws == nullptr) {
+        auto new_ws = new workspace_type();
+        solver_ws = new_ws;
+        free_solver_ws = [new_ws]() {
+            new_ws->free();
+            delete new_ws;
+        };
+    }
+    return (workspace_type*)solver_ws;
+}
+
+// Solves the loaded problem with LSQR or LSMR (--solver), or block LSQR if
+// the rhs file has several columns. The single rhs solvers start from guess,
+// if any, and from zero otherwise.
+template <typename value_type_in, typename value_type>
+void lsqr::solve()
+{
+    typedef rls::matrix::sparse<value_type, magma_int_t> sparse_type;
+    typedef rls::matrix::panelled<value_type, magma_int_t> panelled_type;
+    if (sketch_solve) {
+        check_sketch_solution<value_type>();
+        return;
+    }
+    rls::utils::reset_solution(num_cols * num_rhs, (value_type*)init_sol,
+                               (value_type*)sol, magma_config);
+    if (guess != nullptr) {
+        rls::blas::copy(num_cols, (value_type*)guess, 1, (value_type*)init_sol,
+                        1, magma_config.queue);
+    }
+    if (num_rhs > 1) {
+        solve_block<value_type_in, value_type>();
+        return;
+    }
+    if (option("solver", "lsqr").compare("lsmr") == 0) {
+        auto ws = solver_workspace<rls::solver::lsmr::workspace<
+            value_type_in, value_type, magma_int_t>>();
+        if (sparse) {
+            rls::solver::lsmr::run<value_type_in>(
+                (sparse_type*)sparse_mtx, (value_type*)rhs,
+                (value_type*)init_sol, (value_type*)sol, max_iter, &iter,
+                (value_type)tol, &relres_norm, (value_type*)precond_mtx,
+                sampled_rows, magma_config.queue, &t_solve, &convergence_info,
+                ws, (value_type)damp);
+            return;
+        }
+        rls::solver::lsmr::run<value_type_in, value_type, magma_int_t>(
+            num_rows, num_cols, (value_type*)dmtx, (value_type*)rhs,
+            (value_type*)init_sol, (value_type*)sol, max_iter, &iter,
+            (value_type)tol, &relres_norm, (value_type*)precond_mtx,
+            sampled_rows, magma_config.queue, &t_solve, &convergence_info, ws,
+            (value_type)damp);
+        return;
+    }
+
+    auto ws = solver_workspace<rls::solver::lsqr::workspace<
+        value_type_in, value_type, magma_int_t>>();
+    if (sparse) {
+        rls::solver::lsqr::run<value_type_in>(
+            (sparse_type*)sparse_mtx, (value_type*)rhs, (value_type*)init_sol,
+            (value_type*)sol, max_iter, &iter, (value_type)tol, &relres_norm,
+            (value_type*)precond_mtx, sampled_rows, magma_config.queue,
+            &t_solve, &convergence_info, ws, (value_type)damp);
+        return;
+    }
+    if (panelled) {
+        rls::solver::lsqr::run<value_type_in>(
+            (panelled_type*)panelled_mtx, (value_type*)rhs,
+            (value_type*)init_sol, (value_type*)sol, max_iter, &iter,
+            (value_type)tol, &relres_norm, (value_type*)precond_mtx,
+            sampled_rows, magma_config.queue, &t_solve, &convergence_info, ws,
+            (value_type)damp);
+        return;
+    }
+    rls::solver::lsqr::run<value_type_in, value_type, magma_int_t>(
+        num_rows, num_cols, (value_type*)dmtx, (value_type*)rhs,
+        (value_type*)init_sol, (value_type*)sol, max_iter, &iter,
+        (value_type)tol, &relres_norm, (value_type*)precond_mtx, sampled_rows,
+        magma_config.queue, &t_solve, &convergence_info, ws, (value_type)damp);
+}
+
+// Solves for all columns of rhs at once. Reports the largest relative
+// residual and iteration count over the columns and the convergence
+// information of the column with the largest residual.
+template <typename value_type_in, typename value_type>
+void lsqr::solve_block()
+{
+    auto ws = solver_workspace<rls::solver::block_lsqr::workspace<
+        value_type_in, value_type, magma_int_t>>();
+    std::vector<magma_int_t> iters(num_rhs);
+    std::vector<double> relres(num_rhs);
+    std::vector<rls::solver::lsqr::convergence> info(num_rhs);
+    rls::solver::block_lsqr::run<value_type_in, value_type, magma_int_t>(
+        num_rows, num_cols, num_rhs, (value_type*)dmtx, (value_type*)rhs,
+        (value_type*)sol, max_iter, iters.data(), (value_type)tol,
+        relres.data(), (value_type*)precond_mtx, sampled_rows,
+        magma_config.queue, &t_solve, info.data(), ws);
+    auto worst = std::max_element(relres.begin(), relres.end()) -
+                 relres.begin();
+    relres_norm = relres[worst];
+    iter = *std::max_element(iters.begin(), iters.end());
+    convergence_info = info[worst];
+}
+
+// Solves the double problem by mixed precision iterative refinement, with the
+// correction solves in single precision and the matrix in value_type_in.
+template <typename value_type_in>
+void lsqr::solve_refined()
+{
+    rls::utils::reset_solution(num_cols, (double*)init_sol, (double*)sol,
+                               magma_config);
+    if (guess != nullptr) {
+        rls::blas::copy(num_cols, (double*)guess, 1, (double*)init_sol, 1,
+                        magma_config.queue);
+    }
+    auto ws = solver_workspace<rls::solver::refine::workspace<
+        value_type_in, float, magma_int_t>>();
+    refinement_info.inner_tol = std::atof(option("inner_tol", "1e-4").c_str());
+    rls::solver::refine::run<value_type_in, float, magma_int_t>(
+        num_rows, num_cols, (double*)dmtx, (double*)rhs, (double*)init_sol,
+        (double*)sol, max_iter, &iter, tol, &relres_norm,
+        (double*)precond_mtx, sampled_rows, magma_config.queue, &t_solve,
+        &refinement_info, ws);
+    convergence_info = rls::solver::lsqr::convergence();
+    convergence_info.reason = refinement_info.reason;
+}
+
+// Reports the residual of the sketch-and-solve solution computed with the
+// preconditioner; no iterations are run.
+template <typename value_type>
+void lsqr::check_sketch_solution()
+{
+    typedef rls::matrix::sparse<value_type, magma_int_t> sparse_type;
+    value_type* res_vector = nullptr;
+    rls::memory::malloc(&res_vector, num_rows);
+    auto t = rls::detail::sync_wtime(magma_config.queue);
+    if (sparse) {
+        relres_norm = rls::solver::lsqr::true_relres(
+            num_rows, num_cols, (sparse_type*)sparse_mtx, (value_type*)rhs,
+            (value_type*)sol, res_vector, magma_config.queue);
+    } else {
+        relres_norm = rls::solver::lsqr::true_relres(
+            num_rows, num_cols, (value_type*)dmtx, (value_type*)rhs,
+            (value_type*)sol, res_vector, magma_config.queue);
+    }
+    t_solve = rls::detail::sync_wtime(magma_config.queue) - t;
+    rls::memory::free(res_vector);
+    iter = 0;
+    convergence_info = rls::solver::lsqr::convergence();
+}
+
+// Solves the ridge problem for every damp of --damp_path. A is sketched once;
+// each damp only re-factorizes the small R factor and starts from the
+// solution of the previous one. t_solve sums the solves of the path.
+void lsqr::solve_path()
+{
+    damp = 0.0;
+    dispatch_preconditioner();
+    path_iters.clear();
+    path_times.clear();
+    path_relres.clear();
+    double t_path_solve = 0.0;
+    for (std::size_t k = 0; k < damp_path.size(); k++) {
+        auto t_start = t_precond;
+        if (args[1].compare("fp64") == 0) {
+            next_damp<double>(k);
+        } else {
+            next_damp<float>(k);
+        }
+        dispatch_solver();
+        path_iters.push_back(iter);
+        path_times.push_back(t_precond - t_start + t_solve);
+        path_relres.push_back(relres_norm);
+        t_path_solve += t_solve;
+    }
+    t_solve = t_path_solve;
+}
+
+// Prepares solve k of the path: keeps the undamped R factor before the first
+// damp and the previous solution before the others, then builds the
+// preconditioner for damp_path[k].
+template <typename value_type>
+void lsqr::next_damp(std::size_t index)
+{
+    if (index == 0) {
+        if ((base_precond != nullptr) && (base_rows < sampled_rows)) {
+            rls::memory::free((value_type*)base_precond);
+            base_precond = nullptr;
+        }
+        if (base_precond == nullptr) {
+            rls::memory::malloc((value_type**)&base_precond,
+                                sampled_rows * num_cols);
+            base_rows = sampled_rows;
+        }
+        rls::blas::copy(sampled_rows * num_cols, (value_type*)precond_mtx, 1,
+                        (value_type*)base_precond, 1, magma_config.queue);
+        guess = warm_sol;
+    } else {
+        if (path_sol == nullptr) {
+            rls::memory::malloc((value_type**)&path_sol, num_cols);
+        }
+        rls::blas::copy(num_cols, (value_type*)sol, 1, (value_type*)path_sol,
+                        1, magma_config.queue);
+        guess = path_sol;
+    }
+    damp = damp_path[index];
+    rls::utils::redamp(num_cols, sampled_rows, (value_type*)base_precond,
+                       (value_type*)precond_mtx, damp, magma_config,
+                       &t_precond, &t_qr, sketch);
+}
+
+// Frees the buffers allocated by load, the preconditioner and the solver.
+void lsqr::unload()
+{
+    if (solver_ws != nullptr) {
+        free_solver_ws();
+        solver_ws = nullptr;
+    }
+    if (args[1].compare("fp64") == 0) {
+        free_problem<double>();
+    } else {
+        free_problem<float>();
+    }
+}
+
+template <typename value_type>
+void lsqr::free_problem()
+{
+    if (sparse) {
+        auto mtx = (rls::matrix::sparse<value_type, magma_int_t>*)sparse_mtx;
+        rls::utils::finalize_with_precond(
+            mtx, (value_type*)init_sol, (value_type*)sol, (value_type*)rhs,
+            (value_type*)precond_mtx, magma_config);
+        delete mtx;
+        sparse_mtx = nullptr;
+    } else if (panelled) {
+        auto mtx =
+            (rls::matrix::panelled<value_type, magma_int_t>*)panelled_mtx;
+        rls::utils::finalize_with_precond(
+            mtx, (value_type*)init_sol, (value_type*)sol, (value_type*)rhs,
+            (value_type*)precond_mtx, magma_config);
+        delete mtx;
+        panelled_mtx = nullptr;
+    } else {
+        rls::utils::finalize_with_precond(
+            (value_type*)mtx, (value_type*)dmtx, (value_type*)init_sol,
+            (value_type*)sol, (value_type*)rhs, (value_type*)precond_mtx,
+            magma_config);
+        mtx = nullptr;
+        dmtx = nullptr;
+    }
+    for (auto buffer : {warm_sol, path_sol, base_precond}) {
+        if (buffer != nullptr) {
+            rls::memory::free((value_type*)buffer);
+        }
+    }
+    init_sol = nullptr;
+    warm_sol = nullptr;
+    guess = nullptr;
+    path_sol = nullptr;
+    base_precond = nullptr;
+    base_rows = 0;
+    sol = nullptr;
+    rhs = nullptr;
+    precond_mtx = nullptr;
+}
+
+// Returns the name of the sketch in use, as given to --sketch.
+std::string lsqr::sketch_name()
+{
+    if (sketch == rls::sketch_type::srht) {
+        return "srht";
+    } else if (sketch == rls::sketch_type::sparse_sign) {
+        return (sketch_nnz == 1) ? "countsketch" : "sparse_sign";
+    }
+    return "gaussian";
+}
+
 void lsqr::print_runtime_info()
 {
     std::cout << "inputs:" << '\n';
@@ -257,7 +799,30 @@ void lsqr::print_runtime_info()
     std::cout << " solver internal precision: " << args[4] << '\n';
     std::cout << "                    matrix: " << args[5] << '\n';
     std::cout << "                       rhs: " << args[6] << '\n';
-    std::cout << "      sampling coefficient: " << sampling_coeff << '\n'
+    std::cout << "      sampling coefficient: " << sampling_coeff << '\n';
+    std::cout << "                    sketch: " << sketch_name() << '\n';
+    std::cout << "                        qr: "
+              << option("qr", "householder") << '\n';
+    if (damp_path.empty()) {
+        std::cout << "                      damp: " << damp << '\n';
+    } else {
+        std::cout << "                 damp path: " << damp_path.size()
+                  << " values\n";
+    }
+    std::cout << "                    solver: "
+              << (sketch_solve ? "sketch_solve"
+                  : (num_rhs > 1) ? "block_lsqr"
+                  : refine        ? "refine"
+                                  : option("solver", "lsqr"))
+              << '\n';
+    std::cout << "             initial guess: "
+              << (sketch_warm_start ? "sketch_solve"
+                  : (options.count("init_sol") > 0) ? options["init_sol"]
+                                                    : "zero")
+              << '\n';
+    std::cout << "          right-hand sides: " << num_rhs << '\n';
+    std::cout << "                   backend: " << option("backend", "cuda")
+              << '\n'
               << '\n';
 
     std::cout << "runtimes:\n";
@@ -269,10 +834,54 @@ void lsqr::print_runtime_info()
     std::cout << "            total time_avg: " << t_total_avg << '\n';
     std::cout << "                  t_mm_avg: " << t_mm_avg << '\n';
     std::cout << "                  t_qr_avg: " << t_qr_avg << '\n';
+    for (std::size_t level = 0; level < t_qr_levels_avg.size(); level++) {
+        std::cout << std::setw(26)
+                  << ("t_qr level " + std::to_string(level) + " avg")
+                  << ": " << t_qr_levels_avg[level] << '\n';
+    }
+    if (magma_config.qr.type == rls::qr_type::cholqr2) {
+        std::cout << "             t_qr gram avg: " << t_qr_gram_avg << '\n';
+        std::cout << "           t_qr factor avg: " << t_qr_factor_avg
+                  << '\n';
+    }
     std::cout << "                      iter: " << iter << '\n';
     std::cout << "                relres_avg: " << relres_norm_avg << '\n';
+    std::cout << "               stop reason: "
+              << rls::solver::lsqr::to_string(convergence_info.reason) << '\n';
+    std::cout << "        residual norm est.: " << convergence_info.rnorm
+              << '\n';
+    std::cout << "  normal eq. residual est.: " << convergence_info.arnorm
+              << '\n';
+    std::cout << "         ||A R^-1||_F est.: " << convergence_info.anorm
+              << '\n';
+    std::cout << "         cond(A R^-1) est.: " << convergence_info.acond
+              << '\n';
+    if (refine) {
+        std::cout << "          refinement steps: " << refinement_info.steps
+                  << '\n';
+        std::cout << "   ||A^T r|| / ||A|| ||r||: "
+                  << refinement_info.normal_resnorm << '\n';
+    }
     std::cout << "      sampling coefficient: " << sampling_coeff << '\n';
     std::cout << "              sampled rows: " << sampled_rows << '\n';
+    if (auto_sketch) {
+        std::cout << "       target cond(A R^-1): " << selection.target_cond
+                  << '\n';
+        std::cout << "          sketch cond est.: " << selection.cond
+                  << '\n';
+        std::cout << "           sketch attempts: " << selection.attempts
+                  << '\n';
+    }
+    if (!damp_path.empty()) {
+        std::cout << "\nregularization path (last run):\n";
+        std::cout << "==============================\n";
+        std::cout << "          damp   iter          time        relres\n";
+        for (std::size_t k = 0; k < path_iters.size(); k++) {
+            std::cout << std::setw(14) << damp_path[k] << std::setw(7)
+                      << path_iters[k] << std::setw(14) << path_times[k]
+                      << std::setw(14) << path_relres[k] << '\n';
+        }
+    }
     std::cout << "               output file: " << filename_out << '\n';
 }
 
@@ -284,11 +893,24 @@ void lsqr::write_output()
                                 t_mm_avg, t_qr_avg, iter, relres_norm_avg);
 }
 
+// Computes the preconditioner and solves, or runs the whole regularization
+// path.
+void lsqr::run_once()
+{
+    if (!damp_path.empty()) {
+        solve_path();
+        return;
+    }
+    dispatch_preconditioner();
+    dispatch_solver();
+}
+
 void lsqr::run()
 {
     filename_out = args[9];
     warmup_iters = std::atoi(args[10].c_str());
     runtime_iters = std::atoi(args[11].c_str());
+    load();
 
     // Warmup runs.
     for (auto i = 0; i < warmup_iters; i++) {
@@ -296,8 +918,7 @@ void lsqr::run()
         t_solve = 0.0;
         t_mm = 0.0;
         t_qr = 0.0;
-        dispatch_preconditioner();
-        dispatch_solver();
+        run_once();
         std::cout << "  warmup -> t_precond: " << t_precond << '\n';
         std::cout << "  warmup ->   t_solve: " << t_solve << '\n';
     }
@@ -307,13 +928,26 @@ void lsqr::run()
     t_solve_avg = 0.0;
     t_mm_avg = 0.0;
     t_qr_avg = 0.0;
+    t_qr_levels_avg.clear();
+    t_qr_gram_avg = 0.0;
+    t_qr_factor_avg = 0.0;
     for (auto i = 0; i < runtime_iters; i++) {
         t_precond = 0.0;
         t_solve = 0.0;
         t_mm = 0.0;
         t_qr = 0.0;
-        dispatch_preconditioner();
-        dispatch_solver();
+        magma_config.qr.t_levels.clear();
+        magma_config.qr.t_gram = 0.0;
+        magma_config.qr.t_factor = 0.0;
+        run_once();
+        auto& t_levels = magma_config.qr.t_levels;
+        t_qr_levels_avg.resize(
+            std::max(t_qr_levels_avg.size(), t_levels.size()), 0.0);
+        for (std::size_t level = 0; level < t_levels.size(); level++) {
+            t_qr_levels_avg[level] += t_levels[level];
+        }
+        t_qr_gram_avg += magma_config.qr.t_gram;
+        t_qr_factor_avg += magma_config.qr.t_factor;
         t_precond_avg += t_precond;
         t_solve_avg += t_solve;
         t_mm_avg += t_mm;
@@ -331,12 +965,34 @@ void lsqr::run()
     t_total_avg = t_precond_avg + t_solve_avg;  // total runtime
     t_mm_avg /= runtime_iters;  // matrix-mult runtime (part of precond)
     t_qr_avg /= runtime_iters;  // qr runtime (part of precond)
+    for (auto& t_level : t_qr_levels_avg) {
+        t_level /= runtime_iters;
+    }
+    t_qr_gram_avg /= runtime_iters;
+    t_qr_factor_avg /= runtime_iters;
+    unload();
 }
 
-void lsqr::initialize() { rls::detail::configure_magma(magma_config); }
+void lsqr::initialize()
+{
+    parse_options();
+    if (option("backend", "cuda").compare("host") == 0) {
+        rls::detail::configure_host(magma_config);
+    } else {
+        rls::detail::configure_magma(magma_config);
+    }
+    sparse = rls::io::is_coordinate((char*)args[5].c_str());
+    if (sparse && (magma_config.exec != rls::detail::backend::host)) {
+        std::cout << "Sparse matrices require --backend host." << '\n';
+        std::exit(EXIT_FAILURE);
+    }
+}
 
 void lsqr::finalize()
 {
+    if (magma_config.exec == rls::detail::backend::host) {
+        return;
+    }
     cudaStreamDestroy(magma_config.cuda_stream);
     cublasDestroy(magma_config.cublas_handle);
     cusparseDestroy(magma_config.cusparse_handle);
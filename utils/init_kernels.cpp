@@ -1,21 +1,482 @@
 #include <cuda_runtime.h>
 #include <curand.h>
 #include <time.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
+#include <map>
 #include <string>
+#include <type_traits>
 
 
+#include "../core/blas/blas.hpp"
 #include "../core/memory/detail.hpp"
 #include "../core/memory/memory.hpp"
+#include "../core/preconditioner/condition.hpp"
+#include "../core/preconditioner/factorize.hpp"
 #include "../core/preconditioner/gaussian.hpp"
+#include "../core/preconditioner/regularize.hpp"
+#include "../core/preconditioner/sparse_sign.hpp"
+#include "../core/preconditioner/srht.hpp"
+#include "../core/preconditioner/streamed.hpp"
 #include "../core/solver/lsqr.hpp"
 #include "../cuda/solver/lsqr_kernels.cuh"
+#include "../host/preconditioner/preconditioner_kernels.hpp"
+#include "../host/solver/lsqr_kernels.hpp"
 #include "../include/base_types.hpp"
+#include "init_kernels.hpp"
 #include "io.hpp"
 
 
 namespace rls {
 namespace utils {
+namespace {
+
+
+template <typename value_type, typename index_type>
+void default_initialization(index_type num_rows, index_type num_cols,
+                            value_type* mtx, value_type* init_sol,
+                            value_type* sol, value_type* rhs,
+                            detail::magma_info& magma_config)
+{
+    if (detail::use_host_backend()) {
+        host::default_initialization(num_rows, num_cols, mtx, init_sol, sol,
+                                     rhs);
+    } else {
+        cuda::default_initialization(magma_config.queue, num_rows, num_cols,
+                                     mtx, init_sol, sol, rhs);
+    }
+}
+
+template <typename value_type, typename index_type>
+void solution_initialization(index_type num_cols, value_type* init_sol,
+                             value_type* sol, detail::magma_info& magma_config)
+{
+    if (detail::use_host_backend()) {
+        host::solution_initialization(num_cols, init_sol, sol);
+    } else {
+        cuda::solution_initialization(num_cols, init_sol, sol,
+                                      magma_config.queue);
+    }
+}
+
+
+template <typename value_type, typename stored_type>
+void convert_values(magma_int_t num_rows, magma_int_t num_cols,
+                    const stored_type* values, magma_int_t ld,
+                    value_type* mtx, magma_int_t ld_mtx)
+{
+#pragma omp parallel for schedule(static)
+    for (magma_int_t col = 0; col < num_cols; col++) {
+        for (magma_int_t row = 0; row < num_rows; row++) {
+            mtx[row + static_cast<std::size_t>(col) * ld_mtx] =
+                static_cast<value_type>(
+                    values[row + static_cast<std::size_t>(col) * ld]);
+        }
+    }
+}
+
+// Binary matrices used in place by read_dense, keyed on their values, until
+// release_mapped unmaps them.
+std::map<const void*, io::mapped_mtx>& mapped_matrices()
+{
+    static std::map<const void*, io::mapped_mtx> mappings;
+    return mappings;
+}
+
+// Unmaps dmtx and returns true if read_dense mapped it in place.
+bool release_mapped(const void* dmtx)
+{
+    auto& mappings = mapped_matrices();
+    auto it = mappings.find(dmtx);
+    if (it == mappings.end()) {
+        return false;
+    }
+    io::unmap_bin(&it->second);
+    mappings.erase(it);
+    return true;
+}
+
+// Copies the mapped binary matrix into dmtx (num_rows x num_cols, leading
+// dimension num_rows), converting it to value_type if it is stored in another
+// precision.
+template <typename value_type, typename stored_type>
+void load_mapped(io::mapped_mtx& mapped, value_type* dmtx,
+                 detail::magma_info& magma_config)
+{
+    magma_int_t num_rows = mapped.header.num_rows;
+    magma_int_t num_cols = mapped.header.num_cols;
+    magma_int_t ld = mapped.header.ld;
+    auto values = static_cast<const stored_type*>(mapped.values);
+    if (std::is_same<value_type, stored_type>::value) {
+        memory::setmatrix(num_rows, num_cols,
+                          (value_type*)const_cast<stored_type*>(values), ld,
+                          dmtx, num_rows, magma_config.queue);
+    } else if (detail::use_host_backend()) {
+        convert_values(num_rows, num_cols, values, ld, dmtx, num_rows);
+    } else {
+        value_type* mtx = nullptr;
+        memory::malloc_cpu(&mtx, num_rows * num_cols);
+        convert_values(num_rows, num_cols, values, ld, mtx, num_rows);
+        memory::setmatrix(num_rows, num_cols, mtx, num_rows, dmtx, num_rows,
+                          magma_config.queue);
+        memory::free_cpu(mtx);
+    }
+}
+
+// Reads a dense matrix from a MatrixMarket array file or a binary container
+// into dmtx, allocated here. Binary files are mapped and copied straight into
+// dmtx without parsing; MatrixMarket files are parsed into *mtx first. With
+// in_place set, a binary file stored in value_type with ld = num_rows is not
+// copied on the host backend: dmtx points to the read-only mapping, which is
+// kept until release_mapped.
+template <typename value_type, typename index_type>
+void read_dense(std::string filename, index_type* num_rows_io,
+                index_type* num_cols_io, value_type** mtx, value_type** dmtx,
+                detail::magma_info& magma_config, bool in_place = false)
+{
+    index_type num_rows = 0;
+    index_type num_cols = 0;
+    if (io::is_binary((char*)filename.c_str())) {
+        io::mapped_mtx mapped;
+        if (!io::map_bin((char*)filename.c_str(), &mapped)) {
+            std::exit(EXIT_FAILURE);
+        }
+        num_rows = mapped.header.num_rows;
+        num_cols = mapped.header.num_cols;
+        auto stored_fp64 = (mapped.header.dtype == io::bin_fp64);
+        *mtx = nullptr;
+        if (in_place && detail::use_host_backend() &&
+            (mapped.header.ld == mapped.header.num_rows) &&
+            (std::is_same<value_type, double>::value == stored_fp64)) {
+            *dmtx = static_cast<value_type*>(const_cast<void*>(mapped.values));
+            mapped_matrices()[mapped.values] = mapped;
+        } else {
+            memory::malloc(dmtx, num_rows * num_cols);
+            if (stored_fp64) {
+                load_mapped<value_type, double>(mapped, *dmtx, magma_config);
+            } else {
+                load_mapped<value_type, float>(mapped, *dmtx, magma_config);
+            }
+            io::unmap_bin(&mapped);
+        }
+    } else {
+        io::read_mtx_size((char*)filename.c_str(), &num_rows, &num_cols);
+        memory::malloc_cpu(mtx, num_rows * num_cols);
+        io::read_mtx_values((char*)filename.c_str(), num_rows, num_cols,
+                            *mtx);
+        memory::malloc(dmtx, num_rows * num_cols);
+        memory::setmatrix(num_rows, num_cols, *mtx, num_rows, *dmtx, num_rows,
+                          magma_config.queue);
+    }
+    *num_rows_io = num_rows;
+    *num_cols_io = num_cols;
+}
+
+
+// Allocates precond_mtx for sampled_rows x num_cols values, or reuses the
+// buffer of the previous call, sized by *sampled_rows_io, if it is big enough.
+template <typename value_type, typename index_type>
+void reserve_precond(index_type sampled_rows, index_type num_cols,
+                     value_type** precond_mtx, index_type* sampled_rows_io)
+{
+    if ((*precond_mtx != nullptr) && (*sampled_rows_io < sampled_rows)) {
+        memory::free(*precond_mtx);
+        *precond_mtx = nullptr;
+    }
+    if (*precond_mtx == nullptr) {
+        memory::malloc(precond_mtx, sampled_rows * num_cols);
+    }
+    *sampled_rows_io = sampled_rows;
+}
+
+// Sampling coefficient d / n at which a Gaussian sketch with d rows gives
+// cond(A * R^{-1}) <= (1 + sqrt(n / d)) / (1 - sqrt(n / d)) = target_cond.
+double sampling_coeff_for(double target_cond)
+{
+    auto ratio = (target_cond + 1.0) / (target_cond - 1.0);
+    return ratio * ratio;
+}
+
+// Builds R with build(sampling_coeff, sketch) and measures cond(A * R^{-1})
+// with estimate(), growing the sketch until the estimate meets the target.
+// sketch_bytes_per_entry is the memory needed per entry of a dense sketch,
+// used to fall back to sparse_sign when a Gaussian sketch does not fit.
+template <typename index_type, typename build_type, typename estimate_type>
+void select_sketch(index_type num_rows, index_type num_cols, bool is_sparse,
+                   std::size_t sketch_bytes_per_entry,
+                   sketch_selection& selection, build_type build,
+                   estimate_type estimate, detail::magma_info& magma_config,
+                   double* t_precond)
+{
+    auto target_cond = std::max(selection.target_cond, 1.5);
+    auto max_coeff = (double)num_rows / num_cols;
+    auto coeff = std::min(sampling_coeff_for(target_cond), max_coeff);
+    auto fits = [&](double sampling_coeff) {
+        return sampling_coeff * num_cols * num_rows * sketch_bytes_per_entry <=
+               0.5 * detail::available_memory();
+    };
+    selection.attempts = 0;
+    while (true) {
+        if (selection.choose_sketch) {
+            selection.sketch = (is_sparse || !fits(coeff))
+                                   ? sketch_type::sparse_sign
+                                   : sketch_type::gaussian;
+        }
+        build(coeff, selection.sketch);
+        auto t = detail::sync_wtime(magma_config.queue);
+        selection.cond = estimate();
+        *t_precond += (detail::sync_wtime(magma_config.queue) - t);
+        selection.sampling_coeff = coeff;
+        selection.attempts++;
+        if ((selection.cond <= target_cond) || (coeff >= max_coeff) ||
+            (selection.attempts > selection.max_retries)) {
+            break;
+        }
+        // The estimate behaves like the Gaussian bound above, so the ratio
+        // of the observed to the target sqrt(n / d) predicts the growth.
+        auto observed = (selection.cond - 1.0) / (selection.cond + 1.0);
+        auto target = (target_cond - 1.0) / (target_cond + 1.0);
+        auto growth = std::min(std::max(std::pow(observed / target, 2.0), 1.25),
+                               4.0);
+        coeff = std::min(coeff * growth, max_coeff);
+    }
+}
+
+
+// Exits if srht cannot sample sampled_rows rows of a matrix with num_rows
+// rows.
+template <typename index_type>
+void check_srht_rows(index_type num_rows, index_type sampled_rows)
+{
+    auto max_rows = preconditioner::srht::max_rows(num_rows);
+    if (sampled_rows > max_rows) {
+        std::cout << "srht samples at most " << max_rows << " rows of a "
+                  << "matrix with " << num_rows << " rows, but "
+                  << sampled_rows << " were requested; lower "
+                  << "sampling_coeff\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+// Returns a Gaussian sketch matrix of size sampled_rows x num_rows generated
+// with curand, to be released with memory::free.
+template <typename value_type, typename index_type>
+value_type* generate_sketch_mtx(index_type sampled_rows, index_type num_rows,
+                                detail::magma_info& magma_config)
+{
+    value_type* sketch_mtx = nullptr;
+    memory::malloc(&sketch_mtx, sampled_rows * num_rows);
+
+    if (std::is_same<value_type, double>::value) {
+        curandGenerateNormalDouble(magma_config.rand_generator,
+                                   (double*)sketch_mtx, sampled_rows * num_rows,
+                                   0, 1);
+    } else if (std::is_same<value_type, float>::value) {
+        curandGenerateNormal(magma_config.rand_generator, (float*)sketch_mtx,
+                             sampled_rows * num_rows, 0, 1);
+    }
+    cudaDeviceSynchronize();
+    return sketch_mtx;
+}
+
+// Computes the R factor of S * dmtx into r_factor (ld sampled_rows) for a
+// sketch S with sampled_rows rows.
+template <typename value_type_in, typename value_type, typename index_type>
+void sketch_qr(index_type num_rows, index_type num_cols, value_type* dmtx,
+               index_type sampled_rows, value_type* r_factor,
+               detail::magma_info& magma_config, double* t_precond,
+               double* t_mm, double* t_qr, sketch_type sketch,
+               index_type sketch_nnz)
+{
+    // Structured sketches are applied without forming the sketch matrix.
+    if (sketch == sketch_type::srht) {
+        check_srht_rows(num_rows, sampled_rows);
+        preconditioner::srht::generate<value_type_in>(
+            sampled_rows, num_rows, num_cols, dmtx, num_rows, r_factor,
+            sampled_rows, magma_config, t_precond, t_mm, t_qr);
+        return;
+    } else if (sketch == sketch_type::sparse_sign) {
+        preconditioner::sparse_sign::generate<value_type_in>(
+            sampled_rows, sketch_nnz, num_rows, num_cols, dmtx, num_rows,
+            r_factor, sampled_rows, magma_config, t_precond, t_mm, t_qr);
+        return;
+    } else if (detail::use_host_backend()) {
+        // The Gaussian sketch is generated tile by tile inside the product.
+        preconditioner::gaussian::generate<value_type_in>(
+            sampled_rows, num_rows, num_cols, dmtx, num_rows, r_factor,
+            sampled_rows, magma_config, t_precond, t_mm, t_qr);
+        return;
+    }
+
+    // Generates sketch matrix.
+    auto sketch_mtx = generate_sketch_mtx<value_type>(sampled_rows, num_rows,
+                                                      magma_config);
+
+    // Generates preconditioner.
+    auto precond_state = new preconditioner::gaussian::state<value_type_in, value_type,
+        index_type>();
+    precond_state->allocate(num_rows, num_cols, sampled_rows, num_rows, sampled_rows,
+        sampled_rows);
+    preconditioner::gaussian::generate(
+        sampled_rows, num_rows, sketch_mtx, sampled_rows, num_rows, num_cols,
+        dmtx, num_rows, r_factor, sampled_rows, precond_state, magma_config,
+        t_precond, t_mm, t_qr);
+    memory::free(sketch_mtx);
+    precond_state->free();
+    delete precond_state;
+}
+
+// Forms S * [dmtx rhs] in result (num_cols + 1 columns, ld sampled_rows)
+// without copying [dmtx rhs]: dmtx and rhs are sketched in separate calls with
+// the same S, which the host sketches draw from (seed, row) and the cuda
+// backend stores.
+template <typename value_type_in, typename value_type, typename index_type>
+void sketch_augmented(index_type num_rows, index_type num_cols,
+                      value_type* dmtx, value_type* rhs,
+                      index_type sampled_rows, value_type* result,
+                      detail::magma_info& magma_config, double* t_precond,
+                      sketch_type sketch, index_type sketch_nnz)
+{
+    auto rhs_sketch = result + sampled_rows * num_cols;
+    if (sketch == sketch_type::srht) {
+        check_srht_rows(num_rows, sampled_rows);
+        preconditioner::srht::sketch<value_type_in>(
+            sampled_rows, num_rows, num_cols, dmtx, num_rows, result,
+            sampled_rows, magma_config, t_precond);
+        preconditioner::srht::sketch<value_type_in>(
+            sampled_rows, num_rows, 1, rhs, num_rows, rhs_sketch, sampled_rows,
+            magma_config, t_precond);
+        return;
+    } else if (sketch == sketch_type::sparse_sign) {
+        preconditioner::sparse_sign::sketch<value_type_in>(
+            sampled_rows, sketch_nnz, num_rows, num_cols, dmtx, num_rows,
+            result, sampled_rows, magma_config, t_precond);
+        preconditioner::sparse_sign::sketch<value_type_in>(
+            sampled_rows, sketch_nnz, num_rows, 1, rhs, num_rows, rhs_sketch,
+            sampled_rows, magma_config, t_precond);
+        return;
+    } else if (detail::use_host_backend()) {
+        preconditioner::gaussian::sketch<value_type_in>(
+            sampled_rows, num_rows, num_cols, dmtx, num_rows, result,
+            sampled_rows, magma_config, t_precond);
+        preconditioner::gaussian::sketch<value_type_in>(
+            sampled_rows, num_rows, 1, rhs, num_rows, rhs_sketch, sampled_rows,
+            magma_config, t_precond);
+        return;
+    }
+
+    index_type inc = 1;
+    auto sketch_mtx = generate_sketch_mtx<value_type>(sampled_rows, num_rows,
+                                                      magma_config);
+    auto precond_state = new preconditioner::gaussian::state<value_type_in,
+                                                             value_type,
+                                                             index_type>();
+    precond_state->allocate(num_rows, num_cols, sampled_rows, num_rows,
+                            sampled_rows, sampled_rows);
+    preconditioner::gaussian::sketch(sampled_rows, num_rows, sketch_mtx,
+                                     sampled_rows, num_rows, num_cols, dmtx,
+                                     num_rows, result, sampled_rows,
+                                     precond_state, magma_config, t_precond);
+    auto t = detail::sync_wtime(magma_config.queue);
+    blas::gemv(MagmaNoTrans, sampled_rows, num_rows, 1.0, sketch_mtx,
+               sampled_rows, rhs, inc, 0.0, rhs_sketch, inc,
+               magma_config.queue);
+    *t_precond += (detail::sync_wtime(magma_config.queue) - t);
+    memory::free(sketch_mtx);
+    precond_state->free();
+    delete precond_state;
+}
+
+// Computes the R factor of S * mtx for mtx in CSR format.
+template <typename value_type_in, typename value_type, typename index_type>
+void sketch_qr(matrix::sparse<value_type, index_type>* mtx,
+               index_type sampled_rows, value_type* r_factor,
+               detail::magma_info& magma_config, double* t_precond,
+               double* t_mm, double* t_qr, sketch_type sketch,
+               index_type sketch_nnz)
+{
+    if (sketch == sketch_type::sparse_sign) {
+        preconditioner::sparse_sign::generate<value_type_in>(
+            sampled_rows, sketch_nnz, mtx, r_factor, sampled_rows,
+            magma_config, t_precond, t_mm, t_qr);
+        return;
+    } else if (sketch == sketch_type::srht) {
+        std::cout << "srht is not supported for sparse matrices, using a "
+                     "gaussian sketch\n";
+    }
+
+    preconditioner::gaussian::generate<value_type_in>(
+        sampled_rows, mtx, r_factor, sampled_rows, magma_config, t_precond,
+        t_mm, t_qr);
+}
+
+// Returns the factor by which the sketch scales ||A * x|| on average. The
+// Gaussian sketch has unit variance entries, srht and sparse_sign are
+// normalized.
+template <typename index_type>
+double sketch_gain(sketch_type sketch, index_type sampled_rows)
+{
+    return (sketch == sketch_type::gaussian) ? std::sqrt(sampled_rows) : 1.0;
+}
+
+// Returns [mtx b] in CSR format, with the nonzeros of b in column num_cols.
+template <typename value_type, typename index_type>
+matrix::sparse<value_type, index_type>* append_column(
+    matrix::sparse<value_type, index_type>* mtx, value_type* rhs)
+{
+    auto num_rows = mtx->num_rows;
+    index_type nnz_rhs = 0;
+    for (index_type row = 0; row < num_rows; row++) {
+        nnz_rhs += (rhs[row] != value_type(0));
+    }
+    auto aug = new matrix::sparse<value_type, index_type>();
+    aug->allocate(num_rows, mtx->num_cols + 1, mtx->nnz + nnz_rhs);
+    aug->row_ptrs[0] = 0;
+    for (index_type row = 0; row < num_rows; row++) {
+        aug->row_ptrs[row + 1] = aug->row_ptrs[row] + mtx->row_ptrs[row + 1] -
+                                 mtx->row_ptrs[row] +
+                                 (rhs[row] != value_type(0));
+    }
+#pragma omp parallel for schedule(static)
+    for (index_type row = 0; row < num_rows; row++) {
+        auto dest = aug->row_ptrs[row];
+        for (auto k = mtx->row_ptrs[row]; k < mtx->row_ptrs[row + 1]; k++) {
+            aug->col_idxs[dest] = mtx->col_idxs[k];
+            aug->values[dest] = mtx->values[k];
+            dest++;
+        }
+        if (rhs[row] != value_type(0)) {
+            aug->col_idxs[dest] = mtx->num_cols;
+            aug->values[dest] = rhs[row];
+        }
+    }
+    return aug;
+}
+
+// Splits the R factor of S * [A b] (num_cols + 1 columns, ld sampled_rows)
+// into the preconditioner R of A and the sketch-and-solve solution
+// sol = R^{-1} * (Q^T * S * b), which is the leading part of the last column.
+template <typename value_type, typename index_type>
+void split_augmented_factor(index_type sampled_rows, index_type num_cols,
+                            value_type* r_factor, value_type** precond_mtx,
+                            index_type* sampled_rows_io, value_type* sol,
+                            detail::magma_info& magma_config)
+{
+    index_type inc = 1;
+    reserve_precond(sampled_rows, num_cols, precond_mtx, sampled_rows_io);
+    blas::copy(sampled_rows * num_cols, r_factor, inc, *precond_mtx, inc,
+               magma_config.queue);
+    blas::copy(num_cols, r_factor + sampled_rows * num_cols, inc, sol, inc,
+               magma_config.queue);
+    blas::trsv(MagmaUpper, MagmaNoTrans, MagmaNonUnit, num_cols, *precond_mtx,
+               sampled_rows, sol, inc, magma_config.queue);
+}
+
+
+}  // anonymous namespace
+
 
 
 void finalize(void* mtx, void* dmtx, void* init_sol, void* sol, void* rhs,
@@ -36,7 +497,10 @@ void finalize_with_precond(value_type* mtx, value_type* dmtx,
                            detail::magma_info& magma_config)
 {
     // memory::free_cpu(mtx);
-    memory::free(dmtx);
+    memory::release_demoted_copies(dmtx);
+    if (!release_mapped(dmtx)) {
+        memory::free(dmtx);
+    }
     memory::free(init_sol);
     memory::free(sol);
     memory::free(rhs);
@@ -52,6 +516,52 @@ template void finalize_with_precond(float* mtx, float* dmtx, float* init_sol,
                                     float* sol, float* rhs, float* precond_mtx,
                                     detail::magma_info& magma_config);
 
+template <typename value_type, typename index_type>
+void finalize_with_precond(matrix::sparse<value_type, index_type>* mtx,
+                           value_type* init_sol, value_type* sol,
+                           value_type* rhs, value_type* precond_mtx,
+                           detail::magma_info& magma_config)
+{
+    mtx->free();
+    memory::free(init_sol);
+    memory::free(sol);
+    memory::free(rhs);
+    memory::free(precond_mtx);
+}
+
+template void finalize_with_precond(matrix::sparse<double, magma_int_t>* mtx,
+                                    double* init_sol, double* sol, double* rhs,
+                                    double* precond_mtx,
+                                    detail::magma_info& magma_config);
+
+template void finalize_with_precond(matrix::sparse<float, magma_int_t>* mtx,
+                                    float* init_sol, float* sol, float* rhs,
+                                    float* precond_mtx,
+                                    detail::magma_info& magma_config);
+
+template <typename value_type, typename index_type>
+void finalize_with_precond(matrix::panelled<value_type, index_type>* mtx,
+                           value_type* init_sol, value_type* sol,
+                           value_type* rhs, value_type* precond_mtx,
+                           detail::magma_info& magma_config)
+{
+    mtx->free();
+    memory::free(init_sol);
+    memory::free(sol);
+    memory::free(rhs);
+    memory::free(precond_mtx);
+}
+
+template void finalize_with_precond(matrix::panelled<double, magma_int_t>* mtx,
+                                    double* init_sol, double* sol, double* rhs,
+                                    double* precond_mtx,
+                                    detail::magma_info& magma_config);
+
+template void finalize_with_precond(matrix::panelled<float, magma_int_t>* mtx,
+                                    float* init_sol, float* sol, float* rhs,
+                                    float* precond_mtx,
+                                    detail::magma_info& magma_config);
+
 
 template <typename value_type, typename index_type>
 void initialize(std::string filename_mtx, index_type* num_rows_io,
@@ -74,8 +584,8 @@ void initialize(std::string filename_mtx, index_type* num_rows_io,
     memory::malloc(sol, num_cols);
     memory::malloc(init_sol, num_cols);
     memory::malloc(rhs, num_rows);
-    cuda::default_initialization(magma_config.queue, num_rows, num_cols, *dmtx,
-                                 *init_sol, *sol, *rhs);
+    default_initialization(num_rows, num_cols, *dmtx, *init_sol, *sol, *rhs,
+                           magma_config);
     *num_rows_io = num_rows;
     *num_cols_io = num_cols;
 }
@@ -116,8 +626,7 @@ void initialize(std::string filename_mtx, std::string filename_rhs,
         memory::setmatrix(num_rows, 1, rhs_tmp, num_rows, *rhs, num_rows,
                           magma_config.queue);
         memory::free_cpu(rhs_tmp);
-        cuda::solution_initialization(num_cols, *init_sol, *sol,
-                                      magma_config.queue);
+        solution_initialization(num_cols, *init_sol, *sol, magma_config);
     }
     *num_rows_io = num_rows;
     *num_cols_io = num_cols;
@@ -154,25 +663,35 @@ void initialize_with_precond(
     memory::malloc(sol, num_cols);
     memory::malloc(init_sol, num_cols);
     memory::malloc(rhs, num_rows);
-    cuda::default_initialization(magma_config.queue, num_rows, num_cols, *dmtx,
-                                 *init_sol, *sol, *rhs);
+    default_initialization(num_rows, num_cols, *dmtx, *init_sol, *sol, *rhs,
+                           magma_config);
 
-    // Generates sketch matrix.
-    value_type* sketch_mtx = nullptr;
     index_type sampled_rows = (index_type)(sampling_coeff * num_cols);
-    memory::malloc(&sketch_mtx, sampled_rows * num_rows);
     memory::malloc(precond_mtx, sampled_rows * num_cols);
-    auto status = curandGenerateNormalDouble(
-        magma_config.rand_generator, sketch_mtx, sampled_rows * num_rows, 0, 1);
+    if (detail::use_host_backend()) {
+        // Generates the sketch inside the product, without storing it.
+        double t_mm = 0.0;
+        double t_qr = 0.0;
+        preconditioner::gaussian::generate<value_type_in>(
+            sampled_rows, num_rows, num_cols, *dmtx, num_rows, *precond_mtx,
+            sampled_rows, magma_config, t_precond, &t_mm, &t_qr);
+    } else {
+        // Generates sketch matrix.
+        value_type* sketch_mtx = nullptr;
+        memory::malloc(&sketch_mtx, sampled_rows * num_rows);
+        curandGenerateNormalDouble(magma_config.rand_generator, sketch_mtx,
+                                   sampled_rows * num_rows, 0, 1);
 
-    // Generates preconditioner.
-    value_type* dt = nullptr;
-    memory::malloc(&dt, sampled_rows * num_cols);
-    preconditioner::gaussian::generate<value_type_in>(
-        sampled_rows, num_rows, sketch_mtx, sampled_rows, num_rows, num_cols,
-        *dmtx, num_rows, *precond_mtx, sampled_rows, dt, magma_config);
-    memory::free(dt);
-    memory::free(sketch_mtx);
+        // Generates preconditioner.
+        value_type* dt = nullptr;
+        memory::malloc(&dt, sampled_rows * num_cols);
+        preconditioner::gaussian::generate<value_type_in>(
+            sampled_rows, num_rows, sketch_mtx, sampled_rows, num_rows,
+            num_cols, *dmtx, num_rows, *precond_mtx, sampled_rows, dt,
+            magma_config);
+        memory::free(dt);
+        memory::free(sketch_mtx);
+    }
     *num_rows_io = num_rows;
     *num_cols_io = num_cols;
     *sampled_rows_io = sampled_rows;
@@ -184,6 +703,12 @@ template void initialize_with_precond<__half>(
     double sampling_coeff, magma_int_t* sampled_rows_io, double** precond_mtx,
     detail::magma_info& magma_config, double* t_precond);
 
+template void initialize_with_precond<__nv_bfloat16>(
+    std::string filename_mtx, magma_int_t* num_rows, magma_int_t* num_cols,
+    double** mtx, double** d_mtx, double** init_sol, double** sol, double** rhs,
+    double sampling_coeff, magma_int_t* sampled_rows_io, double** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond);
+
 template void initialize_with_precond<float>(
     std::string filename_mtx, magma_int_t* num_rows, magma_int_t* num_cols,
     double** mtx, double** d_mtx, double** init_sol, double** sol, double** rhs,
@@ -197,92 +722,357 @@ template void initialize_with_precond<double>(
     detail::magma_info& magma_config, double* t_precond);
 
 
-// Initialization of preconditioned LSQR, with runtime measurement.
-template <typename value_type_in, typename value_type, typename index_type>
-void initialize_with_precond(std::string filename_mtx, std::string filename_rhs,
-                             index_type* num_rows_io, index_type* num_cols_io,
-                             value_type** mtx, value_type** dmtx,
-                             value_type** init_sol, value_type** sol,
-                             value_type** rhs, double sampling_coeff,
-                             index_type* sampled_rows_io,
-                             value_type** precond_mtx,
-                             detail::magma_info& magma_config,
-                             double* t_precond, double* t_mm, double* t_qr)
+// Reads the matrix and rhs and allocates the solution vectors.
+template <typename value_type, typename index_type>
+void load(std::string filename_mtx, std::string filename_rhs,
+          index_type* num_rows_io, index_type* num_cols_io, value_type** mtx,
+          value_type** dmtx, value_type** init_sol, value_type** sol,
+          value_type** rhs, detail::magma_info& magma_config,
+          index_type* num_rhs_io)
 {
-    std::cout << "=== INITIALIZE ===" << '\n';
     index_type num_rows = 0;
     index_type num_cols = 0;
-    io::read_mtx_size((char*)filename_mtx.c_str(), &num_rows, &num_cols);
+    read_dense(filename_mtx, &num_rows, &num_cols, mtx, dmtx, magma_config,
+               true);
     std::cout << "matrix: " << filename_mtx.c_str() << "\n";
     std::cout << "rows: " << num_rows << ", cols: " << num_cols << "\n";
 
-    // Initializes matrix and rhs.
-    memory::malloc_cpu(mtx, num_rows * num_cols);
-    io::read_mtx_values((char*)filename_mtx.c_str(), num_rows, num_cols, *mtx);
-    auto v = *mtx;
+    // Initializes rhs; one solution is allocated per rhs column.
+    index_type rhs_rows = 0;
+    index_type rhs_cols = 0;
+    value_type* rhs_tmp = nullptr;
+    read_dense(filename_rhs, &rhs_rows, &rhs_cols, &rhs_tmp, rhs,
+               magma_config);
+    memory::free_cpu(rhs_tmp);
+    auto num_rhs = (num_rhs_io == nullptr) ? 1 : rhs_cols;
+    memory::malloc(sol, num_cols * num_rhs);
+    memory::malloc(init_sol, num_cols * num_rhs);
+    solution_initialization(num_cols * num_rhs, *init_sol, *sol,
+                            magma_config);
+    *num_rows_io = num_rows;
+    *num_cols_io = num_cols;
+    if (num_rhs_io != nullptr) {
+        *num_rhs_io = num_rhs;
+    }
+}
 
-    std::cout << "*mtx[0]: " << v[0] << '\n';
-    std::cout << "*mtx[" << num_rows << "]: " << v[num_rows] << '\n';
-    std::cout << "*mtx[" << 2* num_rows << "]: " << v[2*num_rows] << '\n';
-    std::cout << "mtx\n";
-    rls::io::print_mtx(5, 5, (double*)v, num_rows);
+template void load(std::string filename_mtx, std::string filename_rhs,
+                   magma_int_t* num_rows_io, magma_int_t* num_cols_io,
+                   double** mtx, double** dmtx, double** init_sol,
+                   double** sol, double** rhs,
+                   detail::magma_info& magma_config, magma_int_t* num_rhs_io);
 
-    memory::malloc(dmtx, num_rows * num_cols);
-    std::cout << "(dmtx == nullptr): " << (dmtx == nullptr) << '\n';
-    memory::setmatrix(num_rows, num_cols, *mtx, num_rows, *dmtx, num_rows,
-                      magma_config.queue);
-    std::cout << "\n\n";
-    // rls::io::print_mtx_gpu(5, 5, (*dmtx), num_rows, magma_config.queue);
-    memory::malloc(sol, num_cols);
-    memory::malloc(init_sol, num_cols);
-    memory::malloc(rhs, num_rows);
+template void load(std::string filename_mtx, std::string filename_rhs,
+                   magma_int_t* num_rows_io, magma_int_t* num_cols_io,
+                   float** mtx, float** dmtx, float** init_sol, float** sol,
+                   float** rhs, detail::magma_info& magma_config,
+                   magma_int_t* num_rhs_io);
 
-    value_type* rhs_tmp = nullptr;
-    memory::malloc_cpu(&rhs_tmp, num_rows);
-    io::read_mtx_values((char*)filename_rhs.c_str(), num_rows, 1, rhs_tmp);
-    memory::setmatrix(num_rows, 1, rhs_tmp, num_rows, *rhs, num_rows,
-                      magma_config.queue);
-    memory::free_cpu(rhs_tmp);
-    cuda::solution_initialization(num_cols, *init_sol, *sol,
-                                  magma_config.queue);
 
-    // Generates sketch matrix.
-    value_type* sketch_mtx = nullptr;
+template <typename value_type, typename index_type>
+void load_initial_guess(std::string filename, index_type num_cols,
+                        value_type** guess, detail::magma_info& magma_config)
+{
+    index_type guess_rows = 0;
+    index_type guess_cols = 0;
+    value_type* guess_tmp = nullptr;
+    read_dense(filename, &guess_rows, &guess_cols, &guess_tmp, guess,
+               magma_config);
+    memory::free_cpu(guess_tmp);
+    if ((guess_rows != num_cols) || (guess_cols != 1)) {
+        std::cout << "initial guess " << filename << " is " << guess_rows
+                  << " x " << guess_cols << ", expected " << num_cols
+                  << " x 1\n";
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+template void load_initial_guess(std::string filename, magma_int_t num_cols,
+                                 double** guess,
+                                 detail::magma_info& magma_config);
+
+template void load_initial_guess(std::string filename, magma_int_t num_cols,
+                                 float** guess,
+                                 detail::magma_info& magma_config);
+
+
+template <typename value_type, typename index_type>
+void reset_solution(index_type num_cols, value_type* init_sol,
+                    value_type* sol, detail::magma_info& magma_config)
+{
+    solution_initialization(num_cols, init_sol, sol, magma_config);
+}
+
+template void reset_solution(magma_int_t num_cols, double* init_sol,
+                             double* sol, detail::magma_info& magma_config);
+
+template void reset_solution(magma_int_t num_cols, float* init_sol,
+                             float* sol, detail::magma_info& magma_config);
+
+
+// Computes the preconditioner of dmtx, with runtime measurement.
+template <typename value_type_in, typename value_type, typename index_type>
+void precondition(index_type num_rows, index_type num_cols, value_type* dmtx,
+                  double sampling_coeff, index_type* sampled_rows_io,
+                  value_type** precond_mtx, detail::magma_info& magma_config,
+                  double* t_precond, double* t_mm, double* t_qr,
+                  sketch_type sketch, index_type sketch_nnz, double damp)
+{
     index_type sampled_rows = (index_type)(sampling_coeff * num_cols);
-    memory::malloc(&sketch_mtx, sampled_rows * num_rows);
-    memory::malloc(precond_mtx, sampled_rows * num_cols);
+    reserve_precond(sampled_rows, num_cols, precond_mtx, sampled_rows_io);
+    sketch_qr<value_type_in>(num_rows, num_cols, dmtx, sampled_rows,
+                             *precond_mtx, magma_config, t_precond, t_mm,
+                             t_qr, sketch, sketch_nnz);
+    auto gain = sketch_gain(sketch, sampled_rows);
+    preconditioner::regularize(num_cols, (value_type)(gain * damp),
+                               *precond_mtx, sampled_rows, magma_config,
+                               t_precond, t_qr);
+}
 
-    // auto t = magma_sync_wtime(magma_config.queue);
-    if (std::is_same<value_type, double>::value) {
-        auto status = curandGenerateNormalDouble(magma_config.rand_generator,
-                                                 (double*)sketch_mtx,
-                                                 sampled_rows * num_rows, 0, 1);
-        std::cout << "generate rand status: " << status << '\n';
-    } else if (std::is_same<value_type, float>::value) {
-        auto status = curandGenerateNormal(magma_config.rand_generator,
-                                           (float*)sketch_mtx,
-                                           sampled_rows * num_rows, 0, 1);
-        std::cout << "status: " << status << '\n';
+template void precondition<__half>(
+    magma_int_t num_rows, magma_int_t num_cols, double* dmtx,
+    double sampling_coeff, magma_int_t* sampled_rows_io, double** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz, double damp);
+
+template void precondition<__nv_bfloat16>(
+    magma_int_t num_rows, magma_int_t num_cols, double* dmtx,
+    double sampling_coeff, magma_int_t* sampled_rows_io, double** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz, double damp);
+
+template void precondition<float>(
+    magma_int_t num_rows, magma_int_t num_cols, double* dmtx,
+    double sampling_coeff, magma_int_t* sampled_rows_io, double** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz, double damp);
+
+template void precondition<double>(
+    magma_int_t num_rows, magma_int_t num_cols, double* dmtx,
+    double sampling_coeff, magma_int_t* sampled_rows_io, double** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz, double damp);
+
+template void precondition<float>(
+    magma_int_t num_rows, magma_int_t num_cols, float* dmtx,
+    double sampling_coeff, magma_int_t* sampled_rows_io, float** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz, double damp);
+
+template void precondition<__half>(
+    magma_int_t num_rows, magma_int_t num_cols, float* dmtx,
+    double sampling_coeff, magma_int_t* sampled_rows_io, float** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz, double damp);
+
+template void precondition<__nv_bfloat16>(
+    magma_int_t num_rows, magma_int_t num_cols, float* dmtx,
+    double sampling_coeff, magma_int_t* sampled_rows_io, float** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz, double damp);
+
+
+template <typename value_type, typename index_type>
+void redamp(index_type num_cols, index_type sampled_rows,
+            value_type* r_factor, value_type* precond_mtx, double damp,
+            detail::magma_info& magma_config, double* t_precond, double* t_qr,
+            sketch_type sketch)
+{
+    index_type inc = 1;
+    auto t = detail::sync_wtime(magma_config.queue);
+    blas::copy(sampled_rows * num_cols, r_factor, inc, precond_mtx, inc,
+               magma_config.queue);
+    *t_precond += (detail::sync_wtime(magma_config.queue) - t);
+    auto gain = sketch_gain(sketch, sampled_rows);
+    preconditioner::regularize(num_cols, (value_type)(gain * damp),
+                               precond_mtx, sampled_rows, magma_config,
+                               t_precond, t_qr);
+}
+
+template void redamp(magma_int_t num_cols, magma_int_t sampled_rows,
+                     double* r_factor, double* precond_mtx, double damp,
+                     detail::magma_info& magma_config, double* t_precond,
+                     double* t_qr, sketch_type sketch);
+
+template void redamp(magma_int_t num_cols, magma_int_t sampled_rows,
+                     float* r_factor, float* precond_mtx, double damp,
+                     detail::magma_info& magma_config, double* t_precond,
+                     double* t_qr, sketch_type sketch);
+
+
+// Computes the preconditioner of dmtx with a sketch chosen by
+// select_sketch, with runtime measurement.
+template <typename value_type_in, typename value_type, typename index_type>
+void precondition_auto(index_type num_rows, index_type num_cols,
+                       value_type* dmtx, sketch_selection& selection,
+                       index_type* sampled_rows_io, value_type** precond_mtx,
+                       detail::magma_info& magma_config, double* t_precond,
+                       double* t_mm, double* t_qr, index_type sketch_nnz,
+                       double damp)
+{
+    // On the cuda backend the Gaussian sketch is held in value_type, plus a
+    // copy in value_type_in when the precisions differ. The host backend
+    // never stores it.
+    std::size_t sketch_bytes = 0;
+    if (!detail::use_host_backend()) {
+        sketch_bytes = sizeof(value_type);
+        if (!std::is_same<value_type_in, value_type>::value) {
+            sketch_bytes += sizeof(value_type_in);
+        }
     }
-    cudaDeviceSynchronize();
-    std::cout << "sketch_mtx:\n";
-    // rls::io::print_mtx_gpu(5, 5, sketch_mtx, sampled_rows, magma_config.queue);
+    auto build = [&](double sampling_coeff, sketch_type sketch) {
+        precondition<value_type_in>(num_rows, num_cols, dmtx, sampling_coeff,
+                                    sampled_rows_io, precond_mtx, magma_config,
+                                    t_precond, t_mm, t_qr, sketch, sketch_nnz);
+    };
+    auto estimate = [&]() {
+        return preconditioner::estimate_condition(
+            num_rows, num_cols, dmtx, *precond_mtx, *sampled_rows_io,
+            selection.cond_steps, magma_config.queue);
+    };
+    select_sketch(num_rows, num_cols, false, sketch_bytes, selection, build,
+                  estimate, magma_config, t_precond);
+    auto gain = sketch_gain(selection.sketch, *sampled_rows_io);
+    preconditioner::regularize(num_cols, (value_type)(gain * damp),
+                               *precond_mtx, *sampled_rows_io, magma_config,
+                               t_precond, t_qr);
+}
 
-    // Generates preconditioner.
-    auto precond_state = new preconditioner::gaussian::state<value_type_in, value_type,
-        index_type>();
-    precond_state->allocate(num_rows, num_cols, sampled_rows, num_rows, sampled_rows,
-        sampled_rows);
-    preconditioner::gaussian::generate(
-        sampled_rows, num_rows, sketch_mtx, sampled_rows, num_rows, num_cols,
-        *dmtx, num_rows, *precond_mtx, sampled_rows, precond_state, magma_config,
-        t_precond, t_mm, t_qr);
-    memory::free(sketch_mtx);
-    precond_state->free();
+template void precondition_auto<__half>(
+    magma_int_t num_rows, magma_int_t num_cols, double* dmtx,
+    sketch_selection& selection, magma_int_t* sampled_rows_io,
+    double** precond_mtx, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, magma_int_t sketch_nnz, double damp);
 
-    *num_rows_io = num_rows;
-    *num_cols_io = num_cols;
-    *sampled_rows_io = sampled_rows;
+template void precondition_auto<__nv_bfloat16>(
+    magma_int_t num_rows, magma_int_t num_cols, double* dmtx,
+    sketch_selection& selection, magma_int_t* sampled_rows_io,
+    double** precond_mtx, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, magma_int_t sketch_nnz, double damp);
+
+template void precondition_auto<float>(
+    magma_int_t num_rows, magma_int_t num_cols, double* dmtx,
+    sketch_selection& selection, magma_int_t* sampled_rows_io,
+    double** precond_mtx, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, magma_int_t sketch_nnz, double damp);
+
+template void precondition_auto<double>(
+    magma_int_t num_rows, magma_int_t num_cols, double* dmtx,
+    sketch_selection& selection, magma_int_t* sampled_rows_io,
+    double** precond_mtx, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, magma_int_t sketch_nnz, double damp);
+
+template void precondition_auto<float>(
+    magma_int_t num_rows, magma_int_t num_cols, float* dmtx,
+    sketch_selection& selection, magma_int_t* sampled_rows_io,
+    float** precond_mtx, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, magma_int_t sketch_nnz, double damp);
+
+template void precondition_auto<__half>(
+    magma_int_t num_rows, magma_int_t num_cols, float* dmtx,
+    sketch_selection& selection, magma_int_t* sampled_rows_io,
+    float** precond_mtx, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, magma_int_t sketch_nnz, double damp);
+
+template void precondition_auto<__nv_bfloat16>(
+    magma_int_t num_rows, magma_int_t num_cols, float* dmtx,
+    sketch_selection& selection, magma_int_t* sampled_rows_io,
+    float** precond_mtx, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, magma_int_t sketch_nnz, double damp);
+
+
+// Sketch-and-solve for dmtx, with runtime measurement. S * [A b] is formed
+// directly in the sketch buffer and factorized once.
+template <typename value_type_in, typename value_type, typename index_type>
+void sketch_and_solve(index_type num_rows, index_type num_cols,
+                      value_type* dmtx, value_type* rhs, double sampling_coeff,
+                      index_type* sampled_rows_io, value_type** precond_mtx,
+                      value_type* sol, detail::magma_info& magma_config,
+                      double* t_precond, double* t_mm, double* t_qr,
+                      sketch_type sketch, index_type sketch_nnz)
+{
+    index_type sampled_rows = (index_type)(sampling_coeff * num_cols);
+    value_type* r_factor = nullptr;
+    memory::malloc(&r_factor, sampled_rows * (num_cols + 1));
+
+    sketch_augmented<value_type_in>(num_rows, num_cols, dmtx, rhs,
+                                    sampled_rows, r_factor, magma_config,
+                                    t_precond, sketch, sketch_nnz);
+    preconditioner::factorize(sampled_rows, num_cols + 1, r_factor,
+                              sampled_rows, magma_config, t_precond, t_mm,
+                              t_qr);
+
+    auto t = detail::sync_wtime(magma_config.queue);
+    split_augmented_factor(sampled_rows, num_cols, r_factor, precond_mtx,
+                           sampled_rows_io, sol, magma_config);
+    memory::free(r_factor);
+    *t_precond += (detail::sync_wtime(magma_config.queue) - t);
+}
+
+template void sketch_and_solve<__half>(
+    magma_int_t num_rows, magma_int_t num_cols, double* dmtx, double* rhs,
+    double sampling_coeff, magma_int_t* sampled_rows_io, double** precond_mtx,
+    double* sol, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
+
+template void sketch_and_solve<__nv_bfloat16>(
+    magma_int_t num_rows, magma_int_t num_cols, double* dmtx, double* rhs,
+    double sampling_coeff, magma_int_t* sampled_rows_io, double** precond_mtx,
+    double* sol, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
+
+template void sketch_and_solve<float>(
+    magma_int_t num_rows, magma_int_t num_cols, double* dmtx, double* rhs,
+    double sampling_coeff, magma_int_t* sampled_rows_io, double** precond_mtx,
+    double* sol, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
+
+template void sketch_and_solve<double>(
+    magma_int_t num_rows, magma_int_t num_cols, double* dmtx, double* rhs,
+    double sampling_coeff, magma_int_t* sampled_rows_io, double** precond_mtx,
+    double* sol, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
+
+template void sketch_and_solve<float>(
+    magma_int_t num_rows, magma_int_t num_cols, float* dmtx, float* rhs,
+    double sampling_coeff, magma_int_t* sampled_rows_io, float** precond_mtx,
+    float* sol, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
+
+template void sketch_and_solve<__half>(
+    magma_int_t num_rows, magma_int_t num_cols, float* dmtx, float* rhs,
+    double sampling_coeff, magma_int_t* sampled_rows_io, float** precond_mtx,
+    float* sol, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
+
+template void sketch_and_solve<__nv_bfloat16>(
+    magma_int_t num_rows, magma_int_t num_cols, float* dmtx, float* rhs,
+    double sampling_coeff, magma_int_t* sampled_rows_io, float** precond_mtx,
+    float* sol, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
+
+
+// Initialization of preconditioned LSQR, with runtime measurement.
+template <typename value_type_in, typename value_type, typename index_type>
+void initialize_with_precond(std::string filename_mtx, std::string filename_rhs,
+                             index_type* num_rows_io, index_type* num_cols_io,
+                             value_type** mtx, value_type** dmtx,
+                             value_type** init_sol, value_type** sol,
+                             value_type** rhs, double sampling_coeff,
+                             index_type* sampled_rows_io,
+                             value_type** precond_mtx,
+                             detail::magma_info& magma_config,
+                             double* t_precond, double* t_mm, double* t_qr,
+                             sketch_type sketch, index_type sketch_nnz)
+{
+    std::cout << "=== INITIALIZE ===" << '\n';
+    load(filename_mtx, filename_rhs, num_rows_io, num_cols_io, mtx, dmtx,
+         init_sol, sol, rhs, magma_config);
+    *precond_mtx = nullptr;
+    precondition<value_type_in>(*num_rows_io, *num_cols_io, *dmtx,
+                                sampling_coeff, sampled_rows_io, precond_mtx,
+                                magma_config, t_precond, t_mm, t_qr, sketch,
+                                sketch_nnz);
 }
 
 template void initialize_with_precond<__half>(
@@ -291,7 +1081,15 @@ template void initialize_with_precond<__half>(
     double** sol, double** rhs, double sampling_coeff,
     magma_int_t* sampled_rows_io, double** precond_mtx,
     detail::magma_info& magma_config, double* t_precond, double* t_mm,
-    double* t_qr);
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
+
+template void initialize_with_precond<__nv_bfloat16>(
+    std::string filename_mtx, std::string filename_rhs, magma_int_t* num_rows,
+    magma_int_t* num_cols, double** mtx, double** d_mtx, double** init_sol,
+    double** sol, double** rhs, double sampling_coeff,
+    magma_int_t* sampled_rows_io, double** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
 
 template void initialize_with_precond<float>(
     std::string filename_mtx, std::string filename_rhs, magma_int_t* num_rows,
@@ -299,7 +1097,7 @@ template void initialize_with_precond<float>(
     double** sol, double** rhs, double sampling_coeff,
     magma_int_t* sampled_rows_io, double** precond_mtx,
     detail::magma_info& magma_config, double* t_precond, double* t_mm,
-    double* t_qr);
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
 
 template void initialize_with_precond<double>(
     std::string filename_mtx, std::string filename_rhs, magma_int_t* num_rows,
@@ -307,7 +1105,7 @@ template void initialize_with_precond<double>(
     double** sol, double** rhs, double sampling_coeff,
     magma_int_t* sampled_rows_io, double** precond_mtx,
     detail::magma_info& magma_config, double* t_precond, double* t_mm,
-    double* t_qr);
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
 
 template void initialize_with_precond<float, float, magma_int_t>(
     std::string filename_mtx, std::string filename_rhs, magma_int_t* num_rows,
@@ -315,7 +1113,7 @@ template void initialize_with_precond<float, float, magma_int_t>(
     float** sol, float** rhs, double sampling_coeff,
     magma_int_t* sampled_rows_io, float** precond_mtx,
     detail::magma_info& magma_config, double* t_precond, double* t_mm,
-    double* t_qr);
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
 
 template void initialize_with_precond<__half, float, magma_int_t>(
     std::string filename_mtx, std::string filename_rhs, magma_int_t* num_rows,
@@ -323,7 +1121,444 @@ template void initialize_with_precond<__half, float, magma_int_t>(
     float** sol, float** rhs, double sampling_coeff,
     magma_int_t* sampled_rows_io, float** precond_mtx,
     detail::magma_info& magma_config, double* t_precond, double* t_mm,
-    double* t_qr);
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
+
+template void initialize_with_precond<__nv_bfloat16, float, magma_int_t>(
+    std::string filename_mtx, std::string filename_rhs, magma_int_t* num_rows,
+    magma_int_t* num_cols, float** mtx, float** d_mtx, float** init_sol,
+    float** sol, float** rhs, double sampling_coeff,
+    magma_int_t* sampled_rows_io, float** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
+
+
+// Reads a sparse matrix and the rhs and allocates the solution vectors.
+template <typename value_type, typename index_type>
+void load(std::string filename_mtx, std::string filename_rhs,
+          matrix::sparse<value_type, index_type>* mtx, value_type** init_sol,
+          value_type** sol, value_type** rhs,
+          detail::magma_info& magma_config)
+{
+    io::read_mtx_sparse((char*)filename_mtx.c_str(), mtx);
+    std::cout << "matrix: " << filename_mtx.c_str() << "\n";
+    std::cout << "rows: " << mtx->num_rows << ", cols: " << mtx->num_cols
+              << ", nnz: " << mtx->nnz << "\n";
+
+    // Initializes rhs.
+    memory::malloc(sol, mtx->num_cols);
+    memory::malloc(init_sol, mtx->num_cols);
+    index_type rhs_rows = 0;
+    index_type rhs_cols = 0;
+    value_type* rhs_tmp = nullptr;
+    read_dense(filename_rhs, &rhs_rows, &rhs_cols, &rhs_tmp, rhs,
+               magma_config);
+    memory::free_cpu(rhs_tmp);
+    solution_initialization(mtx->num_cols, *init_sol, *sol, magma_config);
+}
+
+template void load(std::string filename_mtx, std::string filename_rhs,
+                   matrix::sparse<double, magma_int_t>* mtx, double** init_sol,
+                   double** sol, double** rhs,
+                   detail::magma_info& magma_config);
+
+template void load(std::string filename_mtx, std::string filename_rhs,
+                   matrix::sparse<float, magma_int_t>* mtx, float** init_sol,
+                   float** sol, float** rhs, detail::magma_info& magma_config);
+
+
+// Opens a dense matrix for panelled products and reads the rhs.
+template <typename value_type, typename index_type>
+void load(std::string filename_mtx, std::string filename_rhs,
+          index_type panel_rows, matrix::panelled<value_type, index_type>* mtx,
+          value_type** init_sol, value_type** sol, value_type** rhs,
+          detail::magma_info& magma_config)
+{
+    if (!mtx->open(filename_mtx, panel_rows)) {
+        std::cout << "could not read " << filename_mtx << " in panels\n";
+        std::exit(EXIT_FAILURE);
+    }
+    std::cout << "matrix: " << filename_mtx.c_str() << "\n";
+    std::cout << "rows: " << mtx->num_rows << ", cols: " << mtx->num_cols
+              << ", panels: " << mtx->file.num_panels << " of "
+              << mtx->file.panel_rows << " rows\n";
+
+    // Initializes rhs.
+    memory::malloc(sol, mtx->num_cols);
+    memory::malloc(init_sol, mtx->num_cols);
+    index_type rhs_rows = 0;
+    index_type rhs_cols = 0;
+    value_type* rhs_tmp = nullptr;
+    read_dense(filename_rhs, &rhs_rows, &rhs_cols, &rhs_tmp, rhs,
+               magma_config);
+    memory::free_cpu(rhs_tmp);
+    solution_initialization(mtx->num_cols, *init_sol, *sol, magma_config);
+}
+
+template void load(std::string filename_mtx, std::string filename_rhs,
+                   magma_int_t panel_rows,
+                   matrix::panelled<double, magma_int_t>* mtx,
+                   double** init_sol, double** sol, double** rhs,
+                   detail::magma_info& magma_config);
+
+template void load(std::string filename_mtx, std::string filename_rhs,
+                   magma_int_t panel_rows,
+                   matrix::panelled<float, magma_int_t>* mtx, float** init_sol,
+                   float** sol, float** rhs, detail::magma_info& magma_config);
+
+
+// Computes the preconditioner of a sparse matrix, with runtime measurement.
+template <typename value_type_in, typename value_type, typename index_type>
+void precondition(matrix::sparse<value_type, index_type>* mtx,
+                  double sampling_coeff, index_type* sampled_rows_io,
+                  value_type** precond_mtx, detail::magma_info& magma_config,
+                  double* t_precond, double* t_mm, double* t_qr,
+                  sketch_type sketch, index_type sketch_nnz, double damp)
+{
+    index_type sampled_rows = (index_type)(sampling_coeff * mtx->num_cols);
+    reserve_precond(sampled_rows, mtx->num_cols, precond_mtx, sampled_rows_io);
+    sketch_qr<value_type_in>(mtx, sampled_rows, *precond_mtx, magma_config,
+                             t_precond, t_mm, t_qr, sketch, sketch_nnz);
+    // srht falls back to a Gaussian sketch for sparse matrices.
+    auto gain = sketch_gain((sketch == sketch_type::sparse_sign)
+                                ? sketch
+                                : sketch_type::gaussian,
+                            sampled_rows);
+    preconditioner::regularize(mtx->num_cols, (value_type)(gain * damp),
+                               *precond_mtx, sampled_rows, magma_config,
+                               t_precond, t_qr);
+}
+
+template void precondition<__half>(
+    matrix::sparse<double, magma_int_t>* mtx, double sampling_coeff,
+    magma_int_t* sampled_rows_io, double** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz, double damp);
+
+template void precondition<__nv_bfloat16>(
+    matrix::sparse<double, magma_int_t>* mtx, double sampling_coeff,
+    magma_int_t* sampled_rows_io, double** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz, double damp);
+
+template void precondition<float>(
+    matrix::sparse<double, magma_int_t>* mtx, double sampling_coeff,
+    magma_int_t* sampled_rows_io, double** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz, double damp);
+
+template void precondition<double>(
+    matrix::sparse<double, magma_int_t>* mtx, double sampling_coeff,
+    magma_int_t* sampled_rows_io, double** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz, double damp);
+
+template void precondition<float>(
+    matrix::sparse<float, magma_int_t>* mtx, double sampling_coeff,
+    magma_int_t* sampled_rows_io, float** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz, double damp);
+
+template void precondition<__half>(
+    matrix::sparse<float, magma_int_t>* mtx, double sampling_coeff,
+    magma_int_t* sampled_rows_io, float** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz, double damp);
+
+template void precondition<__nv_bfloat16>(
+    matrix::sparse<float, magma_int_t>* mtx, double sampling_coeff,
+    magma_int_t* sampled_rows_io, float** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz, double damp);
+
+template <typename value_type_in, typename value_type, typename index_type>
+void precondition(std::string filename, index_type panel_rows,
+                  double sampling_coeff, index_type* sampled_rows_io,
+                  value_type** precond_mtx, detail::magma_info& magma_config,
+                  double* t_precond, double* t_mm, double* t_qr,
+                  sketch_type sketch, index_type sketch_nnz, double damp)
+{
+    io::panel_file file;
+    if (!io::open_panels((char*)filename.c_str(), panel_rows, &file)) {
+        std::exit(EXIT_FAILURE);
+    }
+    if (sketch == sketch_type::srht) {
+        std::cout << "srht is not supported for streamed matrices, using a "
+                     "gaussian sketch\n";
+        sketch = sketch_type::gaussian;
+    }
+    index_type num_cols = file.num_cols;
+    index_type sampled_rows = (index_type)(sampling_coeff * num_cols);
+    reserve_precond(sampled_rows, num_cols, precond_mtx, sampled_rows_io);
+    if (!preconditioner::streamed::generate<value_type_in>(
+            &file, sampled_rows, sketch, sketch_nnz, *precond_mtx,
+            sampled_rows, magma_config, t_precond, t_mm, t_qr)) {
+        std::cerr << filename << ": read failed\n";
+        std::exit(EXIT_FAILURE);
+    }
+    io::close_panels(&file);
+    auto gain = sketch_gain(sketch, sampled_rows);
+    preconditioner::regularize(num_cols, (value_type)(gain * damp),
+                               *precond_mtx, sampled_rows, magma_config,
+                               t_precond, t_qr);
+}
+
+template void precondition<__half>(
+    std::string filename, magma_int_t panel_rows, double sampling_coeff,
+    magma_int_t* sampled_rows_io, double** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz, double damp);
+
+template void precondition<__nv_bfloat16>(
+    std::string filename, magma_int_t panel_rows, double sampling_coeff,
+    magma_int_t* sampled_rows_io, double** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz, double damp);
+
+template void precondition<float>(
+    std::string filename, magma_int_t panel_rows, double sampling_coeff,
+    magma_int_t* sampled_rows_io, double** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz, double damp);
+
+template void precondition<double>(
+    std::string filename, magma_int_t panel_rows, double sampling_coeff,
+    magma_int_t* sampled_rows_io, double** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz, double damp);
+
+template void precondition<float>(
+    std::string filename, magma_int_t panel_rows, double sampling_coeff,
+    magma_int_t* sampled_rows_io, float** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz, double damp);
+
+template void precondition<__half>(
+    std::string filename, magma_int_t panel_rows, double sampling_coeff,
+    magma_int_t* sampled_rows_io, float** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz, double damp);
+
+template void precondition<__nv_bfloat16>(
+    std::string filename, magma_int_t panel_rows, double sampling_coeff,
+    magma_int_t* sampled_rows_io, float** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, sketch_type sketch, magma_int_t sketch_nnz, double damp);
+
+
+// Computes the preconditioner of a sparse matrix with a sketch chosen by
+// select_sketch, with runtime measurement.
+template <typename value_type_in, typename value_type, typename index_type>
+void precondition_auto(matrix::sparse<value_type, index_type>* mtx,
+                       sketch_selection& selection,
+                       index_type* sampled_rows_io, value_type** precond_mtx,
+                       detail::magma_info& magma_config, double* t_precond,
+                       double* t_mm, double* t_qr, index_type sketch_nnz,
+                       double damp)
+{
+    auto build = [&](double sampling_coeff, sketch_type sketch) {
+        precondition<value_type_in>(mtx, sampling_coeff, sampled_rows_io,
+                                    precond_mtx, magma_config, t_precond,
+                                    t_mm, t_qr, sketch, sketch_nnz);
+    };
+    auto estimate = [&]() {
+        return preconditioner::estimate_condition(
+            mtx, *precond_mtx, *sampled_rows_io, selection.cond_steps,
+            magma_config.queue);
+    };
+    select_sketch(mtx->num_rows, mtx->num_cols, true, sizeof(value_type),
+                  selection, build, estimate, magma_config, t_precond);
+    auto gain = sketch_gain((selection.sketch == sketch_type::sparse_sign)
+                                ? selection.sketch
+                                : sketch_type::gaussian,
+                            *sampled_rows_io);
+    preconditioner::regularize(mtx->num_cols, (value_type)(gain * damp),
+                               *precond_mtx, *sampled_rows_io, magma_config,
+                               t_precond, t_qr);
+}
+
+template void precondition_auto<__half>(
+    matrix::sparse<double, magma_int_t>* mtx, sketch_selection& selection,
+    magma_int_t* sampled_rows_io, double** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, magma_int_t sketch_nnz, double damp);
+
+template void precondition_auto<__nv_bfloat16>(
+    matrix::sparse<double, magma_int_t>* mtx, sketch_selection& selection,
+    magma_int_t* sampled_rows_io, double** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, magma_int_t sketch_nnz, double damp);
+
+template void precondition_auto<float>(
+    matrix::sparse<double, magma_int_t>* mtx, sketch_selection& selection,
+    magma_int_t* sampled_rows_io, double** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, magma_int_t sketch_nnz, double damp);
+
+template void precondition_auto<double>(
+    matrix::sparse<double, magma_int_t>* mtx, sketch_selection& selection,
+    magma_int_t* sampled_rows_io, double** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, magma_int_t sketch_nnz, double damp);
+
+template void precondition_auto<float>(
+    matrix::sparse<float, magma_int_t>* mtx, sketch_selection& selection,
+    magma_int_t* sampled_rows_io, float** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, magma_int_t sketch_nnz, double damp);
+
+template void precondition_auto<__half>(
+    matrix::sparse<float, magma_int_t>* mtx, sketch_selection& selection,
+    magma_int_t* sampled_rows_io, float** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, magma_int_t sketch_nnz, double damp);
+
+template void precondition_auto<__nv_bfloat16>(
+    matrix::sparse<float, magma_int_t>* mtx, sketch_selection& selection,
+    magma_int_t* sampled_rows_io, float** precond_mtx,
+    detail::magma_info& magma_config, double* t_precond, double* t_mm,
+    double* t_qr, magma_int_t sketch_nnz, double damp);
+
+
+// Sketch-and-solve for a sparse matrix, with runtime measurement.
+template <typename value_type_in, typename value_type, typename index_type>
+void sketch_and_solve(matrix::sparse<value_type, index_type>* mtx,
+                      value_type* rhs, double sampling_coeff,
+                      index_type* sampled_rows_io, value_type** precond_mtx,
+                      value_type* sol, detail::magma_info& magma_config,
+                      double* t_precond, double* t_mm, double* t_qr,
+                      sketch_type sketch, index_type sketch_nnz)
+{
+    auto num_cols = mtx->num_cols;
+    index_type sampled_rows = (index_type)(sampling_coeff * num_cols);
+    auto t = detail::sync_wtime(magma_config.queue);
+    auto aug = append_column(mtx, rhs);
+    value_type* r_factor = nullptr;
+    memory::malloc(&r_factor, sampled_rows * (num_cols + 1));
+    *t_precond += (detail::sync_wtime(magma_config.queue) - t);
+
+    sketch_qr<value_type_in>(aug, sampled_rows, r_factor, magma_config,
+                             t_precond, t_mm, t_qr, sketch, sketch_nnz);
+
+    t = detail::sync_wtime(magma_config.queue);
+    split_augmented_factor(sampled_rows, num_cols, r_factor, precond_mtx,
+                           sampled_rows_io, sol, magma_config);
+    aug->free();
+    delete aug;
+    memory::free(r_factor);
+    *t_precond += (detail::sync_wtime(magma_config.queue) - t);
+}
+
+template void sketch_and_solve<__half>(
+    matrix::sparse<double, magma_int_t>* mtx, double* rhs,
+    double sampling_coeff, magma_int_t* sampled_rows_io, double** precond_mtx,
+    double* sol, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
+
+template void sketch_and_solve<__nv_bfloat16>(
+    matrix::sparse<double, magma_int_t>* mtx, double* rhs,
+    double sampling_coeff, magma_int_t* sampled_rows_io, double** precond_mtx,
+    double* sol, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
+
+template void sketch_and_solve<float>(
+    matrix::sparse<double, magma_int_t>* mtx, double* rhs,
+    double sampling_coeff, magma_int_t* sampled_rows_io, double** precond_mtx,
+    double* sol, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
+
+template void sketch_and_solve<double>(
+    matrix::sparse<double, magma_int_t>* mtx, double* rhs,
+    double sampling_coeff, magma_int_t* sampled_rows_io, double** precond_mtx,
+    double* sol, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
+
+template void sketch_and_solve<float>(
+    matrix::sparse<float, magma_int_t>* mtx, float* rhs,
+    double sampling_coeff, magma_int_t* sampled_rows_io, float** precond_mtx,
+    float* sol, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
+
+template void sketch_and_solve<__half>(
+    matrix::sparse<float, magma_int_t>* mtx, float* rhs,
+    double sampling_coeff, magma_int_t* sampled_rows_io, float** precond_mtx,
+    float* sol, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
+
+template void sketch_and_solve<__nv_bfloat16>(
+    matrix::sparse<float, magma_int_t>* mtx, float* rhs,
+    double sampling_coeff, magma_int_t* sampled_rows_io, float** precond_mtx,
+    float* sol, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
+
+
+// Initialization of preconditioned LSQR for a sparse matrix, with runtime
+// measurement.
+template <typename value_type_in, typename value_type, typename index_type>
+void initialize_with_precond(std::string filename_mtx, std::string filename_rhs,
+                             matrix::sparse<value_type, index_type>* mtx,
+                             value_type** init_sol, value_type** sol,
+                             value_type** rhs, double sampling_coeff,
+                             index_type* sampled_rows_io,
+                             value_type** precond_mtx,
+                             detail::magma_info& magma_config,
+                             double* t_precond, double* t_mm, double* t_qr,
+                             sketch_type sketch, index_type sketch_nnz)
+{
+    std::cout << "=== INITIALIZE ===" << '\n';
+    load(filename_mtx, filename_rhs, mtx, init_sol, sol, rhs, magma_config);
+    *precond_mtx = nullptr;
+    precondition<value_type_in>(mtx, sampling_coeff, sampled_rows_io,
+                                precond_mtx, magma_config, t_precond, t_mm,
+                                t_qr, sketch, sketch_nnz);
+}
+template void initialize_with_precond<__half, double, magma_int_t>(
+    std::string filename_mtx, std::string filename_rhs,
+    matrix::sparse<double, magma_int_t>* mtx, double** init_sol, double** sol,
+    double** rhs, double sampling_coeff, magma_int_t* sampled_rows_io,
+    double** precond_mtx, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
+
+template void initialize_with_precond<__nv_bfloat16, double, magma_int_t>(
+    std::string filename_mtx, std::string filename_rhs,
+    matrix::sparse<double, magma_int_t>* mtx, double** init_sol, double** sol,
+    double** rhs, double sampling_coeff, magma_int_t* sampled_rows_io,
+    double** precond_mtx, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
+
+template void initialize_with_precond<float, double, magma_int_t>(
+    std::string filename_mtx, std::string filename_rhs,
+    matrix::sparse<double, magma_int_t>* mtx, double** init_sol, double** sol,
+    double** rhs, double sampling_coeff, magma_int_t* sampled_rows_io,
+    double** precond_mtx, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
+
+template void initialize_with_precond<double, double, magma_int_t>(
+    std::string filename_mtx, std::string filename_rhs,
+    matrix::sparse<double, magma_int_t>* mtx, double** init_sol, double** sol,
+    double** rhs, double sampling_coeff, magma_int_t* sampled_rows_io,
+    double** precond_mtx, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
+
+template void initialize_with_precond<float, float, magma_int_t>(
+    std::string filename_mtx, std::string filename_rhs,
+    matrix::sparse<float, magma_int_t>* mtx, float** init_sol, float** sol,
+    float** rhs, double sampling_coeff, magma_int_t* sampled_rows_io,
+    float** precond_mtx, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
+
+template void initialize_with_precond<__half, float, magma_int_t>(
+    std::string filename_mtx, std::string filename_rhs,
+    matrix::sparse<float, magma_int_t>* mtx, float** init_sol, float** sol,
+    float** rhs, double sampling_coeff, magma_int_t* sampled_rows_io,
+    float** precond_mtx, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
+
+template void initialize_with_precond<__nv_bfloat16, float, magma_int_t>(
+    std::string filename_mtx, std::string filename_rhs,
+    matrix::sparse<float, magma_int_t>* mtx, float** init_sol, float** sol,
+    float** rhs, double sampling_coeff, magma_int_t* sampled_rows_io,
+    float** precond_mtx, detail::magma_info& magma_config, double* t_precond,
+    double* t_mm, double* t_qr, sketch_type sketch, magma_int_t sketch_nnz);
 
 
 }  // end of namespace utils
@@ -2,7 +2,10 @@
 #define TEST_KERNELS
 
 
+#include "../core/matrix/panelled.hpp"
+#include "../core/matrix/sparse.hpp"
 #include "../core/memory/detail.hpp"
+#include "../include/base_types.hpp"
 
 
 namespace rls {
@@ -32,7 +35,167 @@ void initialize_with_precond(std::string filename_mtx, std::string filename_rhs,
                              index_type* sampled_rows_io,
                              value_type** precond_mtx,
                              detail::magma_info& magma_config,
-                             double* t_precond, double* t_mm, double* t_qr);
+                             double* t_precond, double* t_mm, double* t_qr,
+                             sketch_type sketch = sketch_type::gaussian,
+                             index_type sketch_nnz = 8);
+
+// Initializes preconditioned LSQR for a MatrixMarket coordinate file, read
+// into mtx in CSR format. Host backend only; srht falls back to gaussian.
+template <typename value_type_in, typename value_type, typename index_type>
+void initialize_with_precond(std::string filename_mtx, std::string filename_rhs,
+                             matrix::sparse<value_type, index_type>* mtx,
+                             value_type** init_sol, value_type** sol,
+                             value_type** rhs, double sampling_coeff,
+                             index_type* sampled_rows_io,
+                             value_type** precond_mtx,
+                             detail::magma_info& magma_config,
+                             double* t_precond, double* t_mm, double* t_qr,
+                             sketch_type sketch = sketch_type::gaussian,
+                             index_type sketch_nnz = 8);
+
+// Reads the matrix and rhs and allocates the solution vectors; the problem
+// can then be preconditioned and solved repeatedly without reloading it. If
+// num_rhs_io is given, every column of the rhs file is a right-hand side and
+// sol and init_sol hold one column per right-hand side.
+template <typename value_type, typename index_type>
+void load(std::string filename_mtx, std::string filename_rhs,
+          index_type* num_rows_io, index_type* num_cols_io, value_type** mtx,
+          value_type** dmtx, value_type** init_sol, value_type** sol,
+          value_type** rhs, detail::magma_info& magma_config,
+          index_type* num_rhs_io = nullptr);
+
+template <typename value_type, typename index_type>
+void load(std::string filename_mtx, std::string filename_rhs,
+          matrix::sparse<value_type, index_type>* mtx, value_type** init_sol,
+          value_type** sol, value_type** rhs,
+          detail::magma_info& magma_config);
+
+// Opens the dense matrix file in mtx with panels of panel_rows rows, without
+// reading it, and reads the rhs. Exits if the matrix cannot be opened.
+template <typename value_type, typename index_type>
+void load(std::string filename_mtx, std::string filename_rhs,
+          index_type panel_rows, matrix::panelled<value_type, index_type>* mtx,
+          value_type** init_sol, value_type** sol, value_type** rhs,
+          detail::magma_info& magma_config);
+
+// Reads a num_cols x 1 initial guess for the solvers into guess, allocated
+// here. Exits if the file has another shape.
+template <typename value_type, typename index_type>
+void load_initial_guess(std::string filename, index_type num_cols,
+                        value_type** guess, detail::magma_info& magma_config);
+
+// Sets the initial guess and the solution to zero before a solve.
+template <typename value_type, typename index_type>
+void reset_solution(index_type num_cols, value_type* init_sol,
+                    value_type* sol, detail::magma_info& magma_config);
+
+// Computes the preconditioner into precond_mtx, which is allocated if it is
+// nullptr and reused otherwise; a buffer too small for the new sketch, as
+// given by the previous *sampled_rows_io, is reallocated. A nonzero damp
+// builds R from [S * A; damp * I], matching the ridge problem of a damped
+// solve.
+template <typename value_type_in, typename value_type, typename index_type>
+void precondition(index_type num_rows, index_type num_cols, value_type* dmtx,
+                  double sampling_coeff, index_type* sampled_rows_io,
+                  value_type** precond_mtx, detail::magma_info& magma_config,
+                  double* t_precond, double* t_mm, double* t_qr,
+                  sketch_type sketch = sketch_type::gaussian,
+                  index_type sketch_nnz = 8, double damp = 0.0);
+
+template <typename value_type_in, typename value_type, typename index_type>
+void precondition(matrix::sparse<value_type, index_type>* mtx,
+                  double sampling_coeff, index_type* sampled_rows_io,
+                  value_type** precond_mtx, detail::magma_info& magma_config,
+                  double* t_precond, double* t_mm, double* t_qr,
+                  sketch_type sketch = sketch_type::gaussian,
+                  index_type sketch_nnz = 8, double damp = 0.0);
+
+// Overload that streams the dense matrix of filename (binary container or
+// MatrixMarket array) from disk in panels of panel_rows rows (0: about 64 MB)
+// rather than taking it in memory, see preconditioner::streamed; srht is
+// replaced by a Gaussian sketch. Exits if the file cannot be read.
+template <typename value_type_in, typename value_type, typename index_type>
+void precondition(std::string filename, index_type panel_rows,
+                  double sampling_coeff, index_type* sampled_rows_io,
+                  value_type** precond_mtx, detail::magma_info& magma_config,
+                  double* t_precond, double* t_mm, double* t_qr,
+                  sketch_type sketch = sketch_type::gaussian,
+                  index_type sketch_nnz = 8, double damp = 0.0);
+
+// Sets precond_mtx to the preconditioner of the ridge problem with the given
+// damp from r_factor, the R factor left by precondition with damp = 0 for the
+// same sketch and sampled_rows (ld of both). Costs a QR factorization of a
+// 2n x n matrix and no pass over A, so a regularization path sketches A once.
+// sketch is the one applied to A, gaussian where precondition replaced srht
+// (sparse or streamed A).
+template <typename value_type, typename index_type>
+void redamp(index_type num_cols, index_type sampled_rows,
+            value_type* r_factor, value_type* precond_mtx, double damp,
+            detail::magma_info& magma_config, double* t_precond, double* t_qr,
+            sketch_type sketch = sketch_type::gaussian);
+
+// Sketch-and-solve: computes the QR factorization of S * [A b] with one
+// sketch and returns the minimizer of ||S * (A * x - b)||,
+// R^{-1} * Q^T * S * b, in sol, and the preconditioner R of A in precond_mtx
+// as precondition does.
+// With a subspace embedding the residual is within a factor (1 + eps) of the
+// optimum, which suffices for loose tolerances without running LSQR. Costs
+// one sketch and one QR with an extra column, plus a copy of [A b].
+template <typename value_type_in, typename value_type, typename index_type>
+void sketch_and_solve(index_type num_rows, index_type num_cols,
+                      value_type* dmtx, value_type* rhs, double sampling_coeff,
+                      index_type* sampled_rows_io, value_type** precond_mtx,
+                      value_type* sol, detail::magma_info& magma_config,
+                      double* t_precond, double* t_mm, double* t_qr,
+                      sketch_type sketch = sketch_type::gaussian,
+                      index_type sketch_nnz = 8);
+
+template <typename value_type_in, typename value_type, typename index_type>
+void sketch_and_solve(matrix::sparse<value_type, index_type>* mtx,
+                      value_type* rhs, double sampling_coeff,
+                      index_type* sampled_rows_io, value_type** precond_mtx,
+                      value_type* sol, detail::magma_info& magma_config,
+                      double* t_precond, double* t_mm, double* t_qr,
+                      sketch_type sketch = sketch_type::gaussian,
+                      index_type sketch_nnz = 8);
+
+// Settings and outcome of precondition_auto.
+struct sketch_selection {
+    double target_cond = 10.0;
+    magma_int_t cond_steps = 20;
+    int max_retries = 3;
+    // Picks the sketch type; otherwise sketch is used as given.
+    bool choose_sketch = true;
+
+    sketch_type sketch = sketch_type::gaussian;
+    double sampling_coeff = 0.0;
+    double cond = 0.0;
+    int attempts = 0;
+};
+
+// Blendenpik-style driver: sizes the sketch for selection.target_cond from
+// the Gaussian bound cond(A * R^{-1}) <= (1 + sqrt(n / d)) / (1 - sqrt(n /
+// d)), estimates the condition number of the preconditioned matrix and
+// grows the sketch, up to max_retries times, while the estimate is above the
+// target. Uses sparse_sign for sparse matrices and when a Gaussian sketch
+// would take more than half of the available memory. The sketch is sized for
+// the undamped A; a nonzero damp then regularizes the chosen R as in
+// precondition, which only lowers the condition number.
+template <typename value_type_in, typename value_type, typename index_type>
+void precondition_auto(index_type num_rows, index_type num_cols,
+                       value_type* dmtx, sketch_selection& selection,
+                       index_type* sampled_rows_io, value_type** precond_mtx,
+                       detail::magma_info& magma_config, double* t_precond,
+                       double* t_mm, double* t_qr, index_type sketch_nnz = 8,
+                       double damp = 0.0);
+
+template <typename value_type_in, typename value_type, typename index_type>
+void precondition_auto(matrix::sparse<value_type, index_type>* mtx,
+                       sketch_selection& selection,
+                       index_type* sampled_rows_io, value_type** precond_mtx,
+                       detail::magma_info& magma_config, double* t_precond,
+                       double* t_mm, double* t_qr, index_type sketch_nnz = 8,
+                       double damp = 0.0);
 
 template <typename value_type>
 void finalize(value_type* mtx, value_type* dmtx, value_type* init_sol,
@@ -45,6 +208,18 @@ void finalize_with_precond(value_type* mtx, value_type* dmtx,
                            value_type* rhs, value_type* precond_mtx,
                            detail::magma_info& magma_config);
 
+template <typename value_type, typename index_type>
+void finalize_with_precond(matrix::sparse<value_type, index_type>* mtx,
+                           value_type* init_sol, value_type* sol,
+                           value_type* rhs, value_type* precond_mtx,
+                           detail::magma_info& magma_config);
+
+template <typename value_type, typename index_type>
+void finalize_with_precond(matrix::panelled<value_type, index_type>* mtx,
+                           value_type* init_sol, value_type* sol,
+                           value_type* rhs, value_type* precond_mtx,
+                           detail::magma_info& magma_config);
+
 
 }  // namespace utils
 }  // namespace rls
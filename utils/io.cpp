@@ -2,50 +2,949 @@
 #include "stdio.h"
 #include "magma_v2.h"
 #include <cuda_runtime.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <omp.h>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <string>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 #include "../core/memory/memory.hpp"
+#include "io.hpp"
 
 namespace rls {
 namespace io {
+namespace {
 
 
-void read_mtx_size(char* filename, magma_int_t* m, magma_int_t* n) {
-    MM_typecode matcode;
-    FILE* file_handle = fopen(filename, "r");
-    mm_read_banner(file_handle, &matcode);
-    mm_read_mtx_array_size(file_handle, m, n);
-    fclose(file_handle);
+// Maps filename read-only. Returns false and prints the reason on failure.
+bool map_file(char* filename, void** base, std::size_t* size)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        std::cerr << filename << ": cannot open\n";
+        return false;
+    }
+    struct stat info;
+    fstat(fd, &info);
+    *size = info.st_size;
+    *base = (*size > 0)
+                ? mmap(nullptr, *size, PROT_READ, MAP_SHARED, fd, 0)
+                : nullptr;
+    close(fd);
+    if (*base == MAP_FAILED) {
+        std::cerr << filename << ": mmap failed\n";
+        return false;
+    }
+    return true;
 }
 
-void read_mtx_values(char* filename, magma_int_t m, magma_int_t n, double* mtx) {
-    MM_typecode matcode;
-    FILE* file_handle = fopen(filename, "r");
-    mm_read_banner(file_handle, &matcode);
-    mm_read_mtx_array_size(file_handle, &m, &n);
-    magma_int_t size[2] = {m, n};
-    for (int i = 0; i < m; ++i) {
-        for (int j = 0; j < n; ++j) {
-            fscanf(file_handle, "%lf ", &mtx[i * n + j]);
+inline const char* find_eol(const char* p, const char* end)
+{
+    auto eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    return (eol == nullptr) ? end : eol;
+}
+
+inline bool is_space(char c)
+{
+    return (c == ' ') || (c == '\t') || (c == '\n') || (c == '\r');
+}
+
+inline const char* skip_space(const char* p, const char* end)
+{
+    while ((p < end) && is_space(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+inline const char* skip_token(const char* p, const char* end)
+{
+    while ((p < end) && !is_space(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+// Parses the token [p, end) as a double. Decimals with at most 19
+// significant digits and a mantissa below 2^53 are scaled by an exact power
+// of ten up to 1e22, which is correctly rounded (Clinger's fast path). Longer
+// mantissas, such as the 17 digits printed by %.17g, are scaled in x87
+// extended precision with one rounding; the result is kept unless it lies within one
+// long double ulp of a halfway point between two doubles, where the second
+// rounding could differ. All other tokens fall back to strtod.
+double parse_double(const char* p, const char* end)
+{
+    static const double powers[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                    1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                    1e18, 1e19, 1e20, 1e21, 1e22};
+    const char* begin = p;
+    bool negative = false;
+    if ((p < end) && ((*p == '-') || (*p == '+'))) {
+        negative = (*p == '-');
+        ++p;
+    }
+    std::uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool exact = true;
+    bool any_digit = false;
+    for (; (p < end) && (*p >= '0') && (*p <= '9'); ++p) {
+        any_digit = true;
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (*p - '0');
+            digits += (mantissa != 0);
+        } else {
+            exact = exact && (*p == '0');
+            exponent++;
+        }
+    }
+    if ((p < end) && (*p == '.')) {
+        for (++p; (p < end) && (*p >= '0') && (*p <= '9'); ++p) {
+            any_digit = true;
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits += (mantissa != 0);
+                exponent--;
+            } else {
+                exact = exact && (*p == '0');
+            }
+        }
+    }
+    if (any_digit && (p < end) && ((*p == 'e') || (*p == 'E'))) {
+        ++p;
+        bool negative_exponent = false;
+        if ((p < end) && ((*p == '-') || (*p == '+'))) {
+            negative_exponent = (*p == '-');
+            ++p;
+        }
+        int value = 0;
+        for (; (p < end) && (*p >= '0') && (*p <= '9'); ++p) {
+            value = std::min(value * 10 + (*p - '0'), 100000);
+        }
+        exponent += negative_exponent ? -value : value;
+    }
+    if (any_digit && exact && (p == end) && (mantissa < (1ull << 53)) &&
+        (exponent >= -22) && (exponent <= 22)) {
+        double value = static_cast<double>(mantissa);
+        value = (exponent < 0) ? value / powers[-exponent]
+                               : value * powers[exponent];
+        return negative ? -value : value;
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    // x87 extended precision: the first 8 bytes hold the 64-bit significand.
+    if (any_digit && exact && (p == end) && (exponent >= -27) &&
+        (exponent <= 27)) {
+        static const long double long_powers[] = {
+            1e0L,  1e1L,  1e2L,  1e3L,  1e4L,  1e5L,  1e6L,
+            1e7L,  1e8L,  1e9L,  1e10L, 1e11L, 1e12L, 1e13L,
+            1e14L, 1e15L, 1e16L, 1e17L, 1e18L, 1e19L, 1e20L,
+            1e21L, 1e22L, 1e23L, 1e24L, 1e25L, 1e26L, 1e27L};
+        long double value = static_cast<long double>(mantissa);
+        value = (exponent < 0) ? value / long_powers[-exponent]
+                               : value * long_powers[exponent];
+        std::uint64_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(bits));
+        auto low_bits = bits & 0x7ff;
+        if ((low_bits < 0x3ff) || (low_bits > 0x401)) {
+            double result = static_cast<double>(value);
+            return negative ? -result : result;
+        }
+    }
+#endif
+    char buffer[128];
+    std::size_t length = std::min<std::size_t>(end - begin, 127);
+    std::memcpy(buffer, begin, length);
+    buffer[length] = '\0';
+    return std::strtod(buffer, nullptr);
+}
+
+inline long long parse_integer(const char* p, const char* end)
+{
+    bool negative = (p < end) && (*p == '-');
+    p += ((p < end) && ((*p == '-') || (*p == '+'))) ? 1 : 0;
+    long long value = 0;
+    for (; (p < end) && (*p >= '0') && (*p <= '9'); ++p) {
+        value = value * 10 + (*p - '0');
+    }
+    return negative ? -value : value;
+}
+
+// Banner and size line of a MatrixMarket file; body points to the first
+// entry.
+struct mtx_text {
+    bool coordinate = false;
+    bool pattern = false;
+    bool symmetric = false;
+    bool skew = false;
+    long long num_rows = 0;
+    long long num_cols = 0;
+    long long nnz = 0;
+    const char* body = nullptr;
+    const char* end = nullptr;
+};
+
+inline bool contains(const std::string& line, const char* word)
+{
+    return line.find(word) != std::string::npos;
+}
+
+// Parses the banner, skips comments and reads the size line.
+void parse_mtx_header(const char* data, std::size_t size, mtx_text* text)
+{
+    const char* end = data + size;
+    const char* p = data;
+    const char* eol = std::find(p, end, '\n');
+    std::string banner(p, eol);
+    std::transform(banner.begin(), banner.end(), banner.begin(), ::tolower);
+    text->coordinate = contains(banner, "coordinate");
+    text->pattern = contains(banner, "pattern");
+    text->skew = contains(banner, "skew-symmetric");
+    text->symmetric = text->skew || contains(banner, "symmetric") ||
+                      contains(banner, "hermitian");
+    p = eol;
+    while (true) {
+        p = skip_space(p, end);
+        if ((p < end) && (*p == '%')) {
+            p = find_eol(p, end);
+        } else {
+            break;
+        }
+    }
+    long long* fields[3] = {&text->num_rows, &text->num_cols, &text->nnz};
+    int num_fields = text->coordinate ? 3 : 2;
+    for (int i = 0; i < num_fields; i++) {
+        p = skip_space(p, end);
+        const char* token_end = skip_token(p, end);
+        *fields[i] = parse_integer(p, token_end);
+        p = token_end;
+    }
+    text->body = p;
+    text->end = end;
+}
+
+// Splits [begin, end) into num_chunks pieces that start at line boundaries.
+std::vector<const char*> split_lines(const char* begin, const char* end,
+                                     int num_chunks)
+{
+    std::vector<const char*> bounds(num_chunks + 1, end);
+    bounds[0] = begin;
+    std::size_t length = end - begin;
+    for (int i = 1; i < num_chunks; i++) {
+        const char* p = std::max(bounds[i - 1], begin + length * i / num_chunks);
+        if (p > begin && p < end && *(p - 1) != '\n') {
+            p = find_eol(p, end);
+            p = (p < end) ? p + 1 : end;
+        }
+        bounds[i] = p;
+    }
+    return bounds;
+}
+
+// Calls parse_line(first token, end of line, line index) for every
+// non-empty line of the body, in parallel over line-aligned chunks. Lines are
+// numbered in file order.
+template <typename line_parser>
+long long parse_lines(const mtx_text& text, line_parser parse_line)
+{
+    int num_chunks = std::max(1, omp_get_max_threads()) * 4;
+    auto bounds = split_lines(text.body, text.end, num_chunks);
+    std::vector<long long> offsets(num_chunks + 1, 0);
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int chunk = 0; chunk < num_chunks; chunk++) {
+        long long count = 0;
+        for (const char* p = bounds[chunk]; p < bounds[chunk + 1];) {
+            const char* eol = find_eol(p, bounds[chunk + 1]);
+            const char* first = skip_space(p, eol);
+            count += (first < eol) && (*first != '%');
+            p = (eol < bounds[chunk + 1]) ? eol + 1 : eol;
+        }
+        offsets[chunk + 1] = count;
+    }
+    for (int chunk = 0; chunk < num_chunks; chunk++) {
+        offsets[chunk + 1] += offsets[chunk];
+    }
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int chunk = 0; chunk < num_chunks; chunk++) {
+        long long line = offsets[chunk];
+        for (const char* p = bounds[chunk]; p < bounds[chunk + 1];) {
+            const char* eol = find_eol(p, bounds[chunk + 1]);
+            const char* first = skip_space(p, eol);
+            if ((first < eol) && (*first != '%')) {
+                parse_line(first, eol, line++);
+            }
+            p = (eol < bounds[chunk + 1]) ? eol + 1 : eol;
+        }
+    }
+    return offsets[num_chunks];
+}
+
+void report_throughput(char* filename, std::size_t size,
+                       std::chrono::steady_clock::time_point start)
+{
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    double megabytes = size / 1e6;
+    std::cout << filename << ": parsed " << megabytes << " MB in "
+              << elapsed.count() << " s ("
+              << megabytes / std::max(elapsed.count(), 1e-9) << " MB/s)\n";
+}
+
+// Parses an array file into the column-major mtx with leading dimension ld.
+template <typename value_type>
+void read_mtx_array(char* filename, magma_int_t num_rows,
+                    magma_int_t num_cols, value_type* mtx, magma_int_t ld)
+{
+    auto start = std::chrono::steady_clock::now();
+    void* base = nullptr;
+    std::size_t size = 0;
+    if (!map_file(filename, &base, &size)) {
+        return;
+    }
+    mtx_text text;
+    parse_mtx_header(static_cast<const char*>(base), size, &text);
+    long long num_values = static_cast<long long>(num_rows) * num_cols;
+    auto count = parse_lines(
+        text, [&](const char* p, const char* eol, long long k) {
+            if (k < num_values) {
+                mtx[k % num_rows + (k / num_rows) * ld] =
+                    static_cast<value_type>(
+                        parse_double(p, skip_token(p, eol)));
+            }
+        });
+    if (count != num_values) {
+        std::cerr << filename << ": expected " << num_values
+                  << " values, found " << count << '\n';
+    }
+    munmap(base, size);
+    report_throughput(filename, size, start);
+}
+
+
+// Reads the coordinate entries of filename and compresses them by row.
+template <typename value_type>
+void read_mtx_coordinate(char* filename,
+                         matrix::sparse<value_type, magma_int_t>* mtx)
+{
+    auto start = std::chrono::steady_clock::now();
+    void* base = nullptr;
+    std::size_t size = 0;
+    if (!map_file(filename, &base, &size)) {
+        return;
+    }
+    mtx_text text;
+    parse_mtx_header(static_cast<const char*>(base), size, &text);
+    magma_int_t m = text.num_rows;
+    magma_int_t n = text.num_cols;
+    long long nz = text.nnz;
+    std::vector<magma_int_t> rows(nz);
+    std::vector<magma_int_t> cols(nz);
+    std::vector<value_type> values(nz);
+    auto count = parse_lines(
+        text, [&](const char* p, const char* eol, long long k) {
+            if (k >= nz) {
+                return;
+            }
+            const char* token_end = skip_token(p, eol);
+            rows[k] = parse_integer(p, token_end) - 1;
+            p = skip_space(token_end, eol);
+            token_end = skip_token(p, eol);
+            cols[k] = parse_integer(p, token_end) - 1;
+            if (text.pattern) {
+                values[k] = 1;
+            } else {
+                p = skip_space(token_end, eol);
+                values[k] = static_cast<value_type>(
+                    parse_double(p, skip_token(p, eol)));
+            }
+        });
+    if (count != nz) {
+        std::cerr << filename << ": expected " << nz << " entries, found "
+                  << count << '\n';
+    }
+    munmap(base, size);
+    report_throughput(filename, size, start);
+    if (text.symmetric) {
+        value_type mirror_sign = text.skew ? -1 : 1;
+        for (long long k = 0; k < nz; ++k) {
+            if (rows[k] != cols[k]) {
+                rows.push_back(cols[k]);
+                cols.push_back(rows[k]);
+                values.push_back(mirror_sign * values[k]);
+            }
+        }
+    }
+
+    magma_int_t nnz = static_cast<magma_int_t>(values.size());
+    mtx->allocate(m, n, nnz);
+    std::fill(mtx->row_ptrs, mtx->row_ptrs + m + 1, 0);
+    for (magma_int_t k = 0; k < nnz; ++k) {
+        mtx->row_ptrs[rows[k] + 1] += 1;
+    }
+    for (magma_int_t i = 0; i < m; ++i) {
+        mtx->row_ptrs[i + 1] += mtx->row_ptrs[i];
+    }
+    std::vector<magma_int_t> next(mtx->row_ptrs, mtx->row_ptrs + m);
+    for (magma_int_t k = 0; k < nnz; ++k) {
+        auto dest = next[rows[k]]++;
+        mtx->col_idxs[dest] = cols[k];
+        mtx->values[dest] = values[k];
+    }
+
+    // Sorts the columns of each row.
+    std::vector<std::pair<magma_int_t, value_type>> row_entries;
+    for (magma_int_t i = 0; i < m; ++i) {
+        auto begin = mtx->row_ptrs[i];
+        auto end = mtx->row_ptrs[i + 1];
+        row_entries.clear();
+        for (auto k = begin; k < end; ++k) {
+            row_entries.push_back(
+                std::make_pair(mtx->col_idxs[k], mtx->values[k]));
+        }
+        std::sort(row_entries.begin(), row_entries.end(),
+                  [](const std::pair<magma_int_t, value_type>& a,
+                     const std::pair<magma_int_t, value_type>& b) {
+                      return a.first < b.first;
+                  });
+        for (auto k = begin; k < end; ++k) {
+            mtx->col_idxs[k] = row_entries[k - begin].first;
+            mtx->values[k] = row_entries[k - begin].second;
+        }
+    }
+}
+
+
+const char bin_magic[8] = {'R', 'L', 'S', 'B', 'I', 'N', '\0', '\0'};
+
+const std::uint64_t bin_alignment = 4096;
+
+// Target size of a panel when open_panels picks the number of rows.
+const std::size_t panel_bytes = std::size_t(64) << 20;
+
+std::uint64_t fnv1a(const void* data, std::size_t size)
+{
+    const std::uint64_t prime = 1099511628211ull;
+    std::uint64_t hash = 14695981039346656037ull;
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    std::size_t num_words = size / sizeof(std::uint64_t);
+    for (std::size_t i = 0; i < num_words; i++) {
+        std::uint64_t word;
+        std::memcpy(&word, bytes + i * sizeof(word), sizeof(word));
+        hash = (hash ^ word) * prime;
+    }
+    for (std::size_t i = num_words * sizeof(std::uint64_t); i < size; i++) {
+        hash = (hash ^ bytes[i]) * prime;
+    }
+    return hash;
+}
+
+std::size_t bin_value_size(const bin_header& header)
+{
+    return (header.dtype == bin_fp64) ? sizeof(double) : sizeof(float);
+}
+
+// Returns why header does not describe a valid file of size bytes, or nullptr.
+const char* check_header(const bin_header& header, std::size_t size)
+{
+    std::size_t data_size =
+        bin_value_size(header) * header.ld * header.num_cols;
+    if (std::memcmp(header.magic, bin_magic, sizeof(bin_magic)) != 0) {
+        return "bad magic";
+    } else if (header.version != bin_version) {
+        return "unsupported version";
+    } else if ((header.dtype != bin_fp64 && header.dtype != bin_fp32) ||
+               (header.layout != bin_col_major) ||
+               (header.ld < header.num_rows)) {
+        return "unsupported dtype or layout";
+    } else if (header.data_offset + data_size != size) {
+        return "size does not match the header";
+    }
+    return nullptr;
+}
+
+// Reads size bytes at offset of fd into dest, retrying short reads.
+bool read_at(int fd, void* dest, std::size_t size, std::uint64_t offset)
+{
+    char* p = static_cast<char*>(dest);
+    while (size > 0) {
+        ssize_t count = pread(fd, p, size, offset);
+        if (count <= 0) {
+            return false;
+        }
+        p += count;
+        size -= count;
+        offset += count;
+    }
+    return true;
+}
+
+// Indexes the lines of the array file mapped at data: records the byte
+// offset of the first value of every panel of every column and the end of
+// the last value, in one sequential pass.
+bool index_panels(char* filename, const char* data, std::size_t size,
+                  panel_file* file)
+{
+    mtx_text text;
+    parse_mtx_header(data, size, &text);
+    file->num_rows = text.num_rows;
+    file->num_cols = text.num_cols;
+    if (text.coordinate || (file->num_rows <= 0) || (file->num_cols <= 0)) {
+        std::cerr << filename << ": not a dense MatrixMarket array\n";
+        return false;
+    }
+    if (file->panel_rows <= 0) {
+        file->panel_rows = static_cast<magma_int_t>(std::max<std::size_t>(
+            1, panel_bytes / (sizeof(double) * file->num_cols)));
+    }
+    file->panel_rows = std::min(file->panel_rows, file->num_rows);
+    file->num_panels =
+        (file->num_rows + file->panel_rows - 1) / file->panel_rows;
+    long long num_values = static_cast<long long>(file->num_rows) *
+                           file->num_cols;
+    file->offsets.reserve(std::size_t(file->num_panels) * file->num_cols + 1);
+    long long line = 0;
+    const char* p = text.body;
+    while ((p < text.end) && (line < num_values)) {
+        const char* eol = find_eol(p, text.end);
+        const char* first = skip_space(p, eol);
+        if ((first < eol) && (*first != '%')) {
+            if ((line % file->num_rows) % file->panel_rows == 0) {
+                file->offsets.push_back(first - data);
+            }
+            line++;
         }
+        p = (eol < text.end) ? eol + 1 : eol;
     }
+    file->offsets.push_back(p - data);
+    if (line != num_values) {
+        std::cerr << filename << ": expected " << num_values
+                  << " values, found " << line << '\n';
+        return false;
+    }
+    return true;
+}
+
+// Asks the kernel to read panel panel of file ahead of its use.
+void advise_panel(const panel_file* file, magma_int_t panel)
+{
+    if ((panel < 0) || (panel >= file->num_panels)) {
+        return;
+    }
+    magma_int_t row_begin = panel * file->panel_rows;
+    magma_int_t rows = std::min(file->panel_rows, file->num_rows - row_begin);
+    for (magma_int_t col = 0; col < file->num_cols; col++) {
+        std::uint64_t begin = 0;
+        std::uint64_t size = 0;
+        if (file->binary) {
+            std::size_t value_size = bin_value_size(file->header);
+            begin = file->header.data_offset +
+                    (col * file->header.ld + row_begin) * value_size;
+            size = rows * value_size;
+        } else {
+            std::size_t index =
+                static_cast<std::size_t>(col) * file->num_panels + panel;
+            begin = file->offsets[index];
+            size = file->offsets[index + 1] - begin;
+        }
+        posix_fadvise(file->fd, begin, size, POSIX_FADV_WILLNEED);
+    }
+}
+
+// Parses the values of the lines in [begin, end) to values.
+template <typename value_type>
+magma_int_t parse_values(const char* begin, const char* end,
+                         value_type* values)
+{
+    magma_int_t count = 0;
+    for (const char* p = begin; p < end;) {
+        const char* eol = find_eol(p, end);
+        const char* first = skip_space(p, eol);
+        if ((first < eol) && (*first != '%')) {
+            values[count++] = static_cast<value_type>(
+                parse_double(first, skip_token(first, eol)));
+        }
+        p = (eol < end) ? eol + 1 : eol;
+    }
+    return count;
+}
+
+template <typename value_type>
+magma_int_t read_panel_values(panel_file* file, magma_int_t panel,
+                              value_type* values)
+{
+    magma_int_t row_begin = panel * file->panel_rows;
+    magma_int_t rows = std::min(file->panel_rows, file->num_rows - row_begin);
+    for (magma_int_t col = 0; col < file->num_cols; col++) {
+        value_type* dest = values + static_cast<std::size_t>(col) * rows;
+        if (file->binary) {
+            std::size_t value_size = bin_value_size(file->header);
+            std::uint64_t offset =
+                file->header.data_offset +
+                (col * file->header.ld + row_begin) * value_size;
+            bool same_type = (value_size == sizeof(value_type));
+            file->buffer.resize(same_type ? 0 : rows * value_size);
+            void* target = same_type ? static_cast<void*>(dest)
+                                     : static_cast<void*>(file->buffer.data());
+            if (!read_at(file->fd, target, rows * value_size, offset)) {
+                return -1;
+            }
+            if (!same_type && (file->header.dtype == bin_fp64)) {
+                auto source = reinterpret_cast<const double*>(target);
+                std::copy(source, source + rows, dest);
+            } else if (!same_type) {
+                auto source = reinterpret_cast<const float*>(target);
+                std::copy(source, source + rows, dest);
+            }
+        } else {
+            std::size_t index =
+                static_cast<std::size_t>(col) * file->num_panels + panel;
+            std::uint64_t begin = file->offsets[index];
+            std::size_t size = file->offsets[index + 1] - begin;
+            file->buffer.resize(size);
+            if (!read_at(file->fd, file->buffer.data(), size, begin) ||
+                (parse_values(file->buffer.data(),
+                              file->buffer.data() + size, dest) != rows)) {
+                return -1;
+            }
+        }
+    }
+    return rows;
+}
+
+template <typename value_type>
+void write_bin_values(char* filename, magma_int_t num_rows,
+                      magma_int_t num_cols, const value_type* mtx,
+                      magma_int_t ld, bin_dtype dtype)
+{
+    std::size_t column_size = sizeof(value_type) * num_rows;
+    std::vector<char> payload(column_size * num_cols);
+    for (magma_int_t j = 0; j < num_cols; ++j) {
+        std::memcpy(payload.data() + j * column_size,
+                    mtx + static_cast<std::size_t>(j) * ld, column_size);
+    }
+    bin_header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, bin_magic, sizeof(bin_magic));
+    header.version = bin_version;
+    header.dtype = dtype;
+    header.layout = bin_col_major;
+    header.num_rows = num_rows;
+    header.num_cols = num_cols;
+    header.ld = num_rows;
+    header.data_offset = bin_alignment;
+    header.checksum = fnv1a(payload.data(), payload.size());
+    std::vector<char> padding(bin_alignment - sizeof(header), 0);
+    FILE* file_handle = fopen(filename, "wb");
+    fwrite(&header, sizeof(header), 1, file_handle);
+    fwrite(padding.data(), 1, padding.size(), file_handle);
+    fwrite(payload.data(), 1, payload.size(), file_handle);
     fclose(file_handle);
 }
 
-void read_mtx_values(char* filename, magma_int_t m, magma_int_t n, float* mtx) {
+
+}  // anonymous namespace
+
+
+bool is_binary(char* filename)
+{
+    char magic[sizeof(bin_magic)] = {};
+    FILE* file_handle = fopen(filename, "rb");
+    if (file_handle == nullptr) {
+        return false;
+    }
+    auto count = fread(magic, 1, sizeof(magic), file_handle);
+    fclose(file_handle);
+    return (count == sizeof(magic)) &&
+           (std::memcmp(magic, bin_magic, sizeof(magic)) == 0);
+}
+
+void write_bin(char* filename, magma_int_t num_rows, magma_int_t num_cols,
+               const double* mtx, magma_int_t ld)
+{
+    write_bin_values(filename, num_rows, num_cols, mtx, ld, bin_fp64);
+}
+
+void write_bin(char* filename, magma_int_t num_rows, magma_int_t num_cols,
+               const float* mtx, magma_int_t ld)
+{
+    write_bin_values(filename, num_rows, num_cols, mtx, ld, bin_fp32);
+}
+
+bool map_bin(char* filename, mapped_mtx* mapped, bool verify)
+{
+    void* base = nullptr;
+    std::size_t size = 0;
+    if (!map_file(filename, &base, &size)) {
+        return false;
+    }
+    if (size < sizeof(bin_header)) {
+        std::cerr << filename << ": too small for a binary matrix\n";
+        if (base != nullptr) {
+            munmap(base, size);
+        }
+        return false;
+    }
+    bin_header header;
+    std::memcpy(&header, base, sizeof(header));
+    std::size_t data_size =
+        bin_value_size(header) * header.ld * header.num_cols;
+    const char* reason = check_header(header, size);
+    auto values = static_cast<const char*>(base) + header.data_offset;
+    if ((reason == nullptr) && verify &&
+        (fnv1a(values, data_size) != header.checksum)) {
+        reason = "checksum mismatch";
+    }
+    if (reason != nullptr) {
+        std::cerr << filename << ": " << reason << '\n';
+        munmap(base, size);
+        return false;
+    }
+    madvise(base, size, MADV_SEQUENTIAL);
+    mapped->header = header;
+    mapped->values = values;
+    mapped->base = base;
+    mapped->size = size;
+    return true;
+}
+
+void unmap_bin(mapped_mtx* mapped)
+{
+    if (mapped->base != nullptr) {
+        munmap(mapped->base, mapped->size);
+    }
+    mapped->values = nullptr;
+    mapped->base = nullptr;
+    mapped->size = 0;
+}
+
+bool open_panels(char* filename, magma_int_t panel_rows, panel_file* file)
+{
+    file->panel_rows = panel_rows;
+    file->binary = is_binary(filename);
+    file->fd = open(filename, O_RDONLY);
+    if (file->fd < 0) {
+        std::cerr << filename << ": cannot open\n";
+        return false;
+    }
+    struct stat info;
+    fstat(file->fd, &info);
+    std::size_t size = info.st_size;
+    bool valid = true;
+    if (file->binary) {
+        const char* reason = "too small for a binary matrix";
+        if ((size >= sizeof(bin_header)) &&
+            read_at(file->fd, &file->header, sizeof(bin_header), 0)) {
+            reason = check_header(file->header, size);
+        }
+        if (reason != nullptr) {
+            std::cerr << filename << ": " << reason << '\n';
+            valid = false;
+        } else {
+            file->num_rows = file->header.num_rows;
+            file->num_cols = file->header.num_cols;
+            if (file->panel_rows <= 0) {
+                file->panel_rows = static_cast<magma_int_t>(
+                    std::max<std::size_t>(
+                        1, panel_bytes / (bin_value_size(file->header) *
+                                          file->num_cols)));
+            }
+            file->panel_rows = std::min(file->panel_rows, file->num_rows);
+            file->num_panels =
+                (file->num_rows + file->panel_rows - 1) / file->panel_rows;
+        }
+    } else {
+        void* base = (size > 0) ? mmap(nullptr, size, PROT_READ, MAP_SHARED,
+                                       file->fd, 0)
+                                : MAP_FAILED;
+        if (base == MAP_FAILED) {
+            std::cerr << filename << ": mmap failed\n";
+            valid = false;
+        } else {
+            madvise(base, size, MADV_SEQUENTIAL);
+            valid = index_panels(filename, static_cast<const char*>(base),
+                                 size, file);
+            munmap(base, size);
+        }
+    }
+    if (!valid) {
+        close_panels(file);
+    } else {
+        posix_fadvise(file->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+    return valid;
+}
+
+magma_int_t read_panel(panel_file* file, magma_int_t panel, double* values)
+{
+    return read_panel_values(file, panel, values);
+}
+
+magma_int_t read_panel(panel_file* file, magma_int_t panel, float* values)
+{
+    return read_panel_values(file, panel, values);
+}
+
+void close_panels(panel_file* file)
+{
+    if (file->fd >= 0) {
+        close(file->fd);
+    }
+    file->fd = -1;
+    file->offsets.clear();
+    file->offsets.shrink_to_fit();
+    file->buffer.clear();
+    file->buffer.shrink_to_fit();
+}
+
+template <typename value_type>
+panel_reader<value_type>::panel_reader(panel_file* file_in) : file(file_in)
+{
+    for (auto& buffer : buffers) {
+        buffer.resize(static_cast<std::size_t>(file->panel_rows) *
+                      file->num_cols);
+    }
+}
+
+template <typename value_type>
+panel_reader<value_type>::~panel_reader()
+{
+    finish();
+}
+
+template <typename value_type>
+void panel_reader<value_type>::finish()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stop = true;
+    }
+    changed.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+template <typename value_type>
+void panel_reader<value_type>::start()
+{
+    finish();
+    stop = false;
+    failed = false;
+    panel = -1;
+    full[0] = false;
+    full[1] = false;
+    thread = std::thread([this]() { read_all(); });
+}
+
+template <typename value_type>
+void panel_reader<value_type>::read_all()
+{
+    for (magma_int_t k = 0; k < file->num_panels; k++) {
+        auto slot = k % 2;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            changed.wait(guard, [&]() { return stop || !full[slot]; });
+            if (stop) {
+                return;
+            }
+        }
+        advise_panel(file, k + 1);
+        auto count = read_panel(file, k, buffers[slot].data());
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            rows[slot] = count;
+            full[slot] = true;
+            failed = (count < 0);
+        }
+        changed.notify_all();
+        if (count < 0) {
+            return;
+        }
+    }
+}
+
+template <typename value_type>
+value_type* panel_reader<value_type>::next(magma_int_t* num_rows)
+{
+    std::unique_lock<std::mutex> guard(lock);
+    if (panel >= 0) {
+        full[panel % 2] = false;
+        changed.notify_all();
+    }
+    panel++;
+    *num_rows = 0;
+    if (panel >= file->num_panels) {
+        return nullptr;
+    }
+    auto slot = panel % 2;
+    auto t = std::chrono::steady_clock::now();
+    changed.wait(guard, [&]() { return full[slot] || failed; });
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - t;
+    t_wait += elapsed.count();
+    if (!full[slot] || (rows[slot] < 0)) {
+        *num_rows = -1;
+        return nullptr;
+    }
+    *num_rows = rows[slot];
+    return buffers[slot].data();
+}
+
+template struct panel_reader<double>;
+template struct panel_reader<float>;
+
+
+bool is_coordinate(char* filename)
+{
     MM_typecode matcode;
     FILE* file_handle = fopen(filename, "r");
     mm_read_banner(file_handle, &matcode);
-    mm_read_mtx_array_size(file_handle, &m, &n);
-    magma_int_t size[2] = {m, n};
-    for (int i = 0; i < m; ++i) {
-        for (int j = 0; j < n; ++j) {
-            fscanf(file_handle, "%f ", &mtx[i * n + j]);
-        }
-    }
     fclose(file_handle);
+    return mm_is_coordinate(matcode);
+}
+
+void read_mtx_sparse(char* filename, matrix::sparse<double, magma_int_t>* mtx)
+{
+    read_mtx_coordinate(filename, mtx);
+}
+
+void read_mtx_sparse(char* filename, matrix::sparse<float, magma_int_t>* mtx)
+{
+    read_mtx_coordinate(filename, mtx);
 }
+
+
+void read_mtx_size(char* filename, magma_int_t* m, magma_int_t* n) {
+    void* base = nullptr;
+    std::size_t size = 0;
+    if (!map_file(filename, &base, &size)) {
+        return;
+    }
+    mtx_text text;
+    parse_mtx_header(static_cast<const char*>(base), size, &text);
+    *m = text.num_rows;
+    *n = text.num_cols;
+    munmap(base, size);
+}
+
+void read_mtx_values(char* filename, magma_int_t m, magma_int_t n, double* mtx) {
+    read_mtx_array(filename, m, n, mtx, m);
+}
+
+void read_mtx_values(char* filename, magma_int_t m, magma_int_t n, float* mtx) {
+    read_mtx_array(filename, m, n, mtx, m);
+}
+
 void write_mtx(char* filename, magma_int_t m, magma_int_t n, double* mtx) {
     MM_typecode matcode;
     mm_initialize_typecode(&matcode);
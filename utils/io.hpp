@@ -8,6 +8,13 @@
 #include "magma_lapack.h"
 #include "magma_v2.h"
 #include "mmio.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../core/matrix/sparse.hpp"
 
 
 namespace rls {
@@ -20,6 +27,135 @@ void read_mtx_values(char* filename, magma_int_t m, magma_int_t n, double* mtx);
 
 void read_mtx_values(char* filename, magma_int_t m, magma_int_t n, float* mtx);
 
+// Returns true if filename is a MatrixMarket file in coordinate (sparse)
+// format.
+bool is_coordinate(char* filename);
+
+// Reads a MatrixMarket coordinate file into a CSR matrix allocated with
+// memory::malloc. Pattern files get unit values and symmetric files are
+// expanded.
+void read_mtx_sparse(char* filename, matrix::sparse<double, magma_int_t>* mtx);
+
+void read_mtx_sparse(char* filename, matrix::sparse<float, magma_int_t>* mtx);
+
+// Header of the binary matrix container. The payload starts at data_offset
+// (a multiple of the page size) and holds a num_rows x num_cols column-major
+// matrix with leading dimension ld, so it can be used in place once mapped.
+// checksum is the 64-bit FNV-1a hash of the payload, taken word by word.
+struct bin_header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t dtype;
+    std::uint32_t layout;
+    std::uint32_t reserved;
+    std::uint64_t num_rows;
+    std::uint64_t num_cols;
+    std::uint64_t ld;
+    std::uint64_t data_offset;
+    std::uint64_t checksum;
+};
+
+const std::uint32_t bin_version = 1;
+
+enum bin_dtype : std::uint32_t { bin_fp64 = 0, bin_fp32 = 1 };
+
+enum bin_layout : std::uint32_t { bin_col_major = 0 };
+
+// Read-only mapping of a binary matrix file.
+struct mapped_mtx {
+    bin_header header;
+    const void* values = nullptr;
+    void* base = nullptr;
+    std::size_t size = 0;
+};
+
+// Returns true if filename starts with the magic of the binary container.
+bool is_binary(char* filename);
+
+void write_bin(char* filename, magma_int_t num_rows, magma_int_t num_cols,
+               const double* mtx, magma_int_t ld);
+
+void write_bin(char* filename, magma_int_t num_rows, magma_int_t num_cols,
+               const float* mtx, magma_int_t ld);
+
+// Maps filename read-only, so the values are backed by the page cache and
+// shared across runs. The header is validated against the file size; the
+// payload checksum is only verified if verify is set, since that touches
+// every page. Returns false and prints the reason on failure.
+bool map_bin(char* filename, mapped_mtx* mapped, bool verify = false);
+
+void unmap_bin(mapped_mtx* mapped);
+
+// Dense matrix file (binary container or MatrixMarket array) read in panels
+// of panel_rows consecutive rows, so that it never has to fit in memory. Array
+// files are indexed once when opened: offsets holds the byte offset of the
+// first value of every panel of every column, column by column, followed by
+// the end of the last value.
+struct panel_file {
+    int fd = -1;
+    bool binary = false;
+    bin_header header;
+    magma_int_t num_rows = 0;
+    magma_int_t num_cols = 0;
+    magma_int_t panel_rows = 0;
+    magma_int_t num_panels = 0;
+    std::vector<std::uint64_t> offsets;
+    std::vector<char> buffer;
+};
+
+// Opens filename for read_panel. panel_rows <= 0 picks panels of about
+// 64 MB. Returns false and prints the reason on failure.
+bool open_panels(char* filename, magma_int_t panel_rows, panel_file* file);
+
+// Reads panel panel of file into values, column-major with leading dimension
+// the number of rows of the panel, which is returned (-1 on a read error).
+// Not thread-safe: a file is read by one thread at a time.
+magma_int_t read_panel(panel_file* file, magma_int_t panel, double* values);
+
+magma_int_t read_panel(panel_file* file, magma_int_t panel, float* values);
+
+void close_panels(panel_file* file);
+
+// Reads the panels of file in order on a background thread, one pass over
+// the file per call to start. Panel k goes to buffer k % 2, which is refilled
+// only once next has moved past it, so at most two panels are held and the
+// read of a panel overlaps the use of the previous one. While a panel is
+// read, the kernel is asked to read ahead the one after it.
+template <typename value_type>
+struct panel_reader {
+    panel_file* file = nullptr;
+    std::vector<value_type> buffers[2];
+    magma_int_t rows[2] = {0, 0};
+    bool full[2] = {false, false};
+    magma_int_t panel = -1;
+    bool stop = false;
+    // Set once a read fails; the thread reads no further panels of the pass.
+    bool failed = false;
+    // Seconds next spent waiting for reads, over all passes.
+    double t_wait = 0.0;
+    std::mutex lock;
+    std::condition_variable changed;
+    std::thread thread;
+
+    explicit panel_reader(panel_file* file_in);
+
+    ~panel_reader();
+
+    // Starts a pass from the first panel, abandoning the current one.
+    void start();
+
+    // Releases the current panel and returns the next one with its number of
+    // rows, or nullptr after the last panel (rows = 0) or once a read of the
+    // pass has failed (rows < 0, for this and every later call).
+    value_type* next(magma_int_t* num_rows);
+
+    // Body of the reading thread.
+    void read_all();
+
+    // Stops and joins the reading thread.
+    void finish();
+};
+
 void write_mtx(char* filename, magma_int_t m, magma_int_t n, double* mtx);
 
 void write_mtx(char* filename, magma_int_t num_rows, magma_int_t num_cols, double* dmtx, magma_int_t ld, magma_queue_t queue);